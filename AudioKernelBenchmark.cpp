@@ -0,0 +1,155 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2018, Live Networks, Inc.  All rights reserved
+// An audio conversion benchmark: Measures the samples/s converted by each of the filters in "uLawAudioFilter.hh"
+// (uLaw <-> 16-bit PCM, and 16- and 24-bit byte swapping), by pulling frames through each filter from an in-memory source.
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include <stdlib.h>
+#include <unistd.h>
+
+// Parameters (set from the command line):
+static unsigned samplesPerFrame = 4096;
+static double secondsPerKernel = 1.0;
+
+// A source that delivers (synchronously) copies of a fixed frame of data:
+class MemoryFrameSource: public FramedSource {
+public:
+    static MemoryFrameSource* createNew(UsageEnvironment& env, u_int8_t const* frame, unsigned frameSize) {
+        return new MemoryFrameSource(env, frame, frameSize);
+    }
+
+protected:
+    MemoryFrameSource(UsageEnvironment& env, u_int8_t const* frame, unsigned frameSize)
+        : FramedSource(env), fFrame(frame), fFrameSize1(frameSize) {}
+
+private: // redefined virtual functions
+    virtual void doGetNextFrame();
+
+private:
+    u_int8_t const* fFrame;
+    unsigned fFrameSize1;
+};
+
+void MemoryFrameSource::doGetNextFrame() {
+    fFrameSize = fFrameSize1 < fMaxSize ? fFrameSize1 : fMaxSize;
+    fNumTruncatedBytes = fFrameSize1 - fFrameSize;
+    memmove(fTo, fFrame, fFrameSize);
+    gettimeofday(&fPresentationTime, NULL);
+    FramedSource::afterGetting(this);
+}
+
+static unsigned long numFramesDelivered = 0;
+
+static void afterGettingFrame(void*, unsigned /*frameSize*/, unsigned /*numTruncatedBytes*/,
+                              struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/) {
+    ++numFramesDelivered;
+}
+
+static double wallSeconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec + tv.tv_usec/1e6;
+}
+
+// Pulls frames through "source" (whose input frames each hold "samplesPerFrame" samples) for "secondsPerKernel",
+// then reports the conversion rate:
+static void runKernel(char const* kernelName, FramedSource* source, u_int8_t* outBuf, unsigned outBufSize) {
+    numFramesDelivered = 0;
+    double const startTime = wallSeconds();
+    double elapsed;
+    do {
+        for (unsigned i = 0; i < 100; ++i) {
+            // Our input source delivers synchronously, so each frame is converted before "getNextFrame()" returns:
+            source->getNextFrame(outBuf, outBufSize, afterGettingFrame, NULL, NULL, NULL);
+        }
+        elapsed = wallSeconds() - startTime;
+    } while (elapsed < secondsPerKernel);
+
+    double const samplesPerSecond = ((double)numFramesDelivered*samplesPerFrame)/elapsed;
+    fprintf(stdout, "%-24s %10.1f Msamples/s\n", kernelName, samplesPerSecond/1e6);
+}
+
+static void usage(char const* progName) {
+    fprintf(stderr, "Usage: %s [-s <samples-per-frame>] [-d <seconds-per-kernel>]\n", progName);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "s:d:")) != -1) {
+        switch (opt) {
+            case 's': samplesPerFrame = (unsigned)atoi(optarg); break;
+            case 'd': secondsPerKernel = atof(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || samplesPerFrame == 0 || secondsPerKernel <= 0.0) usage(argv[0]);
+
+    TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+    UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+    // Input data: pseudo-random bytes (so that the uLaw encoder sees a spread of sample values):
+    unsigned const inBufSize = 3*samplesPerFrame; // enough for 24-bit samples
+    u_int8_t* inBuf = new u_int8_t[inBufSize];
+    srandom(1);
+    for (unsigned i = 0; i < inBufSize; ++i) inBuf[i] = (u_int8_t)random();
+    unsigned const outBufSize = 3*samplesPerFrame;
+    u_int8_t* outBuf = new u_int8_t[outBufSize];
+
+    fprintf(stderr, "Converting %u samples per frame, for %g s per kernel\n", samplesPerFrame, secondsPerKernel);
+
+    // First, our source alone (i.e., just the copying of each 16-bit frame), for comparison:
+    FramedSource* source = MemoryFrameSource::createNew(*env, inBuf, 2*samplesPerFrame);
+    runKernel("(copy 16-bit frame)", source, outBuf, outBufSize);
+    Medium::close(source);
+
+    source = uLawFromPCMAudioSource::createNew(*env, MemoryFrameSource::createNew(*env, inBuf, 2*samplesPerFrame), 1);
+    runKernel("uLawFromPCM (LE)", source, outBuf, outBufSize);
+    Medium::close(source);
+
+    source = uLawFromPCMAudioSource::createNew(*env, MemoryFrameSource::createNew(*env, inBuf, 2*samplesPerFrame), 2);
+    runKernel("uLawFromPCM (BE)", source, outBuf, outBufSize);
+    Medium::close(source);
+
+    // ("PCMFromuLawAudioSource" reads into the second half of the downstream buffer, so give it exactly 2 bytes per sample:)
+    source = PCMFromuLawAudioSource::createNew(*env, MemoryFrameSource::createNew(*env, inBuf, samplesPerFrame));
+    runKernel("PCMFromuLaw", source, outBuf, 2*samplesPerFrame);
+    Medium::close(source);
+
+    source = NetworkFromHostOrder16::createNew(*env, MemoryFrameSource::createNew(*env, inBuf, 2*samplesPerFrame));
+    runKernel("NetworkFromHostOrder16", source, outBuf, outBufSize);
+    Medium::close(source);
+
+    source = HostFromNetworkOrder16::createNew(*env, MemoryFrameSource::createNew(*env, inBuf, 2*samplesPerFrame));
+    runKernel("HostFromNetworkOrder16", source, outBuf, outBufSize);
+    Medium::close(source);
+
+    source = EndianSwap16::createNew(*env, MemoryFrameSource::createNew(*env, inBuf, 2*samplesPerFrame));
+    runKernel("EndianSwap16", source, outBuf, outBufSize);
+    Medium::close(source);
+
+    source = EndianSwap24::createNew(*env, MemoryFrameSource::createNew(*env, inBuf, 3*samplesPerFrame));
+    runKernel("EndianSwap24", source, outBuf, outBufSize);
+    Medium::close(source);
+
+    delete[] outBuf; delete[] inBuf;
+    env->reclaim();
+    delete scheduler;
+    return 0;
+}
@@ -0,0 +1,380 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2018, Live Networks, Inc.  All rights reserved
+// A "BitVector" benchmark: First checks - using random sequences of operations on random data - that "BitVector"
+// (and "shiftBits()") give the same results as the original (bit-at-a-time) implementation, a copy of which is below.
+// Then measures (for each implementation) the bits/ns read by "getBits()", written by "putBits()",
+// and read by "get_expGolomb()".
+// Exits with status 0 iff the implementations' results were identical.
+
+#include "liveMedia.hh"
+#include "BitVector.hh"
+#include <stdlib.h>
+#include <unistd.h>
+
+// Parameters (set from the command line):
+static unsigned numSequencesToCompare = 100000;
+static unsigned dataKBytes = 1024;
+static double secondsPerMeasurement = 1.0;
+
+static double wallSeconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec + tv.tv_usec/1e6;
+}
+
+////////// The original implementation, for comparison //////////
+
+static unsigned char const singleBitMask[8]
+    = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+
+#define MAX_LENGTH 32
+
+static void originalShiftBits(unsigned char* toBasePtr, unsigned toBitOffset,
+                              unsigned char const* fromBasePtr, unsigned fromBitOffset,
+                              unsigned numBits) {
+    if (numBits == 0) return;
+
+    /* Note that from and to may overlap, if from>to */
+    unsigned char const* fromBytePtr = fromBasePtr + fromBitOffset/8;
+    unsigned fromBitRem = fromBitOffset%8;
+    unsigned char* toBytePtr = toBasePtr + toBitOffset/8;
+    unsigned toBitRem = toBitOffset%8;
+
+    while (numBits-- > 0) {
+        unsigned char fromBitMask = singleBitMask[fromBitRem];
+        unsigned char fromBit = (*fromBytePtr)&fromBitMask;
+        unsigned char toBitMask = singleBitMask[toBitRem];
+
+        if (fromBit != 0) {
+            *toBytePtr |= toBitMask;
+        } else {
+            *toBytePtr &=~ toBitMask;
+        }
+
+        if (++fromBitRem == 8) {
+            ++fromBytePtr;
+            fromBitRem = 0;
+        }
+        if (++toBitRem == 8) {
+            ++toBytePtr;
+            toBitRem = 0;
+        }
+    }
+}
+
+class OriginalBitVector {
+public:
+    OriginalBitVector(unsigned char* baseBytePtr, unsigned baseBitOffset, unsigned totNumBits)
+        : fBaseBytePtr(baseBytePtr), fBaseBitOffset(baseBitOffset), fTotNumBits(totNumBits), fCurBitIndex(0) {}
+
+    void putBits(unsigned from, unsigned numBits) {
+        if (numBits == 0) return;
+
+        unsigned char tmpBuf[4];
+        unsigned overflowingBits = 0;
+
+        if (numBits > MAX_LENGTH) {
+            numBits = MAX_LENGTH;
+        }
+
+        if (numBits > fTotNumBits - fCurBitIndex) {
+            overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
+        }
+
+        tmpBuf[0] = (unsigned char)(from>>24);
+        tmpBuf[1] = (unsigned char)(from>>16);
+        tmpBuf[2] = (unsigned char)(from>>8);
+        tmpBuf[3] = (unsigned char)from;
+
+        originalShiftBits(fBaseBytePtr, fBaseBitOffset + fCurBitIndex, /* to */
+                          tmpBuf, MAX_LENGTH - numBits, /* from */
+                          numBits - overflowingBits /* num bits */);
+        fCurBitIndex += numBits - overflowingBits;
+    }
+
+    void put1Bit(unsigned bit) {
+        if (fCurBitIndex >= fTotNumBits) { /* overflow */
+            return;
+        } else {
+            unsigned totBitOffset = fBaseBitOffset + fCurBitIndex++;
+            unsigned char mask = singleBitMask[totBitOffset%8];
+            if (bit) {
+                fBaseBytePtr[totBitOffset/8] |= mask;
+            } else {
+                fBaseBytePtr[totBitOffset/8] &=~ mask;
+            }
+        }
+    }
+
+    unsigned getBits(unsigned numBits) {
+        if (numBits == 0) return 0;
+
+        unsigned char tmpBuf[4] = {0, 0, 0, 0};
+            // Note: The original left this uninitialized, but then masked off any bits that weren't read into it
+        unsigned overflowingBits = 0;
+
+        if (numBits > MAX_LENGTH) {
+            numBits = MAX_LENGTH;
+        }
+
+        if (numBits > fTotNumBits - fCurBitIndex) {
+            overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
+        }
+        if (overflowingBits == MAX_LENGTH) return 0;
+            // Note: The original shifted by 32 bits here (undefined behavior), returning uninitialized bits
+
+        originalShiftBits(tmpBuf, 0, /* to */
+                          fBaseBytePtr, fBaseBitOffset + fCurBitIndex, /* from */
+                          numBits - overflowingBits /* num bits */);
+        fCurBitIndex += numBits - overflowingBits;
+
+        unsigned result
+            = (tmpBuf[0]<<24) | (tmpBuf[1]<<16) | (tmpBuf[2]<<8) | tmpBuf[3];
+        result >>= (MAX_LENGTH - numBits); // move into low-order part of word
+        result &= (0xFFFFFFFF << overflowingBits); // so any overflow bits are 0
+        return result;
+    }
+
+    unsigned get1Bit() {
+        if (fCurBitIndex >= fTotNumBits) { /* overflow */
+            return 0;
+        } else {
+            unsigned totBitOffset = fBaseBitOffset + fCurBitIndex++;
+            unsigned char curFromByte = fBaseBytePtr[totBitOffset/8];
+            unsigned result = (curFromByte >> (7-(totBitOffset%8))) & 0x01;
+            return result;
+        }
+    }
+
+    void skipBits(unsigned numBits) {
+        if (numBits > fTotNumBits - fCurBitIndex) { /* overflow */
+            fCurBitIndex = fTotNumBits;
+        } else {
+            fCurBitIndex += numBits;
+        }
+    }
+
+    unsigned curBitIndex() const { return fCurBitIndex; }
+
+    unsigned get_expGolomb() {
+        unsigned numLeadingZeroBits = 0;
+        unsigned codeStart = 1;
+
+        while (get1Bit() == 0 && fCurBitIndex < fTotNumBits) {
+            ++numLeadingZeroBits;
+            codeStart *= 2;
+        }
+
+        return codeStart - 1 + getBits(numLeadingZeroBits);
+    }
+
+private:
+    unsigned char* fBaseBytePtr;
+    unsigned fBaseBitOffset;
+    unsigned fTotNumBits;
+    unsigned fCurBitIndex;
+};
+
+////////// Comparison //////////
+
+#define COMPARISON_BUFFER_SIZE 64
+
+// Applies the same random operation to "bv" and "originalBV"; returns False iff the results differ:
+static Boolean doRandomOperation(BitVector& bv, OriginalBitVector& originalBV) {
+    unsigned result = 0, originalResult = 0;
+    unsigned const numBits = random()%(MAX_LENGTH+1);
+    unsigned const value = (unsigned)random()^((unsigned)random()<<16);
+
+    switch (random()%6) {
+        case 0: result = bv.getBits(numBits); originalResult = originalBV.getBits(numBits); break;
+        case 1: result = bv.get1Bit(); originalResult = originalBV.get1Bit(); break;
+        case 2: result = bv.get_expGolomb(); originalResult = originalBV.get_expGolomb(); break;
+        case 3: bv.skipBits(numBits); originalBV.skipBits(numBits); break;
+        case 4: bv.putBits(value, numBits); originalBV.putBits(value, numBits); break;
+        case 5: bv.put1Bit(value&1); originalBV.put1Bit(value&1); break;
+    }
+    return result == originalResult && bv.curBitIndex() == originalBV.curBitIndex();
+}
+
+static void fillRandomly(unsigned char* buf, unsigned size) {
+    // Use runs of 0 bytes, as well as random bytes, so that we also see long exponential-Golomb codes:
+    Boolean const useZeroRuns = random()%2;
+    for (unsigned i = 0; i < size; ++i) buf[i] = useZeroRuns && random()%4 != 0 ? 0 : (unsigned char)random();
+}
+
+// Applies "numSequencesToCompare" random sequences of operations, to random data, with each implementation;
+// returns the number of sequences whose results (or resulting data) differed:
+static unsigned compareBitVectors() {
+    unsigned char buf[COMPARISON_BUFFER_SIZE], originalBuf[COMPARISON_BUFFER_SIZE];
+    unsigned numMismatches = 0;
+
+    for (unsigned i = 0; i < numSequencesToCompare; ++i) {
+        fillRandomly(buf, sizeof buf);
+        memcpy(originalBuf, buf, sizeof buf);
+        unsigned const baseBitOffset = random()%64;
+        unsigned const totNumBits = random()%(8*COMPARISON_BUFFER_SIZE - baseBitOffset + 1);
+
+        BitVector bv(buf, baseBitOffset, totNumBits);
+        OriginalBitVector originalBV(originalBuf, baseBitOffset, totNumBits);
+        Boolean sameResults = True;
+        unsigned const numOperations = 1 + random()%40;
+        for (unsigned j = 0; j < numOperations && sameResults; ++j) {
+            sameResults = doRandomOperation(bv, originalBV);
+        }
+        if (!sameResults || memcmp(buf, originalBuf, sizeof buf) != 0) ++numMismatches;
+    }
+    return numMismatches;
+}
+
+// Copies random bit ranges - including overlapping ones, with 'from' after 'to' - with each implementation;
+// returns the number of copies whose resulting data differed:
+static unsigned compareShiftBits() {
+    unsigned char buf[COMPARISON_BUFFER_SIZE], originalBuf[COMPARISON_BUFFER_SIZE];
+    unsigned numMismatches = 0;
+
+    for (unsigned i = 0; i < numSequencesToCompare; ++i) {
+        fillRandomly(buf, sizeof buf);
+        memcpy(originalBuf, buf, sizeof buf);
+        unsigned const toBitOffset = random()%(8*COMPARISON_BUFFER_SIZE);
+        unsigned const fromBitOffset = toBitOffset + random()%(8*COMPARISON_BUFFER_SIZE - toBitOffset);
+        unsigned const numBits = random()%(8*COMPARISON_BUFFER_SIZE - fromBitOffset + 1);
+
+        if (random()%2) { // copy within the buffer
+            shiftBits(buf, toBitOffset, buf, fromBitOffset, numBits);
+            originalShiftBits(originalBuf, toBitOffset, originalBuf, fromBitOffset, numBits);
+        } else { // copy from a separate buffer
+            unsigned char fromBuf[COMPARISON_BUFFER_SIZE];
+            fillRandomly(fromBuf, sizeof fromBuf);
+            shiftBits(buf, toBitOffset, fromBuf, fromBitOffset, numBits);
+            originalShiftBits(originalBuf, toBitOffset, fromBuf, fromBitOffset, numBits);
+        }
+        if (memcmp(buf, originalBuf, sizeof buf) != 0) ++numMismatches;
+    }
+    return numMismatches;
+}
+
+////////// Measurements //////////
+
+#define NUM_WIDTHS 4096
+static unsigned char widths[NUM_WIDTHS]; // random field widths (1-24 bits), that we cycle through
+static unsigned char* data;
+static unsigned dataSize;
+static unsigned char* expGolombData; // random values, encoded as exponential-Golomb codes
+static unsigned expGolombDataNumBits;
+static unsigned checksum; // of the values read, so that the reads aren't optimized away
+
+// Calls "pass()" (which returns the number of bits that it read or wrote) repeatedly, then reports the rate:
+static void measure(char const* operationName, char const* implementationName, u_int64_t (*pass)()) {
+    u_int64_t numBits = 0;
+    double const startTime = wallSeconds();
+    double elapsed;
+    do {
+        numBits += (*pass)();
+        elapsed = wallSeconds() - startTime;
+    } while (elapsed < secondsPerMeasurement);
+
+    fprintf(stdout, "%-14s %-9s %8.3f bits/ns\n", operationName, implementationName, numBits/(elapsed*1e9));
+}
+
+template <class BitVectorClass>
+static u_int64_t getBitsPass() {
+    BitVectorClass bv(data, 0, 8*dataSize);
+    u_int64_t numBits = 0;
+    for (unsigned i = 0; numBits + 24 <= 8*dataSize; i = (i+1)%NUM_WIDTHS) {
+        checksum += bv.getBits(widths[i]);
+        numBits += widths[i];
+    }
+    return numBits;
+}
+
+template <class BitVectorClass>
+static u_int64_t putBitsPass() {
+    BitVectorClass bv(data, 0, 8*dataSize);
+    u_int64_t numBits = 0;
+    for (unsigned i = 0; numBits + 24 <= 8*dataSize; i = (i+1)%NUM_WIDTHS) {
+        bv.putBits(i, widths[i]);
+        numBits += widths[i];
+    }
+    return numBits;
+}
+
+template <class BitVectorClass>
+static u_int64_t expGolombPass() {
+    BitVectorClass bv(expGolombData, 0, expGolombDataNumBits);
+    while (bv.curBitIndex() < expGolombDataNumBits) checksum += bv.get_expGolomb();
+    return expGolombDataNumBits;
+}
+
+static void usage(char const* progName) {
+    fprintf(stderr, "Usage: %s [-n <sequences-to-compare>] [-k <data-KBytes>] [-d <seconds-per-measurement>]\n", progName);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:k:d:")) != -1) {
+        switch (opt) {
+            case 'n': numSequencesToCompare = (unsigned)atoi(optarg); break;
+            case 'k': dataKBytes = (unsigned)atoi(optarg); break;
+            case 'd': secondsPerMeasurement = atof(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || dataKBytes == 0 || secondsPerMeasurement <= 0.0) usage(argv[0]);
+
+    srandom(1);
+
+    // First, check that both implementations give the same results:
+    unsigned const numBitVectorMismatches = compareBitVectors();
+    fprintf(stderr, "%s: %u of %u random sequences of operations gave different results\n",
+            numBitVectorMismatches == 0 ? "PASSED" : "FAILED", numBitVectorMismatches, numSequencesToCompare);
+    unsigned const numShiftBitsMismatches = compareShiftBits();
+    fprintf(stderr, "%s: %u of %u random bit copies gave different results\n",
+            numShiftBitsMismatches == 0 ? "PASSED" : "FAILED", numShiftBitsMismatches, numSequencesToCompare);
+
+    // Then, measure each implementation:
+    for (unsigned i = 0; i < NUM_WIDTHS; ++i) widths[i] = 1 + random()%24;
+    dataSize = 1024*dataKBytes;
+    data = new unsigned char[dataSize];
+    for (unsigned i = 0; i < dataSize; ++i) data[i] = (unsigned char)random();
+
+    // Fill "expGolombData" with codes for random values of (mostly) a few bits, as found in H.264/5 headers:
+    expGolombData = new unsigned char[dataSize];
+    BitVector ebv(expGolombData, 0, 8*dataSize);
+    while (True) {
+        unsigned const codeNum = random()%(1<<(random()%12));
+        unsigned numBits = 1;
+        while ((codeNum+1)>>numBits != 0) ++numBits;
+        if (ebv.curBitIndex() + 2*numBits - 1 > 8*dataSize) break;
+        ebv.putBits(0, numBits - 1);
+        ebv.putBits(codeNum + 1, numBits);
+    }
+    expGolombDataNumBits = ebv.curBitIndex();
+
+    fprintf(stderr, "Measuring with %u KBytes of data, for %g s per measurement\n", dataKBytes, secondsPerMeasurement);
+    measure("getBits", "original", getBitsPass<OriginalBitVector>);
+    measure("getBits", "new", getBitsPass<BitVector>);
+    measure("putBits", "original", putBitsPass<OriginalBitVector>);
+    measure("putBits", "new", putBitsPass<BitVector>);
+    measure("get_expGolomb", "original", expGolombPass<OriginalBitVector>);
+    measure("get_expGolomb", "new", expGolombPass<BitVector>);
+    fprintf(stderr, "(checksum: %08x)\n", checksum);
+
+    delete[] data; delete[] expGolombData;
+    return numBitVectorMismatches == 0 && numShiftBitsMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2018, Live Networks, Inc.  All rights reserved
+// A test of "QuickTimeFileSink"s fragmented MP4 mode: Records a H.264 video track and a PCMU audio track,
+// where the video stops (without ending) part way through, and checks that fragments continue to be
+// written - from the audio alone - rather than the audio being buffered until the end.
+// Exits with status 0 iff the test passed.
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include <stdlib.h>
+
+// Parameters:
+static unsigned const fragmentDuration = 1; // seconds
+static unsigned const videoDuration = 2; // seconds (after which the video stops)
+static unsigned const audioDuration = 10; // seconds
+static unsigned const speedup = 10; // we deliver frames this much faster than real time
+static char const* outputFileName = "FragmentedMP4Test.mp4";
+
+static char const* sdpDescription =
+    "v=0\r\n"
+    "o=- 0 0 IN IP4 127.0.0.1\r\n"
+    "s=FragmentedMP4Test\r\n"
+    "t=0 0\r\n"
+    "m=video 0 RTP/AVP 96\r\n"
+    "c=IN IP4 127.0.0.1\r\n"
+    "a=rtpmap:96 H264/90000\r\n"
+    "a=fmtp:96 packetization-mode=1;sprop-parameter-sets=Z0IAHpWoKA9puAgICBA=,aM48gA==\r\n"
+    "m=audio 0 RTP/AVP 0\r\n"
+    "c=IN IP4 127.0.0.1\r\n";
+
+static struct timeval streamStartTime;
+static struct timeval videoEndTime; // the presentation time just after the last video frame
+static char testIsDone = 0;
+
+// A filter that ignores its (RTP) input source, and instead delivers synthetic frames:
+class TestFrameSource: public FramedFilter {
+public:
+    static TestFrameSource* createNew(UsageEnvironment& env, FramedSource* inputSource, Boolean isVideo) {
+        return new TestFrameSource(env, inputSource, isVideo);
+    }
+
+protected:
+    TestFrameSource(UsageEnvironment& env, FramedSource* inputSource, Boolean isVideo)
+        : FramedFilter(env, inputSource), fIsVideo(isVideo), fFrameNum(0) {
+        fNumFrames = isVideo ? videoDuration*30 : audioDuration*50;
+        fFrameUSeconds = isVideo ? 1000000/30 : 20000;
+    }
+
+private: // redefined virtual functions
+    virtual void doGetNextFrame();
+    virtual void doStopGettingFrames();
+
+private:
+    static void deliverFrame(void* clientData);
+
+private:
+    Boolean fIsVideo;
+    unsigned fFrameNum, fNumFrames, fFrameUSeconds;
+};
+
+void TestFrameSource::doGetNextFrame() {
+    if (fFrameNum >= fNumFrames) {
+        if (fIsVideo) return; // the video stalls (but doesn't end)
+
+        testIsDone = 1;
+        return;
+    }
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(fFrameUSeconds/speedup, deliverFrame, this);
+}
+
+void TestFrameSource::doStopGettingFrames() {
+    envir().taskScheduler().unscheduleDelayedTask(nextTask());
+}
+
+void TestFrameSource::deliverFrame(void* clientData) {
+    TestFrameSource* source = (TestFrameSource*)clientData;
+
+    unsigned const frameSize = source->fIsVideo ? 5000 : 160;
+    source->fFrameSize = frameSize < source->fMaxSize ? frameSize : source->fMaxSize;
+    source->fNumTruncatedBytes = frameSize - source->fFrameSize;
+    memset(source->fTo, 0, source->fFrameSize);
+    if (source->fIsVideo && source->fFrameSize > 0) {
+        // A IDR NAL unit once per second; otherwise a non-IDR slice:
+        source->fTo[0] = source->fFrameNum%30 == 0 ? 0x65 : 0x41;
+    }
+
+    unsigned const uSecondsFromStart = source->fFrameNum*source->fFrameUSeconds;
+    source->fPresentationTime.tv_sec = streamStartTime.tv_sec + uSecondsFromStart/1000000;
+    source->fPresentationTime.tv_usec = uSecondsFromStart%1000000;
+    source->fDurationInMicroseconds = source->fFrameUSeconds;
+    ++source->fFrameNum;
+    FramedSource::afterGetting(source);
+}
+
+// A sink that notes when each fragment is completed:
+class TestFileSink: public QuickTimeFileSink {
+public:
+    static TestFileSink* createNew(UsageEnvironment& env, MediaSession& inputSession) {
+        return new TestFileSink(env, inputSession);
+    }
+
+    unsigned numFragmentsAfterVideoEnded;
+
+protected:
+    TestFileSink(UsageEnvironment& env, MediaSession& inputSession)
+        : QuickTimeFileSink(env, inputSession, outputFileName, 100000, 320, 240, 30,
+                            False, False, False, True, fragmentDuration),
+          numFragmentsAfterVideoEnded(0) {}
+
+private: // redefined virtual functions
+    virtual void noteRecordedFrame(MediaSubsession& /*inputSubsession*/,
+                                   unsigned /*packetDataSize*/, struct timeval const& presentationTime) {
+        fNewestPresentationTime = presentationTime;
+    }
+    virtual void noteCompletedFragment(int64_t /*fileOffset*/, unsigned /*fragmentSize*/,
+                                       Boolean isInitializationSegment) {
+        if (isInitializationSegment) return;
+
+        // Note: A fragment is completed just before the first frame of the next fragment gets recorded:
+        if (fNewestPresentationTime.tv_sec > videoEndTime.tv_sec
+            || (fNewestPresentationTime.tv_sec == videoEndTime.tv_sec
+                && fNewestPresentationTime.tv_usec > videoEndTime.tv_usec)) {
+            ++numFragmentsAfterVideoEnded;
+        }
+    }
+
+private:
+    struct timeval fNewestPresentationTime;
+};
+
+int main(int /*argc*/, char** /*argv*/) {
+    TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+    UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+    streamStartTime.tv_sec = 1000000000; streamStartTime.tv_usec = 0;
+    videoEndTime.tv_sec = streamStartTime.tv_sec + videoDuration; videoEndTime.tv_usec = 0;
+
+    MediaSession* session = MediaSession::createNew(*env, sdpDescription);
+    if (session == NULL) {
+        *env << "Failed to create a MediaSession: " << env->getResultMsg() << "\n";
+        return 1;
+    }
+    MediaSubsessionIterator iter(*session);
+    MediaSubsession* subsession;
+    while ((subsession = iter.next()) != NULL) {
+        if (!subsession->initiate()) {
+            *env << "Failed to initiate the \"" << subsession->mediumName() << "\" subsession: "
+                 << env->getResultMsg() << "\n";
+            return 1;
+        }
+        subsession->addFilter(TestFrameSource::createNew(*env, subsession->readSource(),
+                                                         strcmp(subsession->mediumName(), "video") == 0));
+    }
+
+    TestFileSink* sink = TestFileSink::createNew(*env, *session);
+    sink->startPlaying(NULL, NULL);
+    env->taskScheduler().doEventLoop(&testIsDone);
+
+    // With the video stopped, the audio alone should end a fragment every "2*fragmentDuration" seconds:
+    unsigned const numFragmentsExpected = (audioDuration - videoDuration)/(2*fragmentDuration) - 1;
+    unsigned const numFragments = sink->numFragmentsAfterVideoEnded;
+    Boolean const passed = numFragments >= numFragmentsExpected;
+    fprintf(stderr, "%s: %u fragments were written after the video stopped (expected at least %u)\n",
+            passed ? "PASSED" : "FAILED", numFragments, numFragmentsExpected);
+
+    Medium::close(sink);
+    Medium::close(session);
+    remove(outputFileName);
+    env->reclaim();
+    delete scheduler;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2018, Live Networks, Inc.  All rights reserved
+// An MP3 Huffman decoding benchmark: First checks that "MP3HuffmanDecode()" gives the same results as the
+// reference (bit-at-a-time) decoder, for random granules and for the ADU transcoding of random ADUs.
+// Then measures (for each decoder) the granules/s decoded, and the ADU frames/s transcoded to a lower bitrate
+// (as done by "MP3Transcoder").
+// Exits with status 0 iff the decoders' results were identical.
+
+#include "liveMedia.hh"
+#include "MP3InternalsHuffman.hh"
+#include <stdlib.h>
+#include <unistd.h>
+
+// Parameters (set from the command line):
+static unsigned numGranulesToCompare = 200000;
+static unsigned numADUsToCompare = 20000;
+static double secondsPerMeasurement = 1.0;
+static unsigned toBitrate = 64; // kbps
+
+static double wallSeconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec + tv.tv_usec/1e6;
+}
+
+////////// Granules //////////
+
+#define GRANULE_DATA_SIZE 1200
+
+// A random granule: its side info, and its (random) 'main data':
+struct Granule {
+    MP3SideInfo::gr_info_s_t gr;
+    Boolean isMPEG2;
+    unsigned char data[GRANULE_DATA_SIZE];
+    unsigned bitOffset, numBits;
+};
+
+static void makeRandomGranule(Granule& g) {
+    memset(&g.gr, 0, sizeof g.gr);
+    g.gr.scfsi = random()%3 - 1;
+    g.gr.scalefac_compress = random()%16;
+    g.gr.block_type = random()%4;
+    g.gr.mixed_block_flag = random()%2;
+    g.gr.big_values = random()%289;
+    g.gr.region1start = random()%100;
+    g.gr.region2start = g.gr.region1start + random()%100;
+    for (unsigned i = 0; i < 3; ++i) g.gr.table_select[i] = random()%32;
+    g.gr.count1table_select = random()%2;
+    g.isMPEG2 = random()%2;
+
+    for (unsigned i = 0; i < GRANULE_DATA_SIZE; ++i) g.data[i] = (unsigned char)random();
+    g.bitOffset = random()%64;
+    g.numBits = random()%(8*GRANULE_DATA_SIZE - 64);
+}
+
+// The result of decoding a granule:
+struct DecodedGranule {
+    DecodedGranule() : hei(True) {}
+
+    MP3SideInfo::gr_info_s_t gr; // as updated by the decoder
+    unsigned scaleFactorsLength;
+    MP3HuffmanEncodingInfo hei;
+};
+
+static void decodeGranule(Granule const& g, DecodedGranule& result) {
+    result.gr = g.gr;
+    MP3HuffmanDecode(&result.gr, g.isMPEG2, g.data, g.bitOffset, g.numBits, result.scaleFactorsLength, result.hei);
+}
+
+static Boolean decodedGranulesAreEqual(DecodedGranule const& a, DecodedGranule const& b) {
+    if (a.gr.big_values != b.gr.big_values || a.scaleFactorsLength != b.scaleFactorsLength
+        || a.hei.numSamples != b.hei.numSamples || a.hei.reg1Start != b.hei.reg1Start
+        || a.hei.reg2Start != b.hei.reg2Start || a.hei.bigvalStart != b.hei.bigvalStart) {
+        return False;
+    }
+    unsigned const numSamples = a.hei.numSamples;
+    return memcmp(a.hei.allBitOffsets, b.hei.allBitOffsets, (numSamples+1)*sizeof (unsigned)) == 0
+        && memcmp(a.hei.decodedValues, b.hei.decodedValues, 4*numSamples*sizeof (unsigned)) == 0;
+}
+
+////////// ADUs //////////
+
+#define SIDE_INFO_SIZE 32 // for MPEG-1, stereo
+#define MAX_PART23_LENGTH 700 // bits, for each granule and channel
+
+// A random ADU: A MPEG-1 Layer III (stereo, 128 kbps, 44.1 kHz) header, random side info, and random 'main data'.
+// (Note: Because the 'main data' is random, it decodes to arbitrary (but valid) Huffman codes.)
+struct ADU {
+    unsigned char bytes[4 + SIDE_INFO_SIZE + (4*MAX_PART23_LENGTH+7)/8];
+    unsigned size;
+};
+
+static void makeRandomADU(ADU& adu) {
+    unsigned char* ptr = adu.bytes;
+    *ptr++ = 0xFF; *ptr++ = 0xFB; *ptr++ = 0x90; *ptr++ = 0x00;
+
+    BitVector bv(ptr, 0, 8*SIDE_INFO_SIZE);
+    bv.putBits(0, 9); // main_data_begin (i.e., the backpointer)
+    bv.putBits(0, 3); // private_bits
+    bv.putBits(random(), 8); // scfsi (for each channel)
+    unsigned totPart23Length = 0;
+    for (unsigned i = 0; i < 4; ++i) { // for each granule and channel
+        unsigned const part23Length = random()%(MAX_PART23_LENGTH+1);
+        totPart23Length += part23Length;
+        bv.putBits(part23Length, 12);
+        bv.putBits(random()%289, 9); // big_values
+        bv.putBits(random(), 8); // global_gain
+        bv.putBits(random(), 4); // scalefac_compress
+        if (random()%2) {
+            bv.put1Bit(1); // window_switching_flag
+            bv.putBits(1 + random()%3, 2); // block_type
+            bv.putBits(random(), 1); // mixed_block_flag
+            bv.putBits(random(), 10); // table_select[0..1]
+            bv.putBits(random(), 9); // subblock_gain[0..2]
+        } else {
+            bv.put1Bit(0); // window_switching_flag
+            bv.putBits(random(), 15); // table_select[0..2]
+            bv.putBits(random(), 7); // region0_count, region1_count
+        }
+        bv.putBits(random(), 3); // preflag, scalefac_scale, count1table_select
+    }
+    ptr += SIDE_INFO_SIZE;
+
+    unsigned const mainDataSize = (totPart23Length+7)/8;
+    for (unsigned i = 0; i < mainDataSize; ++i) *ptr++ = (unsigned char)random();
+    adu.size = ptr - adu.bytes;
+}
+
+// The result of transcoding an ADU:
+struct TranscodedADU {
+    unsigned char bytes[MAX_MP3_FRAME_SIZE];
+    unsigned size;
+};
+
+static void transcodeADU(ADU const& adu, TranscodedADU& result, unsigned& availableBytesForBackpointer) {
+    result.size = TranscodeMP3ADU(adu.bytes, adu.size, toBitrate, result.bytes, sizeof result.bytes,
+                                  availableBytesForBackpointer);
+}
+
+////////// Tests and measurements //////////
+
+static Granule* granules;
+static ADU* adus;
+#define NUM_BENCHMARK_ITEMS 1000 // the number of (pre-generated) granules and ADUs that we cycle through
+
+// Decodes "numGranulesToCompare" random granules with each decoder; returns the number of mismatches:
+static unsigned compareGranules() {
+    Granule g;
+    DecodedGranule fromReference, fromFast;
+    unsigned numMismatches = 0;
+
+    for (unsigned i = 0; i < numGranulesToCompare; ++i) {
+        makeRandomGranule(g);
+        setMP3HuffmanReferenceDecoding(True);
+        decodeGranule(g, fromReference);
+        setMP3HuffmanReferenceDecoding(False);
+        decodeGranule(g, fromFast);
+        if (!decodedGranulesAreEqual(fromReference, fromFast)) ++numMismatches;
+    }
+    return numMismatches;
+}
+
+// Transcodes "numADUsToCompare" random ADUs with each decoder; returns the number of mismatches:
+static unsigned compareADUs() {
+    ADU adu;
+    TranscodedADU fromReference, fromFast;
+    unsigned referenceBytesForBackpointer = 0, fastBytesForBackpointer = 0;
+    unsigned numMismatches = 0;
+
+    for (unsigned i = 0; i < numADUsToCompare; ++i) {
+        makeRandomADU(adu);
+        setMP3HuffmanReferenceDecoding(True);
+        transcodeADU(adu, fromReference, referenceBytesForBackpointer);
+        setMP3HuffmanReferenceDecoding(False);
+        transcodeADU(adu, fromFast, fastBytesForBackpointer);
+        if (fromReference.size == 0 || fromReference.size != fromFast.size
+            || memcmp(fromReference.bytes, fromFast.bytes, fromReference.size) != 0
+            || referenceBytesForBackpointer != fastBytesForBackpointer) {
+            ++numMismatches;
+        }
+    }
+    return numMismatches;
+}
+
+static void measureGranuleDecoding(char const* decoderName) {
+    DecodedGranule result;
+    unsigned long numGranules = 0;
+    double const startTime = wallSeconds();
+    double elapsed;
+    do {
+        for (unsigned i = 0; i < NUM_BENCHMARK_ITEMS; ++i) decodeGranule(granules[i], result);
+        numGranules += NUM_BENCHMARK_ITEMS;
+        elapsed = wallSeconds() - startTime;
+    } while (elapsed < secondsPerMeasurement);
+
+    fprintf(stdout, "%-10s decoding:    %10.1f kgranules/s\n", decoderName, numGranules/elapsed/1e3);
+}
+
+static void measureADUTranscoding(char const* decoderName) {
+    TranscodedADU result;
+    unsigned availableBytesForBackpointer = 0;
+    unsigned long numADUs = 0;
+    double const startTime = wallSeconds();
+    double elapsed;
+    do {
+        for (unsigned i = 0; i < NUM_BENCHMARK_ITEMS; ++i) transcodeADU(adus[i], result, availableBytesForBackpointer);
+        numADUs += NUM_BENCHMARK_ITEMS;
+        elapsed = wallSeconds() - startTime;
+    } while (elapsed < secondsPerMeasurement);
+
+    fprintf(stdout, "%-10s transcoding: %10.1f kframes/s\n", decoderName, numADUs/elapsed/1e3);
+}
+
+static void usage(char const* progName) {
+    fprintf(stderr, "Usage: %s [-g <granules-to-compare>] [-a <ADUs-to-compare>] [-b <output-bitrate-kbps>] [-d <seconds-per-measurement>]\n", progName);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "g:a:b:d:")) != -1) {
+        switch (opt) {
+            case 'g': numGranulesToCompare = (unsigned)atoi(optarg); break;
+            case 'a': numADUsToCompare = (unsigned)atoi(optarg); break;
+            case 'b': toBitrate = (unsigned)atoi(optarg); break;
+            case 'd': secondsPerMeasurement = atof(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || toBitrate == 0 || secondsPerMeasurement <= 0.0) usage(argv[0]);
+
+    srandom(1);
+
+    // First, check that both decoders give the same results:
+    unsigned const numGranuleMismatches = compareGranules();
+    fprintf(stderr, "%s: %u of %u random granules decoded differently\n",
+            numGranuleMismatches == 0 ? "PASSED" : "FAILED", numGranuleMismatches, numGranulesToCompare);
+    unsigned const numADUMismatches = compareADUs();
+    fprintf(stderr, "%s: %u of %u random ADUs transcoded (to %u kbps) differently\n",
+            numADUMismatches == 0 ? "PASSED" : "FAILED", numADUMismatches, numADUsToCompare, toBitrate);
+
+    // Then, measure each decoder:
+    granules = new Granule[NUM_BENCHMARK_ITEMS];
+    adus = new ADU[NUM_BENCHMARK_ITEMS];
+    for (unsigned i = 0; i < NUM_BENCHMARK_ITEMS; ++i) {
+        makeRandomGranule(granules[i]);
+        makeRandomADU(adus[i]);
+    }
+
+    setMP3HuffmanReferenceDecoding(True);
+    measureGranuleDecoding("reference");
+    measureADUTranscoding("reference");
+    setMP3HuffmanReferenceDecoding(False);
+    measureGranuleDecoding("fast");
+    measureADUTranscoding("fast");
+
+    delete[] granules; delete[] adus;
+    return numGranuleMismatches == 0 && numADUMismatches == 0 ? 0 : 1;
+}
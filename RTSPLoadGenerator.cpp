@@ -0,0 +1,457 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2018, Live Networks, Inc.  All rights reserved
+// A RTSP load generator: Opens many concurrent sessions on a RTSP server (from several event loops,
+// each running in its own thread, with its own "UsageEnvironment"), and reports percentiles of
+// setup latency, first-frame latency, packet loss, and jitter.
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Parameters (set from the command line):
+static char const* rtspURL = NULL;
+static unsigned numSessions = 100;
+static unsigned numThreads = 1;
+static double rampRate = 50.0; // sessions started per second (over all threads)
+static unsigned sessionDuration = 10; // seconds of streaming per session
+static Boolean streamUsingTCP = False;
+static int verbosityLevel = 0;
+
+// Results for a single session:
+class SessionResult {
+public:
+    SessionResult();
+
+public:
+    Boolean setupSucceeded, gotFirstFrame;
+    double setupLatency; // ms, from sending "DESCRIBE" until the "PLAY" response
+    double firstFrameLatency; // ms, from sending "DESCRIBE" until the first frame arrives
+    unsigned numPacketsExpected, numPacketsReceived;
+    double jitter; // ms (the largest over all of the session's subsessions)
+};
+
+SessionResult::SessionResult()
+    : setupSucceeded(False), gotFirstFrame(False), setupLatency(0.0), firstFrameLatency(0.0),
+      numPacketsExpected(0), numPacketsReceived(0), jitter(0.0) {
+}
+
+// The state of one event loop (thread):
+class LoadThread {
+public:
+    LoadThread();
+
+public:
+    pthread_t thread;
+    UsageEnvironment* env;
+    unsigned index;
+    unsigned firstSessionIndex, numSessions;
+    unsigned numSessionsStarted, numSessionsActive;
+    char watchVariable;
+};
+
+LoadThread::LoadThread()
+    : env(NULL), index(0), firstSessionIndex(0), numSessions(0), numSessionsStarted(0), numSessionsActive(0), watchVariable(0) {
+}
+
+static SessionResult* results = NULL; // one per session; each is written only by its own thread
+
+class loadRTSPClient: public RTSPClient {
+public:
+    static loadRTSPClient* createNew(LoadThread& thread, unsigned sessionIndex);
+
+protected:
+    loadRTSPClient(LoadThread& thread, unsigned sessionIndex);
+    virtual ~loadRTSPClient();
+
+public:
+    LoadThread& fThread;
+    SessionResult& fResult;
+    struct timeval fStartTime;
+    MediaSession* fSession;
+    MediaSubsessionIterator* fIter;
+    MediaSubsession* fSubsession;
+    TaskToken fStreamTimerTask;
+};
+
+class LoadSink: public MediaSink {
+public:
+    static LoadSink* createNew(UsageEnvironment& env, loadRTSPClient& client);
+
+private:
+    LoadSink(UsageEnvironment& env, loadRTSPClient& client);
+    virtual ~LoadSink();
+
+    static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+				  struct timeval presentationTime, unsigned durationInMicroseconds);
+
+private:
+    virtual Boolean continuePlaying();
+
+private:
+    u_int8_t* fReceiveBuffer;
+    loadRTSPClient& fClient;
+};
+
+void continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString);
+void continueAfterSETUP(RTSPClient* rtspClient, int resultCode, char* resultString);
+void continueAfterPLAY(RTSPClient* rtspClient, int resultCode, char* resultString);
+void setupNextSubsession(loadRTSPClient* client);
+void streamTimerHandler(void* clientData);
+void subsessionAfterPlaying(void* clientData);
+void shutdownSession(loadRTSPClient* client);
+void startNextSession(void* clientData);
+
+static double msSince(struct timeval const& startTime) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (now.tv_sec - startTime.tv_sec)*1000.0 + (now.tv_usec - startTime.tv_usec)/1000.0;
+}
+
+void startNextSession(void* clientData) {
+    LoadThread* thread = (LoadThread*)clientData;
+
+    if (thread->numSessionsStarted < thread->numSessions) {
+        loadRTSPClient* client = loadRTSPClient::createNew(*thread, thread->firstSessionIndex + thread->numSessionsStarted);
+        ++thread->numSessionsStarted;
+        if (client != NULL) {
+            ++thread->numSessionsActive;
+            client->sendDescribeCommand(continueAfterDESCRIBE);
+        }
+    }
+
+    if (thread->numSessionsStarted < thread->numSessions) {
+        // Each thread starts its sessions at (its share of) the ramp rate:
+        unsigned uSecsToDelay = (unsigned)((numThreads*1000000.0)/rampRate);
+        thread->env->taskScheduler().scheduleDelayedTask(uSecsToDelay, startNextSession, thread);
+    } else if (thread->numSessionsActive == 0) {
+        thread->watchVariable = 1;
+    }
+}
+
+void continueAfterDESCRIBE(RTSPClient* rtspClient, int resultCode, char* resultString) {
+    loadRTSPClient* client = (loadRTSPClient*)rtspClient;
+
+    do {
+        if (resultCode != 0) break;
+
+        client->fSession = MediaSession::createNew(client->envir(), resultString);
+        if (client->fSession == NULL || !client->fSession->hasSubsessions()) break;
+
+        delete[] resultString;
+        client->fIter = new MediaSubsessionIterator(*client->fSession);
+        setupNextSubsession(client);
+        return;
+    } while (0);
+
+    delete[] resultString;
+    shutdownSession(client);
+}
+
+void setupNextSubsession(loadRTSPClient* client) {
+    client->fSubsession = client->fIter->next();
+    if (client->fSubsession != NULL) {
+        if (!client->fSubsession->initiate()) {
+            setupNextSubsession(client);
+        } else {
+            client->sendSetupCommand(*client->fSubsession, continueAfterSETUP, False, streamUsingTCP);
+        }
+        return;
+    }
+
+    client->sendPlayCommand(*client->fSession, continueAfterPLAY);
+}
+
+void continueAfterSETUP(RTSPClient* rtspClient, int resultCode, char* resultString) {
+    loadRTSPClient* client = (loadRTSPClient*)rtspClient;
+    MediaSubsession* subsession = client->fSubsession;
+
+    if (resultCode == 0) {
+        subsession->sink = LoadSink::createNew(client->envir(), *client);
+        if (subsession->sink != NULL) {
+            subsession->miscPtr = client;
+            subsession->sink->startPlaying(*(subsession->readSource()), subsessionAfterPlaying, subsession);
+        }
+    }
+    delete[] resultString;
+
+    setupNextSubsession(client);
+}
+
+void continueAfterPLAY(RTSPClient* rtspClient, int resultCode, char* resultString) {
+    loadRTSPClient* client = (loadRTSPClient*)rtspClient;
+    delete[] resultString;
+
+    if (resultCode != 0) {
+        shutdownSession(client);
+        return;
+    }
+
+    client->fResult.setupSucceeded = True;
+    client->fResult.setupLatency = msSince(client->fStartTime);
+    client->fStreamTimerTask
+        = client->envir().taskScheduler().scheduleDelayedTask(sessionDuration*1000000, streamTimerHandler, client);
+}
+
+void streamTimerHandler(void* clientData) {
+    loadRTSPClient* client = (loadRTSPClient*)clientData;
+
+    client->fStreamTimerTask = NULL;
+    shutdownSession(client);
+}
+
+void subsessionAfterPlaying(void* clientData) {
+    MediaSubsession* subsession = (MediaSubsession*)clientData;
+    loadRTSPClient* client = (loadRTSPClient*)(subsession->miscPtr);
+
+    Medium::close(subsession->sink);
+    subsession->sink = NULL;
+
+    MediaSubsessionIterator iter(subsession->parentSession());
+    while ((subsession = iter.next()) != NULL) {
+        if (subsession->sink != NULL) return;
+    }
+
+    shutdownSession(client);
+}
+
+void shutdownSession(loadRTSPClient* client) {
+    LoadThread& thread = client->fThread;
+    SessionResult& result = client->fResult;
+
+    if (client->fSession != NULL) {
+        Boolean someSubsessionsWereActive = False;
+        MediaSubsessionIterator iter(*client->fSession);
+        MediaSubsession* subsession;
+
+        while ((subsession = iter.next()) != NULL) {
+            // Record this subsession's reception statistics:
+            RTPSource* rtpSource = subsession->rtpSource();
+            if (rtpSource != NULL) {
+                RTPReceptionStatsDB::Iterator statsIter(rtpSource->receptionStatsDB());
+                RTPReceptionStats* stats;
+                while ((stats = statsIter.next(True)) != NULL) {
+                    result.numPacketsExpected += stats->totNumPacketsExpected();
+                    result.numPacketsReceived += stats->totNumPacketsReceived();
+                    if (rtpSource->timestampFrequency() > 0) {
+                        double jitter = (stats->jitter()*1000.0)/rtpSource->timestampFrequency();
+                        if (jitter > result.jitter) result.jitter = jitter;
+                    }
+                }
+            }
+
+            if (subsession->sink != NULL) {
+                Medium::close(subsession->sink);
+                subsession->sink = NULL;
+                someSubsessionsWereActive = True;
+            }
+        }
+
+        if (someSubsessionsWereActive) client->sendTeardownCommand(*client->fSession, NULL);
+    }
+
+    Medium::close(client);
+
+    if (--thread.numSessionsActive == 0 && thread.numSessionsStarted == thread.numSessions) {
+        thread.watchVariable = 1;
+    }
+}
+
+loadRTSPClient* loadRTSPClient::createNew(LoadThread& thread, unsigned sessionIndex) {
+    return new loadRTSPClient(thread, sessionIndex);
+}
+
+loadRTSPClient::loadRTSPClient(LoadThread& thread, unsigned sessionIndex)
+    : RTSPClient(*thread.env, rtspURL, verbosityLevel, "RTSPLoadGenerator", 0, -1),
+      fThread(thread), fResult(results[sessionIndex]),
+      fSession(NULL), fIter(NULL), fSubsession(NULL), fStreamTimerTask(NULL) {
+    gettimeofday(&fStartTime, NULL);
+}
+
+loadRTSPClient::~loadRTSPClient() {
+    delete fIter;
+    envir().taskScheduler().unscheduleDelayedTask(fStreamTimerTask);
+    Medium::close(fSession);
+}
+
+#define LOAD_SINK_RECEIVE_BUFFER_SIZE 100000
+
+LoadSink* LoadSink::createNew(UsageEnvironment& env, loadRTSPClient& client) {
+    return new LoadSink(env, client);
+}
+
+LoadSink::LoadSink(UsageEnvironment& env, loadRTSPClient& client)
+    : MediaSink(env), fClient(client) {
+    fReceiveBuffer = new u_int8_t[LOAD_SINK_RECEIVE_BUFFER_SIZE];
+}
+
+LoadSink::~LoadSink() {
+    delete[] fReceiveBuffer;
+}
+
+void LoadSink::afterGettingFrame(void* clientData, unsigned /*frameSize*/, unsigned /*numTruncatedBytes*/,
+				 struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/) {
+    LoadSink* sink = (LoadSink*)clientData;
+    SessionResult& result = sink->fClient.fResult;
+
+    if (!result.gotFirstFrame) {
+        result.gotFirstFrame = True;
+        result.firstFrameLatency = msSince(sink->fClient.fStartTime);
+    }
+
+    sink->continuePlaying();
+}
+
+Boolean LoadSink::continuePlaying() {
+    if (fSource == NULL) return False;
+
+    fSource->getNextFrame(fReceiveBuffer, LOAD_SINK_RECEIVE_BUFFER_SIZE, afterGettingFrame, this, onSourceClosure, this);
+    return True;
+}
+
+static void* runLoadThread(void* arg) {
+    LoadThread* thread = (LoadThread*)arg;
+
+    TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+    thread->env = BasicUsageEnvironment::createNew(*scheduler);
+
+    if (thread->numSessions > 0) {
+        // Stagger the threads' first sessions, so that the overall start rate is "rampRate":
+        thread->env->taskScheduler().scheduleDelayedTask((unsigned)((thread->index*1000000.0)/rampRate),
+							  startNextSession, thread);
+        thread->env->taskScheduler().doEventLoop(&thread->watchVariable);
+    }
+
+    thread->env->reclaim();
+    delete scheduler;
+    return NULL;
+}
+
+// Reporting:
+
+static int compareDoubles(void const* a, void const* b) {
+    double x = *(double const*)a, y = *(double const*)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void reportPercentiles(char const* label, char const* units, double* values, unsigned numValues) {
+    if (numValues == 0) {
+        fprintf(stdout, "%-20s (no samples)\n", label);
+        return;
+    }
+
+    qsort(values, numValues, sizeof values[0], compareDoubles);
+
+    double const percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+    fprintf(stdout, "%-20s n=%-6u min %9.3f", label, numValues, values[0]);
+    for (unsigned i = 0; i < sizeof percentiles/sizeof percentiles[0]; ++i) {
+        unsigned index = (unsigned)((percentiles[i]*(numValues-1))/100.0 + 0.5);
+        fprintf(stdout, "  p%g %9.3f", percentiles[i], values[index]);
+    }
+    fprintf(stdout, "  max %9.3f %s\n", values[numValues-1], units);
+}
+
+static void reportResults() {
+    double* values = new double[numSessions];
+    unsigned numSetupSucceeded = 0, numGotFirstFrame = 0;
+    unsigned long long totExpected = 0, totReceived = 0;
+    unsigned n, i;
+
+    for (n = 0, i = 0; i < numSessions; ++i) {
+        if (results[i].setupSucceeded) values[n++] = results[i].setupLatency;
+    }
+    numSetupSucceeded = n;
+    reportPercentiles("setup latency", "ms", values, n);
+
+    for (n = 0, i = 0; i < numSessions; ++i) {
+        if (results[i].gotFirstFrame) values[n++] = results[i].firstFrameLatency;
+    }
+    numGotFirstFrame = n;
+    reportPercentiles("first-frame latency", "ms", values, n);
+
+    for (n = 0, i = 0; i < numSessions; ++i) {
+        if (results[i].numPacketsExpected > 0) {
+            unsigned numLost = results[i].numPacketsExpected > results[i].numPacketsReceived
+                ? results[i].numPacketsExpected - results[i].numPacketsReceived : 0;
+            values[n++] = (100.0*numLost)/results[i].numPacketsExpected;
+            totExpected += results[i].numPacketsExpected;
+            totReceived += results[i].numPacketsReceived;
+        }
+    }
+    reportPercentiles("packet loss", "%", values, n);
+
+    for (n = 0, i = 0; i < numSessions; ++i) {
+        if (results[i].numPacketsReceived > 0) values[n++] = results[i].jitter;
+    }
+    reportPercentiles("jitter", "ms", values, n);
+
+    fprintf(stdout, "%u sessions: %u set up, %u received data; %llu of %llu expected packets received\n",
+            numSessions, numSetupSucceeded, numGotFirstFrame, totReceived, totExpected);
+    delete[] values;
+}
+
+static void usage(char const* progName) {
+    fprintf(stderr, "Usage: %s [-n <num-sessions>] [-j <num-threads>] [-r <sessions-per-second>] [-d <seconds-per-session>] [-t] [-v] <rtsp-url>\n", progName);
+    fprintf(stderr, "\t-t: request RTP-over-TCP (rather than RTP-over-UDP)\n");
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:r:d:tv")) != -1) {
+        switch (opt) {
+            case 'n': numSessions = (unsigned)atoi(optarg); break;
+            case 'j': numThreads = (unsigned)atoi(optarg); break;
+            case 'r': rampRate = atof(optarg); break;
+            case 'd': sessionDuration = (unsigned)atoi(optarg); break;
+            case 't': streamUsingTCP = True; break;
+            case 'v': ++verbosityLevel; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc-1 || numSessions == 0 || numThreads == 0 || rampRate <= 0.0) usage(argv[0]);
+    rtspURL = argv[optind];
+    if (numThreads > numSessions) numThreads = numSessions;
+
+    results = new SessionResult[numSessions];
+
+    // Give each thread a contiguous range of sessions (and thus result slots):
+    LoadThread* threads = new LoadThread[numThreads];
+    unsigned nextSessionIndex = 0;
+    for (unsigned i = 0; i < numThreads; ++i) {
+        threads[i].index = i;
+        threads[i].firstSessionIndex = nextSessionIndex;
+        threads[i].numSessions = numSessions/numThreads + (i < numSessions%numThreads ? 1 : 0);
+        nextSessionIndex += threads[i].numSessions;
+    }
+
+    fprintf(stderr, "Starting %u sessions (%s) on %u event loop(s), at %g sessions/s, each streaming for %u s\n",
+            numSessions, streamUsingTCP ? "RTP-over-TCP" : "RTP-over-UDP", numThreads, rampRate, sessionDuration);
+    for (unsigned i = 0; i < numThreads; ++i) {
+        pthread_create(&threads[i].thread, NULL, runLoadThread, &threads[i]);
+    }
+    for (unsigned i = 0; i < numThreads; ++i) {
+        pthread_join(threads[i].thread, NULL);
+    }
+
+    reportResults();
+
+    delete[] threads;
+    delete[] results;
+    return 0;
+}
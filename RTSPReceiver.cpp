@@ -31,6 +31,7 @@ void openURL(UsageEnvironment& env, char const* progName, char const* rtspURL);
 void setupNextSubsession(RTSPClient* rtspClient);
 
 void shutdownStream(RTSPClient* rtspClient, int exitCode = 1);
+void printReorderingStats(MediaSubsession& subsession);
 
 char eventLoopWatchVariable = 0;
 
@@ -154,6 +155,14 @@ void setupNextSubsession(RTSPClient* rtspClient) {
         if(!scs.subsession->initiate()) {
             setupNextSubsession(rtspClient);
         } else {
+            if(scs.subsession->rtpSource() != NULL) {
+                // Wait for reordered packets only as long as the network's jitter and reordering require:
+                scs.subsession->rtpSource()->setAdaptivePacketReorderingThresholdTime(2000, 250000);
+                if(scs.subsession->serverSupportsNACK()) {
+                    // Ask for lost packets to be resent, rather than waiting for the next key frame:
+                    scs.subsession->rtpSource()->enableRetransmissionRequests(scs.subsession->rtcpInstance(), scs.subsession->rtxPayloadFormat());
+                }
+            }
             rtspClient->sendSetupCommand(*scs.subsession, continueAfterSETUP, False, false);
         }
         return;
@@ -248,6 +257,36 @@ void streamTimerHandler(void* clientData) {
     shutdownStream(rtspClient);
 }
 
+void printReorderingStats(MediaSubsession& subsession) {
+    if(subsession.rtpSource() == NULL || !subsession.rtpSource()->isMultiFramedRTPSource())
+        return; // only "MultiFramedRTPSource"s keep these statistics
+    MultiFramedRTPSource* rtpSource = (MultiFramedRTPSource*)subsession.rtpSource();
+    UsageEnvironment& env = rtpSource->envir();
+    unsigned const* histogram = rtpSource->addedDelayHistogram();
+
+    env << subsession.mediumName() << "/" << subsession.codecName()
+        << ": reordering threshold " << rtpSource->packetReorderingThresholdTime()/1000.0 << " ms, "
+        << rtpSource->numPacketsArrivingTooLate() << " packets arrived too late; added delay (ms):";
+    for(unsigned i = 0; i < NUM_ADDED_DELAY_HISTOGRAM_BUCKETS; ++i) {
+        if(histogram[i] == 0)
+            continue;
+        if(i == 0)
+            env << " <1";
+        else if(i == NUM_ADDED_DELAY_HISTOGRAM_BUCKETS-1)
+            env << " >=" << (1<<(i-1));
+        else
+            env << " " << (1<<(i-1)) << "-" << (1<<i);
+        env << ":" << histogram[i];
+    }
+    env << "\n";
+
+    if(subsession.serverSupportsNACK()) {
+        env << subsession.mediumName() << "/" << subsession.codecName()
+            << ": " << rtpSource->numPacketsNACKed() << " packets NACKed, "
+            << rtpSource->numPacketsRecovered() << " recovered by retransmission\n";
+    }
+}
+
 void shutdownStream(RTSPClient* rtspClient, int exitCode) {
     StreamClientState& scs = ((ourRTSPClient*)rtspClient)->scs;
 
@@ -258,13 +297,15 @@ void shutdownStream(RTSPClient* rtspClient, int exitCode) {
 
         while((subsession = iter.next()) != NULL) {
             if(subsession->sink != NULL) {
-	            Medium::close(subsession->sink);
-	            subsession->sink = NULL;
+                printReorderingStats(*subsession);
+
+                Medium::close(subsession->sink);
+                subsession->sink = NULL;
 
-	            if(subsession->rtcpInstance() != NULL)
-	                subsession->rtcpInstance()->setByeHandler(NULL, NULL);	            
+                if(subsession->rtcpInstance() != NULL)
+                    subsession->rtcpInstance()->setByeHandler(NULL, NULL);
 
-	            someSubsessionsWereActive = True;
+                someSubsessionsWereActive = True;
             }
         }
 
@@ -0,0 +1,369 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2018, Live Networks, Inc.  All rights reserved
+// A RTSP request-handling benchmark: Runs a "RTSPServer" (serving a synthetic audio stream) in its own event loop
+// (thread), and has several client connections send it 'storms' of pipelined "OPTIONS", "DESCRIBE", "SETUP" and
+// "PLAY" requests.  For each storm, reports the requests handled per second, and per second of server CPU time
+// (i.e., per core, because the server is single-threaded).
+// (Note that we never send "TEARDOWN", because our "RTSPServer" exits after handling one.  Instead, the "SETUP" storm
+// repeatedly re-"SETUP"s a track within an existing session, which replaces the track's stream each time.)
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <netinet/tcp.h>
+
+// Parameters (set from the command line):
+static unsigned numConnections = 4;
+static unsigned pipelineDepth = 8; // requests sent per write
+static unsigned stormDuration = 3; // seconds
+
+static char const* streamName = "bench";
+static char* serverURL = NULL; // "rtsp://<address>:<port>/<streamName>"
+static portNumBits serverPortNum = 0;
+
+// A synthetic audio source (silent 16-bit PCM), so that the server needs no input file:
+
+#define SILENCE_SAMPLING_FREQUENCY 8000
+#define SILENCE_FRAME_SIZE 320 // bytes (20 ms)
+
+class SilenceSource: public FramedSource {
+public:
+    static SilenceSource* createNew(UsageEnvironment& env) { return new SilenceSource(env); }
+
+protected:
+    SilenceSource(UsageEnvironment& env) : FramedSource(env) {}
+
+private: // redefined virtual functions
+    virtual void doGetNextFrame();
+};
+
+void SilenceSource::doGetNextFrame() {
+    fFrameSize = fMaxSize < SILENCE_FRAME_SIZE ? fMaxSize : SILENCE_FRAME_SIZE;
+    memset(fTo, 0, fFrameSize);
+    gettimeofday(&fPresentationTime, NULL);
+    fDurationInMicroseconds = 20000;
+
+    // Deliver the frame via the event loop, to avoid infinite recursion:
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
+}
+
+class SilenceServerMediaSubsession: public OnDemandServerMediaSubsession {
+public:
+    static SilenceServerMediaSubsession* createNew(UsageEnvironment& env) { return new SilenceServerMediaSubsession(env); }
+
+protected:
+    SilenceServerMediaSubsession(UsageEnvironment& env) : OnDemandServerMediaSubsession(env, False) {}
+
+private: // redefined virtual functions
+    virtual FramedSource* createNewStreamSource(unsigned /*clientSessionId*/, unsigned& estBitrate) {
+        estBitrate = (SILENCE_SAMPLING_FREQUENCY*16 + 500)/1000; // kbps
+        return SilenceSource::createNew(envir());
+    }
+    virtual RTPSink* createNewRTPSink(Groupsock* rtpGroupsock, unsigned char rtpPayloadTypeIfDynamic,
+                                      FramedSource* /*inputSource*/) {
+        return SimpleRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
+                                        SILENCE_SAMPLING_FREQUENCY, "audio", "L16", 1);
+    }
+};
+
+// The server, running in its own thread:
+
+static pthread_t serverThread;
+static pthread_mutex_t serverReadyMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t serverReadyCond = PTHREAD_COND_INITIALIZER;
+
+static void* runServer(void*) {
+    TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+    UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+    RTSPServer* rtspServer = RTSPServer::createNew(*env, 0/*choose a port*/, NULL);
+    if (rtspServer == NULL) {
+        fprintf(stderr, "Failed to create RTSP server: %s\n", env->getResultMsg());
+        exit(1);
+    }
+    ServerMediaSession* sms = ServerMediaSession::createNew(*env, streamName, streamName, "RTSP request benchmark");
+    sms->addSubsession(SilenceServerMediaSubsession::createNew(*env));
+    rtspServer->addServerMediaSession(sms);
+
+    pthread_mutex_lock(&serverReadyMutex);
+    serverURL = rtspServer->rtspURL(sms);
+    char const* portStr = strrchr(serverURL, ':');
+    if (portStr != NULL) serverPortNum = (portNumBits)atoi(portStr+1);
+    pthread_cond_signal(&serverReadyCond);
+    pthread_mutex_unlock(&serverReadyMutex);
+
+    env->taskScheduler().doEventLoop(); // does not return
+    return NULL;
+}
+
+static double serverCPUSeconds() {
+    clockid_t clockId;
+    struct timespec ts;
+    if (pthread_getcpuclockid(serverThread, &clockId) != 0 || clock_gettime(clockId, &ts) != 0) return 0.0;
+
+    return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+static double wallSeconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec + tv.tv_usec/1e6;
+}
+
+// A client connection (each run in its own thread, using blocking socket I/O):
+
+typedef enum StormType { OPTIONS_STORM, DESCRIBE_STORM, SETUP_STORM, PLAY_STORM } StormType;
+static char const* const stormNames[] = { "OPTIONS", "DESCRIBE", "SETUP", "PLAY" };
+
+class BenchConnection {
+public:
+    BenchConnection();
+    ~BenchConnection();
+
+    Boolean connectToServer();
+    Boolean sendRequests(char const* requests);
+    Boolean readResponses(unsigned numResponses, char* sessionIdStr = NULL);
+        // reads "numResponses" responses; returns False on a connection error or a non-"200" response
+    char const* request(char const* cmd, char const* urlSuffix, char const* sessionIdStr, char const* extraHeaders);
+        // formats a request (into an internal buffer)
+
+public:
+    pthread_t thread;
+    StormType stormType;
+    double endTime;
+    unsigned long numRequests; // completed (i.e., responded-to) requests
+    Boolean failed;
+
+private:
+    int fSocket;
+    unsigned fCSeq;
+    char fRequest[500];
+    char fInBuf[20000];
+    unsigned fInBufBytes;
+};
+
+BenchConnection::BenchConnection()
+    : stormType(OPTIONS_STORM), endTime(0.0), numRequests(0), failed(False),
+      fSocket(-1), fCSeq(0), fInBufBytes(0) {
+}
+
+BenchConnection::~BenchConnection() {
+    if (fSocket >= 0) close(fSocket);
+}
+
+Boolean BenchConnection::connectToServer() {
+    fSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (fSocket < 0) return False;
+
+    int one = 1;
+    setsockopt(fSocket, IPPROTO_TCP, TCP_NODELAY, (char*)&one, sizeof one);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(serverPortNum);
+    return connect(fSocket, (struct sockaddr*)&addr, sizeof addr) == 0;
+}
+
+Boolean BenchConnection::sendRequests(char const* requests) {
+    unsigned len = strlen(requests);
+    while (len > 0) {
+        int n = send(fSocket, requests, len, 0);
+        if (n <= 0) return False;
+        requests += n; len -= n;
+    }
+
+    return True;
+}
+
+Boolean BenchConnection::readResponses(unsigned numResponses, char* sessionIdStr) {
+    Boolean allSucceeded = True;
+    while (numResponses > 0) {
+        // Look for a complete response (headers, plus any "Content-Length:" bytes) at the start of "fInBuf":
+        fInBuf[fInBufBytes] = '\0';
+        char const* endOfHeaders = strstr(fInBuf, "\r\n\r\n");
+        unsigned responseSize = 0;
+        if (endOfHeaders != NULL) {
+            unsigned contentLength = 0;
+            char const* cl = strstr(fInBuf, "Content-Length:");
+            if (cl != NULL && cl < endOfHeaders) sscanf(cl+15, "%u", &contentLength);
+            responseSize = (endOfHeaders + 4 - fInBuf) + contentLength;
+            if (responseSize > fInBufBytes) responseSize = 0; // we don't yet have all of the content
+        }
+
+        if (responseSize == 0) {
+            // Read more data:
+            if (fInBufBytes >= sizeof fInBuf - 1) return False; // the response is too large
+            int n = recv(fSocket, &fInBuf[fInBufBytes], sizeof fInBuf - 1 - fInBufBytes, 0);
+            if (n <= 0) return False;
+            fInBufBytes += n;
+#ifdef TCP_QUICKACK
+            // Acknowledge each response immediately, so that the server's sending of the next (pipelined) response
+            // doesn't get held up by our delayed ACK (and thus dominate the measured request rate):
+            int one = 1;
+            setsockopt(fSocket, IPPROTO_TCP, TCP_QUICKACK, (char*)&one, sizeof one);
+#endif
+            continue;
+        }
+
+        if (strncmp(fInBuf, "RTSP/1.0 200", 12) != 0) allSucceeded = False;
+        if (sessionIdStr != NULL) {
+            char const* session = strstr(fInBuf, "Session: ");
+            if (session != NULL && session < endOfHeaders) sscanf(session+9, "%[^;\r\n]", sessionIdStr);
+        }
+
+        // Remove this response from the start of "fInBuf":
+        fInBufBytes -= responseSize;
+        memmove(fInBuf, &fInBuf[responseSize], fInBufBytes);
+        ++numRequests;
+        --numResponses;
+    }
+
+    return allSucceeded;
+}
+
+char const* BenchConnection::request(char const* cmd, char const* urlSuffix, char const* sessionIdStr, char const* extraHeaders) {
+    char sessionHeader[100];
+    if (sessionIdStr != NULL) {
+        snprintf(sessionHeader, sizeof sessionHeader, "Session: %s\r\n", sessionIdStr);
+    } else {
+        sessionHeader[0] = '\0';
+    }
+    snprintf(fRequest, sizeof fRequest, "%s %s%s RTSP/1.0\r\nCSeq: %u\r\nUser-Agent: RTSPRequestBenchmark\r\n%s%s\r\n",
+             cmd, serverURL, urlSuffix, ++fCSeq, sessionHeader, extraHeaders);
+
+    return fRequest;
+}
+
+static char const* const setupTransportHeader = "Transport: RTP/AVP;unicast;client_port=9-10\r\n"; // (the "discard" port)
+
+static void* runConnection(void* clientData) {
+    BenchConnection* conn = (BenchConnection*)clientData;
+    if (!conn->connectToServer()) {
+        conn->failed = True;
+        return NULL;
+    }
+
+    char* batch = new char[pipelineDepth*500 + 1];
+    char sessionIdStr[100];
+    sessionIdStr[0] = '\0';
+    if (conn->stormType == SETUP_STORM || conn->stormType == PLAY_STORM) {
+        // Set up a session first (not counted), to be repeatedly re-"SETUP", or "PLAY"ed and "PAUSE"d:
+        if (!conn->sendRequests(conn->request("SETUP", "/track1", NULL, setupTransportHeader))
+            || !conn->readResponses(1, sessionIdStr)) {
+            conn->failed = True;
+        }
+        conn->numRequests = 0;
+    }
+
+    while (!conn->failed && wallSeconds() < conn->endTime) {
+        batch[0] = '\0';
+        switch (conn->stormType) {
+            case OPTIONS_STORM: {
+                for (unsigned i = 0; i < pipelineDepth; ++i) strcat(batch, conn->request("OPTIONS", "", NULL, ""));
+                break;
+            }
+            case DESCRIBE_STORM: {
+                for (unsigned i = 0; i < pipelineDepth; ++i) {
+                    strcat(batch, conn->request("DESCRIBE", "", NULL, "Accept: application/sdp\r\n"));
+                }
+                break;
+            }
+            case SETUP_STORM: {
+                for (unsigned i = 0; i < pipelineDepth; ++i) {
+                    strcat(batch, conn->request("SETUP", "/track1", sessionIdStr, setupTransportHeader));
+                }
+                break;
+            }
+            case PLAY_STORM: {
+                for (unsigned i = 0; i < pipelineDepth; ++i) {
+                    strcat(batch, conn->request(i%2 == 0 ? "PLAY" : "PAUSE", "", sessionIdStr, i%2 == 0 ? "Range: npt=0-\r\n" : ""));
+                }
+                break;
+            }
+        }
+
+        if (!conn->sendRequests(batch) || !conn->readResponses(pipelineDepth)) conn->failed = True;
+    }
+
+    delete[] batch;
+    return NULL;
+}
+
+static void runStorm(StormType stormType) {
+    BenchConnection* conns = new BenchConnection[numConnections];
+    double const startTime = wallSeconds();
+    double const startCPU = serverCPUSeconds();
+
+    for (unsigned i = 0; i < numConnections; ++i) {
+        conns[i].stormType = stormType;
+        conns[i].endTime = startTime + stormDuration;
+        pthread_create(&conns[i].thread, NULL, runConnection, &conns[i]);
+    }
+
+    unsigned long numRequests = 0;
+    unsigned numFailed = 0;
+    for (unsigned i = 0; i < numConnections; ++i) {
+        pthread_join(conns[i].thread, NULL);
+        numRequests += conns[i].numRequests;
+        if (conns[i].failed) ++numFailed;
+    }
+
+    double const elapsed = wallSeconds() - startTime;
+    double const cpu = serverCPUSeconds() - startCPU;
+    fprintf(stdout, "%-8s storm: %9lu requests in %6.2f s: %9.0f requests/s; server CPU %6.2f s: %9.0f requests/s per core%s\n",
+            stormNames[stormType], numRequests, elapsed, numRequests/elapsed,
+            cpu, cpu > 0.0 ? numRequests/cpu : 0.0, numFailed > 0 ? " (some requests FAILED)" : "");
+    delete[] conns;
+}
+
+static void usage(char const* progName) {
+    fprintf(stderr, "Usage: %s [-c <num-connections>] [-p <pipeline-depth>] [-d <seconds-per-storm>]\n", progName);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "c:p:d:")) != -1) {
+        switch (opt) {
+            case 'c': numConnections = (unsigned)atoi(optarg); break;
+            case 'p': pipelineDepth = (unsigned)atoi(optarg); break;
+            case 'd': stormDuration = (unsigned)atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || numConnections == 0 || pipelineDepth == 0 || stormDuration == 0) usage(argv[0]);
+
+    pthread_mutex_lock(&serverReadyMutex);
+    pthread_create(&serverThread, NULL, runServer, NULL);
+    while (serverURL == NULL) pthread_cond_wait(&serverReadyCond, &serverReadyMutex);
+    pthread_mutex_unlock(&serverReadyMutex);
+
+    fprintf(stderr, "Benchmarking \"%s\", with %u connection(s), %u pipelined request(s) per write, %u s per storm\n",
+            serverURL, numConnections, pipelineDepth, stormDuration);
+    runStorm(OPTIONS_STORM);
+    runStorm(DESCRIBE_STORM);
+    runStorm(SETUP_STORM);
+    runStorm(PLAY_STORM);
+
+    return 0; // (we don't bother shutting down the server thread)
+}
@@ -11,6 +11,10 @@
 
 #define MAX_MESSAGE_LEN 512
 #define MAX_FILE_NAME_LEN 256
+#define MEMORY_STATISTICS_INTERVAL 30 // seconds
+#define SHARED_RTP_PORT_NUM 6968
+    // Note: This is below 6970, where the subsessions' server port pool (and their fallback port search) begins,
+    // so that the shared socket can't collide with the port pairs that they use for RTP-over-TCP clients' streams.
 
 UsageEnvironment* env;
 Boolean reuseFirstSource = False;
@@ -22,6 +26,13 @@ static void onMatroskaDemuxCreation(MatroskaFileServerDemux* newDemux, void* ) {
   newDemuxWatchVariable = 1;
 }
 
+// Reports the memory used by per-client objects, and by RTP sinks' buffers, every MEMORY_STATISTICS_INTERVAL seconds:
+void printMemoryStatistics(void* /*clientData*/) {
+    MemoryPool::printStatistics(*env);
+    MultiFramedRTPSink::printStatistics(*env);
+    env->taskScheduler().scheduleDelayedTask(MEMORY_STATISTICS_INTERVAL*1000000, printMemoryStatistics, NULL);
+}
+
 int createAndBindSocket(int port) {
     struct sockaddr_in local_addr;
     int sockfd;
@@ -94,8 +105,13 @@ int getFileList(char *dirname, char *list) {
 }
 
 int startVideoStreaming(char *fileName) {
+    // We run a single event loop, so per-client objects can be counted, and recycled, by their "MemoryPool"s:
+    MemoryPool::setAccountingEnabled(True);
+    MemoryPool::setPoolingEnabled(True);
     TaskScheduler* scheduler = BasicTaskScheduler::createNew();
     env = BasicUsageEnvironment::createNew(*scheduler);
+    SDPCache* sdpCache = SDPCache::createNew(*env, "sdp.cache");
+    SharedRTPSocket* sharedRTPSocket = SharedRTPSocket::createNew(*env, SHARED_RTP_PORT_NUM);
 
     RTSPServer* rtspServer = RTSPServer::createNew(*env, 8554, NULL);
     if(rtspServer == NULL) {
@@ -115,13 +131,24 @@ int startVideoStreaming(char *fileName) {
     Boolean sessionHasTracks = False;
     ServerMediaSubsession* smss;
     while((smss = matroskaDemux->newServerMediaSubsession()) != NULL) {
+        if(sharedRTPSocket != NULL) {
+            ((OnDemandServerMediaSubsession*)smss)->useSharedRTPSocket(sharedRTPSocket);
+        } else {
+            // Wake up every 10 ms to send a burst of packets, rather than once per packet.
+            // (The kernel paces each stream's bursts, so this needs a RTP socket per stream - i.e., no shared socket.)
+            ((OnDemandServerMediaSubsession*)smss)->enableKernelPacing(10000);
+        }
         sms->addSubsession(smss);
+        // Keep ~0.5 s of video for NACKed retransmissions, resent as "rtx" (payload type 112+, clear of the tracks' 96+):
+        ((OnDemandServerMediaSubsession*)smss)->enableRetransmissions(512, 112 + smss->trackNumber()-1);
         sessionHasTracks = True;
     }
     if(sessionHasTracks) {
         rtspServer->addServerMediaSession(sms);
+        sdpCache->prewarm(*sms);
     }
 
+    env->taskScheduler().scheduleDelayedTask(MEMORY_STATISTICS_INTERVAL*1000000, printMemoryStatistics, NULL);
     env->taskScheduler().doEventLoop();
 
     return 0;
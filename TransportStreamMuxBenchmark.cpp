@@ -0,0 +1,135 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2018, Live Networks, Inc.  All rights reserved
+// A Transport Stream multiplexing benchmark: Measures the Mbit/s (per core) of Transport Stream that
+// "MPEG2TransportStreamFromESSource" produces from in-memory video and audio Elementary Streams,
+// when it delivers 1 Transport packet per frame (the default) and several (e.g., 7, as for RTP).
+
+#include "liveMedia.hh"
+#include "BasicUsageEnvironment.hh"
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// Parameters (set from the command line):
+static unsigned videoMBytes = 100;
+static unsigned maxNumPacketsPerFrame = 7;
+
+static unsigned char* outBuf;
+static unsigned outBufSize;
+static MPEG2TransportStreamFromESSource* muxSource;
+static u_int64_t numBytesDelivered, numBytesToDeliver;
+static unsigned long numFramesDelivered;
+static char muxingIsDone;
+
+static void afterGettingFrame(void*, unsigned frameSize, unsigned /*numTruncatedBytes*/,
+                              struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/);
+static void onSourceClosure(void*) {
+    muxingIsDone = 1;
+}
+
+static void getNextFrame() {
+    muxSource->getNextFrame(outBuf, outBufSize, afterGettingFrame, NULL, onSourceClosure, NULL);
+}
+
+static void afterGettingFrame(void*, unsigned frameSize, unsigned /*numTruncatedBytes*/,
+                              struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/) {
+    numBytesDelivered += frameSize;
+    ++numFramesDelivered;
+    if (numBytesDelivered >= numBytesToDeliver) {
+        muxingIsDone = 1;
+        return;
+    }
+    getNextFrame();
+}
+
+static double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec/1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec/1e6;
+}
+
+// Multiplexes "videoData" and "audioData" into a Transport Stream, delivering up to "numPacketsPerFrame"
+// Transport packets per frame, then reports the rate.
+// Note: The multiplexor stops as soon as either of its inputs ends - which (because of buffering) can happen
+// after different amounts of output, depending on how frames are delivered.  So that each run produces the
+// same output, we stop after half as much output as there's video input (before either input can end).
+static void runMux(UsageEnvironment& env, unsigned numPacketsPerFrame,
+                   u_int8_t* videoData, unsigned videoDataSize, u_int8_t* audioData, unsigned audioDataSize) {
+    muxSource = MPEG2TransportStreamFromESSource::createNew(env);
+    muxSource->addNewVideoSource(ByteStreamMemoryBufferSource::createNew(env, videoData, videoDataSize, False, 50000), 2);
+    muxSource->addNewAudioSource(ByteStreamMemoryBufferSource::createNew(env, audioData, audioDataSize, False, 1000), 1);
+    muxSource->setMaxNumTransportPacketsPerFrame(numPacketsPerFrame);
+    outBufSize = numPacketsPerFrame*188;
+
+    numBytesDelivered = 0;
+    numBytesToDeliver = videoDataSize/2;
+    numFramesDelivered = 0;
+    muxingIsDone = 0;
+    double const startTime = cpuSeconds();
+    getNextFrame();
+    env.taskScheduler().doEventLoop(&muxingIsDone);
+    double const elapsed = cpuSeconds() - startTime;
+
+    fprintf(stdout, "%2u packet(s)/frame: %llu bytes in %lu frames, %.3f CPU s => %.0f Mbit/s per core\n",
+            numPacketsPerFrame, (unsigned long long)numBytesDelivered, numFramesDelivered, elapsed,
+            (numBytesDelivered*8)/elapsed/1e6);
+    Medium::close(muxSource);
+}
+
+static void usage(char const* progName) {
+    fprintf(stderr, "Usage: %s [-m <MBytes-of-video>] [-p <max-packets-per-frame>]\n", progName);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "m:p:")) != -1) {
+        switch (opt) {
+            case 'm': videoMBytes = (unsigned)atoi(optarg); break;
+            case 'p': maxNumPacketsPerFrame = (unsigned)atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || videoMBytes == 0 || maxNumPacketsPerFrame == 0) usage(argv[0]);
+
+    TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+    UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+    // Input data: pseudo-random bytes (the multiplexor doesn't parse its input), with 1/8 as much audio as video:
+    unsigned const videoDataSize = videoMBytes*1000000;
+    unsigned const audioDataSize = videoDataSize/8;
+    u_int8_t* videoData = new u_int8_t[videoDataSize];
+    u_int8_t* audioData = new u_int8_t[audioDataSize];
+    srandom(1);
+    for (unsigned i = 0; i < videoDataSize; ++i) videoData[i] = (u_int8_t)random();
+    for (unsigned i = 0; i < audioDataSize; ++i) audioData[i] = (u_int8_t)random();
+    outBuf = new unsigned char[maxNumPacketsPerFrame*188];
+
+    fprintf(stderr, "Multiplexing %u MB of video and %u MB of audio\n", videoDataSize/1000000, audioDataSize/1000000);
+
+    // First, one Transport packet per frame (the multiplexor's default):
+    runMux(*env, 1, videoData, videoDataSize, audioData, audioDataSize);
+    if (maxNumPacketsPerFrame > 1) {
+        runMux(*env, maxNumPacketsPerFrame, videoData, videoDataSize, audioData, audioDataSize);
+    }
+
+    delete[] outBuf; delete[] audioData; delete[] videoData;
+    env->reclaim();
+    delete scheduler;
+    return 0;
+}
@@ -126,6 +126,8 @@ HashTable::Iterator* HashTable::Iterator::create(HashTable const& hashTable) {
 
 ////////// Implementation of internal member functions //////////
 
+MemoryPool BasicHashTable::TableEntry::fMemoryPool("BasicHashTable::TableEntry", sizeof (BasicHashTable::TableEntry));
+
 BasicHashTable::TableEntry* BasicHashTable
 ::lookupKey(char const* key, unsigned& index) const {
   TableEntry* entry;
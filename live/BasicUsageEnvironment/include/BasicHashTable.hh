@@ -26,6 +26,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _NET_COMMON_H
 #include <NetCommon.h> // to ensure that "uintptr_t" is defined
 #endif
+#ifndef _MEMORY_POOL_HH
+#include "MemoryPool.hh"
+#endif
 
 // A simple hash table implementation, inspired by the hash table
 // implementation used in Tcl 7.6: <http://www.tcl.tk/>
@@ -69,6 +72,12 @@ private:
     TableEntry* fNext;
     char const* key;
     void* value;
+
+    // Entries are allocated from a "MemoryPool", because they come and go so often:
+    static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+    static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
+  private:
+    static MemoryPool fMemoryPool;
   };
 
   TableEntry* lookupKey(char const* key, unsigned& index) const;
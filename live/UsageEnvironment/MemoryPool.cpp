@@ -0,0 +1,134 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2018 Live Networks, Inc.  All rights reserved.
+// A pool from which objects of a single class can be allocated.
+// Implementation
+
+#include "MemoryPool.hh"
+#include <stdio.h>
+
+MemoryPool* MemoryPool::fFirstPool = NULL;
+Boolean MemoryPool::fAccountingIsEnabled = False;
+Boolean MemoryPool::fPoolingIsEnabled = False;
+
+MemoryPool::MemoryPool(char const* objectTypeName, size_t objectSize)
+  : fObjectTypeName(objectTypeName),
+    fObjectSize(objectSize),
+    fNumLiveObjects(0), fMaxNumLiveObjects(0), fNumLiveBytes(0),
+    fFreeList(NULL), fNumFreeObjects(0) {
+  // Add ourself to the list of all pools:
+  fNextPool = fFirstPool;
+  fFirstPool = this;
+}
+
+MemoryPool::~MemoryPool() {
+  freeFreeList();
+
+  // Remove ourself from the list of all pools:
+  for (MemoryPool** pool = &fFirstPool; *pool != NULL; pool = &((*pool)->fNextPool)) {
+    if (*pool == this) {
+      *pool = fNextPool;
+      break;
+    }
+  }
+}
+
+void* MemoryPool::allocate(size_t size) {
+  void* result;
+  if (size == fObjectSize && fFreeList != NULL) {
+    // Reuse a previously-deleted object:
+    result = fFreeList;
+    fFreeList = *(void**)fFreeList;
+    --fNumFreeObjects;
+  } else {
+    result = ::operator new(size);
+  }
+
+  if (fAccountingIsEnabled) {
+    ++fNumLiveObjects;
+    if (fNumLiveObjects > fMaxNumLiveObjects) fMaxNumLiveObjects = fNumLiveObjects;
+    fNumLiveBytes += size;
+  }
+
+  return result;
+}
+
+void MemoryPool::deallocate(void* p, size_t size) {
+  if (p == NULL) return;
+
+  if (fAccountingIsEnabled) {
+    --fNumLiveObjects;
+    fNumLiveBytes -= size;
+  }
+
+  if (size == fObjectSize && size >= sizeof (void*) && fPoolingIsEnabled) {
+    // Keep the object for reuse:
+    *(void**)p = fFreeList;
+    fFreeList = p;
+    ++fNumFreeObjects;
+  } else {
+    ::operator delete(p);
+  }
+}
+
+void MemoryPool::printStatistics(UsageEnvironment& env) {
+  size_t totNumLiveBytes = 0, totNumFreeBytes = 0;
+  char buf[100];
+
+  if (!fAccountingIsEnabled) {
+    env << "Memory pool statistics are not available (accounting is disabled)\n";
+    return;
+  }
+
+  env << "Memory pool statistics (pooling " << (fPoolingIsEnabled ? "enabled" : "disabled") << "):\n";
+  for (MemoryPool* pool = fFirstPool; pool != NULL; pool = pool->fNextPool) {
+    env << "\t" << pool->fObjectTypeName << " (" << (unsigned)pool->fObjectSize << " bytes): "
+	<< pool->fNumLiveObjects << " live (";
+    snprintf(buf, sizeof buf, "%lu bytes; max ", (unsigned long)pool->fNumLiveBytes);
+    env << buf << pool->fMaxNumLiveObjects << " objects), " << pool->fNumFreeObjects << " free (";
+    snprintf(buf, sizeof buf, "%lu bytes)\n", (unsigned long)pool->numFreeBytes());
+    env << buf;
+    totNumLiveBytes += pool->fNumLiveBytes;
+    totNumFreeBytes += pool->numFreeBytes();
+  }
+  snprintf(buf, sizeof buf, "\tTotal: %lu live bytes, %lu free bytes",
+	   (unsigned long)totNumLiveBytes, (unsigned long)totNumFreeBytes);
+  env << buf << " (not including \"strDup()\" strings)\n";
+}
+
+void MemoryPool::setAccountingEnabled(Boolean enabled) {
+  fAccountingIsEnabled = enabled;
+}
+
+void MemoryPool::setPoolingEnabled(Boolean enabled) {
+  fPoolingIsEnabled = enabled;
+
+  if (!enabled) {
+    // Return all previously-deleted objects to the heap:
+    for (MemoryPool* pool = fFirstPool; pool != NULL; pool = pool->fNextPool) {
+      pool->freeFreeList();
+    }
+  }
+}
+
+void MemoryPool::freeFreeList() {
+  while (fFreeList != NULL) {
+    void* next = *(void**)fFreeList;
+    ::operator delete(fFreeList);
+    fFreeList = next;
+  }
+  fNumFreeObjects = 0;
+}
@@ -0,0 +1,103 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+
+#ifndef _MEMORY_POOL_HH
+#define _MEMORY_POOL_HH
+
+// Copyright (c) 1996-2018 Live Networks, Inc.  All rights reserved.
+// A pool from which objects of a single class - usually ones that are created and deleted
+// once (or more) for each client (e.g., of a server) - can be allocated.
+// Optionally, each pool keeps count of the objects (and bytes) currently allocated from it, so
+// that the memory used by each type of object can be reported; and, optionally, objects that
+// are deleted can be kept (on a 'free list') for reuse, rather than being returned to the heap.
+// (With both options disabled - the default - a pool just uses the heap.)
+// Header
+
+#ifndef _USAGE_ENVIRONMENT_HH
+#include "UsageEnvironment.hh"
+#endif
+
+// A class uses a "MemoryPool" by redefining its "operator new" and "operator delete" - e.g.:
+//     static MemoryPool fooPool("Foo", sizeof (Foo));
+//     void* Foo::operator new(size_t size) { return fooPool.allocate(size); }
+//     void Foo::operator delete(void* p, size_t size) { fooPool.deallocate(p, size); }
+// (Objects of a subclass of "Foo" are counted by "Foo"s pool, but - because they have a
+//  different size - are always allocated from, and returned to, the heap.)
+
+class MemoryPool {
+public:
+  MemoryPool(char const* objectTypeName, size_t objectSize);
+      // "objectTypeName" must be a string constant (it is not copied)
+  virtual ~MemoryPool();
+
+  void* allocate(size_t size);
+  void deallocate(void* p, size_t size);
+
+  char const* objectTypeName() const { return fObjectTypeName; }
+  size_t objectSize() const { return fObjectSize; }
+  unsigned numLiveObjects() const { return fNumLiveObjects; }
+  size_t numLiveBytes() const { return fNumLiveBytes; }
+  unsigned maxNumLiveObjects() const { return fMaxNumLiveObjects; } // the 'high-water mark'
+  unsigned numFreeObjects() const { return fNumFreeObjects; } // kept for reuse
+  size_t numFreeBytes() const { return fNumFreeObjects*fObjectSize; }
+
+  // Iterating over all pools:
+  static MemoryPool* firstPool() { return fFirstPool; }
+  MemoryPool* nextPool() const { return fNextPool; }
+
+  // Reports - for each pool - the number of objects (and bytes) that are currently allocated,
+  // and currently kept for reuse:
+  static void printStatistics(UsageEnvironment& env);
+      // Note: Strings that are allocated by "strDup()" (e.g., URLs, session ids, and SDP
+      // descriptions) are not counted, because they vary in size, and are freed (using "delete[]")
+      // in many places.  The counts therefore underestimate the memory used by each client.
+
+  static void setAccountingEnabled(Boolean enabled);
+      // If "enabled" is True, then each pool counts the objects (and bytes) allocated from it.
+      // Call this before any objects are allocated from a pool (e.g., at the start of "main()").
+      // Note: Pools are shared by all "UsageEnvironment"s, and their counts are not synchronized,
+      // so don't enable this if your application runs more than one event loop at a time (in
+      // separate threads).  (By default, accounting is disabled.)
+  static Boolean accountingIsEnabled() { return fAccountingIsEnabled; }
+
+  static void setPoolingEnabled(Boolean enabled);
+      // If "enabled" is True, then deleted objects are kept for reuse, rather than being returned to
+      // the heap.  This can reduce heap fragmentation (for example, in a long-running server with
+      // many short-lived clients), but means that memory used by the most clients ever served at
+      // once is never given back.
+      // Note: Pools are shared by all "UsageEnvironment"s, so don't enable this if your
+      // application runs more than one event loop at a time (in separate threads).
+      // (By default, pooling is disabled.)
+  static Boolean poolingIsEnabled() { return fPoolingIsEnabled; }
+
+private:
+  void freeFreeList();
+
+private:
+  char const* fObjectTypeName;
+  size_t fObjectSize;
+  unsigned fNumLiveObjects, fMaxNumLiveObjects;
+  size_t fNumLiveBytes;
+  void* fFreeList; // each free object begins with a pointer to the next one
+  unsigned fNumFreeObjects;
+  MemoryPool* fNextPool;
+
+  static MemoryPool* fFirstPool;
+  static Boolean fAccountingIsEnabled;
+  static Boolean fPoolingIsEnabled;
+};
+
+#endif
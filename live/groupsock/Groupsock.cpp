@@ -39,6 +39,11 @@ OutputSocket::OutputSocket(UsageEnvironment& env, Port port)
     fSourcePort(0), fLastSentTTL(256/*hack: a deliberately invalid value*/) {
 }
 
+OutputSocket::OutputSocket(UsageEnvironment& env, Port port, int sharedSocketNum)
+  : Socket(env, port, sharedSocketNum),
+    fSourcePort(port), fLastSentTTL(256/*hack: a deliberately invalid value*/) {
+}
+
 OutputSocket::~OutputSocket() {
 }
 
@@ -92,13 +97,15 @@ NetInterfaceTrafficStats Groupsock::statsOutgoing;
 NetInterfaceTrafficStats Groupsock::statsRelayedIncoming;
 NetInterfaceTrafficStats Groupsock::statsRelayedOutgoing;
 
+MemoryPool Groupsock::fMemoryPool("Groupsock", sizeof (Groupsock));
+
 // Constructor for a source-independent multicast group
 Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
 		     Port port, u_int8_t ttl)
   : OutputSocket(env, port),
     deleteIfNoMembers(False), isSlave(False),
     fDests(new destRecord(groupAddr, port, ttl, 0, NULL)),
-    fIncomingGroupEId(groupAddr, port.num(), ttl) {
+    fIncomingGroupEId(groupAddr, port.num(), ttl), fReceiveTimestampsAreEnabled(False) {
 }
 
 // Constructor for a source-specific multicast group
@@ -108,10 +115,19 @@ Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
   : OutputSocket(env, port),
     deleteIfNoMembers(False), isSlave(False),
     fDests(new destRecord(groupAddr, port, 255, 0, NULL)),
-    fIncomingGroupEId(groupAddr, sourceFilterAddr, port.num()) {
+    fIncomingGroupEId(groupAddr, sourceFilterAddr, port.num()), fReceiveTimestampsAreEnabled(False) {
   // First try a SSM join.  If that fails, try a regular join:
 }
 
+// Constructor for a unicast 'groupsock' that shares an existing socket
+Groupsock::Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
+		     Port port, u_int8_t ttl, int sharedSocketNum)
+  : OutputSocket(env, port, sharedSocketNum),
+    deleteIfNoMembers(False), isSlave(False),
+    fDests(new destRecord(groupAddr, port, ttl, 0, NULL)),
+    fIncomingGroupEId(groupAddr, port.num(), ttl), fReceiveTimestampsAreEnabled(False) {
+}
+
 Groupsock::~Groupsock() {
   if (isSSM()) {
     if (!socketLeaveGroupSSM(env(), socketNum(), groupAddress().s_addr,
@@ -252,17 +268,55 @@ Boolean Groupsock::output(UsageEnvironment& env, unsigned char* buffer, unsigned
   return False;
 }
 
+Boolean Groupsock::outputToSession(UsageEnvironment& /*env*/, unsigned char* buffer, unsigned bufferSize,
+				   unsigned sessionId) {
+  Boolean sawDestination = False;
+  for (destRecord* dests = fDests; dests != NULL; dests = dests->fNext) {
+    if (dests->fSessionId != sessionId) continue;
+
+    if (!write(dests->fGroupEId.groupAddress().s_addr, dests->fGroupEId.portNum(), dests->fGroupEId.ttl(),
+	       buffer, bufferSize)) {
+      return False;
+    }
+    sawDestination = True;
+  }
+  if (!sawDestination) return False;
+
+  statsOutgoing.countPacket(bufferSize);
+  statsGroupOutgoing.countPacket(bufferSize);
+  return True;
+}
+
+Boolean Groupsock::enableReceiveTimestamps() {
+  fReceiveTimestampsAreEnabled = setSocketReceiveTimestamps(socketNum());
+  return fReceiveTimestampsAreEnabled;
+}
+
 Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 			      unsigned& bytesRead,
 			      struct sockaddr_in& fromAddressAndPort) {
+  return handleRead(buffer, bufferMaxSize, bytesRead, fromAddressAndPort, NULL);
+}
+
+Boolean Groupsock::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
+			      unsigned& bytesRead,
+			      struct sockaddr_in& fromAddressAndPort,
+			      struct timeval* timeReceived) {
   // Read data from the socket, and relay it across any attached tunnels
   //##### later make this code more general - independent of tunnels
 
   bytesRead = 0;
 
   int maxBytesToRead = bufferMaxSize - TunnelEncapsulationTrailerMaxSize;
-  int numBytes = readSocket(env(), socketNum(),
-			    buffer, maxBytesToRead, fromAddressAndPort);
+  int numBytes;
+  if (timeReceived == NULL) {
+    numBytes = readSocket(env(), socketNum(), buffer, maxBytesToRead, fromAddressAndPort);
+  } else if (fReceiveTimestampsAreEnabled) {
+    numBytes = readSocket(env(), socketNum(), buffer, maxBytesToRead, fromAddressAndPort, *timeReceived);
+  } else {
+    numBytes = readSocket(env(), socketNum(), buffer, maxBytesToRead, fromAddressAndPort);
+    gettimeofday(timeReceived, NULL);
+  }
   if (numBytes < 0) {
     return False;
   }
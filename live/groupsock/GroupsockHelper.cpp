@@ -254,6 +254,29 @@ Boolean setSocketKeepAlive(int sock) {
   return True;
 }
 
+Boolean setSocketReceiveTimestamps(int sock) {
+  int const enable = 1;
+#if defined(SO_TIMESTAMPNS)
+  return setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, (void*)&enable, sizeof enable) >= 0;
+#elif defined(SO_TIMESTAMP)
+  return setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, (void*)&enable, sizeof enable) >= 0;
+#else
+  return False;
+#endif
+}
+
+Boolean setSocketMaxPacingRate(int sock, unsigned bytesPerSecond) {
+#ifdef SO_MAX_PACING_RATE
+  if (setsockopt(sock, SOL_SOCKET, SO_MAX_PACING_RATE, (void*)&bytesPerSecond, sizeof bytesPerSecond) < 0) {
+    return False;
+  }
+
+  return True;
+#else
+  return False;
+#endif
+}
+
 int setupStreamSocket(UsageEnvironment& env,
                       Port port, Boolean makeNonBlocking, Boolean setKeepAlive) {
   if (!initializeWinsockIfNecessary()) {
@@ -334,13 +357,7 @@ int setupStreamSocket(UsageEnvironment& env,
   return newSocket;
 }
 
-int readSocket(UsageEnvironment& env,
-	       int socket, unsigned char* buffer, unsigned bufferSize,
-	       struct sockaddr_in& fromAddress) {
-  SOCKLEN_T addressSize = sizeof fromAddress;
-  int bytesRead = recvfrom(socket, (char*)buffer, bufferSize, 0,
-			   (struct sockaddr*)&fromAddress,
-			   &addressSize);
+static int checkReadSocketResult(UsageEnvironment& env, int bytesRead, struct sockaddr_in& fromAddress) {
   if (bytesRead < 0) {
     //##### HACK to work around bugs in Linux and Windows:
     int err = env.getErrno();
@@ -370,6 +387,71 @@ int readSocket(UsageEnvironment& env,
   return bytesRead;
 }
 
+int readSocket(UsageEnvironment& env,
+	       int socket, unsigned char* buffer, unsigned bufferSize,
+	       struct sockaddr_in& fromAddress) {
+  SOCKLEN_T addressSize = sizeof fromAddress;
+  int bytesRead = recvfrom(socket, (char*)buffer, bufferSize, 0,
+			   (struct sockaddr*)&fromAddress,
+			   &addressSize);
+  return checkReadSocketResult(env, bytesRead, fromAddress);
+}
+
+int readSocket(UsageEnvironment& env,
+	       int socket, unsigned char* buffer, unsigned bufferSize,
+	       struct sockaddr_in& fromAddress, struct timeval& timeReceived) {
+#if defined(SO_TIMESTAMPNS) || defined(SO_TIMESTAMP)
+  struct iovec iov;
+  iov.iov_base = buffer;
+  iov.iov_len = bufferSize;
+  union { // ensures proper alignment for "struct cmsghdr"
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof (struct timespec))];
+  } control;
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_name = &fromAddress;
+  msg.msg_namelen = sizeof fromAddress;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof control.buf;
+
+  int bytesRead = recvmsg(socket, &msg, 0);
+  Boolean haveTimestamp = False;
+  if (bytesRead > 0) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET) continue;
+#ifdef SO_TIMESTAMPNS
+      if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+	struct timespec ts;
+	memcpy(&ts, CMSG_DATA(cmsg), sizeof ts);
+	timeReceived.tv_sec = ts.tv_sec;
+	timeReceived.tv_usec = ts.tv_nsec/1000;
+	haveTimestamp = True;
+	break;
+      }
+#endif
+#ifdef SO_TIMESTAMP
+      if (cmsg->cmsg_type == SCM_TIMESTAMP) {
+	memcpy(&timeReceived, CMSG_DATA(cmsg), sizeof timeReceived);
+	haveTimestamp = True;
+	break;
+      }
+#endif
+    }
+  }
+  if (!haveTimestamp) gettimeofday(&timeReceived, NULL);
+
+  return checkReadSocketResult(env, bytesRead, fromAddress);
+#else
+  int bytesRead = readSocket(env, socket, buffer, bufferSize, fromAddress);
+  gettimeofday(&timeReceived, NULL);
+  return bytesRead;
+#endif
+}
+
 Boolean writeSocket(UsageEnvironment& env,
 		    int socket, struct in_addr address, portNumBits portNum,
 		    u_int8_t ttlArg,
@@ -86,12 +86,17 @@ DirectedNetInterface* DirectedNetInterfaceSet::Iterator::next() {
 int Socket::DebugLevel = 1; // default value
 
 Socket::Socket(UsageEnvironment& env, Port port)
-  : fEnv(DefaultUsageEnvironment != NULL ? *DefaultUsageEnvironment : env), fPort(port) {
+  : fOwnsSocketNum(True), fEnv(DefaultUsageEnvironment != NULL ? *DefaultUsageEnvironment : env), fPort(port) {
   fSocketNum = setupDatagramSocket(fEnv, port);
 }
 
+Socket::Socket(UsageEnvironment& env, Port port, int sharedSocketNum)
+  : fSocketNum(sharedSocketNum), fOwnsSocketNum(False),
+    fEnv(DefaultUsageEnvironment != NULL ? *DefaultUsageEnvironment : env), fPort(port) {
+}
+
 void Socket::reset() {
-  if (fSocketNum >= 0) closeSocket(fSocketNum);
+  if (fSocketNum >= 0 && fOwnsSocketNum) closeSocket(fSocketNum);
   fSocketNum = -1;
 }
 
@@ -100,6 +105,8 @@ Socket::~Socket() {
 }
 
 Boolean Socket::changePort(Port newPort) {
+  if (!fOwnsSocketNum) return False; // we can't rebind someone else's socket
+
   int oldSocketNum = fSocketNum;
   unsigned oldReceiveBufferSize = getReceiveBufferSize(fEnv, fSocketNum);
   unsigned oldSendBufferSize = getSendBufferSize(fEnv, fSocketNum);
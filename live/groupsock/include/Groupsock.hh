@@ -32,6 +32,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _GROUPEID_HH
 #include "GroupEId.hh"
 #endif
+#ifndef _MEMORY_POOL_HH
+#include "MemoryPool.hh"
+#endif
 
 // An "OutputSocket" is (by default) used only to send packets.
 // No packets are received on it (unless a subclass arranges this)
@@ -50,6 +53,7 @@ public:
 
 protected:
   OutputSocket(UsageEnvironment& env, Port port);
+  OutputSocket(UsageEnvironment& env, Port port, int sharedSocketNum);
 
   portNumBits sourcePortNum() const {return fSourcePort.num();}
 
@@ -81,6 +85,8 @@ public:
 
 class Groupsock: public OutputSocket {
 public:
+  static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+  static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
   Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
 	    Port port, u_int8_t ttl);
       // used for a 'source-independent multicast' group
@@ -88,6 +94,10 @@ public:
 	    struct in_addr const& sourceFilterAddr,
 	    Port port);
       // used for a 'source-specific multicast' group
+  Groupsock(UsageEnvironment& env, struct in_addr const& groupAddr,
+	    Port port, u_int8_t ttl, int sharedSocketNum);
+      // used for a unicast 'groupsock' that sends from an existing socket (bound to "port"),
+      // shared with other 'groupsocks'.  (The socket is not closed when we're deleted.)
   virtual ~Groupsock();
 
   virtual destRecord* createNewDestRecord(struct in_addr const& addr, Port const& port, u_int8_t ttl, unsigned sessionId, destRecord* next);
@@ -111,6 +121,7 @@ public:
   virtual void addDestination(struct in_addr const& addr, Port const& port, unsigned sessionId);
   virtual void removeDestination(unsigned sessionId);
   void removeAllDestinations();
+  Boolean hasDestinations() const { return fDests != NULL; }
   Boolean hasMultipleDestinations() const { return fDests != NULL && fDests->fNext != NULL; }
 
   struct in_addr const& groupAddress() const {
@@ -128,8 +139,21 @@ public:
 
   void multicastSendOnly(); // send, but don't receive any multicast packets
 
+  Boolean enableReceiveTimestamps();
+      // Has the kernel timestamp each incoming packet, for use by the version of "handleRead()"
+      // below.  Returns False if the OS doesn't support this.
+  Boolean handleRead(unsigned char* buffer, unsigned bufferMaxSize,
+		     unsigned& bytesRead,
+		     struct sockaddr_in& fromAddressAndPort,
+		     struct timeval* timeReceived);
+      // Like the usual "handleRead()", but (if "timeReceived" is non-NULL) also returns the packet's
+      // arrival time (from the kernel, if "enableReceiveTimestamps()" succeeded; otherwise, the current time)
+
   virtual Boolean output(UsageEnvironment& env, unsigned char* buffer, unsigned bufferSize,
 			 DirectedNetInterface* interfaceNotToFwdBackTo = NULL);
+  Boolean outputToSession(UsageEnvironment& env, unsigned char* buffer, unsigned bufferSize, unsigned sessionId);
+      // Like "output()", but sends only to our destination(s) that have the given "sessionId" (and not to any members).
+      // Returns False if there is no such destination, or if a send fails.
 
   DirectedNetInterfaceSet& members() { return fMembers; }
 
@@ -168,6 +192,9 @@ protected:
 private:
   GroupEId fIncomingGroupEId;
   DirectedNetInterfaceSet fMembers;
+  Boolean fReceiveTimestampsAreEnabled;
+
+  static MemoryPool fMemoryPool;
 };
 
 UsageEnvironment& operator<<(UsageEnvironment& s, const Groupsock& g);
@@ -32,6 +32,12 @@ int setupStreamSocket(UsageEnvironment& env,
 int readSocket(UsageEnvironment& env,
 	       int socket, unsigned char* buffer, unsigned bufferSize,
 	       struct sockaddr_in& fromAddress);
+int readSocket(UsageEnvironment& env,
+	       int socket, unsigned char* buffer, unsigned bufferSize,
+	       struct sockaddr_in& fromAddress, struct timeval& timeReceived);
+    // A version of "readSocket()" that also returns the time at which the packet arrived.  If
+    // "setSocketReceiveTimestamps()" succeeded on the socket, this is the kernel's arrival time;
+    // otherwise, it's the current time.
 
 Boolean writeSocket(UsageEnvironment& env,
 		    int socket, struct in_addr address, portNumBits portNum/*network byte order*/,
@@ -60,6 +66,14 @@ Boolean makeSocketNonBlocking(int sock);
 Boolean makeSocketBlocking(int sock, unsigned writeTimeoutInMilliseconds = 0);
   // A "writeTimeoutInMilliseconds" value of 0 means: Don't timeout
 Boolean setSocketKeepAlive(int sock);
+Boolean setSocketReceiveTimestamps(int sock);
+  // Asks the kernel to timestamp each incoming datagram on "sock" (Linux's "SO_TIMESTAMPNS", or
+  // else "SO_TIMESTAMP"), for use by "readSocket(..., timeReceived)".
+  // Returns False if the OS doesn't support this.
+Boolean setSocketMaxPacingRate(int sock, unsigned bytesPerSecond);
+  // Asks the kernel to space out packets sent on "sock" so that they don't exceed this rate
+  // (Linux's "SO_MAX_PACING_RATE"; for UDP sockets, this requires the "fq" queueing discipline).
+  // Returns False if the OS doesn't support this.
 
 Boolean socketJoinGroup(UsageEnvironment& env, int socket,
 			netAddressBits groupAddress);
@@ -88,6 +88,8 @@ public:
       // Returns False on error; resultData == NULL if data ignored
 
   int socketNum() const { return fSocketNum; }
+  Boolean ownsSocketNum() const { return fOwnsSocketNum; }
+      // False iff our socket is shared with (and will be closed by) someone else
 
   Port port() const {
     return fPort;
@@ -99,11 +101,14 @@ public:
 
 protected:
   Socket(UsageEnvironment& env, Port port); // virtual base class
+  Socket(UsageEnvironment& env, Port port, int sharedSocketNum);
+      // uses an existing socket (already bound to "port"), which we do not close
 
   Boolean changePort(Port newPort); // will also cause socketNum() to change
 
 private:
   int fSocketNum;
+  Boolean fOwnsSocketNum;
   UsageEnvironment& fEnv;
   Port fPort;
 };
@@ -119,6 +119,10 @@ void AC3AudioStreamFramer::flushInput() {
   fParser->flushInput();
 }
 
+unsigned AC3AudioStreamFramer::maxFrameSize() const {
+  return 3840; // the largest possible AC-3 frame (1920 16-bit words: 640 kbps at 32 kHz)
+}
+
 void AC3AudioStreamFramer::doGetNextFrame() {
   fParser->registerReadInterest(fTo, fMaxSize);
   parseNextFrame();
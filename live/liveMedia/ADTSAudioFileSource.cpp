@@ -112,6 +112,10 @@ ADTSAudioFileSource::~ADTSAudioFileSource() {
   CloseInputFile(fFid);
 }
 
+unsigned ADTSAudioFileSource::maxFrameSize() const {
+  return 8191; // the largest possible ADTS "frame_length" (13 bits), which also counts the header that we strip
+}
+
 // Note: We should change the following to use asynchronous file reading, #####
 // as we now do with ByteStreamFileSource. #####
 void ADTSAudioFileSource::doGetNextFrame() {
@@ -22,20 +22,25 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include <strDup.hh>
 #include <string.h>
 
-static char base64DecodeTable[256];
-
-static void initBase64DecodeTable() {
-  int i;
-  for (i = 0; i < 256; ++i) base64DecodeTable[i] = (char)0x80;
-      // default value: invalid
-
-  for (i = 'A'; i <= 'Z'; ++i) base64DecodeTable[i] = 0 + (i - 'A');
-  for (i = 'a'; i <= 'z'; ++i) base64DecodeTable[i] = 26 + (i - 'a');
-  for (i = '0'; i <= '9'; ++i) base64DecodeTable[i] = 52 + (i - '0');
-  base64DecodeTable[(unsigned char)'+'] = 62;
-  base64DecodeTable[(unsigned char)'/'] = 63;
-  base64DecodeTable[(unsigned char)'='] = 0;
-}
+// Maps each character to its 6-bit value; 0x40 for the '=' padding character; 0x80 for any other (invalid) character:
+static unsigned char const base64DecodeTable[256] = {
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3e, 0x80, 0x80, 0x80, 0x3f,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x80, 0x80, 0x80, 0x40, 0x80, 0x80,
+  0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+  0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+  0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+};
 
 unsigned char* base64Decode(char const* in, unsigned& resultSize,
 			    Boolean trimTrailingZeros) {
@@ -46,12 +51,6 @@ unsigned char* base64Decode(char const* in, unsigned& resultSize,
 unsigned char* base64Decode(char const* in, unsigned inSize,
 			    unsigned& resultSize,
 			    Boolean trimTrailingZeros) {
-  static Boolean haveInitializedBase64DecodeTable = False;
-  if (!haveInitializedBase64DecodeTable) {
-    initBase64DecodeTable();
-    haveInitializedBase64DecodeTable = True;
-  }
-
   unsigned char* out = new unsigned char[inSize+1]; // ensures we have enough space
   int k = 0;
   int paddingCount = 0;
@@ -63,7 +62,7 @@ unsigned char* base64Decode(char const* in, unsigned inSize,
       inTmp[i] = in[i+j];
       if (inTmp[i] == '=') ++paddingCount;
       outTmp[i] = base64DecodeTable[(unsigned char)inTmp[i]];
-      if ((outTmp[i]&0x80) != 0) outTmp[i] = 0; // this happens only if there was an invalid character; pretend that it was 'A'
+      if ((outTmp[i]&0xC0) != 0) outTmp[i] = 0; // this happens only for '=', or if there was an invalid character; pretend that it was 'A'
     }
 
     out[k++] = (outTmp[0]<<2) | (outTmp[1]>>4);
@@ -85,15 +84,21 @@ unsigned char* base64Decode(char const* in, unsigned inSize,
 static const char base64Char[] =
 "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-char* base64Encode(char const* origSigned, unsigned origLength) {
-  unsigned char const* orig = (unsigned char const*)origSigned; // in case any input bytes have the MSB set
+char* base64Encode(char const* orig, unsigned origLength) {
   if (orig == NULL) return NULL;
 
+  char* result = new char[base64EncodedSize(origLength)+1]; // allow for trailing '\0'
+  base64Encode(result, orig, origLength);
+  return result;
+}
+
+unsigned base64Encode(char* result, char const* origSigned, unsigned origLength) {
+  unsigned char const* orig = (unsigned char const*)origSigned; // in case any input bytes have the MSB set
+
   unsigned const numOrig24BitValues = origLength/3;
   Boolean havePadding = origLength > numOrig24BitValues*3;
   Boolean havePadding2 = origLength == numOrig24BitValues*3 + 2;
   unsigned const numResultBytes = 4*(numOrig24BitValues + havePadding);
-  char* result = new char[numResultBytes+1]; // allow for trailing '\0'
 
   // Map each full group of 3 input bytes into 4 output base-64 characters:
   unsigned i;
@@ -118,5 +123,51 @@ char* base64Encode(char const* origSigned, unsigned origLength) {
   }
 
   result[numResultBytes] = '\0';
-  return result;
+  return numResultBytes;
+}
+
+
+////////// Base64Decoder implementation //////////
+
+unsigned Base64Decoder::decode(unsigned char* to, char const* from, unsigned fromSize) {
+  unsigned char const* in = (unsigned char const*)from;
+  unsigned char const* const inEnd = in + fromSize;
+  unsigned char* out = to;
+
+  while (in < inEnd) {
+    if (fNumBits == 0) {
+      // Fast path: Decode complete groups of 4 valid characters directly:
+      while (inEnd - in >= 4) {
+	unsigned char c0 = base64DecodeTable[in[0]], c1 = base64DecodeTable[in[1]];
+	unsigned char c2 = base64DecodeTable[in[2]], c3 = base64DecodeTable[in[3]];
+	if (((c0|c1|c2|c3)&0xC0) != 0) break; // padding, whitespace, or an invalid character
+
+	unsigned group = (c0<<18) | (c1<<12) | (c2<<6) | c3;
+	out[0] = group>>16; out[1] = group>>8; out[2] = group;
+	in += 4; out += 3;
+      }
+      if (in == inEnd) break;
+    }
+
+    // Slow path: Handle a single character:
+    unsigned char c = base64DecodeTable[*in++];
+    if ((c&0x80) != 0) continue; // whitespace (or some other invalid character); skip it
+    if ((c&0x40) != 0) {
+      // '=' padding: Any remaining bits are zero fill, so discard them:
+      fBits = 0; fNumBits = 0;
+      continue;
+    }
+
+    fBits = (fBits<<6) | c;
+    fNumBits += 6;
+    if (fNumBits >= 8) {
+      // Note: Because we output each byte as soon as we have it, we never write output past the input that
+      // we've already read.  This is what allows "to" to be the same as "from".
+      fNumBits -= 8;
+      *out++ = (unsigned char)(fBits>>fNumBits);
+      fBits &= (1<<fNumBits) - 1;
+    }
+  }
+
+  return out - to;
 }
@@ -19,6 +19,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "BitVector.hh"
+#include "NetCommon.h" // for "u_int64_t"
+#include <string.h>
 
 BitVector::BitVector(unsigned char* baseBytePtr,
 		     unsigned baseBitOffset,
@@ -40,29 +42,53 @@ static unsigned char const singleBitMask[8]
 
 #define MAX_LENGTH 32
 
-void BitVector::putBits(unsigned from, unsigned numBits) {
-  if (numBits == 0) return; 
+// Rather than moving one bit at a time, we access the (at most 5) bytes that contain the bits
+// of interest as a single 64-bit word, with the first of these bytes in the high-order position:
+static u_int64_t loadBytes(unsigned char const* ptr, unsigned numBytes) {
+  u_int64_t word = 0;
+  for (unsigned i = 0; i < numBytes; ++i) word = (word<<8)|ptr[i];
+  return word<<(64 - 8*numBytes);
+}
+
+static void storeBytes(unsigned char* ptr, unsigned numBytes, u_int64_t word) {
+  for (unsigned i = 0; i < numBytes; ++i) {
+    ptr[i] = (unsigned char)(word>>56);
+    word <<= 8;
+  }
+}
+
+static unsigned readBitsAt(unsigned char const* basePtr, unsigned bitOffset, unsigned numBits) {
+  // Returns the "numBits" (1 <= "numBits" <= 32) bits starting at "bitOffset":
+  unsigned const bitRem = bitOffset%8;
+  u_int64_t word = loadBytes(&basePtr[bitOffset/8], (bitRem + numBits + 7)/8);
+  return (unsigned)((word<<bitRem)>>(64 - numBits));
+}
 
-  unsigned char tmpBuf[4];
-  unsigned overflowingBits = 0;
+void BitVector::putBitsGeneral(unsigned from, unsigned numBits) {
+  if (numBits == 0) return; 
 
   if (numBits > MAX_LENGTH) {
     numBits = MAX_LENGTH;
   }
 
-  if (numBits > fTotNumBits - fCurBitIndex) {
-    overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
+  // If there's not enough room for all "numBits" bits, we store only its high-order bits:
+  unsigned numBitsToPut = numBits;
+  if (numBitsToPut > fTotNumBits - fCurBitIndex) {
+    numBitsToPut = fTotNumBits - fCurBitIndex;
+    if (numBitsToPut == 0) return;
   }
+  u_int64_t const value = (from&(0xFFFFFFFF>>(MAX_LENGTH - numBits)))>>(numBits - numBitsToPut);
+
+  unsigned const totBitOffset = fBaseBitOffset + fCurBitIndex;
+  unsigned const bitRem = totBitOffset%8;
+  unsigned const numBytes = (bitRem + numBitsToPut + 7)/8;
+  unsigned char* ptr = &fBaseBytePtr[totBitOffset/8];
 
-  tmpBuf[0] = (unsigned char)(from>>24);
-  tmpBuf[1] = (unsigned char)(from>>16);
-  tmpBuf[2] = (unsigned char)(from>>8);
-  tmpBuf[3] = (unsigned char)from;
+  unsigned const shift = 64 - bitRem - numBitsToPut;
+  u_int64_t const mask = ((((u_int64_t)1)<<numBitsToPut) - 1)<<shift;
+  storeBytes(ptr, numBytes, (loadBytes(ptr, numBytes)&~mask) | (value<<shift));
 
-  shiftBits(fBaseBytePtr, fBaseBitOffset + fCurBitIndex, /* to */
-	    tmpBuf, MAX_LENGTH - numBits, /* from */
-	    numBits - overflowingBits /* num bits */);
-  fCurBitIndex += numBits - overflowingBits;
+  fCurBitIndex += numBitsToPut;
 }
 
 void BitVector::put1Bit(unsigned bit) {
@@ -80,43 +106,24 @@ void BitVector::put1Bit(unsigned bit) {
   }
 }
 
-unsigned BitVector::getBits(unsigned numBits) {
+unsigned BitVector::getBitsGeneral(unsigned numBits) {
   if (numBits == 0) return 0;
 
-  unsigned char tmpBuf[4];
-  unsigned overflowingBits = 0;
-
   if (numBits > MAX_LENGTH) {
     numBits = MAX_LENGTH;
   }
 
-  if (numBits > fTotNumBits - fCurBitIndex) {
-    overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
+  // If there are fewer than "numBits" bits left, any missing (low-order) bits are 0:
+  unsigned numBitsToGet = numBits;
+  if (numBitsToGet > fTotNumBits - fCurBitIndex) {
+    numBitsToGet = fTotNumBits - fCurBitIndex;
+    if (numBitsToGet == 0) return 0;
   }
 
-  shiftBits(tmpBuf, 0, /* to */
-	    fBaseBytePtr, fBaseBitOffset + fCurBitIndex, /* from */
-	    numBits - overflowingBits /* num bits */);
-  fCurBitIndex += numBits - overflowingBits;
+  unsigned result = readBitsAt(fBaseBytePtr, fBaseBitOffset + fCurBitIndex, numBitsToGet);
+  fCurBitIndex += numBitsToGet;
 
-  unsigned result
-    = (tmpBuf[0]<<24) | (tmpBuf[1]<<16) | (tmpBuf[2]<<8) | tmpBuf[3];
-  result >>= (MAX_LENGTH - numBits); // move into low-order part of word
-  result &= (0xFFFFFFFF << overflowingBits); // so any overflow bits are 0
-  return result;
-}
-
-unsigned BitVector::get1Bit() {
-  // The following is equivalent to "getBits(1)", except faster:
-
-  if (fCurBitIndex >= fTotNumBits) { /* overflow */
-    return 0;
-  } else {
-    unsigned totBitOffset = fBaseBitOffset + fCurBitIndex++;
-    unsigned char curFromByte = fBaseBytePtr[totBitOffset/8];
-    unsigned result = (curFromByte >> (7-(totBitOffset%8))) & 0x01;
-    return result;
-  }
+  return result<<(numBits - numBitsToGet);
 }
 
 void BitVector::skipBits(unsigned numBits) {
@@ -128,6 +135,24 @@ void BitVector::skipBits(unsigned numBits) {
 }
 
 unsigned BitVector::get_expGolomb() {
+  // Fast path: Look for the code's '1' bit within the next (up to) 32 bits:
+  unsigned numBitsToCheck = fTotNumBits - fCurBitIndex;
+  if (numBitsToCheck > MAX_LENGTH) numBitsToCheck = MAX_LENGTH;
+  if (numBitsToCheck > 0) {
+    unsigned bits = readBitsAt(fBaseBytePtr, fBaseBitOffset + fCurBitIndex, numBitsToCheck);
+    if (bits != 0) {
+      unsigned numLeadingZeroBits = 0;
+#if defined(__GNUC__)
+      numLeadingZeroBits = __builtin_clz(bits) - (8*sizeof (unsigned) - numBitsToCheck);
+#else
+      while ((bits&(1<<(numBitsToCheck-1-numLeadingZeroBits))) == 0) ++numLeadingZeroBits;
+#endif
+      fCurBitIndex += numLeadingZeroBits + 1;
+      return (1<<numLeadingZeroBits) - 1 + getBits(numLeadingZeroBits);
+    }
+  }
+
+  // Otherwise (a very long code, or the end of the data), read it one bit at a time:
   unsigned numLeadingZeroBits = 0;
   unsigned codeStart = 1;
 
@@ -160,6 +185,33 @@ void shiftBits(unsigned char* toBasePtr, unsigned toBitOffset,
   unsigned char* toBytePtr = toBasePtr + toBitOffset/8;
   unsigned toBitRem = toBitOffset%8;
 
+  // Move whole bytes' worth of bits at a time, for as long as we can.
+  // (Because we always read each source byte before writing the destination byte(s) - which
+  // are at or before the source - this is safe even if from and to overlap, with from>to.)
+  if (fromBitRem == 0 && toBitRem == 0) {
+    unsigned const numBytes = numBits/8;
+    memmove(toBytePtr, fromBytePtr, numBytes);
+    fromBytePtr += numBytes;
+    toBytePtr += numBytes;
+    numBits -= numBytes*8;
+  } else {
+    while (numBits >= 8) {
+      unsigned char byte = fromBitRem == 0 ? fromBytePtr[0]
+	: (unsigned char)((fromBytePtr[0]<<fromBitRem)|(fromBytePtr[1]>>(8-fromBitRem)));
+      if (toBitRem == 0) {
+	toBytePtr[0] = byte;
+      } else {
+	toBytePtr[0] = (toBytePtr[0]&~(0xFF>>toBitRem))|(byte>>toBitRem);
+	toBytePtr[1] = (toBytePtr[1]&(0xFF>>toBitRem))|(unsigned char)(byte<<(8-toBitRem));
+      }
+      ++fromBytePtr;
+      ++toBytePtr;
+      numBits -= 8;
+    }
+  }
+
+  // Then move any remaining bits one at a time:
+
   while (numBits-- > 0) {
     unsigned char fromBitMask = singleBitMask[fromBitRem];
     unsigned char fromBit = (*fromBytePtr)&fromBitMask;
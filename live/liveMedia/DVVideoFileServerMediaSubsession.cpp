@@ -75,6 +75,10 @@ float DVVideoFileServerMediaSubsession::duration() const {
   return fFileDuration;
 }
 
+char* DVVideoFileServerMediaSubsession::sdpCacheKey() {
+  return NULL; // because "fFileDuration" gets set only when we create a source
+}
+
 void DVVideoFileServerMediaSubsession
 ::seekStreamSource(FramedSource* inputSource, double& seekNPT, double streamDuration, u_int64_t& numBytes) {
   // First, get the file source from "inputSource" (a framer):
@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "FileServerMediaSubsession.hh"
+#include "InputFile.hh"
 
 FileServerMediaSubsession
 ::FileServerMediaSubsession(UsageEnvironment& env, char const* fileName,
@@ -32,3 +33,16 @@ FileServerMediaSubsession
 FileServerMediaSubsession::~FileServerMediaSubsession() {
   delete[] (char*)fFileName;
 }
+
+char* FileServerMediaSubsession::sdpCacheKey() {
+#if !defined(_WIN32_WCE)
+  struct stat sb;
+  if (fFileName == NULL || stat(fFileName, &sb) != 0) return NULL;
+
+  char* key = new char[strlen(fFileName) + 50];
+  sprintf(key, "%s|%lu|%lu", fFileName, (unsigned long)sb.st_size, (unsigned long)sb.st_mtime);
+  return key;
+#else
+  return NULL;
+#endif
+}
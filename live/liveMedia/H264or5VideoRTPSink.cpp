@@ -41,6 +41,7 @@ public:
 private: // redefined virtual functions:
   virtual void doGetNextFrame();
   virtual void doStopGettingFrames();
+  virtual unsigned maxFrameSize() const;
 
 private:
   static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -56,6 +57,7 @@ private:
 private:
   int fHNumber;
   unsigned fInputBufferSize;
+  unsigned fNewInputBufferSize; // if larger than "fInputBufferSize", we enlarge the buffer before reading the next NAL unit
   unsigned fMaxOutputPacketSize;
   unsigned char* fInputBuffer;
   unsigned fNumValidDataBytes;
@@ -116,7 +118,9 @@ Boolean H264or5VideoRTPSink::continuePlaying() {
   // First, check whether we have a 'fragmenter' class set up yet.
   // If not, create it now:
   if (fOurFragmenter == NULL) {
-    fOurFragmenter = new H264or5Fragmenter(fHNumber, envir(), fSource, OutPacketBuffer::maxSize,
+    unsigned inputBufferMax = fSource->maxFrameSize();
+    if (inputBufferMax < OutPacketBuffer::maxSize) inputBufferMax = OutPacketBuffer::maxSize;
+    fOurFragmenter = new H264or5Fragmenter(fHNumber, envir(), fSource, inputBufferMax,
 					   ourMaxPacketSize() - 12/*RTP hdr size*/);
   } else {
     fOurFragmenter->reassignInputSource(fSource);
@@ -163,7 +167,7 @@ H264or5Fragmenter::H264or5Fragmenter(int hNumber,
 				     unsigned inputBufferMax, unsigned maxOutputPacketSize)
   : FramedFilter(env, inputSource),
     fHNumber(hNumber),
-    fInputBufferSize(inputBufferMax+1), fMaxOutputPacketSize(maxOutputPacketSize) {
+    fInputBufferSize(inputBufferMax+1), fNewInputBufferSize(0), fMaxOutputPacketSize(maxOutputPacketSize) {
   fInputBuffer = new unsigned char[fInputBufferSize];
   reset();
 }
@@ -175,7 +179,12 @@ H264or5Fragmenter::~H264or5Fragmenter() {
 
 void H264or5Fragmenter::doGetNextFrame() {
   if (fNumValidDataBytes == 1) {
-    // We have no NAL unit data currently in the buffer.  Read a new one:
+    // We have no NAL unit data currently in the buffer.  Read a new one (first enlarging the buffer, if we need to):
+    if (fNewInputBufferSize > fInputBufferSize) {
+      delete[] fInputBuffer;
+      fInputBufferSize = fNewInputBufferSize;
+      fInputBuffer = new unsigned char[fInputBufferSize];
+    }
     fInputSource->getNextFrame(&fInputBuffer[1], fInputBufferSize - 1,
 			       afterGettingFrame, this,
 			       FramedSource::handleClosure, this);
@@ -270,6 +279,11 @@ void H264or5Fragmenter::doStopGettingFrames() {
   FramedFilter::doStopGettingFrames();
 }
 
+unsigned H264or5Fragmenter::maxFrameSize() const {
+  // We deliver at most one RTP packet's worth of data at a time:
+  return fMaxOutputPacketSize;
+}
+
 void H264or5Fragmenter::afterGettingFrame(void* clientData, unsigned frameSize,
 					  unsigned numTruncatedBytes,
 					  struct timeval presentationTime,
@@ -285,6 +299,13 @@ void H264or5Fragmenter::afterGettingFrame1(unsigned frameSize,
 					   unsigned durationInMicroseconds) {
   fNumValidDataBytes += frameSize;
   fSaveNumTruncatedBytes = numTruncatedBytes;
+
+  // If this NAL unit was truncated, or used more than half of our buffer, then arrange for the buffer
+  // to be enlarged (to twice the NAL unit's size) before we read the next NAL unit:
+  unsigned newInputBufferSize = 1 + 2*(frameSize + numTruncatedBytes);
+  if (newInputBufferSize > fInputBufferSize && newInputBufferSize > fNewInputBufferSize) {
+    fNewInputBufferSize = newInputBufferSize;
+  }
   fPresentationTime = presentationTime;
   fDurationInMicroseconds = durationInMicroseconds;
 
@@ -177,3 +177,7 @@ void MP3AudioFileServerMediaSubsession::testScaleFactor(float& scale) {
 float MP3AudioFileServerMediaSubsession::duration() const {
   return fFileDuration;
 }
+
+char* MP3AudioFileServerMediaSubsession::sdpCacheKey() {
+  return NULL; // because "fFileDuration" gets set only when we create a source
+}
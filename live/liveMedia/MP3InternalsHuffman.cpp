@@ -330,12 +330,49 @@ struct huffcodetab {
   unsigned char *hlen;	/*pointer to array[xlen][ylen]		*/
   unsigned char(*val)[2];/*decoder tree				*/
   unsigned int treelen;	/*length of decoder tree		*/
+  unsigned short* lookup;/*multi-bit lookup table for the decoder tree, or NULL */
 };
 
 static struct huffcodetab rsf_ht[HTN]; // array of all huffcodetable headers
 				/* 0..31 Huffman code table 0..31	*/
 				/* 32,33 count1-tables			*/
 
+// To speed up decoding, we look up the next "HUFF_LOOKUP_BITS" bits of input in a table
+// (built from each decoder tree) that tells us either
+//   - the decoded value, and the length of its code (if it's no more than "HUFF_LOOKUP_BITS"), or
+//   - the tree position that we reach after "HUFF_LOOKUP_BITS" bits (for longer codes), or
+//   - that we must walk the tree from the start, one bit at a time (for malformed trees).
+#define HUFF_LOOKUP_BITS 8
+#define HUFF_LOOKUP_LEAF 0x4000 /* | (code length<<8) | value */
+#define HUFF_LOOKUP_CONTINUE 0x8000 /* | tree position */
+#define HUFF_LOOKUP_SLOW 0
+
+static void buildHuffmanDecodingTable(struct huffcodetab* h) {
+  h->lookup = new unsigned short[1<<HUFF_LOOKUP_BITS];
+
+  for (unsigned prefix = 0; prefix < (1<<HUFF_LOOKUP_BITS); ++prefix) {
+    // Walk the tree the same way that "rsf_huffman_decoder()" does:
+    unsigned short entry = HUFF_LOOKUP_SLOW;
+    unsigned point = 0;
+    for (unsigned numBits = 0; point < h->treelen; ++numBits) {
+      if (h->val[point][0] == 0) { /*end of tree*/
+	entry = HUFF_LOOKUP_LEAF|(numBits<<8)|h->val[point][1];
+	break;
+      }
+      if (numBits == HUFF_LOOKUP_BITS) {
+	entry = HUFF_LOOKUP_CONTINUE|point;
+	break;
+      }
+
+      unsigned bit = (prefix>>(HUFF_LOOKUP_BITS-1-numBits))&1;
+      while (point < h->treelen && h->val[point][bit] >= MXOFF) point += h->val[point][bit];
+      if (point >= h->treelen) break;
+      point += h->val[point][bit];
+    }
+    h->lookup[prefix] = entry;
+  }
+}
+
 /* read the huffman decoder table */
 static int read_decoder_table(unsigned char* fi) {
   int n,i,nn,t;
@@ -344,6 +381,7 @@ static int read_decoder_table(unsigned char* fi) {
   for (n=0;n<HTN;n++) {
     rsf_ht[n].table = NULL;
     rsf_ht[n].hlen = NULL;
+    rsf_ht[n].lookup = NULL;
 
     /* .table number treelen xlen ylen linbits */
     do {
@@ -378,6 +416,7 @@ static int read_decoder_table(unsigned char* fi) {
       rsf_ht[n].ref   = t;
       rsf_ht[n].val   = rsf_ht[t].val;
       rsf_ht[n].treelen  = rsf_ht[t].treelen;
+      rsf_ht[n].lookup = rsf_ht[t].lookup;
       if ( (rsf_ht[n].xlen != rsf_ht[t].xlen) ||
            (rsf_ht[n].ylen != rsf_ht[t].ylen)  ) {
 #ifdef DEBUG
@@ -407,6 +446,7 @@ static int read_decoder_table(unsigned char* fi) {
         rsf_ht[n].val[i][1]=(unsigned char)v1;
       }
       rsf_getline(line,99,&fi); /* read the rest of the line */
+      if (rsf_ht[n].treelen != 0) buildHuffmanDecodingTable(&rsf_ht[n]);
     }
     else {
 #ifdef DEBUG
@@ -534,19 +574,128 @@ static unsigned getScaleFactorsLength(MP3SideInfo::gr_info_s_t* gr,
                  : rsf_get_scale_factors_1(gr);
 }
 
-static int rsf_huffman_decoder(BitVector& bv,
+// A bit reader - used for Huffman decoding - that behaves like "BitVector" (including
+// returning 0 bits past the end), but that keeps up to 64 bits of upcoming input in a register,
+// refilling it a word at a time:
+class HuffmanBitReader {
+public:
+  HuffmanBitReader(unsigned char const* baseBytePtr, unsigned baseBitOffset, unsigned totNumBits)
+    : fBaseBytePtr(baseBytePtr), fBaseBitOffset(baseBitOffset), fTotNumBits(totNumBits) {
+    fEndBytePtr = baseBytePtr + (baseBitOffset + totNumBits + 7)/8;
+    seek(0);
+  }
+
+  unsigned curBitIndex() const { return fCurBitIndex; }
+  unsigned totNumBits() const { return fTotNumBits; }
+
+  unsigned peekBits(unsigned numBits) { // 1 <= "numBits" <= 32
+    if (fNumCachedBits < numBits) refill();
+    unsigned result = (unsigned)(fCache>>(64-numBits));
+
+    unsigned numBitsRemaining = fTotNumBits - fCurBitIndex;
+    if (numBits > numBitsRemaining) { // any bits past the end are 0
+      result &= ~0U << (numBits - numBitsRemaining);
+    }
+    return result;
+  }
+
+  void skipBits(unsigned numBits) {
+    unsigned numBitsRemaining = fTotNumBits - fCurBitIndex;
+    if (numBits > numBitsRemaining) numBits = numBitsRemaining;
+
+    if (numBits < fNumCachedBits) {
+      fCurBitIndex += numBits;
+      fCache <<= numBits;
+      fNumCachedBits -= numBits;
+    } else {
+      seek(fCurBitIndex + numBits);
+    }
+  }
+
+  unsigned getBits(unsigned numBits) { // "numBits" <= 32
+    if (numBits == 0) return 0;
+    unsigned result = peekBits(numBits);
+    skipBits(numBits);
+    return result;
+  }
+
+  unsigned get1Bit() { return getBits(1); }
+
+private:
+  void seek(unsigned bitIndex) {
+    fCurBitIndex = bitIndex;
+    unsigned totBitOffset = fBaseBitOffset + bitIndex;
+    fNextBytePtr = fBaseBytePtr + totBitOffset/8;
+    fCache = 0;
+    fNumCachedBits = 0;
+    refill();
+    unsigned numBitsToDiscard = totBitOffset%8;
+    fCache <<= numBitsToDiscard;
+    fNumCachedBits = fNumCachedBits > numBitsToDiscard ? fNumCachedBits - numBitsToDiscard : 0;
+  }
+
+  void refill() {
+    if (fNumCachedBits <= 32 && fNextBytePtr + 4 <= fEndBytePtr) {
+      u_int32_t word = (fNextBytePtr[0]<<24)|(fNextBytePtr[1]<<16)|(fNextBytePtr[2]<<8)|fNextBytePtr[3];
+      fCache |= (u_int64_t)word<<(32-fNumCachedBits);
+      fNumCachedBits += 32;
+      fNextBytePtr += 4;
+    }
+    while (fNumCachedBits <= 56 && fNextBytePtr < fEndBytePtr) {
+      fCache |= (u_int64_t)(*fNextBytePtr++)<<(56-fNumCachedBits);
+      fNumCachedBits += 8;
+    }
+    // Note: Past the end of the data, the cache gets (implicitly) filled with 0 bits
+  }
+
+private:
+  unsigned char const* fBaseBytePtr;
+  unsigned char const* fNextBytePtr;
+  unsigned char const* fEndBytePtr;
+  unsigned fBaseBitOffset, fTotNumBits, fCurBitIndex;
+  u_int64_t fCache; // the next "fNumCachedBits" bits of input, in the high-order bits
+  unsigned fNumCachedBits;
+};
+
+template <class BitReader>
+static int rsf_huffman_decoder(BitReader& bv,
 			       struct huffcodetab const* h,
 			       int* x, int* y, int* v, int* w); // forward
 
+static Boolean useReferenceDecoding = False;
+
+void setMP3HuffmanReferenceDecoding(Boolean useReferenceDecoder) {
+  useReferenceDecoding = useReferenceDecoder;
+}
+
+template <class BitReader>
+static void huffmanDecode(BitReader& bv,
+			  MP3SideInfo::gr_info_s_t* gr, Boolean isMPEG2,
+			  unsigned& scaleFactorsLength,
+			  MP3HuffmanEncodingInfo& hei); // forward
+
 void MP3HuffmanDecode(MP3SideInfo::gr_info_s_t* gr, Boolean isMPEG2,
 		      unsigned char const* fromBasePtr,
 		      unsigned fromBitOffset, unsigned fromLength,
 		      unsigned& scaleFactorsLength,
 		      MP3HuffmanEncodingInfo& hei) {
+  if (useReferenceDecoding) {
+    BitVector bv((unsigned char*)fromBasePtr, fromBitOffset, fromLength);
+    huffmanDecode(bv, gr, isMPEG2, scaleFactorsLength, hei);
+  } else {
+    HuffmanBitReader bv(fromBasePtr, fromBitOffset, fromLength);
+    huffmanDecode(bv, gr, isMPEG2, scaleFactorsLength, hei);
+  }
+}
+
+template <class BitReader>
+static void huffmanDecode(BitReader& bv,
+			  MP3SideInfo::gr_info_s_t* gr, Boolean isMPEG2,
+			  unsigned& scaleFactorsLength,
+			  MP3HuffmanEncodingInfo& hei) {
    unsigned i;
    int x, y, v, w;
    struct huffcodetab *h;
-   BitVector bv((unsigned char*)fromBasePtr, fromBitOffset, fromLength);
 
    /* Compute the size of the scale factors (& also advance bv): */
    scaleFactorsLength = getScaleFactorsLength(gr, isMPEG2);
@@ -608,8 +757,37 @@ void MP3HuffmanDecode(MP3SideInfo::gr_info_s_t* gr, Boolean isMPEG2,
 HUFFBITS dmask = 1 << (SIZEOF_HUFFBITS*8-1);
 unsigned int hs = SIZEOF_HUFFBITS*8;
 
+// Tries to decode the next Huffman code by looking up its first "HUFF_LOOKUP_BITS" bits in "h"s lookup table.
+// Returns True iff this got us all the way to the decoded value.  Otherwise, "point" and "level" are
+// updated to the tree position from which we should continue walking, one bit at a time:
+static Boolean lookupHuffmanCode(HuffmanBitReader& bv, struct huffcodetab const* h,
+				 int* x, int* y, unsigned& point, HUFFBITS& level) {
+  if (h->lookup == NULL) return False;
+
+  unsigned short entry = h->lookup[bv.peekBits(HUFF_LOOKUP_BITS)];
+  if (entry&HUFF_LOOKUP_LEAF) {
+    bv.skipBits((entry>>8)&0x3F);
+    *x = (entry>>4)&0xf;
+    *y = entry&0xf;
+    return True;
+  } else if (entry&HUFF_LOOKUP_CONTINUE) {
+    // Continue walking the tree, one bit at a time, from where those bits took us:
+    bv.skipBits(HUFF_LOOKUP_BITS);
+    point = entry&~HUFF_LOOKUP_CONTINUE;
+    level >>= HUFF_LOOKUP_BITS;
+  }
+  return False;
+}
+
+// The reference decoder - which reads from a "BitVector" - always walks the tree one bit at a time:
+static Boolean lookupHuffmanCode(BitVector& /*bv*/, struct huffcodetab const* /*h*/,
+				 int* /*x*/, int* /*y*/, unsigned& /*point*/, HUFFBITS& /*level*/) {
+  return False;
+}
+
 /* do the huffman-decoding 						*/
-static int rsf_huffman_decoder(BitVector& bv,
+template <class BitReader>
+static int rsf_huffman_decoder(BitReader& bv,
 		struct huffcodetab const* h, // ptr to huffman code record
 			/* unsigned */ int *x, // returns decoded x value
 			/* unsigned */ int *y,  // returns decoded y value
@@ -626,6 +804,12 @@ static int rsf_huffman_decoder(BitVector& bv,
 
   /* Lookup in Huffman table. */
 
+  // First, try to decode using the next few bits at once:
+  if (lookupHuffmanCode(bv, h, x, y, point, level)) {
+    error = 0;
+    goto signs;
+  }
+
   do {
     if (h->val[point][0]==0) {   /*end of tree*/
       *x = h->val[point][1] >> 4;
@@ -656,6 +840,7 @@ static int rsf_huffman_decoder(BitVector& bv,
 
   /* Process sign encodings for quadruples tables. */
 
+ signs:
   if (h->tablename[0] == '3'
       && (h->tablename[1] == '2' || h->tablename[1] == '3')) {
      *v = (*y>>3) & 1;
@@ -58,6 +58,10 @@ void MP3HuffmanDecode(MP3SideInfo::gr_info_s_t* gr, Boolean isMPEG2,
 		      unsigned& scaleFactorsLength,
 		      MP3HuffmanEncodingInfo& hei);
 
+// For testing: Makes "MP3HuffmanDecode()" decode the original (slower) way - walking each
+// decoder tree one bit at a time, from a "BitVector" - rather than using lookup tables:
+void setMP3HuffmanReferenceDecoding(Boolean useReferenceDecoder);
+
 extern unsigned char huffdec[]; // huffman table data
 
 // The following are used if we process Huffman-decoded values
@@ -49,6 +49,9 @@ public:
 	      unsigned long transportPacketNumber, float pcr);
   virtual ~IndexRecord();
 
+  void reinit(u_int8_t startOffset, u_int8_t size,
+	      unsigned long transportPacketNumber, float pcr); // used when reusing a freed record
+
   RecordType& recordType() { return fRecordType; }
   void setFirstFlag() { fRecordType = (RecordType)(((u_int8_t)fRecordType) | 0x80); }
   u_int8_t startOffset() const { return fStartOffset; }
@@ -60,6 +63,8 @@ public:
   void addAfter(IndexRecord* prev);
   void unlink();
 
+  IndexRecord*& nextFree() { return fNext; } // used only while the record is in a 'free list'
+
 private:
   // Index records are maintained in a doubly-linked list:
   IndexRecord* fNext;
@@ -130,42 +135,65 @@ MPEG2IFrameIndexFromTransportStream
     fInputTransportPacketCounter((unsigned)-1), fClosureNumber(0), fLastContinuityCounter(~0),
     fFirstPCR(0.0), fLastPCR(0.0), fHaveSeenFirstPCR(False),
     fPMT_PID(0x10), fVideo_PID(0xE0), // default values
+    fInputBufferDataStart(0), fInputBufferDataEnd(0),
     fParseBufferSize(PARSE_BUFFER_SIZE),
     fParseBufferFrameStart(0), fParseBufferParseEnd(4), fParseBufferDataEnd(0),
-    fHeadIndexRecord(NULL), fTailIndexRecord(NULL) {
+    fHeadIndexRecord(NULL), fTailIndexRecord(NULL), fFreeIndexRecords(NULL) {
   fParseBuffer = new unsigned char[fParseBufferSize];
 }
 
 MPEG2IFrameIndexFromTransportStream::~MPEG2IFrameIndexFromTransportStream() {
-  delete fHeadIndexRecord;
+  while (fHeadIndexRecord != NULL) {
+    IndexRecord* next = fHeadIndexRecord->next();
+    fHeadIndexRecord->unlink();
+    delete fHeadIndexRecord;
+    fHeadIndexRecord = next == fHeadIndexRecord ? NULL : next;
+  }
+  while (fFreeIndexRecords != NULL) {
+    IndexRecord* next = fFreeIndexRecords->nextFree();
+    delete fFreeIndexRecords;
+    fFreeIndexRecords = next;
+  }
   delete[] fParseBuffer;
 }
 
 void MPEG2IFrameIndexFromTransportStream::doGetNextFrame() {
-  // Begin by trying to deliver an index record (for an already-parsed frame)
-  // to the client:
-  if (deliverIndexRecord()) return;
+  while (1) {
+    // Begin by trying to deliver an index record (for an already-parsed frame)
+    // to the client:
+    if (deliverIndexRecord()) return;
 
-  // No more index records are left to deliver, so try to parse a new frame:
-  if (parseFrame()) { // success - try again
-    doGetNextFrame();
-    return;
-  }
+    // No more index records are left to deliver, so try to parse a new frame:
+    if (parseFrame()) continue; // success - try again
 
-  // We need to read some more Transport Stream packets.  Check whether we have room:
-  if (fParseBufferSize - fParseBufferDataEnd < TRANSPORT_PACKET_SIZE) {
-    // There's no room left.  Compact the buffer, and check again:
-    compactParseBuffer();
+    // We need some more Transport Stream packets.  Check whether we have room:
     if (fParseBufferSize - fParseBufferDataEnd < TRANSPORT_PACKET_SIZE) {
-      envir() << "ERROR: parse buffer full; increase MAX_FRAME_SIZE\n";
-      // Treat this as if the input source ended:
-      handleInputClosure1();
-      return;
+      // There's no room left.  Compact the buffer, and check again:
+      compactParseBuffer();
+      if (fParseBufferSize - fParseBufferDataEnd < TRANSPORT_PACKET_SIZE) {
+	envir() << "ERROR: parse buffer full; increase MAX_FRAME_SIZE\n";
+	// Treat this as if the input source ended:
+	handleInputClosure1();
+	return;
+      }
+    }
+
+    // If we've already read another complete Transport Stream packet, then use it:
+    if (fInputBufferDataEnd - fInputBufferDataStart >= TRANSPORT_PACKET_SIZE) {
+      unsigned char* pkt = &fInputBuffer[fInputBufferDataStart];
+      fInputBufferDataStart += TRANSPORT_PACKET_SIZE;
+      if (!addTransportPacket(pkt)) return;
+      continue;
     }
+    break;
   }
 
-  // Arrange to read a new Transport Stream packet:
-  fInputSource->getNextFrame(fInputBuffer, sizeof fInputBuffer,
+  // Arrange to read more Transport Stream packets (after any partial packet that we still have):
+  unsigned numRemainingBytes = fInputBufferDataEnd - fInputBufferDataStart;
+  memmove(fInputBuffer, &fInputBuffer[fInputBufferDataStart], numRemainingBytes);
+  fInputBufferDataStart = 0;
+  fInputBufferDataEnd = numRemainingBytes;
+  fInputSource->getNextFrame(&fInputBuffer[fInputBufferDataEnd], sizeof fInputBuffer - fInputBufferDataEnd,
 			     afterGettingFrame, this,
 			     handleInputClosure, this);
 }
@@ -188,37 +216,45 @@ void MPEG2IFrameIndexFromTransportStream
 		     unsigned numTruncatedBytes,
 		     struct timeval presentationTime,
 		     unsigned durationInMicroseconds) {
-  if (frameSize < TRANSPORT_PACKET_SIZE || fInputBuffer[0] != TRANSPORT_SYNC_BYTE) {
-    if (fInputBuffer[0] != TRANSPORT_SYNC_BYTE) {
-      envir() << "Bad TS sync byte: 0x" << fInputBuffer[0] << "\n";
-    }
+  fInputBufferDataEnd += frameSize;
+  if (frameSize == 0) {
     // Handle this as if the source ended:
     handleInputClosure1();
     return;
   }
 
+  doGetNextFrame();
+}
+
+Boolean MPEG2IFrameIndexFromTransportStream::addTransportPacket(unsigned char* pkt) {
+  if (pkt[0] != TRANSPORT_SYNC_BYTE) {
+    envir() << "Bad TS sync byte: 0x" << pkt[0] << "\n";
+    // Handle this as if the source ended:
+    handleInputClosure1();
+    return False;
+  }
+
   ++fInputTransportPacketCounter;
 
   // Figure out how much of this Transport Packet contains PES data:
-  u_int8_t adaptation_field_control = (fInputBuffer[3]&0x30)>>4;
+  u_int8_t adaptation_field_control = (pkt[3]&0x30)>>4;
   u_int8_t totalHeaderSize
-    = adaptation_field_control <= 1 ? 4 : 5 + fInputBuffer[4];
+    = adaptation_field_control <= 1 ? 4 : 5 + pkt[4];
   if ((adaptation_field_control == 2 && totalHeaderSize != TRANSPORT_PACKET_SIZE) ||
       (adaptation_field_control == 3 && totalHeaderSize >= TRANSPORT_PACKET_SIZE)) {
-    envir() << "Bad \"adaptation_field_length\": " << fInputBuffer[4] << "\n";
-    doGetNextFrame();
-    return;
+    envir() << "Bad \"adaptation_field_length\": " << pkt[4] << "\n";
+    return True;
   }
 
   // Check for a PCR:
-  if (totalHeaderSize > 5 && (fInputBuffer[5]&0x10) != 0) {
+  if (totalHeaderSize > 5 && (pkt[5]&0x10) != 0) {
     // There's a PCR:
     u_int32_t pcrBaseHigh
-      = (fInputBuffer[6]<<24)|(fInputBuffer[7]<<16)
-      |(fInputBuffer[8]<<8)|fInputBuffer[9];
+      = (pkt[6]<<24)|(pkt[7]<<16)
+      |(pkt[8]<<8)|pkt[9];
     float pcr = pcrBaseHigh/45000.0f;
-    if ((fInputBuffer[10]&0x80) != 0) pcr += 1/90000.0f; // add in low-bit (if set)
-    unsigned short pcrExt = ((fInputBuffer[10]&0x01)<<8) | fInputBuffer[11];
+    if ((pkt[10]&0x80) != 0) pcr += 1/90000.0f; // add in low-bit (if set)
+    unsigned short pcrExt = ((pkt[10]&0x01)<<8) | pkt[11];
     pcr += pcrExt/27000000.0f;
 
     if (!fHaveSeenFirstPCR) {
@@ -236,50 +272,48 @@ void MPEG2IFrameIndexFromTransportStream
   }
 
   // Get the PID from the packet, and check for special tables: the PAT and PMT:
-  u_int16_t PID = ((fInputBuffer[1]&0x1F)<<8) | fInputBuffer[2];
+  u_int16_t PID = ((pkt[1]&0x1F)<<8) | pkt[2];
   if (PID == PAT_PID) {
-    analyzePAT(&fInputBuffer[totalHeaderSize], TRANSPORT_PACKET_SIZE-totalHeaderSize);
+    analyzePAT(&pkt[totalHeaderSize], TRANSPORT_PACKET_SIZE-totalHeaderSize);
   } else if (PID == fPMT_PID) {
-    analyzePMT(&fInputBuffer[totalHeaderSize], TRANSPORT_PACKET_SIZE-totalHeaderSize);
+    analyzePMT(&pkt[totalHeaderSize], TRANSPORT_PACKET_SIZE-totalHeaderSize);
   }
 
   // Ignore transport packets for non-video programs,
   // or packets with no data, or packets that duplicate the previous packet:
-  u_int8_t continuity_counter = fInputBuffer[3]&0x0F;
+  u_int8_t continuity_counter = pkt[3]&0x0F;
   if ((PID != fVideo_PID) ||
       !(adaptation_field_control == 1 || adaptation_field_control == 3) ||
       continuity_counter == fLastContinuityCounter) {
-    doGetNextFrame();
-    return;
+    return True;
   }
   fLastContinuityCounter = continuity_counter;
 
   // Also, if this is the start of a PES packet, then skip over the PES header:
-  Boolean payload_unit_start_indicator = (fInputBuffer[1]&0x40) != 0;
+  Boolean payload_unit_start_indicator = (pkt[1]&0x40) != 0;
   if (payload_unit_start_indicator && totalHeaderSize < TRANSPORT_PACKET_SIZE - 8 
-      && fInputBuffer[totalHeaderSize] == 0x00 && fInputBuffer[totalHeaderSize+1] == 0x00
-      && fInputBuffer[totalHeaderSize+2] == 0x01) {
-    u_int8_t PES_header_data_length = fInputBuffer[totalHeaderSize+8];
+      && pkt[totalHeaderSize] == 0x00 && pkt[totalHeaderSize+1] == 0x00
+      && pkt[totalHeaderSize+2] == 0x01) {
+    u_int8_t PES_header_data_length = pkt[totalHeaderSize+8];
     totalHeaderSize += 9 + PES_header_data_length;
     if (totalHeaderSize >= TRANSPORT_PACKET_SIZE) {
       envir() << "Unexpectedly large PES header size: " << PES_header_data_length << "\n";
       // Handle this as if the source ended:
       handleInputClosure1();
-      return;
+      return False;
     }
   }
 
   // The remaining data is Video Elementary Stream data.  Add it to our parse buffer:
   unsigned vesSize = TRANSPORT_PACKET_SIZE - totalHeaderSize;
-  memmove(&fParseBuffer[fParseBufferDataEnd], &fInputBuffer[totalHeaderSize], vesSize);
+  memmove(&fParseBuffer[fParseBufferDataEnd], &pkt[totalHeaderSize], vesSize);
   fParseBufferDataEnd += vesSize;
 
   // And add a new index record noting where it came from:
-  addToTail(new IndexRecord(totalHeaderSize, vesSize, fInputTransportPacketCounter,
-			    fLastPCR - fFirstPCR));
+  addToTail(newIndexRecord(totalHeaderSize, vesSize, fInputTransportPacketCounter,
+			   fLastPCR - fFirstPCR));
 
-  // Try again:
-  doGetNextFrame();
+  return True;
 }
 
 void MPEG2IFrameIndexFromTransportStream::handleInputClosure(void* clientData) {
@@ -363,26 +397,27 @@ void MPEG2IFrameIndexFromTransportStream
 }
 
 Boolean MPEG2IFrameIndexFromTransportStream::deliverIndexRecord() {
-  IndexRecord* head = fHeadIndexRecord;
-  if (head == NULL) return False;
-
-  // Check whether the head record has been parsed yet:
-  if (head->recordType() == RECORD_UNPARSED) return False;
+  IndexRecord* head;
+  while (1) {
+    head = fHeadIndexRecord;
+    if (head == NULL) return False;
+
+    // Check whether the head record has been parsed yet:
+    if (head->recordType() == RECORD_UNPARSED) return False;
+
+    // Remove the head record (the one whose data we'll be delivering):
+    IndexRecord* next = head->next();
+    head->unlink();
+    if (next == head) {
+      fHeadIndexRecord = fTailIndexRecord = NULL;
+    } else {
+      fHeadIndexRecord = next;
+    }
 
-  // Remove the head record (the one whose data we'll be delivering):
-  IndexRecord* next = head->next();
-  head->unlink();
-  if (next == head) {
-    fHeadIndexRecord = fTailIndexRecord = NULL;
-  } else {
-    fHeadIndexRecord = next;
-  }
+    if (head->recordType() != RECORD_JUNK) break;
 
-  if (head->recordType() == RECORD_JUNK) {
-    // Don't actually deliver the data to the client:
-    delete head;
-    // Try to deliver the next record instead:
-    return deliverIndexRecord();
+    // Don't actually deliver the data to the client; try to deliver the next record instead:
+    freeIndexRecord(head);
   }
 
   // Deliver data from the head record:
@@ -413,7 +448,7 @@ Boolean MPEG2IFrameIndexFromTransportStream::deliverIndexRecord() {
   }
 
   // Free the (former) head record (as we're now done with it):
-  delete head;
+  freeIndexRecord(head);
 
   // Complete delivery to the client:
   afterGetting(this);
@@ -581,7 +616,7 @@ Boolean MPEG2IFrameIndexFromTransportStream::parseFrame() {
 #endif
 
       IndexRecord* newRecord
-	= new IndexRecord(newOffset, newSize, r->transportPacketNumber(), r->pcr());
+	= newIndexRecord(newOffset, newSize, r->transportPacketNumber(), r->pcr());
       newRecord->addAfter(r);
       if (fTailIndexRecord == r) fTailIndexRecord = newRecord;
 #ifdef DEBUG
@@ -609,20 +644,28 @@ Boolean MPEG2IFrameIndexFromTransportStream::parseFrame() {
 
 Boolean MPEG2IFrameIndexFromTransportStream
 ::parseToNextCode(unsigned char& nextCode) {
-  unsigned char const* p = &fParseBuffer[fParseBufferParseEnd];
+  if (fParseBufferDataEnd < fParseBufferParseEnd + 4) return False; // not enough data
+
+  // Look for each 0x01 byte (using "memchr()", which is usually much faster than a byte-by-byte
+  // loop), and check whether it's preceded by 0x00 0x00.  A code that begins at "p" must
+  // satisfy p+4 <= end, so its 0x01 byte lies within [start+2, end-2]:
+  unsigned char const* start = &fParseBuffer[fParseBufferParseEnd];
   unsigned char const* end = &fParseBuffer[fParseBufferDataEnd];
-  while (p <= end-4) {
-    if (p[2] > 1) p += 3; // common case (optimized)
-    else if (p[2] == 0) ++p;
-    else if (p[0] == 0 && p[1] == 0) { // && p[2] == 1
+  unsigned char const* searchFrom = start+2;
+  while (searchFrom <= end-2) {
+    unsigned char const* q = (unsigned char const*)memchr(searchFrom, 1, (end-1) - searchFrom);
+    if (q == NULL) break;
+
+    if (q[-1] == 0 && q[-2] == 0) {
       // We found a code here:
-      nextCode = p[3];
-      fParseBufferParseEnd = p - &fParseBuffer[0]; // where we've gotten to
+      nextCode = q[1];
+      fParseBufferParseEnd = (q-2) - &fParseBuffer[0]; // where we've gotten to
       return True;
-    } else p += 3;
+    }
+    searchFrom = q+1;
   }
 
-  fParseBufferParseEnd = p - &fParseBuffer[0]; // where we've gotten to
+  fParseBufferParseEnd = (end-3) - &fParseBuffer[0]; // where we've gotten to
   return False; // no luck this time
 }
 
@@ -642,6 +685,25 @@ void MPEG2IFrameIndexFromTransportStream::compactParseBuffer() {
 #endif
 }
 
+IndexRecord* MPEG2IFrameIndexFromTransportStream
+::newIndexRecord(u_int8_t startOffset, u_int8_t size,
+		 unsigned long transportPacketNumber, float pcr) {
+  // We create one record (or more) per Transport Stream packet, so reuse old records if we can,
+  // rather than allocating new ones:
+  IndexRecord* record = fFreeIndexRecords;
+  if (record == NULL) return new IndexRecord(startOffset, size, transportPacketNumber, pcr);
+
+  fFreeIndexRecords = record->nextFree();
+  record->reinit(startOffset, size, transportPacketNumber, pcr);
+  return record;
+}
+
+void MPEG2IFrameIndexFromTransportStream::freeIndexRecord(IndexRecord* record) {
+  // Note: "record" has already been unlinked from the list of index records
+  record->nextFree() = fFreeIndexRecords;
+  fFreeIndexRecords = record;
+}
+
 void MPEG2IFrameIndexFromTransportStream::addToTail(IndexRecord* newIndexRecord) {
 #ifdef DEBUG
   envir() << "adding new: " << *newIndexRecord << "\n";
@@ -664,9 +726,14 @@ IndexRecord::IndexRecord(u_int8_t startOffset, u_int8_t size,
 }
 
 IndexRecord::~IndexRecord() {
-  IndexRecord* nextRecord = next();
-  unlink();
-  if (nextRecord != this) delete nextRecord;
+}
+
+void IndexRecord::reinit(u_int8_t startOffset, u_int8_t size,
+			 unsigned long transportPacketNumber, float pcr) {
+  fNext = fPrev = this;
+  fRecordType = RECORD_UNPARSED;
+  fStartOffset = startOffset; fSize = size;
+  fPCR = pcr; fTransportPacketNumber = transportPacketNumber;
 }
 
 void IndexRecord::addAfter(IndexRecord* prev) {
@@ -306,6 +306,8 @@ void ClientTrickPlayState::updateStateOnScaleChange() {
     // And generate a Transport Stream from this:
     fTrickPlaySource = MPEG2TransportStreamFromESSource::createNew(env);
     fTrickPlaySource->addNewVideoSource(fTrickModeFilter, fIndexFile->mpegVersion());
+    fTrickPlaySource->setMaxNumTransportPacketsPerFrame(TRANSPORT_PACKETS_PER_NETWORK_PACKET);
+        // so that each frame that we deliver can fill a RTP packet
 
     fFramer->changeInputSource(fTrickPlaySource);
   } else {
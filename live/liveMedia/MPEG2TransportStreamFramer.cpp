@@ -73,7 +73,8 @@ MPEG2TransportStreamFramer* MPEG2TransportStreamFramer
 MPEG2TransportStreamFramer
 ::MPEG2TransportStreamFramer(UsageEnvironment& env, FramedSource* inputSource)
   : FramedFilter(env, inputSource),
-    fTSPacketCount(0), fTSPacketDurationEstimate(0.0), fTSPCRCount(0),
+    fTSPacketCount(0), fTSPacketDurationEstimate(0.0), fDurationRemainder(0.0),
+    fLastPCRPID(0), fLastPCRPIDStatus(NULL), fPCRDrift(0.0), fMaxPCRDrift(0.0), fTSPCRCount(0),
     fLimitNumTSPacketsToStream(False), fNumTSPacketsToStream(0),
     fLimitTSPacketsToStreamByPCR(False), fPCRLimit(0.0) {
   fPIDStatusTable = HashTable::create(ONE_WORD_HASH_KEYS);
@@ -89,6 +90,8 @@ void MPEG2TransportStreamFramer::clearPIDStatusTable() {
   while ((pidStatus = (PIDStatus*)fPIDStatusTable->RemoveNext()) != NULL) {
     delete pidStatus;
   }
+  fLastPCRPIDStatus = NULL;
+  fPCRDrift = fMaxPCRDrift = 0.0;
 }
 
 void MPEG2TransportStreamFramer::setNumTSPacketsToStream(unsigned long numTSRecordsToStream) {
@@ -123,6 +126,7 @@ void MPEG2TransportStreamFramer::doStopGettingFrames() {
   FramedFilter::doStopGettingFrames();
   fTSPacketCount = 0;
   fTSPCRCount = 0;
+  fDurationRemainder = 0.0;
 
   clearPIDStatusTable();
 }
@@ -185,8 +189,12 @@ void MPEG2TransportStreamFramer::afterGettingFrame1(unsigned frameSize,
     }
   }
 
-  fDurationInMicroseconds
-    = numTSPackets * (unsigned)(fTSPacketDurationEstimate*1000000);
+  // Compute the chunk's duration without first truncating the per-packet estimate, and carry
+  // any fractional microsecond over to the next chunk, so that rounding doesn't accumulate
+  // into drift from the PCR timeline:
+  double duration = numTSPackets*fTSPacketDurationEstimate*1000000 + fDurationRemainder;
+  fDurationInMicroseconds = (unsigned)duration;
+  fDurationRemainder = duration - fDurationInMicroseconds;
 
   // Complete the delivery to our client:
   afterGetting(this);
@@ -229,8 +237,14 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
 
   unsigned pid = ((pkt[1]&0x1F)<<8) | pkt[2];
 
-  // Check whether we already have a record of a PCR for this PID:
-  PIDStatus* pidStatus = (PIDStatus*)(fPIDStatusTable->Lookup((char*)pid));
+  // Check whether we already have a record of a PCR for this PID.
+  // (Usually, only one PID carries PCRs, so check our cached entry before the hash table.)
+  PIDStatus* pidStatus;
+  if (fLastPCRPIDStatus != NULL && pid == fLastPCRPID) {
+    pidStatus = fLastPCRPIDStatus;
+  } else {
+    pidStatus = (PIDStatus*)(fPIDStatusTable->Lookup((char*)pid));
+  }
 
   if (pidStatus == NULL) {
     // We're seeing this PID's PCR for the first time:
@@ -263,14 +277,32 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
 	+ fTSPacketDurationEstimate*(1-NEW_DURATION_WEIGHT);
 
       // Also adjust the duration estimate to try to ensure that the transmission
-      // rate matches the playout rate:
+      // rate matches the playout rate.  We aim to remove any excess drift over the next
+      // PCR interval (rather than just stepping by a fixed factor, which makes the
+      // transmission rate oscillate), but never adjust by more than "TIME_ADJUSTMENT_FACTOR":
       double transmitDuration = timeNow - pidStatus->firstRealTime;
       double playoutDuration = clock - pidStatus->firstClock;
+      double pcrInterval = durationPerPacket*packetsSinceLast;
+      double excessDrift = 0.0;
       if (transmitDuration > playoutDuration) {
-	fTSPacketDurationEstimate *= TIME_ADJUSTMENT_FACTOR; // reduce estimate
+	excessDrift = transmitDuration - playoutDuration; // we're late; reduce the estimate
       } else if (transmitDuration + MAX_PLAYOUT_BUFFER_DURATION < playoutDuration) {
-	fTSPacketDurationEstimate /= TIME_ADJUSTMENT_FACTOR; // increase estimate
+	excessDrift = transmitDuration + MAX_PLAYOUT_BUFFER_DURATION - playoutDuration;
+	    // we're early; increase the estimate
       }
+      if (excessDrift != 0.0) {
+	double adjustment = pcrInterval > 0.0 ? (pcrInterval - excessDrift)/pcrInterval : 0.0;
+	if (adjustment < TIME_ADJUSTMENT_FACTOR) {
+	  adjustment = TIME_ADJUSTMENT_FACTOR;
+	} else if (adjustment > 1/TIME_ADJUSTMENT_FACTOR) {
+	  adjustment = 1/TIME_ADJUSTMENT_FACTOR;
+	}
+	fTSPacketDurationEstimate *= adjustment;
+      }
+
+      fPCRDrift = transmitDuration - playoutDuration;
+      double absPCRDrift = fPCRDrift < 0.0 ? -fPCRDrift : fPCRDrift;
+      if (absPCRDrift > fMaxPCRDrift) fMaxPCRDrift = absPCRDrift;
     } else {
       // the PCR has a discontinuity from its previous value; don't use it now,
       // but reset our PCR and real-time values to compensate:
@@ -282,6 +314,9 @@ Boolean MPEG2TransportStreamFramer::updateTSPacketDurationEstimate(unsigned char
 #endif
   }
 
+  fLastPCRPID = pid;
+  fLastPCRPIDStatus = pidStatus;
+
   pidStatus->lastClock = clock;
   pidStatus->lastRealTime = timeNow;
   pidStatus->lastPacketNum = fTSPacketCount;
@@ -36,14 +36,21 @@ MPEG2TransportStreamMultiplexor
     fPreviousInputProgramMapVersion(0xFF), fCurrentInputProgramMapVersion(0xFF),
     fPCR_PID(0), fCurrentPID(0),
     fInputBuffer(NULL), fInputBufferSize(0), fInputBufferBytesUsed(0),
-    fIsFirstAdaptationField(True) {
+    fIsFirstAdaptationField(True), fMaxNumTransportPacketsPerFrame(1), fNumFramesDelivered(0),
+    fPATBuffer(new unsigned char[TRANSPORT_PACKET_SIZE - 4]),
+    fPMTBuffer(new unsigned char[TRANSPORT_PACKET_SIZE - 4]), fPMTBufferIsCurrent(False) {
   for (unsigned i = 0; i < PID_TABLE_SIZE; ++i) {
     fPIDState[i].counter = 0;
     fPIDState[i].streamType = 0;
   }
+
+  // The Program Association Table never changes, so we build it (and its CRC) only once:
+  buildPAT();
 }
 
 MPEG2TransportStreamMultiplexor::~MPEG2TransportStreamMultiplexor() {
+  delete[] fPATBuffer;
+  delete[] fPMTBuffer;
 }
 
 void MPEG2TransportStreamMultiplexor::doGetNextFrame() {
@@ -54,6 +61,29 @@ void MPEG2TransportStreamMultiplexor::doGetNextFrame() {
     return;
   }
 
+  // Deliver as many Transport packets as will fit in the client's buffer (up to our limit),
+  // stopping early if we run out of input data:
+  unsigned maxFrameSize = fMaxNumTransportPacketsPerFrame*TRANSPORT_PACKET_SIZE;
+  if (maxFrameSize > fMaxSize) maxFrameSize = fMaxSize;
+
+  fFrameSize = 0;
+  do {
+    deliverNextTransportPacket();
+  } while (fFrameSize + TRANSPORT_PACKET_SIZE <= maxFrameSize
+	   && fInputBufferBytesUsed < fInputBufferSize);
+
+  // NEED TO SET fPresentationTime, durationInMicroseconds #####
+  // Complete the delivery to the client:
+  if ((++fNumFramesDelivered%10) == 0) {
+    // To avoid excessive recursion (and stack overflow) caused by excessively large input frames,
+    // occasionally (i.e., for every 10th frame that we deliver) return to the event loop to do this:
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
+  } else {
+    afterGetting(this);
+  }
+}
+
+void MPEG2TransportStreamMultiplexor::deliverNextTransportPacket() {
   do {
     // Periodically return a Program Association Table packet instead:
     if (fOutgoingPacketCounter++ % PAT_PERIOD == 0) {
@@ -77,16 +107,6 @@ void MPEG2TransportStreamMultiplexor::doGetNextFrame() {
     deliverDataToClient(fCurrentPID, fInputBuffer, fInputBufferSize,
 			fInputBufferBytesUsed);
   } while (0);
-
-  // NEED TO SET fPresentationTime, durationInMicroseconds #####
-  // Complete the delivery to the client:
-  if ((fOutgoingPacketCounter%10) == 0) {
-    // To avoid excessive recursion (and stack overflow) caused by excessively large input frames,
-    // occasionally return to the event loop to do this:
-    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)FramedSource::afterGetting, this);
-  } else {
-    afterGetting(this);
-  }
 }
 
 void MPEG2TransportStreamMultiplexor
@@ -115,6 +135,7 @@ void MPEG2TransportStreamMultiplexor
     u_int8_t& streamType = fPIDState[fCurrentPID].streamType; // alias
 
     if (streamType == 0) {
+      fPMTBufferIsCurrent = False;
       // Instead, set the stream's type to default values, based on whether
       // the stream is audio or video, and whether it's MPEG-1 or MPEG-2:
       if ((stream_id&0xF0) == 0xE0) { // video
@@ -133,6 +154,7 @@ void MPEG2TransportStreamMultiplexor
       if ((!fHaveVideoStreams && (streamType == 3 || streamType == 4 || streamType == 6 || streamType == 0xF))/* audio stream */ ||
 	  (streamType == 1 || streamType == 2 || streamType == 0x10 || streamType == 0x1B || streamType == 0x24)/* video stream */) {
 	fPCR_PID = fCurrentPID; // use this stream's SCR for PCR
+	fPMTBufferIsCurrent = False;
       }
     }
     if (fCurrentPID == fPCR_PID) {
@@ -148,12 +170,11 @@ void MPEG2TransportStreamMultiplexor
 void MPEG2TransportStreamMultiplexor
 ::deliverDataToClient(u_int8_t pid, unsigned char* buffer, unsigned bufferSize,
 		      unsigned& startPositionInBuffer) {
-  // Construct a new Transport packet, and deliver it to the client:
-  if (fMaxSize < TRANSPORT_PACKET_SIZE) {
-    fFrameSize = 0; // the client hasn't given us enough space; deliver nothing
+  // Construct a new Transport packet, and append it to the data that we deliver to the client:
+  if (fFrameSize + TRANSPORT_PACKET_SIZE > fMaxSize) {
+    // the client hasn't given us enough space; deliver nothing more
     fNumTruncatedBytes = TRANSPORT_PACKET_SIZE;
   } else {
-    fFrameSize = TRANSPORT_PACKET_SIZE;
     Boolean willAddPCR = pid == fPCR_PID && startPositionInBuffer == 0
       && !(fPCR.highBit == 0 && fPCR.remainingBits == 0 && fPCR.extension == 0);
     unsigned const numBytesAvailable = bufferSize - startPositionInBuffer;
@@ -191,7 +212,8 @@ void MPEG2TransportStreamMultiplexor
     //         == TRANSPORT_PACKET_SIZE
 
     // Fill in the header of the Transport Stream packet:
-    unsigned char* header = fTo;
+    unsigned char* header = &fTo[fFrameSize];
+    fFrameSize += TRANSPORT_PACKET_SIZE;
     *header++ = 0x47; // sync_byte
     *header++ = (startPositionInBuffer == 0) ? 0x40 : 0x00;
       // transport_error_indicator, payload_unit_start_indicator, transport_priority,
@@ -243,12 +265,10 @@ void MPEG2TransportStreamMultiplexor
 #endif
 #define OUR_PROGRAM_MAP_PID 0x30
 
-void MPEG2TransportStreamMultiplexor::deliverPATPacket() {
-  // First, create a new buffer for the PAT packet:
-  unsigned const patSize = TRANSPORT_PACKET_SIZE - 4; // allow for the 4-byte header
-  unsigned char* patBuffer = new unsigned char[patSize];
+static unsigned const psiSize = TRANSPORT_PACKET_SIZE - 4; // allow for the 4-byte header
 
-  // and fill it in:
+void MPEG2TransportStreamMultiplexor::buildPAT() {
+  unsigned char* patBuffer = fPATBuffer; // alias
   unsigned char* pat = patBuffer;
   *pat++ = 0; // pointer_field
   *pat++ = 0; // table_id
@@ -267,24 +287,29 @@ void MPEG2TransportStreamMultiplexor::deliverPATPacket() {
   *pat++ = crc>>24; *pat++ = crc>>16; *pat++ = crc>>8; *pat++ = crc;
 
   // Fill in the rest of the packet with padding bytes:
-  while (pat < &patBuffer[patSize]) *pat++ = 0xFF;
+  while (pat < &patBuffer[psiSize]) *pat++ = 0xFF;
+}
 
-  // Deliver the packet:
+void MPEG2TransportStreamMultiplexor::deliverPATPacket() {
   unsigned startPosition = 0;
-  deliverDataToClient(PAT_PID, patBuffer, patSize, startPosition);
-
-  // Finally, remove the new buffer:
-  delete[] patBuffer;
+  deliverDataToClient(PAT_PID, fPATBuffer, psiSize, startPosition);
 }
 
 void MPEG2TransportStreamMultiplexor::deliverPMTPacket(Boolean hasChanged) {
-  if (hasChanged) ++fProgramMapVersion;
+  if (hasChanged) {
+    ++fProgramMapVersion;
+    fPMTBufferIsCurrent = False;
+  }
 
-  // First, create a new buffer for the PMT packet:
-  unsigned const pmtSize = TRANSPORT_PACKET_SIZE - 4; // allow for the 4-byte header
-  unsigned char* pmtBuffer = new unsigned char[pmtSize];
+  // Rebuild the table (and recompute its CRC) only if its contents have changed:
+  if (!fPMTBufferIsCurrent) buildPMT();
 
-  // and fill it in:
+  unsigned startPosition = 0;
+  deliverDataToClient(OUR_PROGRAM_MAP_PID, fPMTBuffer, psiSize, startPosition);
+}
+
+void MPEG2TransportStreamMultiplexor::buildPMT() {
+  unsigned char* pmtBuffer = fPMTBuffer; // alias
   unsigned char* pmt = pmtBuffer;
   *pmt++ = 0; // pointer_field
   *pmt++ = 2; // table_id
@@ -317,14 +342,9 @@ void MPEG2TransportStreamMultiplexor::deliverPMTPacket(Boolean hasChanged) {
   *pmt++ = crc>>24; *pmt++ = crc>>16; *pmt++ = crc>>8; *pmt++ = crc;
 
   // Fill in the rest of the packet with padding bytes:
-  while (pmt < &pmtBuffer[pmtSize]) *pmt++ = 0xFF;
-
-  // Deliver the packet:
-  unsigned startPosition = 0;
-  deliverDataToClient(OUR_PROGRAM_MAP_PID, pmtBuffer, pmtSize, startPosition);
+  while (pmt < &pmtBuffer[psiSize]) *pmt++ = 0xFF;
 
-  // Finally, remove the new buffer:
-  delete[] pmtBuffer;
+  fPMTBufferIsCurrent = True;
 }
 
 void MPEG2TransportStreamMultiplexor::setProgramStreamMap(unsigned frameSize) {
@@ -356,6 +376,7 @@ void MPEG2TransportStreamMultiplexor::setProgramStreamMap(unsigned frameSize) {
     u_int8_t elementary_stream_id = fInputBuffer[offset+1];
 
     fPIDState[elementary_stream_id].streamType = stream_type;
+    fPMTBufferIsCurrent = False;
 
     u_int16_t elementary_stream_info_length
       = (fInputBuffer[offset+2]<<8) | fInputBuffer[offset+3];
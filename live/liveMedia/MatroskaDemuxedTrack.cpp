@@ -25,21 +25,132 @@ void MatroskaDemuxedTrack::seekToTime(double& seekNPT) {
   fOurSourceDemux.seekToTime(seekNPT);
 }
 
+////////// MatroskaQueuedFrame //////////
+
+class MatroskaQueuedFrame {
+public:
+  MatroskaQueuedFrame(unsigned frameSize)
+    : fNext(NULL), fData(new u_int8_t[frameSize]), fFrameSize(frameSize), fDurationInMicroseconds(0) {
+  }
+  virtual ~MatroskaQueuedFrame() { delete[] fData; }
+
+public:
+  MatroskaQueuedFrame* fNext;
+  u_int8_t* fData;
+  unsigned fFrameSize;
+  struct timeval fPresentationTime;
+  unsigned fDurationInMicroseconds;
+};
+
+
+////////// MatroskaDemuxedTrack //////////
+
 MatroskaDemuxedTrack::MatroskaDemuxedTrack(UsageEnvironment& env, unsigned trackNumber, MatroskaDemux& sourceDemux)
   : FramedSource(env),
     fOurTrackNumber(trackNumber), fOurSourceDemux(sourceDemux), fDurationImbalance(0),
-    fOpusTrackNumber(0) {
+    fOpusTrackNumber(0),
+    fQueueHead(NULL), fQueueTail(NULL), fNewQueuedFrame(NULL), fNumQueuedBytes(0),
+    fHaveSeenEndOfInput(False) {
   fPrevPresentationTime.tv_sec = 0; fPrevPresentationTime.tv_usec = 0;
 }
 
 MatroskaDemuxedTrack::~MatroskaDemuxedTrack() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  flushQueuedFrames();
   fOurSourceDemux.removeTrack(fOurTrackNumber);
 }
 
 void MatroskaDemuxedTrack::doGetNextFrame() {
+  if (fQueueHead != NULL) {
+    // Deliver our oldest queued frame.  (We do this asynchronously, to avoid possible infinite recursion.)
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, deliverQueuedFrame, this);
+    if (fHaveSeenEndOfInput) return;
+  } else if (fHaveSeenEndOfInput) {
+    handleClosure();
+    return;
+  }
+
+  // Let the parser continue (even if we're being fed from our queue), because it might be waiting
+  // for room in our queue:
   fOurSourceDemux.continueReading();
 }
 
+u_int8_t* MatroskaDemuxedTrack::newQueuedFrame(unsigned frameSize) {
+  delete fNewQueuedFrame; // in case the parser abandoned a previous frame
+  fNewQueuedFrame = new MatroskaQueuedFrame(frameSize);
+  return fNewQueuedFrame->fData;
+}
+
+void MatroskaDemuxedTrack::enqueueNewFrame(struct timeval presentationTime, unsigned durationInMicroseconds) {
+  if (fNewQueuedFrame == NULL) return; // shouldn't happen
+
+  fNewQueuedFrame->fPresentationTime = presentationTime;
+  fNewQueuedFrame->fDurationInMicroseconds = durationInMicroseconds;
+  if (fQueueTail == NULL) {
+    fQueueHead = fQueueTail = fNewQueuedFrame;
+  } else {
+    fQueueTail->fNext = fNewQueuedFrame;
+    fQueueTail = fNewQueuedFrame;
+  }
+  fNumQueuedBytes += fNewQueuedFrame->fFrameSize;
+  fNewQueuedFrame = NULL;
+}
+
+void MatroskaDemuxedTrack::flushQueuedFrames() {
+  while (fQueueHead != NULL) {
+    MatroskaQueuedFrame* next = fQueueHead->fNext;
+    delete fQueueHead;
+    fQueueHead = next;
+  }
+  fQueueTail = NULL;
+  fNumQueuedBytes = 0;
+
+  delete fNewQueuedFrame; fNewQueuedFrame = NULL;
+  fHaveSeenEndOfInput = False;
+}
+
+void MatroskaDemuxedTrack::handleEndOfInput() {
+  if (fQueueHead != NULL) {
+    // We can't close yet, because our consumer hasn't yet read all of our queued frames:
+    fHaveSeenEndOfInput = True;
+  } else {
+    handleClosure();
+  }
+}
+
+void MatroskaDemuxedTrack::deliverQueuedFrame(void* clientData) {
+  ((MatroskaDemuxedTrack*)clientData)->deliverQueuedFrame();
+}
+
+void MatroskaDemuxedTrack::deliverQueuedFrame() {
+  nextTask() = NULL;
+  if (!isCurrentlyAwaitingData()) return; // we're no longer being read
+
+  MatroskaQueuedFrame* frame = fQueueHead;
+  if (frame == NULL) {
+    // Our queue got flushed (e.g., because of a seek), so read a new frame from the file instead:
+    if (fHaveSeenEndOfInput) handleClosure(); else fOurSourceDemux.continueReading();
+    return;
+  }
+  fQueueHead = frame->fNext;
+  if (fQueueHead == NULL) fQueueTail = NULL;
+  fNumQueuedBytes -= frame->fFrameSize;
+
+  if (frame->fFrameSize > fMaxSize) {
+    fFrameSize = fMaxSize;
+    fNumTruncatedBytes = frame->fFrameSize - fMaxSize;
+  } else {
+    fFrameSize = frame->fFrameSize;
+    fNumTruncatedBytes = 0;
+  }
+  memmove(fTo, frame->fData, fFrameSize);
+  fPresentationTime = frame->fPresentationTime;
+  fDurationInMicroseconds = frame->fDurationInMicroseconds;
+  delete frame;
+
+  FramedSource::afterGetting(this);
+}
+
 char const* MatroskaDemuxedTrack::MIMEtype() const {
   MatroskaTrack* track = fOurSourceDemux.fOurFile.lookup(fOurTrackNumber);
   if (track == NULL) return "(unknown)"; // shouldn't happen
@@ -27,6 +27,11 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 class MatroskaDemux; // forward
 
+// The maximum amount of frame data that we'll queue for a track that's not currently being read:
+#ifndef MATROSKA_DEMUXED_TRACK_MAX_QUEUED_BYTES
+#define MATROSKA_DEMUXED_TRACK_MAX_QUEUED_BYTES 1000000
+#endif
+
 class MatroskaDemuxedTrack: public FramedSource {
 public:
   void seekToTime(double& seekNPT);
@@ -53,12 +58,35 @@ private: // We are accessed only by MatroskaDemux and by MatroskaFileParser (a f
   struct timeval& prevPresentationTime() { return fPrevPresentationTime; }
   int& durationImbalance() { return fDurationImbalance; }
 
+  // Frames that get parsed while we're not being read (e.g., because our consumer is slower than
+  // that of another track) are kept in a (bounded) queue, so that the parser can move on to the other
+  // tracks' frames, rather than having to wait for us:
+  Boolean haveQueuedFrames() const { return fQueueHead != NULL; }
+  Boolean canQueueFrame(unsigned frameSize) const {
+    return fNumQueuedBytes + frameSize <= MATROSKA_DEMUXED_TRACK_MAX_QUEUED_BYTES;
+  }
+  u_int8_t* newQueuedFrame(unsigned frameSize);
+      // returns a buffer into which the parser will copy the new frame's data
+  void enqueueNewFrame(struct timeval presentationTime, unsigned durationInMicroseconds);
+      // called once all of the new frame's data has been copied
+  void flushQueuedFrames();
+  void handleEndOfInput(); // closes us, but only once all of our queued frames have been read
+
+private:
+  static void deliverQueuedFrame(void* clientData);
+  void deliverQueuedFrame();
+
 private:
   unsigned fOurTrackNumber;
   MatroskaDemux& fOurSourceDemux;
   struct timeval fPrevPresentationTime;
   int fDurationImbalance;
   unsigned fOpusTrackNumber; // hack for Opus audio
+  class MatroskaQueuedFrame* fQueueHead;
+  class MatroskaQueuedFrame* fQueueTail;
+  class MatroskaQueuedFrame* fNewQueuedFrame; // not yet in the queue; its data is still being copied
+  unsigned fNumQueuedBytes;
+  Boolean fHaveSeenEndOfInput;
 };
 
 #endif
@@ -751,7 +751,17 @@ void MatroskaDemux::continueReading() {
 }
 
 void MatroskaDemux::seekToTime(double& seekNPT) {
-  if (fOurParser != NULL) fOurParser->seekToTime(seekNPT);
+  if (fOurParser == NULL || !fOurParser->seekToTime(seekNPT)) return; // we didn't move, so our queued frames remain valid
+
+  // Any frames that we've queued for our tracks are from the old position in the file, so discard them.
+  // (Note: We do this only after the parser has moved, because until then it may still be filling a queued frame.)
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fDemuxedTracksTable);
+  MatroskaDemuxedTrack* track;
+  char const* trackNumber;
+  while ((track = (MatroskaDemuxedTrack*)iter->next(trackNumber)) != NULL) {
+    track->flushQueuedFrames();
+  }
+  delete iter;
 }
 
 void MatroskaDemux::handleEndOfFile(void* clientData) {
@@ -777,7 +787,7 @@ void MatroskaDemux::handleEndOfFile() {
 
   for (i = 0; i < numTracks; ++i) {
     if (tracks[i] == NULL) continue; // sanity check; shouldn't happen
-    tracks[i]->handleClosure();
+    tracks[i]->handleEndOfInput();
   }
 
   delete[] tracks;
@@ -33,7 +33,7 @@ MatroskaFileParser::MatroskaFileParser(MatroskaFile& ourFile, FramedSource* inpu
     fCurOffsetInFile(0), fSavedCurOffsetInFile(0), fLimitOffsetInFile(0),
     fNumHeaderBytesToSkip(0), fClusterTimecode(0), fBlockTimecode(0),
     fFrameSizesWithinBlock(NULL),
-    fPresentationTimeOffset(0.0) {
+    fPresentationTimeOffset(0.0), fCurFrameIsBeingQueued(False) {
   if (ourDemux == NULL) {
     // Initialization
     fCurrentParseState = PARSING_START_OF_FILE;
@@ -49,7 +49,7 @@ MatroskaFileParser::~MatroskaFileParser() {
   Medium::close(fInputSource);
 }
 
-void MatroskaFileParser::seekToTime(double& seekNPT) {
+Boolean MatroskaFileParser::seekToTime(double& seekNPT) {
 #ifdef DEBUG
   fprintf(stderr, "seekToTime(%f)\n", seekNPT);
 #endif
@@ -59,12 +59,14 @@ void MatroskaFileParser::seekToTime(double& seekNPT) {
 #endif
     seekNPT = 0.0;
     seekToFilePosition(0);
+    fCurrentParseState = LOOKING_FOR_CLUSTER;
   } else if (seekNPT >= fOurFile.fileDuration()) {
 #ifdef DEBUG
     fprintf(stderr, "\t=> end of file\n");
 #endif
     seekNPT = fOurFile.fileDuration();
     seekToEndOfFile();
+    fCurrentParseState = LOOKING_FOR_BLOCK;
   } else {
     u_int64_t clusterOffsetInFile;
     unsigned blockNumWithinCluster;
@@ -72,7 +74,7 @@ void MatroskaFileParser::seekToTime(double& seekNPT) {
 #ifdef DEBUG
       fprintf(stderr, "\t=> not supported\n");
 #endif
-      return; // seeking not supported
+      return False; // seeking not supported
     }
 
 #ifdef DEBUG
@@ -82,6 +84,8 @@ void MatroskaFileParser::seekToTime(double& seekNPT) {
     fCurrentParseState = LOOKING_FOR_BLOCK;
     // LATER handle "blockNumWithinCluster"; for now, we assume that it's 0 #####
   }
+
+  return True;
 }
 
 void MatroskaFileParser
@@ -161,9 +165,10 @@ Boolean MatroskaFileParser::parse() {
 	  break;
 	}
         case DELIVERING_FRAME_BYTES: {
-	  deliverFrameBytes();
-	  return False; // Halt parsing for now.  A new 'read' from downstream will cause parsing to resume.
-	  break;
+	  if (deliverFrameBytes()) {
+	    return False; // Halt parsing for now.  A new 'read' from downstream will cause parsing to resume.
+	  }
+	  break; // The frame was queued (for a track that's not being read right now), so keep parsing
 	}
       }
     } while (!areDone);
@@ -944,16 +949,18 @@ void MatroskaFileParser::parseBlock() {
     if (!parseEBMLNumber(trackNumber)) break;
     fBlockTrackNumber = (unsigned)trackNumber.val();
 
-    // If this track is not being read, then skip the rest of this block, and look for another one:
+    // If this track is not being read, then skip the rest of this block, and look for another one.
+    // (We do this in bank-sized chunks, because the block (e.g., a video key frame) might be large.)
     if (fOurDemux->lookupDemuxedTrack(fBlockTrackNumber) == NULL) {
       unsigned headerBytesSeen = curOffset() - blockStartPos;
+      fCurrentParseState = LOOKING_FOR_BLOCK;
       if (headerBytesSeen < fBlockSize) {
-	skipBytes(fBlockSize - headerBytesSeen);
+	fNumHeaderBytesToSkip = fBlockSize - headerBytesSeen;
+	skipRemainingHeaderBytes(False);
       }
 #ifdef DEBUG
       fprintf(stderr, "\tSkipped block for unused track number %d\n", fBlockTrackNumber);
 #endif
-      fCurrentParseState = LOOKING_FOR_BLOCK;
       setParseState();
       return;
     }
@@ -962,7 +969,7 @@ void MatroskaFileParser::parseBlock() {
     if (track == NULL) break; // shouldn't happen
 
     // The next two bytes are the block's timecode (relative to the cluster timecode)
-    fBlockTimecode = (get1Byte()<<8)|get1Byte();
+    fBlockTimecode = get2Bytes();
 
     // The next byte indicates the type of 'lacing' used:
     u_int8_t c = get1Byte();
@@ -978,8 +985,11 @@ void MatroskaFileParser::parseBlock() {
       // The next byte tells us how many frames are present in this block
       fNumFramesInBlock = get1Byte() + 1;
     }
-    delete[] fFrameSizesWithinBlock; fFrameSizesWithinBlock = new unsigned[fNumFramesInBlock];
-    if (fFrameSizesWithinBlock == NULL) break;
+    if (fFrameSizesWithinBlock == NULL) {
+      // A block can contain at most 256 frames, so we need to allocate this array only once:
+      fFrameSizesWithinBlock = new unsigned[256];
+      if (fFrameSizesWithinBlock == NULL) break;
+    }
   
     if (lacingType == NoLacing) {
       unsigned headerBytesSeen = curOffset() - blockStartPos;
@@ -1012,8 +1022,9 @@ void MatroskaFileParser::parseBlock() {
 	  if (i == 0) {
 	    curFrameSize = fsv;
 	  } else {
-	    // The value we read is a signed value, that's added to the previous frame size, to get the current frame size:
-	    unsigned toSubtract = (fsv>0xFFFFFF)?0x07FFFFFF : (fsv>0xFFFF)?0x0FFFFF : (fsv>0xFF)?0x1FFF : 0x3F;
+	    // The value we read is a signed value, that's added to the previous frame size, to get the current frame size.
+	    // (Its bias depends upon the length of its encoding, not upon its value.)
+	    unsigned toSubtract = frameSize.len >= 4 ? 0x07FFFFFF : (1<<(7*frameSize.len-1)) - 1;
 	    int fsv_signed = fsv - toSubtract;
 	    curFrameSize += fsv_signed;
 	    if ((int)curFrameSize < 0) break;
@@ -1076,9 +1087,12 @@ Boolean MatroskaFileParser::deliverFrameWithinBlock() {
 
     MatroskaDemuxedTrack* demuxedTrack = fOurDemux->lookupDemuxedTrack(fBlockTrackNumber);
     if (demuxedTrack == NULL) break; // shouldn't happen
-    if (!demuxedTrack->isCurrentlyAwaitingData()) {
-      // Someone has been reading this stream, but isn't right now.
-      // We can't deliver this frame until he asks for it, so punt for now.
+    fCurFrameIsBeingQueued = !demuxedTrack->isCurrentlyAwaitingData() || demuxedTrack->haveQueuedFrames();
+    if (fCurFrameIsBeingQueued
+	&& ((track->codecIsOpus && demuxedTrack->fOpusTrackNumber < 2)
+	    || !demuxedTrack->canQueueFrame(fFrameSizesWithinBlock[fNextFrameNumberToDeliver]))) {
+      // Someone has been reading this stream, but isn't right now, and there's no more room to queue
+      // the frame for him.  We can't deliver this frame until he asks for it, so punt for now.
       // The next time he asks for a frame, he'll get it.
 #ifdef DEBUG
       fprintf(stderr, "\tdeferring delivery of frame #%d (%d bytes)", fNextFrameNumberToDeliver, fFrameSizesWithinBlock[fNextFrameNumberToDeliver]);
@@ -1177,6 +1191,16 @@ Boolean MatroskaFileParser::deliverFrameWithinBlock() {
       demuxedTrack->prevPresentationTime() = presentationTime; // for next time
     }
 
+    if (fCurFrameIsBeingQueued) {
+      // Copy the whole frame into the track's queue.  (Any truncation happens when it gets delivered.)
+      fCurFramePresentationTime = presentationTime;
+      fCurFrameDurationInMicroseconds = durationInMicroseconds;
+      getCommonFrameBytes(track, demuxedTrack->newQueuedFrame(frameSize), frameSize, 0);
+      fCurrentParseState = DELIVERING_FRAME_BYTES;
+      setParseState();
+      return True;
+    }
+
     demuxedTrack->presentationTime() = presentationTime;
     demuxedTrack->durationInMicroseconds() = durationInMicroseconds;
 
@@ -1215,7 +1239,7 @@ Boolean MatroskaFileParser::deliverFrameWithinBlock() {
   return True;
 }
 
-void MatroskaFileParser::deliverFrameBytes() {
+Boolean MatroskaFileParser::deliverFrameBytes() {
   do {
     MatroskaTrack* track = fOurFile.lookup(fBlockTrackNumber);
     if (track == NULL) break; // shouldn't happen
@@ -1242,10 +1266,14 @@ void MatroskaFileParser::deliverFrameBytes() {
       setParseState();
     }
 #ifdef DEBUG
-    fprintf(stderr, "\tdelivered frame #%d: %d bytes", fNextFrameNumberToDeliver, demuxedTrack->frameSize());
-    if (track->haveSubframes()) fprintf(stderr, "[offset %d]", fCurOffsetWithinFrame - track->subframeSizeSize - demuxedTrack->frameSize() - demuxedTrack->numTruncatedBytes());
-    if (demuxedTrack->numTruncatedBytes() > 0) fprintf(stderr, " (%d bytes truncated)", demuxedTrack->numTruncatedBytes());
-    fprintf(stderr, " @%u.%06u (%.06f from start); duration %u us\n", demuxedTrack->presentationTime().tv_sec, demuxedTrack->presentationTime().tv_usec, demuxedTrack->presentationTime().tv_sec+demuxedTrack->presentationTime().tv_usec/1000000.0-fPresentationTimeOffset, demuxedTrack->durationInMicroseconds());
+    if (fCurFrameIsBeingQueued) {
+      fprintf(stderr, "\tqueued frame #%d for track %d\n", fNextFrameNumberToDeliver, fBlockTrackNumber);
+    } else {
+      fprintf(stderr, "\tdelivered frame #%d: %d bytes", fNextFrameNumberToDeliver, demuxedTrack->frameSize());
+      if (track->haveSubframes()) fprintf(stderr, "[offset %d]", fCurOffsetWithinFrame - track->subframeSizeSize - demuxedTrack->frameSize() - demuxedTrack->numTruncatedBytes());
+      if (demuxedTrack->numTruncatedBytes() > 0) fprintf(stderr, " (%d bytes truncated)", demuxedTrack->numTruncatedBytes());
+      fprintf(stderr, " @%u.%06u (%.06f from start); duration %u us\n", demuxedTrack->presentationTime().tv_sec, demuxedTrack->presentationTime().tv_usec, demuxedTrack->presentationTime().tv_sec+demuxedTrack->presentationTime().tv_usec/1000000.0-fPresentationTimeOffset, demuxedTrack->durationInMicroseconds());
+    }
 #endif
 
     if (!track->haveSubframes()
@@ -1262,8 +1290,12 @@ void MatroskaFileParser::deliverFrameBytes() {
     }
 
     setParseState();
+    if (fCurFrameIsBeingQueued) {
+      demuxedTrack->enqueueNewFrame(fCurFramePresentationTime, fCurFrameDurationInMicroseconds);
+      return False;
+    }
     FramedSource::afterGetting(demuxedTrack); // completes delivery
-    return;
+    return True;
   } while (0);
 
   // An error occurred.  Try to recover:
@@ -1271,6 +1303,7 @@ void MatroskaFileParser::deliverFrameBytes() {
   fprintf(stderr, "deliverFrameBytes(): Error parsing data; trying to recover...\n");
 #endif
   fCurrentParseState = LOOKING_FOR_BLOCK;
+  return True;
 }
 
 void MatroskaFileParser
@@ -1304,7 +1337,38 @@ void MatroskaFileParser
   fCurFrameNumBytesToSkip = numBytesToSkip;
 }
 
+static unsigned EBMLNumberLength(u_int8_t firstByte) {
+  // The length of an EBML number is 1 + the number of leading 0 bits in its first byte (which must be non-zero):
+#if defined(__GNUC__)
+  return __builtin_clz(firstByte) - (8*sizeof (unsigned) - 9);
+#else
+  unsigned len = 1;
+  for (u_int8_t bitmask = 0x80; (firstByte&bitmask) == 0; bitmask >>= 1) ++len;
+  return len;
+#endif
+}
+
 Boolean MatroskaFileParser::parseEBMLNumber(EBMLNumber& num) {
+  // Fast path: In the common case - when all of the number's bytes have already been read
+  // into our buffer - decode it directly from there:
+  if (numBufferedBytes() > 0) {
+    u_int8_t const* ptr = bufferedBytes();
+    u_int8_t const firstByte = ptr[0];
+    if (firstByte != 0 && (num.stripLeading1 || (firstByte&0xF0) != 0)) {
+      unsigned const len = EBMLNumberLength(firstByte);
+      if (len <= numBufferedBytes()
+	  && (fLimitOffsetInFile == 0 || fCurOffsetInFile + len-1 <= fLimitOffsetInFile)) {
+	memmove(num.data, ptr, len);
+	if (num.stripLeading1) num.data[0] &=~ (0x80>>(len-1));
+	num.len = len;
+	skipBytes(len);
+	fCurOffsetInFile += len;
+	return True;
+      }
+    }
+  }
+
+  // Otherwise, parse the number one byte at a time:
   unsigned i;
   u_int8_t bitmask = 0x80;
   for (i = 0; i < EBML_NUMBER_MAX_LEN; ++i) {
@@ -1504,5 +1568,11 @@ void MatroskaFileParser::resetStateAfterSeeking() {
   // Because we're resuming parsing after seeking to a new position in the file, reset the parser state:
   fCurOffsetInFile = fSavedCurOffsetInFile = 0;
   fCurOffsetWithinFrame = fSavedCurOffsetWithinFrame = 0;
+  fNumHeaderBytesToSkip = 0;
+
+  // We're no longer delivering a (sub)frame (which may have been going to a queued frame that's about to be discarded):
+  fCurFrameIsBeingQueued = False;
+  fCurFrameTo = NULL;
+  fCurFrameNumBytesToGet = fCurFrameNumBytesToSkip = 0;
   flushInput();
 }
@@ -50,7 +50,8 @@ public:
 		     MatroskaDemux* ourDemux = NULL);
   virtual ~MatroskaFileParser();
 
-  void seekToTime(double& seekNPT);
+  Boolean seekToTime(double& seekNPT);
+      // returns True iff we moved to a new position in the file (i.e., if seeking is supported)
 
   // StreamParser 'client continue' function:
   static void continueParsing(void* clientData, unsigned char* ptr, unsigned size, struct timeval presentationTime);
@@ -69,7 +70,8 @@ private:
   void lookForNextBlock();
   void parseBlock();
   Boolean deliverFrameWithinBlock();
-  void deliverFrameBytes();
+  Boolean deliverFrameBytes();
+    // returns True iff a frame was delivered downstream (rather than queued), so parsing should halt
 
   void getCommonFrameBytes(MatroskaTrack* track, u_int8_t* to, unsigned numBytesToGet, unsigned numBytesToSkip);
 
@@ -126,6 +128,9 @@ private:
   unsigned fCurOffsetWithinFrame, fSavedCurOffsetWithinFrame; // used if track->haveSubframes()
 
   // Parameters of the (sub)frame that's currently being delivered:
+  Boolean fCurFrameIsBeingQueued; // True iff the frame is going to its track's queue, rather than directly downstream
+  struct timeval fCurFramePresentationTime; // used only if "fCurFrameIsBeingQueued"
+  unsigned fCurFrameDurationInMicroseconds; // ditto
   u_int8_t* fCurFrameTo;
   unsigned fCurFrameNumBytesToGet;
   unsigned fCurFrameNumBytesToSkip;
@@ -207,6 +207,7 @@ Boolean MediaSession::initializeWithSDP(char const* sdpDescription) {
       if (subsession->parseSDPLine_b(sdpLine)) continue;
       if (subsession->parseSDPAttribute_rtpmap(sdpLine)) continue;
       if (subsession->parseSDPAttribute_rtcpmux(sdpLine)) continue;
+      if (subsession->parseSDPAttribute_rtcpfb(sdpLine)) continue;
       if (subsession->parseSDPAttribute_control(sdpLine)) continue;
       if (subsession->parseSDPAttribute_range(sdpLine)) continue;
       if (subsession->parseSDPAttribute_fmtp(sdpLine)) continue;
@@ -599,7 +600,8 @@ MediaSubsession::MediaSubsession(MediaSession& parent)
     fConnectionEndpointName(NULL),
     fClientPortNum(0), fRTPPayloadFormat(0xFF),
     fSavedSDPLines(NULL), fMediumName(NULL), fCodecName(NULL), fProtocolName(NULL),
-    fRTPTimestampFrequency(0), fMultiplexRTCPWithRTP(False), fControlPath(NULL),
+    fRTPTimestampFrequency(0), fMultiplexRTCPWithRTP(False),
+    fServerSupportsNACK(False), fRTXPayloadFormat(0), fControlPath(NULL),
     fSourceFilterAddr(parent.sourceFilterAddr()), fBandwidth(0),
     fPlayStartTime(0.0), fPlayEndTime(0.0), fAbsStartTime(NULL), fAbsEndTime(NULL),
     fVideoWidth(0), fVideoHeight(0), fVideoFPS(0), fNumChannels(1), fScale(1.0f), fNPT_PTS_Offset(0.0f),
@@ -1030,17 +1032,20 @@ Boolean MediaSubsession::parseSDPAttribute_rtpmap(char const* sdpLine) {
       || sscanf(sdpLine, "a=rtpmap: %u %s",
 		&rtpmapPayloadFormat, codecName) == 2) {
     parseSuccess = True;
+    // (First, make sure the codec name is upper case)
+    {
+      Locale l("POSIX");
+      for (char* p = codecName; *p != '\0'; ++p) *p = toupper(*p);
+    }
     if (rtpmapPayloadFormat == fRTPPayloadFormat) {
       // This "rtpmap" matches our payload format, so set our
       // codec name and timestamp frequency:
-      // (First, make sure the codec name is upper case)
-      {
-	Locale l("POSIX");
-	for (char* p = codecName; *p != '\0'; ++p) *p = toupper(*p);
-      }
       delete[] fCodecName; fCodecName = strDup(codecName);
       fRTPTimestampFrequency = rtpTimestampFrequency;
       fNumChannels = numChannels;
+    } else if (strcmp(codecName, "RTX") == 0) {
+      // This is the "RTX" retransmission format (RFC 4588) for our (single) payload format:
+      fRTXPayloadFormat = (unsigned char)rtpmapPayloadFormat;
     }
   }
   delete[] codecName;
@@ -1057,6 +1062,24 @@ Boolean MediaSubsession::parseSDPAttribute_rtcpmux(char const* sdpLine) {
   return False;
 }
 
+Boolean MediaSubsession::parseSDPAttribute_rtcpfb(char const* sdpLine) {
+  // Check for a "a=rtcp-fb:<fmt> nack" line (but not "nack pli", which is a different feedback type).
+  // (<fmt> may also be "*", meaning all payload formats.)
+  // (Note that "sdpLine" continues past the end of this line.)
+  char fmt[5], feedbackType[10];
+  int lineLen = 0;
+  if (sscanf(sdpLine, "a=rtcp-fb: %4s %9[^ \r\n]%n", fmt, feedbackType, &lineLen) != 2) return False;
+
+  char const* afterType = &sdpLine[lineLen];
+  while (*afterType == ' ') ++afterType;
+  Boolean hasParam = *afterType != '\r' && *afterType != '\n' && *afterType != '\0';
+  if (!hasParam && strcmp(feedbackType, "nack") == 0
+      && (strcmp(fmt, "*") == 0 || (unsigned)atoi(fmt) == fRTPPayloadFormat)) {
+    fServerSupportsNACK = True;
+  }
+  return True;
+}
+
 Boolean MediaSubsession::parseSDPAttribute_control(char const* sdpLine) {
   // Check for a "a=control:<control-path>" line:
   Boolean parseSuccess = False;
@@ -108,10 +108,19 @@ Boolean MediaSink::isRTPSink() const {
   return False; // default implementation
 }
 
+Boolean MediaSink::isMultiFramedRTPSink() const {
+  return False; // default implementation
+}
+
 ////////// OutPacketBuffer //////////
 
 unsigned OutPacketBuffer::maxSize = 60000; // by default
 
+#ifndef OUT_PACKET_BUFFER_MAX_SIZE
+#define OUT_PACKET_BUFFER_MAX_SIZE 16000000
+    // an upper limit on how large "increaseBufferSizeTo()" will make a buffer
+#endif
+
 OutPacketBuffer
 ::OutPacketBuffer(unsigned preferredPacketSize, unsigned maxPacketSize, unsigned maxBufferSize)
   : fPreferred(preferredPacketSize), fMax(maxPacketSize),
@@ -129,6 +138,31 @@ OutPacketBuffer::~OutPacketBuffer() {
   delete[] fBuf;
 }
 
+unsigned OutPacketBuffer::bufferSizeLimit() {
+  return OUT_PACKET_BUFFER_MAX_SIZE;
+}
+
+Boolean OutPacketBuffer::increaseBufferSizeTo(unsigned newBufferSize) {
+  if (newBufferSize > OUT_PACKET_BUFFER_MAX_SIZE) newBufferSize = OUT_PACKET_BUFFER_MAX_SIZE;
+  unsigned maxNumPackets = (newBufferSize + (fMax-1))/fMax;
+  unsigned newLimit = maxNumPackets*fMax;
+  if (newLimit <= fLimit) return False;
+
+  // Copy over the data that's currently in use (the current packet, and any overflow data).
+  // All of our offsets remain valid:
+  unsigned numBytesInUse = fPacketStart + fCurOffset;
+  if (fOverflowDataSize > 0 && fPacketStart + fOverflowDataOffset + fOverflowDataSize > numBytesInUse) {
+    numBytesInUse = fPacketStart + fOverflowDataOffset + fOverflowDataSize;
+  }
+  unsigned char* newBuf = new unsigned char[newLimit];
+  memmove(newBuf, fBuf, numBytesInUse);
+  delete[] fBuf;
+  fBuf = newBuf;
+  fLimit = newLimit;
+
+  return True;
+}
+
 void OutPacketBuffer::enqueue(unsigned char const* from, unsigned numBytes) {
   if (numBytes > totalBytesAvailable()) {
 #ifdef DEBUG
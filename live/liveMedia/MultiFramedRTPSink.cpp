@@ -22,6 +22,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MultiFramedRTPSink.hh"
 #include "GroupsockHelper.hh"
 
+static unsigned const rtpHeaderSize = 12;
+
 ////////// MultiFramedRTPSink //////////
 
 void MultiFramedRTPSink::setPacketSizes(unsigned preferredPacketSize,
@@ -29,8 +31,11 @@ void MultiFramedRTPSink::setPacketSizes(unsigned preferredPacketSize,
   if (preferredPacketSize > maxPacketSize || preferredPacketSize == 0) return;
       // sanity check
 
+  // Note: Until we know what our source is, our buffer is big enough for just one packet.
+  // It gets enlarged (in "continuePlaying()") when we start playing.
+  unsigned bufferSize = fOutBuf == NULL ? maxPacketSize : fOutBuf->totalBufferSize();
   delete fOutBuf;
-  fOutBuf = new OutPacketBuffer(preferredPacketSize, maxPacketSize);
+  fOutBuf = new OutPacketBuffer(preferredPacketSize, maxPacketSize, bufferSize);
   fOurMaxPacketSize = maxPacketSize; // save value, in case subclasses need it
 }
 
@@ -52,14 +57,171 @@ MultiFramedRTPSink::MultiFramedRTPSink(UsageEnvironment& env,
   : RTPSink(env, rtpGS, rtpPayloadType, rtpTimestampFrequency,
 	    rtpPayloadFormatName, numChannels),
     fOutBuf(NULL), fCurFragmentationOffset(0), fPreviousFrameEndedFragmentation(False),
-    fOnSendErrorFunc(NULL), fOnSendErrorData(NULL) {
+    fMinFrameSpace(0), fSourceReportsMaxFrameSize(False),
+    fNumOutputBufferGrowths(0), fNumTruncatedFrames(0),
+    fOnSendErrorFunc(NULL), fOnSendErrorData(NULL),
+    fRetransmissionHistorySize(0), fRetransmissionSlotSize(0), fRetransmissionHistory(NULL),
+    fRetransmissionPacketSizes(NULL), fRetransmissionSeqNos(NULL),
+    fRTXPayloadType(0), fRTXSSRC(0), fRTXSeqNo(0), fRTXPacket(NULL),
+    fNumPacketsRetransmitted(0), fNumRetransmissionsMissed(0),
+    fPacingBurstUSeconds(0), fBurstStatus(NULL), fNumSendWakeups(0) {
   setPacketSizes((RTP_PAYLOAD_PREFERRED_SIZE), (RTP_PAYLOAD_MAX_SIZE));
 }
 
 MultiFramedRTPSink::~MultiFramedRTPSink() {
+  deleteRetransmissionHistory();
   delete fOutBuf;
 }
 
+unsigned MultiFramedRTPSink::outputBufferSize() const {
+  return fOutBuf == NULL ? 0 : fOutBuf->totalBufferSize();
+}
+
+unsigned MultiFramedRTPSink::numBytesAllocated() const {
+  unsigned result = outputBufferSize();
+  if (fRetransmissionHistorySize > 0) {
+    result += fRetransmissionHistorySize*(fRetransmissionSlotSize + sizeof (unsigned) + sizeof (u_int16_t));
+    if (fRTXPacket != NULL) result += fRetransmissionSlotSize + 2;
+  }
+
+  return result;
+}
+
+void MultiFramedRTPSink::printStatistics(UsageEnvironment& env) {
+  unsigned numSinks = 0, totNumBytesAllocated = 0;
+
+  env << "RTP sink buffer statistics:\n";
+  HashTable::Iterator* iter = HashTable::Iterator::create(MediaLookupTable::ourMedia(env)->getTable());
+  char const* key; // dummy
+  Medium* medium;
+  while ((medium = (Medium*)(iter->next(key))) != NULL) {
+    if (!medium->isSink() || !((MediaSink*)medium)->isMultiFramedRTPSink()) continue;
+    MultiFramedRTPSink* sink = (MultiFramedRTPSink*)medium;
+
+    env << "\t" << sink->name() << " (" << sink->sdpMediaType() << "/" << sink->rtpPayloadFormatName()
+	<< "): output buffer " << sink->outputBufferSize() << " bytes (grew " << sink->numOutputBufferGrowths()
+	<< " times; " << sink->numTruncatedFrames() << " frames truncated), "
+	<< sink->numBytesAllocated() << " bytes allocated in all\n";
+    ++numSinks;
+    totNumBytesAllocated += sink->numBytesAllocated();
+  }
+  delete iter;
+  env << "\tTotal: " << numSinks << " sinks, " << totNumBytesAllocated << " bytes allocated\n";
+}
+
+Boolean MultiFramedRTPSink::isMultiFramedRTPSink() const {
+  return True;
+}
+
+Boolean MultiFramedRTPSink::enableRetransmissions(unsigned historySize, unsigned char rtxPayloadType) {
+  deleteRetransmissionHistory();
+  if (historySize == 0) return True; // retransmissions are now disabled
+
+  // Note: Each history slot is big enough for our current maximum packet size.  (If
+  // "setPacketSizes()" is later called with a larger size, then the bigger packets won't be saved.)
+  fRetransmissionHistorySize = historySize;
+  fRetransmissionSlotSize = fOurMaxPacketSize;
+  fRetransmissionHistory = new unsigned char[historySize*fRetransmissionSlotSize];
+  fRetransmissionPacketSizes = new unsigned[historySize];
+  fRetransmissionSeqNos = new u_int16_t[historySize];
+  for (unsigned i = 0; i < historySize; ++i) fRetransmissionPacketSizes[i] = 0;
+
+  fRTXPayloadType = rtxPayloadType;
+  if (fRTXPayloadType != 0) {
+    // The "RTX" stream has its own SSRC and sequence number space (RFC 4588, section 4):
+    fRTXSSRC = our_random32();
+    fRTXSeqNo = (u_int16_t)our_random();
+    fRTXPacket = new unsigned char[fRetransmissionSlotSize + 2/*OSN*/];
+  }
+
+  return True;
+}
+
+Boolean MultiFramedRTPSink::enableKernelPacing(unsigned burstDurationUSeconds, unsigned pacingRateKbps) {
+  fPacingBurstUSeconds = 0;
+  if (burstDurationUSeconds == 0) return True;
+
+  // Send in bursts only if the kernel will pace them; otherwise each burst would go out at line rate:
+  if (pacingRateKbps == 0) pacingRateKbps = (estimatedBitrate()*5)/4;
+  Groupsock* gs = fRTPInterface.gs();
+  if (pacingRateKbps == 0 || gs == NULL || !gs->ownsSocketNum()) return False;
+      // Note: We don't set the pacing rate on a socket that's shared with other streams (e.g., a
+      // "SharedRTPSocket"), because it would limit all of those streams, together, to our rate
+  if (!setSocketMaxPacingRate(gs->socketNum(), pacingRateKbps*(1000/8))) return False;
+
+  fPacingBurstUSeconds = burstDurationUSeconds;
+  gettimeofday(&fBurstStartTime, NULL);
+  return True;
+}
+
+void MultiFramedRTPSink::deleteRetransmissionHistory() {
+  delete[] fRetransmissionHistory; fRetransmissionHistory = NULL;
+  delete[] fRetransmissionPacketSizes; fRetransmissionPacketSizes = NULL;
+  delete[] fRetransmissionSeqNos; fRetransmissionSeqNos = NULL;
+  delete[] fRTXPacket; fRTXPacket = NULL;
+  fRetransmissionHistorySize = fRetransmissionSlotSize = 0;
+}
+
+void MultiFramedRTPSink::saveForRetransmission(unsigned char const* packet, unsigned packetSize) {
+  unsigned slot = fSeqNo%fRetransmissionHistorySize;
+  if (packetSize > fRetransmissionSlotSize) {
+    fRetransmissionPacketSizes[slot] = 0; // too big to save
+    return;
+  }
+
+  memmove(&fRetransmissionHistory[slot*fRetransmissionSlotSize], packet, packetSize);
+  fRetransmissionPacketSizes[slot] = packetSize;
+  fRetransmissionSeqNos[slot] = fSeqNo;
+}
+
+void MultiFramedRTPSink::retransmitPacket(u_int16_t seqNo, unsigned clientSessionId, int tcpSocketNum) {
+  if (fRetransmissionHistorySize == 0) return;
+
+  // Resend only to the client that asked.  If we couldn't tell which client that was, then resend only if we
+  // have a single destination, to avoid sending unrequested packets to other clients (e.g., if our stream is shared):
+  Boolean const clientIsKnown = clientSessionId != 0 || tcpSocketNum >= 0;
+  if (!clientIsKnown && fRTPInterface.hasMultipleDestinations()) {
+    ++fNumRetransmissionsMissed;
+    return;
+  }
+
+  unsigned slot = seqNo%fRetransmissionHistorySize;
+  unsigned packetSize = fRetransmissionPacketSizes[slot];
+  if (packetSize < rtpHeaderSize || fRetransmissionSeqNos[slot] != seqNo) {
+    // This packet has already been overwritten in our history (or was never saved):
+    ++fNumRetransmissionsMissed;
+    return;
+  }
+  unsigned char const* packet = &fRetransmissionHistory[slot*fRetransmissionSlotSize];
+
+  if (fRTXPayloadType == 0) {
+    // Resend the original packet, unchanged:
+    if (clientIsKnown) {
+      if (!fRTPInterface.sendPacketToClient((unsigned char*)packet, packetSize, clientSessionId, tcpSocketNum)) return;
+    } else {
+      fRTPInterface.sendPacket((unsigned char*)packet, packetSize);
+    }
+  } else {
+    // Send a "RTX" packet: The original RTP header (with our RTX payload type, sequence number
+    // and SSRC), then the 2-byte 'original sequence number', then the original payload:
+    // (Note: Our RTP headers never contain CSRCs or header extensions.)
+    u_int32_t rtpHdr = ntohl(*(u_int32_t const*)packet);
+    rtpHdr &=~ 0x007FFFFF; // keep the version, padding and marker bits
+    rtpHdr |= (fRTXPayloadType<<16)|fRTXSeqNo++;
+    *(u_int32_t*)&fRTXPacket[0] = htonl(rtpHdr);
+    memmove(&fRTXPacket[4], &packet[4], 4); // the original timestamp
+    *(u_int32_t*)&fRTXPacket[8] = htonl(fRTXSSRC);
+    fRTXPacket[12] = seqNo>>8; fRTXPacket[13] = (u_int8_t)seqNo;
+    memmove(&fRTXPacket[14], &packet[rtpHeaderSize], packetSize - rtpHeaderSize);
+    if (clientIsKnown) {
+      if (!fRTPInterface.sendPacketToClient(fRTXPacket, packetSize + 2, clientSessionId, tcpSocketNum)) return;
+    } else {
+      fRTPInterface.sendPacket(fRTXPacket, packetSize + 2);
+    }
+  }
+  ++fNumPacketsRetransmitted;
+}
+
 void MultiFramedRTPSink
 ::doSpecialFrameHandling(unsigned /*fragmentationOffset*/,
 			 unsigned char* /*frameStart*/,
@@ -154,6 +316,27 @@ void MultiFramedRTPSink::setFramePadding(unsigned numPaddingBytes) {
 }
 
 Boolean MultiFramedRTPSink::continuePlaying() {
+  // Size our buffer for the frames that our source will deliver.  If the source tells us its
+  // maximum frame size, then we use that.  Otherwise, we start with "OutPacketBuffer::maxSize",
+  // and later enlarge the buffer (in "afterGettingFrame1()") if we see larger frames:
+  unsigned maxFrameSize = fSource == NULL ? 0 : fSource->maxFrameSize();
+  fSourceReportsMaxFrameSize = maxFrameSize > 0;
+  unsigned minFrameSpace = fSourceReportsMaxFrameSize ? maxFrameSize
+    : OutPacketBuffer::maxSize > fOurMaxPacketSize ? OutPacketBuffer::maxSize - fOurMaxPacketSize : 0;
+  if (minFrameSpace > fMinFrameSpace) fMinFrameSpace = minFrameSpace;
+  fOutBuf->increaseBufferSizeTo(fOurMaxPacketSize + fMinFrameSpace);
+  if (fOurMaxPacketSize + fMinFrameSpace > OutPacketBuffer::bufferSizeLimit()) {
+    envir() << "MultiFramedRTPSink::continuePlaying(): Warning: Our source's frames (up to " << fMinFrameSpace
+	    << " bytes) may not fit in our buffer, whose size is limited to " << OutPacketBuffer::bufferSizeLimit()
+	    << ".  Correct this by increasing \"OUT_PACKET_BUFFER_MAX_SIZE\" to at least "
+	    << fOurMaxPacketSize + fMinFrameSpace << ", when compiling \"MediaSink.cpp\".\n";
+  }
+
+  if (fPacingBurstUSeconds > 0) {
+    // Our first packet begins a new burst:
+    gettimeofday(&fBurstStartTime, NULL);
+  }
+
   // Send the first packet.
   // (This will also schedule any future sends.)
   buildAndSendPacket(True);
@@ -220,11 +403,36 @@ void MultiFramedRTPSink::packFrame() {
   } else {
     // Normal case: we need to read a new frame from the source
     if (fSource == NULL) return;
+    increaseOutputBufferSizeIfNecessary();
     fSource->getNextFrame(fOutBuf->curPtr(), fOutBuf->totalBytesAvailable(),
 			  afterGettingFrame, this, ourHandleClosure, this);
   }
 }
 
+void MultiFramedRTPSink::increaseOutputBufferSizeIfNecessary() {
+  // Make sure that a frame that's packed at the start of a packet (after our headers) can have
+  // "fMinFrameSpace" bytes:
+  if (fOutBuf->totalBufferSize() < fOurMaxPacketSize + fMinFrameSpace) {
+    if (fOutBuf->increaseBufferSizeTo(fOurMaxPacketSize + fMinFrameSpace)) ++fNumOutputBufferGrowths;
+  }
+
+  if (fSourceReportsMaxFrameSize) {
+    // Also make sure that the next frame - however large our source now says it can be - fits in the space
+    // that's available at our current position in the buffer (which can be less than "fMinFrameSpace", if the
+    // frame follows others in the packet, or if the packet was moved up to follow overflow data).
+    // We do this before the frame is delivered, so that it doesn't get truncated:
+    unsigned maxFrameSize = fSource->maxFrameSize();
+    if (maxFrameSize > fMinFrameSpace) fMinFrameSpace = maxFrameSize;
+
+    unsigned bytesAvailable = fOutBuf->totalBytesAvailable();
+    if (maxFrameSize > bytesAvailable) {
+      if (fOutBuf->increaseBufferSizeTo(fOutBuf->totalBufferSize() + (maxFrameSize - bytesAvailable))) {
+	++fNumOutputBufferGrowths;
+      }
+    }
+  }
+}
+
 void MultiFramedRTPSink
 ::afterGettingFrame(void* clientData, unsigned numBytesRead,
 		    unsigned numTruncatedBytes,
@@ -249,14 +457,42 @@ void MultiFramedRTPSink
     fInitialPresentationTime = presentationTime;
   }    
 
+  // Note: If the frame filled our buffer, then it was we (rather than something upstream) that truncated it:
+  Boolean frameWasTruncatedByUs = numTruncatedBytes > 0 && frameSize >= fOutBuf->totalBytesAvailable();
   if (numTruncatedBytes > 0) {
     unsigned const bufferSize = fOutBuf->totalBytesAvailable();
     envir() << "MultiFramedRTPSink::afterGettingFrame1(): The input frame data was too large for our buffer size ("
 	    << bufferSize << ").  "
-	    << numTruncatedBytes << " bytes of trailing data was dropped!  Correct this by increasing \"OutPacketBuffer::maxSize\" to at least "
-	    << OutPacketBuffer::maxSize + numTruncatedBytes << ", *before* creating this 'RTPSink'.  (Current value is "
-	    << OutPacketBuffer::maxSize << ".)\n";
+	    << numTruncatedBytes << " bytes of trailing data was dropped!";
+    if (frameWasTruncatedByUs) {
+      ++fNumTruncatedFrames;
+      unsigned const bufferSizeNeeded = fOurMaxPacketSize + frameSize + numTruncatedBytes;
+      if (bufferSizeNeeded > OutPacketBuffer::bufferSizeLimit()) {
+	envir() << "  Our buffer cannot be enlarged enough for this frame, because its size is limited to "
+		<< OutPacketBuffer::bufferSizeLimit() << ".  Correct this by increasing \"OUT_PACKET_BUFFER_MAX_SIZE\" to at least "
+		<< bufferSizeNeeded << ", when compiling \"MediaSink.cpp\".";
+      } else if (fSourceReportsMaxFrameSize) {
+	envir() << "  (Our buffer will be enlarged, to avoid this for subsequent frames.)  Our source's \"maxFrameSize()\" ("
+		<< fSource->maxFrameSize() << ") is too small; correct this by making it at least "
+		<< frameSize + numTruncatedBytes << ".";
+      } else {
+	envir() << "  (Our buffer will be enlarged, to avoid this for subsequent frames.)  To avoid this for the first such frame, "
+		<< "increase \"OutPacketBuffer::maxSize\" to at least " << bufferSizeNeeded
+		<< ", *before* this 'RTPSink' starts playing.  (Current value is " << OutPacketBuffer::maxSize
+		<< ".)  Or have our source implement \"maxFrameSize()\".";
+      }
+    }
+    envir() << "\n";
+  }
+
+  // Leave room for (at least) twice the largest frame that we've seen so far - unless our source
+  // has told us its maximum frame size - so that we (usually) enlarge our buffer before any frame
+  // gets truncated.  (We can't enlarge the buffer now, because the frame data is in it.)
+  unsigned frameSpaceNeeded = 2*(frameSize + (frameWasTruncatedByUs ? numTruncatedBytes : 0));
+  if ((!fSourceReportsMaxFrameSize || frameWasTruncatedByUs) && frameSpaceNeeded > fMinFrameSpace) {
+    fMinFrameSpace = frameSpaceNeeded;
   }
+
   unsigned curFragmentationOffset = fCurFragmentationOffset;
   unsigned numFrameBytesToUse = frameSize;
   unsigned overflowBytes = 0;
@@ -352,8 +588,6 @@ void MultiFramedRTPSink
   }
 }
 
-static unsigned const rtpHeaderSize = 12;
-
 Boolean MultiFramedRTPSink::isTooBigForAPacket(unsigned numBytes) const {
   // Check whether a 'numBytes'-byte frame - together with a RTP header and
   // (possible) special headers - would be too big for an output packet:
@@ -372,6 +606,9 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
 	// if failure handler has been specified, call it
 	if (fOnSendErrorFunc != NULL) (*fOnSendErrorFunc)(fOnSendErrorData);
       }
+    if (fRetransmissionHistorySize > 0) {
+      saveForRetransmission(fOutBuf->packet(), fOutBuf->curPacketSize());
+    }
     ++fPacketCount;
     fTotalOctetCount += fOutBuf->curPacketSize();
     fOctetCount += fOutBuf->curPacketSize()
@@ -398,6 +635,10 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
 
   if (fNoFramesLeft) {
     // We're done:
+    if (fBurstStatus != NULL) {
+      *fBurstStatus = BURST_DONE;
+      fBurstStatus = NULL;
+    }
     onSourceClosure();
   } else {
     // We have more frames left to send.  Figure out when the next frame
@@ -411,7 +652,30 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
       uSecondsToGo = 0;
     }
 
+    if (fPacingBurstUSeconds > 0 && uSecondsToGo > 0) {
+      // We're pacing in bursts.  If the next packet is due before the end of the current burst,
+      // then send it now - as part of this burst - rather than waking up for it:
+      int64_t uSecondsAfterBurstStart
+	= (fNextSendTime.tv_sec - fBurstStartTime.tv_sec)*1000000
+	+ (fNextSendTime.tv_usec - fBurstStartTime.tv_usec);
+      if (uSecondsAfterBurstStart < fPacingBurstUSeconds) {
+	if (fBurstStatus != NULL) {
+	  // We were called (synchronously) from "sendBurst()", which will send the next packet:
+	  *fBurstStatus = BURST_SEND_ANOTHER;
+	  fBurstStatus = NULL;
+	} else {
+	  sendBurst();
+	}
+	return;
+      }
+    }
+
     // Delay this amount of time:
+    if (fBurstStatus != NULL) {
+      *fBurstStatus = BURST_DONE;
+      fBurstStatus = NULL;
+    }
+    ++fNumSendWakeups;
     nextTask() = envir().taskScheduler().scheduleDelayedTask(uSecondsToGo, (TaskFunc*)sendNext, this);
   }
 }
@@ -419,9 +683,33 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
 // The following is called after each delay between packet sends:
 void MultiFramedRTPSink::sendNext(void* firstArg) {
   MultiFramedRTPSink* sink = (MultiFramedRTPSink*)firstArg;
+  if (sink->fPacingBurstUSeconds > 0) {
+    // Begin a new burst:
+    gettimeofday(&sink->fBurstStartTime, NULL);
+  }
   sink->buildAndSendPacket(False);
 }
 
+// Sends each of the remaining packets that are due during the current burst, in a loop (rather than
+// recursively, or by scheduling a task for each):
+void MultiFramedRTPSink::sendBurst() {
+  int status;
+  do {
+    status = BURST_PACKET_PENDING;
+    fBurstStatus = &status;
+    buildAndSendPacket(False);
+
+    // Note: If "status" was changed, then "sendPacketIfNecessary()" has already reset "fBurstStatus".
+    // (We mustn't touch any of our fields in that case, because - if the stream ended - we might have
+    // been closed.)
+    if (status == BURST_PACKET_PENDING) {
+      // Our source will deliver the frame(s) for this packet later, and "sendPacketIfNecessary()"
+      // will then continue the burst itself:
+      fBurstStatus = NULL;
+    }
+  } while (status == BURST_SEND_ANOTHER);
+}
+
 void MultiFramedRTPSink::ourHandleClosure(void* clientData) {
   MultiFramedRTPSink* sink = (MultiFramedRTPSink*)clientData;
   // There are no frames left, but we may have a partially built packet
@@ -45,14 +45,39 @@ public:
   }
   Boolean isEmpty() const { return fHeadPacket == NULL; }
 
-  void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; }
+  void setThresholdTime(unsigned uSeconds) { fThresholdTime = uSeconds; fIsAdaptive = False; }
+  void setAdaptiveThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+  Boolean isAdaptive() const { return fIsAdaptive; }
+  void noteJitter(unsigned jitterUSeconds);
   void resetHaveSeenFirstPacket() { fHaveSeenFirstPacket = False; }
 
+  unsigned thresholdTime() const { return fThresholdTime; }
+  unsigned numLatePackets() const { return fNumLatePackets; }
+  unsigned const* addedDelayHistogram() const { return fAddedDelayHistogram; }
+
+private:
+  void noteReorderDelay(unsigned uSeconds);
+  void updateThresholdTime();
+  void noteAddedDelay(BufferedPacket* packet);
+
 private:
   BufferedPacketFactory* fPacketFactory;
   unsigned fThresholdTime; // uSeconds
   Boolean fHaveSeenFirstPacket; // used to set initial "fNextExpectedSeqNo"
   unsigned short fNextExpectedSeqNo;
+  // Used to adapt "fThresholdTime" (if "fIsAdaptive"):
+  Boolean fIsAdaptive;
+  unsigned fMinThresholdTime, fMaxThresholdTime; // uSeconds
+  unsigned fJitter; // uSeconds
+  unsigned fReorderDelayEstimate; // uSeconds; a slowly decaying maximum of the observed reordering delays
+  // The sequence numbers that we most recently gave up on, and when we did so:
+  unsigned short fGaveUpFromSeqNo, fGaveUpToSeqNo; // [from, to)
+  struct timeval fTimeGaveUp;
+  // Statistics:
+  unsigned fNumLatePackets;
+  Boolean fHaveDeliveredPacket;
+  unsigned short fLastDeliveredSeqNo;
+  unsigned fAddedDelayHistogram[NUM_ADDED_DELAY_HISTOGRAM_BUCKETS];
   BufferedPacket* fHeadPacket;
   BufferedPacket* fTailPacket;
   BufferedPacket* fSavedPacket;
@@ -68,12 +93,19 @@ MultiFramedRTPSource
 		       unsigned char rtpPayloadFormat,
 		       unsigned rtpTimestampFrequency,
 		       BufferedPacketFactory* packetFactory)
-  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency) {
+  : RTPSource(env, RTPgs, rtpPayloadFormat, rtpTimestampFrequency),
+    fRTCPInstanceForRetransmissionRequests(NULL), fRTXPayloadFormat(0),
+    fHaveSeenSeqNoForRetransmissionRequests(False), fHighestSeqNoForRetransmissionRequests(0),
+    fNumPacketsNACKed(0), fNumPacketsRecovered(0) {
   reset();
   fReorderingBuffer = new ReorderingPacketBuffer(packetFactory);
 
   // Try to use a big receive buffer for RTP:
   increaseReceiveBufferTo(env, RTPgs->socketNum(), 50*1024);
+
+  // Have the kernel timestamp incoming packets, so that our jitter (and presentation time)
+  // calculations don't include any delay in handling them:
+  if (RTPgs->ownsSocketNum()) RTPgs->enableReceiveTimestamps();
 }
 
 void MultiFramedRTPSource::reset() {
@@ -115,6 +147,10 @@ void MultiFramedRTPSource::doStopGettingFrames() {
   reset();
 }
 
+Boolean MultiFramedRTPSource::isMultiFramedRTPSource() const {
+  return True;
+}
+
 void MultiFramedRTPSource::doGetNextFrame() {
   if (!fAreDoingNetworkReads) {
     // Turn on background read handling of incoming packets:
@@ -220,6 +256,57 @@ void MultiFramedRTPSource
   fReorderingBuffer->setThresholdTime(uSeconds);
 }
 
+void MultiFramedRTPSource
+::setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds) {
+  fReorderingBuffer->setAdaptiveThresholdTime(minUSeconds, maxUSeconds);
+}
+
+void MultiFramedRTPSource
+::enableRetransmissionRequests(RTCPInstance* rtcpInstance, unsigned char rtxPayloadFormat) {
+  fRTCPInstanceForRetransmissionRequests = rtcpInstance;
+  fRTXPayloadFormat = rtcpInstance == NULL ? 0 : rtxPayloadFormat;
+  fHaveSeenSeqNoForRetransmissionRequests = False;
+}
+
+#define MAX_NUM_PACKETS_TO_NACK 64
+    // We don't request retransmissions for larger gaps than this (they're more likely to be
+    // caused by a stream discontinuity than by packet loss)
+
+void MultiFramedRTPSource::noteSeqNoForRetransmissionRequests(u_int16_t rtpSeqNo) {
+  if (!fHaveSeenSeqNoForRetransmissionRequests) {
+    fHaveSeenSeqNoForRetransmissionRequests = True;
+    fHighestSeqNoForRetransmissionRequests = rtpSeqNo;
+    return;
+  }
+
+  u_int16_t seqNoDiff = rtpSeqNo - fHighestSeqNoForRetransmissionRequests;
+  if (seqNoDiff == 0 || seqNoDiff >= 0x8000) return; // a duplicate, or an old packet arriving out of order
+
+  unsigned numMissing = seqNoDiff - 1;
+  if (numMissing > 0 && numMissing <= MAX_NUM_PACKETS_TO_NACK) {
+    // Ask - right now - for the missing packets to be resent:
+    u_int16_t missingSeqNos[MAX_NUM_PACKETS_TO_NACK];
+    for (unsigned i = 0; i < numMissing; ++i) {
+      missingSeqNos[i] = fHighestSeqNoForRetransmissionRequests + 1 + i;
+    }
+    fRTCPInstanceForRetransmissionRequests->sendNACK(fLastReceivedSSRC, missingSeqNos, numMissing);
+    fNumPacketsNACKed += numMissing;
+  }
+  fHighestSeqNoForRetransmissionRequests = rtpSeqNo;
+}
+
+unsigned MultiFramedRTPSource::packetReorderingThresholdTime() const {
+  return fReorderingBuffer->thresholdTime();
+}
+
+unsigned MultiFramedRTPSource::numPacketsArrivingTooLate() const {
+  return fReorderingBuffer->numLatePackets();
+}
+
+unsigned const* MultiFramedRTPSource::addedDelayHistogram() const {
+  return fReorderingBuffer->addedDelayHistogram();
+}
+
 #define ADVANCE(n) do { bPacket->skip(n); } while (0)
 
 void MultiFramedRTPSource::networkReadHandler(MultiFramedRTPSource* source, int /*mask*/) {
@@ -270,7 +357,8 @@ void MultiFramedRTPSource::networkReadHandler1() {
 
     // Check the Payload Type.
     unsigned char rtpPayloadType = (unsigned char)((rtpHdr&0x007F0000)>>16);
-    if (rtpPayloadType != rtpPayloadFormat()) {
+    Boolean isRetransmission = fRTXPayloadFormat != 0 && rtpPayloadType == fRTXPayloadFormat;
+    if (rtpPayloadType != rtpPayloadFormat() && !isRetransmission) {
       if (fRTCPInstanceForMultiplexedRTCPPackets != NULL
 	  && rtpPayloadType >= 64 && rtpPayloadType <= 95) {
 	// This is a multiplexed RTCP packet, and we've been asked to deliver such packets.
@@ -304,32 +392,51 @@ void MultiFramedRTPSource::networkReadHandler1() {
       bPacket->removePadding(numPaddingBytes);
     }
 
+    unsigned short rtpSeqNo = (unsigned short)(rtpHdr&0xFFFF);
+    if (isRetransmission) {
+      // This is a "RTX" packet (RFC 4588).  Its payload begins with the 'original sequence number';
+      // treat the rest as the (resent) packet from our media source:
+      if (bPacket->dataSize() < 2) break;
+      rtpSeqNo = (bPacket->data()[0]<<8)|bPacket->data()[1]; ADVANCE(2);
+      rtpSSRC = fLastReceivedSSRC;
+    }
+
     // The rest of the packet is the usable data.  Record and save it:
     if (rtpSSRC != fLastReceivedSSRC) {
       // The SSRC of incoming packets has changed.  Unfortunately we don't yet handle streams that contain multiple SSRCs,
       // but we can handle a single-SSRC stream where the SSRC changes occasionally:
       fLastReceivedSSRC = rtpSSRC;
       fReorderingBuffer->resetHaveSeenFirstPacket();
+      fHaveSeenSeqNoForRetransmissionRequests = False;
     }
-    unsigned short rtpSeqNo = (unsigned short)(rtpHdr&0xFFFF);
-    Boolean usableInJitterCalculation
-      = packetIsUsableInJitterCalculation((bPacket->data()),
-						  bPacket->dataSize());
+    if (fRTCPInstanceForRetransmissionRequests != NULL && !isRetransmission) {
+      noteSeqNoForRetransmissionRequests(rtpSeqNo);
+    }
+    Boolean usableInJitterCalculation = !isRetransmission
+      && packetIsUsableInJitterCalculation((bPacket->data()),
+					   bPacket->dataSize());
     struct timeval presentationTime; // computed by:
     Boolean hasBeenSyncedUsingRTCP; // computed by:
     receptionStatsDB()
       .noteIncomingPacket(rtpSSRC, rtpSeqNo, rtpTimestamp,
 			  timestampFrequency(),
 			  usableInJitterCalculation, presentationTime,
-			  hasBeenSyncedUsingRTCP, bPacket->dataSize());
+			  hasBeenSyncedUsingRTCP, bPacket->dataSize(),
+			  &bPacket->timeReceived());
+    if (fReorderingBuffer->isAdaptive() && timestampFrequency() != 0) {
+      // Tell the reordering buffer about the current interarrival jitter (converted to uSeconds):
+      RTPReceptionStats* stats = receptionStatsDB().lookup(rtpSSRC);
+      if (stats != NULL) {
+	fReorderingBuffer->noteJitter((unsigned)((stats->jitter()*1000000.0)/timestampFrequency()));
+      }
+    }
 
     // Fill in the rest of the packet descriptor, and store it:
-    struct timeval timeNow;
-    gettimeofday(&timeNow, NULL);
     bPacket->assignMiscParams(rtpSeqNo, rtpTimestamp, presentationTime,
 			      hasBeenSyncedUsingRTCP, rtpMarkerBit,
-			      timeNow);
+			      bPacket->timeReceived());
     if (!fReorderingBuffer->storePacket(bPacket)) break;
+    if (isRetransmission) ++fNumPacketsRecovered;
 
     readSuccess = True;
   } while (0);
@@ -398,7 +505,7 @@ Boolean BufferedPacket::fillInData(RTPInterface& rtpInterface, struct sockaddr_i
   if (!rtpInterface.handleRead(&fBuf[fTail], maxBytesToRead,
 			       numBytesRead, fromAddress,
 			       tcpSocketNum, tcpStreamChannelId,
-			       packetReadWasIncomplete)) {
+			       packetReadWasIncomplete, &fTimeReceived)) {
     return False;
   }
   fTail += numBytesRead;
@@ -488,10 +595,15 @@ BufferedPacket* BufferedPacketFactory
 ReorderingPacketBuffer
 ::ReorderingPacketBuffer(BufferedPacketFactory* packetFactory)
   : fThresholdTime(100000) /* default reordering threshold: 100 ms */,
-    fHaveSeenFirstPacket(False), fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True) {
+    fHaveSeenFirstPacket(False),
+    fIsAdaptive(False), fMinThresholdTime(0), fMaxThresholdTime(0), fJitter(0), fReorderDelayEstimate(0),
+    fGaveUpFromSeqNo(0), fGaveUpToSeqNo(0), fNumLatePackets(0), fHaveDeliveredPacket(False), fLastDeliveredSeqNo(0),
+    fHeadPacket(NULL), fTailPacket(NULL), fSavedPacket(NULL), fSavedPacketFree(True) {
   fPacketFactory = (packetFactory == NULL)
     ? (new BufferedPacketFactory)
     : packetFactory;
+  fTimeGaveUp.tv_sec = fTimeGaveUp.tv_usec = 0;
+  for (unsigned i = 0; i < NUM_ADDED_DELAY_HISTOGRAM_BUCKETS; ++i) fAddedDelayHistogram[i] = 0;
 }
 
 ReorderingPacketBuffer::~ReorderingPacketBuffer() {
@@ -506,6 +618,70 @@ void ReorderingPacketBuffer::reset() {
   fHeadPacket = fTailPacket = fSavedPacket = NULL;
 }
 
+void ReorderingPacketBuffer::setAdaptiveThresholdTime(unsigned minUSeconds, unsigned maxUSeconds) {
+  if (maxUSeconds < minUSeconds) maxUSeconds = minUSeconds;
+
+  fIsAdaptive = True;
+  fMinThresholdTime = minUSeconds;
+  fMaxThresholdTime = maxUSeconds;
+  updateThresholdTime();
+}
+
+void ReorderingPacketBuffer::noteJitter(unsigned jitterUSeconds) {
+  fJitter = jitterUSeconds;
+
+  // Also, let our reordering delay estimate decay slowly (with a time constant of about 1000 packets),
+  // so that we recover from a past burst of reordering:
+  fReorderDelayEstimate -= fReorderDelayEstimate>>10;
+
+  updateThresholdTime();
+}
+
+void ReorderingPacketBuffer::noteReorderDelay(unsigned uSeconds) {
+  if (uSeconds > fReorderDelayEstimate) {
+    fReorderDelayEstimate = uSeconds;
+    updateThresholdTime();
+  }
+}
+
+void ReorderingPacketBuffer::updateThresholdTime() {
+  if (!fIsAdaptive) return;
+
+  // Wait long enough for the reordering that we've seen (plus a 25% margin), and for several
+  // times the interarrival jitter, but no shorter or longer than our bounds:
+  unsigned threshold = fReorderDelayEstimate + fReorderDelayEstimate/4;
+  if (threshold < 3*fJitter) threshold = 3*fJitter;
+  if (threshold < fMinThresholdTime) threshold = fMinThresholdTime;
+  else if (threshold > fMaxThresholdTime) threshold = fMaxThresholdTime;
+
+  fThresholdTime = threshold;
+}
+
+static unsigned uSecondsBetween(struct timeval const& earlier, struct timeval const& later) {
+  int uSeconds = (later.tv_sec - earlier.tv_sec)*1000000 + (later.tv_usec - earlier.tv_usec);
+  return uSeconds < 0 ? 0 : (unsigned)uSeconds;
+}
+
+void ReorderingPacketBuffer::noteAddedDelay(BufferedPacket* packet) {
+  if (!fIsAdaptive) return; // we collect this only for adaptive thresholds (so that, otherwise, we don't read the clock)
+
+  // Count each packet only once (the first time it's delivered):
+  if (fHaveDeliveredPacket && packet->rtpSeqNo() == fLastDeliveredSeqNo) return;
+  fHaveDeliveredPacket = True;
+  fLastDeliveredSeqNo = packet->rtpSeqNo();
+
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  unsigned mSeconds = uSecondsBetween(packet->timeReceived(), timeNow)/1000;
+
+  unsigned bucket = 0;
+  while (mSeconds > 0 && bucket < NUM_ADDED_DELAY_HISTOGRAM_BUCKETS-1) {
+    mSeconds >>= 1;
+    ++bucket;
+  }
+  ++fAddedDelayHistogram[bucket];
+}
+
 BufferedPacket* ReorderingPacketBuffer::getFreePacket(MultiFramedRTPSource* ourSource) {
   if (fSavedPacket == NULL) { // we're being called for the first time
     fSavedPacket = fPacketFactory->createNewPacket(ourSource);
@@ -531,7 +707,14 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
 
   // Ignore this packet if its sequence number is less than the one
   // that we're looking for (in this case, it's been excessively delayed).
-  if (seqNumLT(rtpSeqNo, fNextExpectedSeqNo)) return False;
+  if (seqNumLT(rtpSeqNo, fNextExpectedSeqNo)) {
+    if (!seqNumLT(rtpSeqNo, fGaveUpFromSeqNo) && seqNumLT(rtpSeqNo, fGaveUpToSeqNo)) {
+      // We gave up on this packet too soon.  (Had we waited this much longer, we'd have delivered it.)
+      ++fNumLatePackets;
+      if (fIsAdaptive) noteReorderDelay(fThresholdTime + uSecondsBetween(fTimeGaveUp, bPacket->timeReceived()));
+    }
+    return False;
+  }
 
   if (fTailPacket == NULL) {
     // Common case: There are no packets in the queue; this will be the first one:
@@ -567,6 +750,12 @@ Boolean ReorderingPacketBuffer::storePacket(BufferedPacket* bPacket) {
     afterPtr = afterPtr->nextPacket();
   }
 
+  if (fIsAdaptive) {
+    // Note how long this packet was reordered by - i.e., how long after the arrival of a later packet
+    // that we'd have had to wait for it:
+    noteReorderDelay(uSecondsBetween(afterPtr->timeReceived(), bPacket->timeReceived()));
+  }
+
   // Link our new packet between "beforePtr" and "afterPtr":
   bPacket->nextPacket() = afterPtr;
   if (beforePtr == NULL) {
@@ -602,6 +791,7 @@ BufferedPacket* ReorderingPacketBuffer
   if (fHeadPacket->rtpSeqNo() == fNextExpectedSeqNo) {
     packetLossPreceded = fHeadPacket->isFirstPacket();
         // (The very first packet is treated as if there was packet loss beforehand.)
+    noteAddedDelay(fHeadPacket);
     return fHeadPacket;
   }
 
@@ -609,20 +799,25 @@ BufferedPacket* ReorderingPacketBuffer
   // our time threshold has been exceeded, then forget it, and return
   // the head packet instead:
   Boolean timeThresholdHasBeenExceeded;
+  struct timeval timeNow;
   if (fThresholdTime == 0) {
     timeThresholdHasBeenExceeded = True; // optimization
+    if (fIsAdaptive) gettimeofday(&timeNow, NULL); // for "fTimeGaveUp"
   } else {
-    struct timeval timeNow;
     gettimeofday(&timeNow, NULL);
-    unsigned uSecondsSinceReceived
-      = (timeNow.tv_sec - fHeadPacket->timeReceived().tv_sec)*1000000
-      + (timeNow.tv_usec - fHeadPacket->timeReceived().tv_usec);
+    unsigned uSecondsSinceReceived = uSecondsBetween(fHeadPacket->timeReceived(), timeNow);
     timeThresholdHasBeenExceeded = uSecondsSinceReceived > fThresholdTime;
   }
   if (timeThresholdHasBeenExceeded) {
+    // Remember the packets that we're giving up on, in case any of them arrive later:
+    fGaveUpFromSeqNo = fNextExpectedSeqNo;
+    fGaveUpToSeqNo = fHeadPacket->rtpSeqNo();
+    if (fIsAdaptive) fTimeGaveUp = timeNow; // used only to adapt our threshold
+
     fNextExpectedSeqNo = fHeadPacket->rtpSeqNo();
         // we've given up on earlier packets now
     packetLossPreceded = True;
+    noteAddedDelay(fHeadPacket);
     return fHeadPacket;
   }
 
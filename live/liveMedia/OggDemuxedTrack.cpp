@@ -24,7 +24,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 OggDemuxedTrack::OggDemuxedTrack(UsageEnvironment& env, unsigned trackNumber, OggDemux& sourceDemux)
   : FramedSource(env),
     fOurTrackNumber(trackNumber), fOurSourceDemux(sourceDemux),
-    fCurrentPageIsContinuation(False) {
+    fCurrentPageIsContinuation(False), fSkipContinuedPacket(False), fLastGranuleNPT(-1.0) {
   fNextPresentationTime.tv_sec = 0; fNextPresentationTime.tv_usec = 0;
 }
 
@@ -32,7 +32,12 @@ OggDemuxedTrack::~OggDemuxedTrack() {
   fOurSourceDemux.removeTrack(fOurTrackNumber);
 }
 
+void OggDemuxedTrack::seekToTime(double& seekNPT) {
+  fOurSourceDemux.seekToTime(seekNPT);
+}
+
 void OggDemuxedTrack::doGetNextFrame() {
+  fFrameSize = 0; // so that "OggDemux::seekToTime()" can tell whether we've delivered part of a packet
   fOurSourceDemux.continueReading();
 }
 
@@ -28,6 +28,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 class OggDemux; // forward
 
 class OggDemuxedTrack: public FramedSource {
+public:
+  void seekToTime(double& seekNPT);
+
 private: // We are created only by a OggDemux (a friend)
   friend class OggDemux;
   OggDemuxedTrack(UsageEnvironment& env, unsigned trackNumber, OggDemux& sourceDemux);
@@ -53,6 +56,8 @@ private:
   OggDemux& fOurSourceDemux;
   Boolean fCurrentPageIsContinuation;
   struct timeval fNextPresentationTime;
+  Boolean fSkipContinuedPacket; // after seeking, until we see the start of a new packet
+  double fLastGranuleNPT; // from the most recent page of this track that ended a packet, or -1
 };
 
 #endif
@@ -24,6 +24,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "VorbisAudioRTPSink.hh"
 #include "SimpleRTPSink.hh"
 #include "TheoraVideoRTPSink.hh"
+#include "InputFile.hh"
 
 ////////// OggTrackTable definition /////////
 
@@ -123,7 +124,8 @@ OggFile::OggFile(UsageEnvironment& env, char const* fileName,
 		 onCreationFunc* onCreation, void* onCreationClientData)
   : Medium(env),
     fFileName(strDup(fileName)),
-    fOnCreation(onCreation), fOnCreationClientData(onCreationClientData) {
+    fOnCreation(onCreation), fOnCreationClientData(onCreationClientData),
+    fFileDuration(0.0), fFileSize(0) {
   fTrackTable = new OggTrackTable;
   fDemuxesTable = HashTable::create(ONE_WORD_HASH_KEYS);
 
@@ -161,10 +163,52 @@ void OggFile::handleEndOfBosPageParsing() {
   // Delete our parser, because it's done its job now:
   delete fParserForInitialization; fParserForInitialization = NULL;
 
+  // Now that we know each track's parameters, we can figure out the file's duration:
+  computeFileDuration();
+
   // Finally, signal our caller that we've been created and initialized:
   if (fOnCreation != NULL) (*fOnCreation)(this, fOnCreationClientData);
 }
 
+#ifndef OGG_DURATION_SCAN_SIZE
+#define OGG_DURATION_SCAN_SIZE 65536
+#endif
+
+void OggFile::computeFileDuration() {
+  // The file's duration is given by the largest 'granule position' in its last page(s), so
+  // scan the end of the file for page headers:
+  FILE* fid = OpenInputFile(envir(), fFileName);
+  if (fid == NULL) return;
+
+  fFileSize = GetFileSize(fFileName, fid);
+  unsigned const numBytesToScan
+    = fFileSize < OGG_DURATION_SCAN_SIZE ? (unsigned)fFileSize : OGG_DURATION_SCAN_SIZE;
+  if (numBytesToScan >= 27 && SeekFile64(fid, fFileSize - numBytesToScan, SEEK_SET) >= 0) {
+    u_int8_t* buf = new u_int8_t[numBytesToScan];
+    unsigned const numBytesRead = fread(buf, 1, numBytesToScan, fid);
+
+    for (unsigned i = 0; i + 27 <= numBytesRead; ++i) {
+      u_int8_t const* p = &buf[i];
+      if (p[0] != 'O' || p[1] != 'g' || p[2] != 'g' || p[3] != 'S' || p[4] != 0/*version*/) continue;
+
+      u_int64_t granule_position = 0;
+      for (int j = 13; j >= 6; --j) granule_position = (granule_position<<8)|p[j];
+      if (granule_position == ~(u_int64_t)0) continue; // no packet ends in this page
+
+      u_int32_t bitstream_serial_number = (p[17]<<24)|(p[16]<<16)|(p[15]<<8)|p[14];
+      OggTrack* track = lookup(bitstream_serial_number);
+      if (track == NULL || track->mimeType == NULL) continue;
+
+      double const npt = track->granulePositionToNPT(granule_position);
+      if (npt > fFileDuration) fFileDuration = (float)npt;
+    }
+
+    delete[] buf;
+  }
+
+  CloseInputFile(fid);
+}
+
 void OggFile::addTrack(OggTrack* newTrack) {
   fTrackTable->add(newTrack);
 }
@@ -219,17 +263,90 @@ OggTrack* OggTrackTableIterator::next() {
 
 OggTrack::OggTrack()
   : trackNumber(0), mimeType(NULL),
-    samplingFrequency(48000), numChannels(2), estBitrate(100) { // default settings
+    samplingFrequency(48000), numChannels(2), estBitrate(100), // default settings
+    fSeekIndexSize(0), fSeekIndexMaxSize(0), fSeekIndexNPT(NULL), fSeekIndexOffsetInFile(NULL) {
   vtoHdrs.header[0] = vtoHdrs.header[1] = vtoHdrs.header[2] = NULL;
   vtoHdrs.headerSize[0] = vtoHdrs.headerSize[1] = vtoHdrs.headerSize[2] = 0;
 
   vtoHdrs.vorbis_mode_count = 0;
   vtoHdrs.vorbis_mode_blockflag = NULL;
+  vtoHdrs.KFGSHIFT = 0;
+  vtoHdrs.uSecsPerFrame = 0;
 }
 
 OggTrack::~OggTrack() {
   delete[] vtoHdrs.header[0]; delete[] vtoHdrs.header[1]; delete[] vtoHdrs.header[2];
   delete[] vtoHdrs.vorbis_mode_blockflag;
+  delete[] fSeekIndexNPT; delete[] fSeekIndexOffsetInFile;
+}
+
+double OggTrack::granulePositionToNPT(u_int64_t granule_position) const {
+  if (mimeType != NULL && strcmp(mimeType, "video/THEORA") == 0) {
+    // The 'granule position' is the frame number of the most recent key frame (in the high bits),
+    // plus the number of frames since that key frame (in the low "KFGSHIFT" bits):
+    unsigned const shift = vtoHdrs.KFGSHIFT;
+    u_int64_t const numFrames
+      = (granule_position>>shift) + (granule_position&(((u_int64_t)1<<shift)-1));
+    return numFrames*(vtoHdrs.uSecsPerFrame/1000000.0);
+  } else {
+    // For Vorbis and Opus audio, the 'granule position' is a count of audio samples.
+    // (For Opus, it's always at 48 kHz, which is our default "samplingFrequency".)
+    if (samplingFrequency == 0) return 0.0; // sanity check
+    return (double)granule_position/samplingFrequency;
+  }
+}
+
+#ifndef OGG_SEEK_INDEX_MIN_INTERVAL
+#define OGG_SEEK_INDEX_MIN_INTERVAL 1.0 // seconds; we don't bother indexing seek points that are any closer
+#endif
+
+void OggTrack::addSeekIndexEntry(double npt, u_int64_t offsetInFile) {
+  // Find where the new entry would go (in time order), using a binary search:
+  unsigned lo = 0, hi = fSeekIndexSize;
+  while (lo < hi) {
+    unsigned mid = (lo + hi)/2;
+    if (fSeekIndexNPT[mid] <= npt) lo = mid + 1; else hi = mid;
+  }
+
+  // Don't add the entry if it's too close to a neighbor (e.g., if we've seen this page before):
+  if (lo > 0 && npt - fSeekIndexNPT[lo-1] < OGG_SEEK_INDEX_MIN_INTERVAL) return;
+  if (lo < fSeekIndexSize && fSeekIndexNPT[lo] - npt < OGG_SEEK_INDEX_MIN_INTERVAL) return;
+
+  if (fSeekIndexSize == fSeekIndexMaxSize) {
+    // Grow the index arrays:
+    unsigned const newMaxSize = fSeekIndexMaxSize == 0 ? 64 : 2*fSeekIndexMaxSize;
+    double* newNPT = new double[newMaxSize];
+    u_int64_t* newOffsetInFile = new u_int64_t[newMaxSize];
+    for (unsigned i = 0; i < fSeekIndexSize; ++i) {
+      newNPT[i] = fSeekIndexNPT[i];
+      newOffsetInFile[i] = fSeekIndexOffsetInFile[i];
+    }
+    delete[] fSeekIndexNPT; fSeekIndexNPT = newNPT;
+    delete[] fSeekIndexOffsetInFile; fSeekIndexOffsetInFile = newOffsetInFile;
+    fSeekIndexMaxSize = newMaxSize;
+  }
+
+  for (unsigned i = fSeekIndexSize; i > lo; --i) {
+    fSeekIndexNPT[i] = fSeekIndexNPT[i-1];
+    fSeekIndexOffsetInFile[i] = fSeekIndexOffsetInFile[i-1];
+  }
+  fSeekIndexNPT[lo] = npt;
+  fSeekIndexOffsetInFile[lo] = offsetInFile;
+  ++fSeekIndexSize;
+}
+
+Boolean OggTrack::lookupSeekIndex(double npt, double& resultNPT, u_int64_t& resultOffsetInFile) const {
+  // Find the first entry whose time is > "npt"; the entry before that is the one we want:
+  unsigned lo = 0, hi = fSeekIndexSize;
+  while (lo < hi) {
+    unsigned mid = (lo + hi)/2;
+    if (fSeekIndexNPT[mid] <= npt) lo = mid + 1; else hi = mid;
+  }
+  if (lo == 0) return False;
+
+  resultNPT = fSeekIndexNPT[lo-1];
+  resultOffsetInFile = fSeekIndexOffsetInFile[lo-1];
+  return True;
 }
 
 
@@ -298,6 +415,75 @@ void OggDemux::continueReading() {
   fOurParser->continueParsing();
 }
 
+#ifndef OGG_MAX_SEEK_INDEX_GAP
+#define OGG_MAX_SEEK_INDEX_GAP 10.0 // seconds
+#endif
+
+void OggDemux::seekToTime(double& seekNPT) {
+  u_int64_t seekOffsetInFile;
+
+  if (seekNPT <= 0.0) {
+    seekNPT = 0.0;
+    seekOffsetInFile = 0;
+  } else if (fOurFile.fFileDuration > 0.0 && seekNPT >= fOurFile.fFileDuration) {
+    seekNPT = fOurFile.fFileDuration;
+    seekOffsetInFile = fOurFile.fFileSize;
+  } else {
+    // Use the seek indexes of the tracks that we're reading to find the latest point in the file
+    // from which every track can be read from a time at or before "seekNPT":
+    double indexNPT = 0.0;
+    seekOffsetInFile = ~(u_int64_t)0;
+
+    HashTable::Iterator* iter = HashTable::Iterator::create(*fDemuxedTracksTable);
+    char const* key;
+    OggDemuxedTrack* demuxedTrack;
+    while ((demuxedTrack = (OggDemuxedTrack*)iter->next(key)) != NULL) {
+      OggTrack* track = fOurFile.lookup(demuxedTrack->fOurTrackNumber);
+      double npt = 0.0; u_int64_t offsetInFile = 0; // the start of the file, if the track has no index entry
+      if (track != NULL) track->lookupSeekIndex(seekNPT, npt, offsetInFile);
+
+      if (offsetInFile < seekOffsetInFile) {
+	seekOffsetInFile = offsetInFile;
+	indexNPT = npt;
+      }
+    }
+    delete iter;
+    if (seekOffsetInFile == ~(u_int64_t)0) seekOffsetInFile = 0; // we have no tracks
+
+    if (seekNPT - indexNPT > OGG_MAX_SEEK_INDEX_GAP
+	&& fOurFile.fFileDuration > seekNPT && fOurFile.fFileSize > seekOffsetInFile) {
+      // The index doesn't (yet) cover this part of the file, so estimate a position by
+      // interpolating between the index entry and the end of the file.  (The parser will find the
+      // next page after this position, and update the index as it reads onward from there.)
+      seekOffsetInFile
+	+= (u_int64_t)(((seekNPT - indexNPT)/(fOurFile.fFileDuration - indexNPT))
+		       *(fOurFile.fFileSize - seekOffsetInFile));
+    } else {
+      seekNPT = indexNPT;
+    }
+  }
+
+  // Reset the state of each of our demuxed tracks:
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fDemuxedTracksTable);
+  char const* key;
+  OggDemuxedTrack* demuxedTrack;
+  while ((demuxedTrack = (OggDemuxedTrack*)iter->next(key)) != NULL) {
+    if (demuxedTrack->isCurrentlyAwaitingData() && demuxedTrack->frameSize() > 0) {
+      // Discard the start of an incomplete packet that had already been delivered:
+      demuxedTrack->to() -= demuxedTrack->frameSize();
+      demuxedTrack->maxSize() += demuxedTrack->frameSize();
+      demuxedTrack->frameSize() = 0;
+      demuxedTrack->numTruncatedBytes() = 0;
+    }
+    demuxedTrack->fCurrentPageIsContinuation = False;
+    demuxedTrack->fSkipContinuedPacket = True;
+    demuxedTrack->fLastGranuleNPT = -1.0;
+  }
+  delete iter;
+
+  fOurParser->seekToFilePosition(seekOffsetInFile);
+}
+
 void OggDemux::handleEndOfFile(void* clientData) {
   ((OggDemux*)clientData)->handleEndOfFile();
 }
@@ -20,27 +20,35 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "OggFileParser.hh"
 #include "OggDemuxedTrack.hh"
+#include "ByteStreamFileSource.hh"
 #include <GroupsockHelper.hh> // for "gettimeofday()
 
-PacketSizeTable::PacketSizeTable(unsigned number_page_segments)
+PacketSizeTable::PacketSizeTable()
   : numCompletedPackets(0), totSizes(0), nextPacketNumToDeliver(0),
     lastPacketIsIncomplete(False) {
-  size = new unsigned[number_page_segments];
-  for (unsigned i = 0; i < number_page_segments; ++i) size[i] = 0;
+  size = new unsigned[255]; // the maximum possible "number_page_segments"
 }
 
 PacketSizeTable::~PacketSizeTable() {
   delete[] size;
 }
 
+void PacketSizeTable::reset(unsigned number_page_segments) {
+  numCompletedPackets = totSizes = nextPacketNumToDeliver = 0;
+  lastPacketIsIncomplete = False;
+  for (unsigned i = 0; i < number_page_segments; ++i) size[i] = 0;
+}
+
 OggFileParser::OggFileParser(OggFile& ourFile, FramedSource* inputSource,
 			     FramedSource::onCloseFunc* onEndFunc, void* onEndClientData,
 			     OggDemux* ourDemux)
   : StreamParser(inputSource, onEndFunc, onEndClientData, continueParsing, this),
     fOurFile(ourFile), fInputSource(inputSource),
     fOnEndFunc(onEndFunc), fOnEndClientData(onEndClientData),
-    fOurDemux(ourDemux), fNumUnfulfilledTracks(0),
-    fPacketSizeTable(NULL), fCurrentTrackNumber(0), fSavedPacket(NULL) {
+    fOurDemux(ourDemux),
+    fCurPageOffsetInFile(0), fNextPageOffsetInFile(0), fSavedNextPageOffsetInFile(0),
+    fNumUnfulfilledTracks(0),
+    fPacketSizeTable(new PacketSizeTable), fCurrentTrackNumber(0), fSavedPacket(NULL) {
   if (ourDemux == NULL) {
     // Initialization
     fCurrentParseState = PARSING_START_OF_FILE;
@@ -78,6 +86,18 @@ void OggFileParser::continueParsing() {
   if (fOnEndFunc != NULL) (*fOnEndFunc)(fOnEndClientData);
 }
 
+void OggFileParser::seekToFilePosition(u_int64_t offsetInFile) {
+  ByteStreamFileSource* fileSource = (ByteStreamFileSource*)fInputSource; // we know it's a "ByteStreamFileSource"
+  if (fileSource != NULL) {
+    fileSource->seekToByteAbsolute(offsetInFile);
+
+    // Because we're resuming parsing after seeking to a new position in the file, reset the parser state:
+    fCurPageOffsetInFile = fNextPageOffsetInFile = fSavedNextPageOffsetInFile = offsetInFile;
+    flushInput();
+    fCurrentParseState = PARSING_AND_DELIVERING_PAGES;
+  }
+}
+
 Boolean OggFileParser::parse() {
   try {
     while (1) {
@@ -118,21 +138,18 @@ Boolean OggFileParser::parseStartOfFile() {
   return True;
 }
 
-static u_int32_t byteSwap(u_int32_t x) {
-  return (x<<24)|((x<<8)&0x00FF0000)|((x>>8)&0x0000FF00)|(x>>24);
-}
-
 u_int8_t OggFileParser::parseInitialPage() {
   u_int8_t header_type_flag;
   u_int32_t bitstream_serial_number;
-  parseStartOfPage(header_type_flag, bitstream_serial_number);
+  u_int64_t granule_position;
+  parseStartOfPage(header_type_flag, bitstream_serial_number, granule_position);
 
   // If this is a BOS page, examine the first 8 bytes of the first 'packet', to see whether
   // the track data type is one that we know how to stream:
   OggTrack* track;
   if ((header_type_flag&0x02) != 0) { // BOS
     char const* mimeType = NULL; // if unknown
-    if (fPacketSizeTable != NULL && fPacketSizeTable->size[0] >= 8) { // sanity check
+    if (fPacketSizeTable->size[0] >= 8) { // sanity check
       char buf[8];
       testBytes((u_int8_t*)buf, 8);
 
@@ -803,7 +820,8 @@ void OggFileParser::parseAndDeliverPages() {
 Boolean OggFileParser::parseAndDeliverPage() {
   u_int8_t header_type_flag;
   u_int32_t bitstream_serial_number;
-  parseStartOfPage(header_type_flag, bitstream_serial_number);
+  u_int64_t granule_position;
+  parseStartOfPage(header_type_flag, bitstream_serial_number, granule_position);
 
   OggDemuxedTrack* demuxedTrack = fOurDemux->lookupDemuxedTrack(bitstream_serial_number);
   if (demuxedTrack == NULL) { // this track is not being read
@@ -813,7 +831,54 @@ Boolean OggFileParser::parseAndDeliverPage() {
 #endif
     skipBytes(fPacketSizeTable->totSizes);
     return True;
-  } else if (fPacketSizeTable->totSizes == 0) {
+  }
+
+  OggTrack* track = fOurFile.lookup(bitstream_serial_number);
+  Boolean const pageIsContinuation = (header_type_flag&0x01) != 0;
+
+  // Check whether this page can be used as a seek point: It must begin with a new packet,
+  // and (for Theora) that packet must be a key frame:
+  Boolean pageIsSeekPoint = !pageIsContinuation && fPacketSizeTable->totSizes > 0;
+  if (pageIsSeekPoint && strcmp(track->mimeType, "video/THEORA") == 0) {
+    u_int8_t firstByte = 0x40; // if the first packet is empty
+    if (fPacketSizeTable->size[0] > 0) testBytes(&firstByte, 1);
+    pageIsSeekPoint = (firstByte&0xC0) == 0; // a data packet, containing an intra frame
+  }
+
+  if (demuxedTrack->fSkipContinuedPacket) {
+    // We've just seeked to this point in the file, so we can't deliver any packet data that
+    // continues from an earlier page (because we never saw the start of that packet):
+    if (pageIsContinuation && fPacketSizeTable->totSizes > 0) {
+      unsigned const numBytesToSkip = fPacketSizeTable->numCompletedPackets == 0
+	? fPacketSizeTable->totSizes // the packet continues onto the next page as well
+	: fPacketSizeTable->size[0];
+#ifdef DEBUG
+      fprintf(stderr, "\t[track: %s] Skipping %d bytes of packet data continued from before the seek point\n",
+	      demuxedTrack->MIMEtype(), numBytesToSkip);
+#endif
+      skipBytes(numBytesToSkip);
+      fPacketSizeTable->totSizes -= numBytesToSkip;
+      if (fPacketSizeTable->numCompletedPackets > 0) {
+	fPacketSizeTable->nextPacketNumToDeliver = 1;
+	demuxedTrack->fSkipContinuedPacket = False;
+      }
+      header_type_flag &=~ 0x01; // any remaining packet data in this page starts a new packet
+    } else {
+      demuxedTrack->fSkipContinuedPacket = False;
+    }
+  }
+
+  // Note: From here until the parser state is next saved, nothing can throw an exception,
+  // so the following won't get redone if we later have to wait for more input data.
+  if (pageIsSeekPoint && demuxedTrack->fLastGranuleNPT >= 0.0) {
+    // Every packet in this page starts after the time given by the previous page's 'granule position':
+    track->addSeekIndexEntry(demuxedTrack->fLastGranuleNPT, fCurPageOffsetInFile);
+  }
+  if (granule_position != ~(u_int64_t)0) {
+    demuxedTrack->fLastGranuleNPT = track->granulePositionToNPT(granule_position);
+  }
+
+  if (fPacketSizeTable->totSizes == 0) {
     // This page is empty (has no packets).  Skip it and continue
 #ifdef DEBUG
     fprintf(stderr, "\t[track: %s] Skipping empty page\n", demuxedTrack->MIMEtype());
@@ -825,7 +890,7 @@ Boolean OggFileParser::parseAndDeliverPage() {
   demuxedTrack->fCurrentPageIsContinuation = (header_type_flag&0x01) != 0;
   fCurrentTrackNumber = bitstream_serial_number;
   fCurrentParseState = DELIVERING_PACKET_WITHIN_PAGE;
-  saveParserState();
+  setParseState();
   return False;
 }
 
@@ -935,7 +1000,7 @@ Boolean OggFileParser::deliverPacketWithinPage() {
     ++demuxedTrack->nextPresentationTime().tv_sec;
     demuxedTrack->nextPresentationTime().tv_usec -= 1000000;    
   }
-  saveParserState();
+  setParseState();
 
   // And check whether there's a next packet in this page:
   if (packetNum == fPacketSizeTable->numCompletedPackets) {
@@ -959,25 +1024,65 @@ Boolean OggFileParser::deliverPacketWithinPage() {
   return True;
 }
 
+// Returns the offset of the first Ogg 'capture_pattern' ("OggS") within "p[0..numBytes-1]",
+// or (if there is none) "numBytes-3" (because the last 3 bytes might begin a 'capture_pattern').
+// Assumes: numBytes >= 4
+static unsigned findCapturePattern(u_int8_t const* p, unsigned numBytes) {
+  unsigned const limit = numBytes - 3; // the first offset at which a capture pattern can't fit
+  unsigned i = 0;
+  while (i < limit) {
+    // Use "memchr()" (which is usually well optimized) to find the next 'O':
+    u_int8_t const* o = (u_int8_t const*)memchr(&p[i], 'O', limit - i);
+    if (o == NULL) break;
+
+    i = o - p;
+    if (o[1] == 'g' && o[2] == 'g' && o[3] == 'S') return i;
+    ++i;
+  }
+
+  return limit;
+}
+
 void OggFileParser::parseStartOfPage(u_int8_t& header_type_flag,
-				     u_int32_t& bitstream_serial_number) {
-  saveParserState();
+				     u_int32_t& bitstream_serial_number,
+				     u_int64_t& granule_position) {
+  setParseState();
   // First, make sure we start with the 'capture_pattern': 0x4F676753 ('OggS'):
-  while (test4Bytes() != 0x4F676753) {
-    skipBytes(1);
-    saveParserState(); // ensures forward progress through the file
+  while (1) {
+    unsigned const numBytesAvailable = numBufferedBytes();
+    if (numBytesAvailable >= 4) {
+      // Search all of the data that we've already read, rather than testing one byte at a time:
+      unsigned const numBytesToSkip = findCapturePattern(bufferedBytes(), numBytesAvailable);
+      if (numBytesToSkip > 0) {
+	skipBytes(numBytesToSkip);
+	fNextPageOffsetInFile += numBytesToSkip;
+	setParseState(); // ensures forward progress through the file
+      }
+      if (numBytesToSkip < numBytesAvailable - 3) break; // we found it
+    } else {
+      // We need to read more data first:
+      if (test4Bytes() == 0x4F676753) break;
+      skipBytes(1);
+      ++fNextPageOffsetInFile;
+      setParseState(); // ensures forward progress through the file
+    }
   }
-  skipBytes(4);
 #ifdef DEBUG
   fprintf(stderr, "\nSaw Ogg page header:\n");
 #endif
 
-  u_int8_t stream_structure_version = get1Byte();
+  // Read the rest of the page header - including the "segment_table" - in bulk:
+  u_int8_t header[27+255];
+  getBytes(header, 27);
+  u_int8_t const number_page_segments = header[26];
+  getBytes(&header[27], number_page_segments);
+
+  u_int8_t stream_structure_version = header[4];
   if (stream_structure_version != 0) {
     fprintf(stderr, "Saw page with unknown Ogg file version number: 0x%02x\n", stream_structure_version);
   }
 
-  header_type_flag = get1Byte();
+  header_type_flag = header[5];
 #ifdef DEBUG
   fprintf(stderr, "\theader_type_flag: 0x%02x (", header_type_flag);
   if (header_type_flag&0x01) fprintf(stderr, "continuation ");
@@ -986,31 +1091,25 @@ void OggFileParser::parseStartOfPage(u_int8_t& header_type_flag,
   fprintf(stderr, ")\n");
 #endif  
 
-  u_int32_t granule_position1 = byteSwap(get4Bytes());
-  u_int32_t granule_position2 = byteSwap(get4Bytes());
-  bitstream_serial_number = byteSwap(get4Bytes());
-  u_int32_t page_sequence_number = byteSwap(get4Bytes());
-  u_int32_t CRC_checksum = byteSwap(get4Bytes());
-  u_int8_t number_page_segments = get1Byte();
+  // All fields are little-endian:
+  granule_position = 0;
+  for (int i = 13; i >= 6; --i) granule_position = (granule_position<<8)|header[i];
+  bitstream_serial_number = (header[17]<<24)|(header[16]<<16)|(header[15]<<8)|header[14];
 #ifdef DEBUG
-  fprintf(stderr, "\tgranule_position 0x%08x%08x, bitstream_serial_number 0x%08x, page_sequence_number 0x%08x, CRC_checksum 0x%08x, number_page_segments %d\n", granule_position2, granule_position1, bitstream_serial_number, page_sequence_number, CRC_checksum, number_page_segments);
-#else
-  // Dummy statements to prevent 'unused variable' compiler warnings:
-#define DUMMY_STATEMENT(x) do {x = x;} while (0)
-  DUMMY_STATEMENT(granule_position1);
-  DUMMY_STATEMENT(granule_position2);
-  DUMMY_STATEMENT(page_sequence_number);
-  DUMMY_STATEMENT(CRC_checksum);
+  u_int32_t page_sequence_number = (header[21]<<24)|(header[20]<<16)|(header[19]<<8)|header[18];
+  u_int32_t CRC_checksum = (header[25]<<24)|(header[24]<<16)|(header[23]<<8)|header[22];
+  fprintf(stderr, "\tgranule_position 0x%016llx, bitstream_serial_number 0x%08x, page_sequence_number 0x%08x, CRC_checksum 0x%08x, number_page_segments %d\n", (unsigned long long)granule_position, bitstream_serial_number, page_sequence_number, CRC_checksum, number_page_segments);
 #endif  
   
   // Look at the "segment_table" to count the sizes of the packets in this page:
-  delete fPacketSizeTable/*if any*/; fPacketSizeTable = new PacketSizeTable(number_page_segments);
+  fPacketSizeTable->reset(number_page_segments);
+  u_int8_t const* segment_table = &header[27];
   u_int8_t lacing_value = 0;
 #ifdef DEBUG
   fprintf(stderr, "\tsegment_table\n");
 #endif
   for (unsigned i = 0; i < number_page_segments; ++i) {
-    lacing_value = get1Byte();
+    lacing_value = segment_table[i];
 #ifdef DEBUG
     fprintf(stderr, "\t\t%d:\t%d", i, lacing_value);
 #endif
@@ -1029,4 +1128,18 @@ void OggFileParser::parseStartOfPage(u_int8_t& header_type_flag,
   }
 
   fPacketSizeTable->lastPacketIsIncomplete = lacing_value == 255;
+
+  // Note where this page began, and where the next page should begin:
+  fCurPageOffsetInFile = fNextPageOffsetInFile;
+  fNextPageOffsetInFile += 27 + number_page_segments + fPacketSizeTable->totSizes;
+}
+
+void OggFileParser::setParseState() {
+  fSavedNextPageOffsetInFile = fNextPageOffsetInFile;
+  saveParserState();
+}
+
+void OggFileParser::restoreSavedParserState() {
+  StreamParser::restoreSavedParserState();
+  fNextPageOffsetInFile = fSavedNextPageOffsetInFile;
 }
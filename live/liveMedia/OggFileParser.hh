@@ -37,9 +37,11 @@ enum OggParseState {
 // A structure that counts the sizes of 'packets' given by each page's "segment_table":
 class PacketSizeTable {
 public:
-  PacketSizeTable(unsigned number_page_segments);
+  PacketSizeTable();
   ~PacketSizeTable();
 
+  void reset(unsigned number_page_segments); // called before counting the sizes for a new page
+
   unsigned numCompletedPackets; // will be <= "number_page_segments"
   unsigned* size; // an array of sizes of each of the packets
   unsigned totSizes;
@@ -58,6 +60,9 @@ public:
   static void continueParsing(void* clientData, unsigned char* ptr, unsigned size, struct timeval presentationTime);
   void continueParsing();
 
+  void seekToFilePosition(u_int64_t offsetInFile);
+      // Note: "offsetInFile" need not be at the start of a page; we'll look for the next page
+
 private:
   Boolean needHeaders() { return fNumUnfulfilledTracks > 0; }
 
@@ -69,10 +74,14 @@ private:
   void parseAndDeliverPages();
   Boolean parseAndDeliverPage();
   Boolean deliverPacketWithinPage();
-  void parseStartOfPage(u_int8_t& header_type_flag, u_int32_t& bitstream_serial_number);
+  void parseStartOfPage(u_int8_t& header_type_flag, u_int32_t& bitstream_serial_number,
+			u_int64_t& granule_position);
 
   Boolean validateHeader(OggTrack* track, u_int8_t const* p, unsigned headerSize);
 
+  void setParseState();
+  virtual void restoreSavedParserState(); // redefined virtual function
+
 private:
   // General state for parsing:
   OggFile& fOurFile;
@@ -81,6 +90,8 @@ private:
   void* fOnEndClientData;
   OggDemux* fOurDemux;
   OggParseState fCurrentParseState;
+  u_int64_t fCurPageOffsetInFile; // where the most recently parsed page began
+  u_int64_t fNextPageOffsetInFile, fSavedNextPageOffsetInFile; // where we'll look for the next page
 
   unsigned fNumUnfulfilledTracks;
   PacketSizeTable* fPacketSizeTable;
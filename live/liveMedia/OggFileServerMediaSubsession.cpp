@@ -37,6 +37,17 @@ OggFileServerMediaSubsession
 OggFileServerMediaSubsession::~OggFileServerMediaSubsession() {
 }
 
+float OggFileServerMediaSubsession::duration() const { return fOurDemux.ourOggFile()->fileDuration(); }
+
+void OggFileServerMediaSubsession
+::seekStreamSource(FramedSource* inputSource, double& seekNPT, double /*streamDuration*/, u_int64_t& /*numBytes*/) {
+  for (unsigned i = 0; i < fNumFiltersInFrontOfTrack; ++i) {
+    // "inputSource" is a filter.  Go back to *its* source:
+    inputSource = ((FramedFilter*)inputSource)->inputSource();
+  }
+  ((OggDemuxedTrack*)inputSource)->seekToTime(seekNPT);
+}
+
 FramedSource* OggFileServerMediaSubsession
 ::createNewStreamSource(unsigned clientSessionId, unsigned& estBitrate) {
   FramedSource* baseSource = fOurDemux.newDemuxedTrack(clientSessionId, fTrack->trackNumber);
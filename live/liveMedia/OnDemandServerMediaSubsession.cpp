@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "OnDemandServerMediaSubsession.hh"
+#include "SDPCache.hh"
 #include <GroupsockHelper.hh>
 
 OnDemandServerMediaSubsession
@@ -29,7 +30,8 @@ OnDemandServerMediaSubsession
 				Boolean multiplexRTCPWithRTP)
   : ServerMediaSubsession(env),
     fSDPLines(NULL), fReuseFirstSource(reuseFirstSource),
-    fMultiplexRTCPWithRTP(multiplexRTCPWithRTP), fLastStreamToken(NULL),
+    fMultiplexRTCPWithRTP(multiplexRTCPWithRTP), fUsesServerPortPool(False), fSharedRTPSocket(NULL),
+    fRetransmissionHistorySize(0), fRTXPayloadType(0), fPacingBurstUSeconds(0), fLastStreamToken(NULL),
     fAppHandlerTask(NULL), fAppHandlerClientData(NULL) {
   fDestinationsHashTable = HashTable::create(ONE_WORD_HASH_KEYS);
   if (fMultiplexRTCPWithRTP) {
@@ -53,6 +55,8 @@ OnDemandServerMediaSubsession::~OnDemandServerMediaSubsession() {
     delete destinations;
   }
   delete fDestinationsHashTable;
+
+  if (fUsesServerPortPool) ServerPortPool::stopUsingOurPool(envir());
 }
 
 char const*
@@ -61,10 +65,38 @@ OnDemandServerMediaSubsession::sdpLines() {
     // We need to construct a set of SDP lines that describe this
     // subsession (as a unicast stream).  To do so, we first create
     // dummy (unused) source and "RTPSink" objects,
-    // whose parameters we use for the SDP lines:
+    // whose parameters we use for the SDP lines.
+    // However, because this can be expensive (e.g., if the source must be read until
+    // parameter sets appear), we first check whether these lines have already been cached:
+    SDPCache* sdpCache = SDPCache::ourCache(envir());
+    char* cacheKey = NULL;
+    if (sdpCache != NULL) {
+      char* mediaKey = sdpCacheKey();
+      if (mediaKey != NULL) {
+	// The SDP lines also depend upon our track id, our server address and port,
+	// and the RTCP features that we advertise:
+	char const* ourTrackId = trackId();
+	cacheKey = new char[strlen(mediaKey) + strlen(ourTrackId) + 60];
+	sprintf(cacheKey, "%s|%s|%u|%u|%d|%d|%u", mediaKey, ourTrackId,
+		fServerAddressForSDP, fPortNumForSDP, fMultiplexRTCPWithRTP,
+		fRetransmissionHistorySize > 0, fRTXPayloadType);
+	delete[] mediaKey;
+
+	char const* cachedSDPLines = sdpCache->lookup(cacheKey);
+	if (cachedSDPLines != NULL) {
+	  fSDPLines = strDup(cachedSDPLines);
+	  delete[] cacheKey;
+	  return fSDPLines;
+	}
+      }
+    }
+
     unsigned estBitrate;
     FramedSource* inputSource = createNewStreamSource(0, estBitrate);
-    if (inputSource == NULL) return NULL; // file not found
+    if (inputSource == NULL) { // file not found
+      delete[] cacheKey;
+      return NULL;
+    }
 
     struct in_addr dummyAddr;
     dummyAddr.s_addr = 0;
@@ -77,6 +109,11 @@ OnDemandServerMediaSubsession::sdpLines() {
     Medium::close(dummyRTPSink);
     delete dummyGroupsock;
     closeStreamSource(inputSource);
+
+    if (cacheKey != NULL) {
+      sdpCache->add(cacheKey, fSDPLines);
+      delete[] cacheKey;
+    }
   }
 
   return fSDPLines;
@@ -119,6 +156,7 @@ void OnDemandServerMediaSubsession
     BasicUDPSink* udpSink = NULL;
     Groupsock* rtpGroupsock = NULL;
     Groupsock* rtcpGroupsock = NULL;
+    Boolean serverPortsArePooled = False;
 
     if (clientRTPPort.num() != 0 || tcpSocketNum >= 0) { // Normal case: Create destinations
       portNumBits serverPortNum;
@@ -138,38 +176,54 @@ void OnDemandServerMediaSubsession
 	// Normal case: We're streaming RTP (over UDP or TCP).  Create a pair of
 	// groupsocks (RTP and RTCP), with adjacent port numbers (RTP port number even).
 	// (If we're multiplexing RTCP and RTP over the same port number, it can be odd or even.)
-	NoReuse dummy(envir()); // ensures that we skip over ports that are already in use
-	for (portNumBits serverPortNum = fInitialPortNum; ; ++serverPortNum) {
+	// (If we're using a shared socket for RTP-over-UDP, then we don't bind any new ports at all.)
+	if (fSharedRTPSocket != NULL && tcpSocketNum < 0) {
 	  struct in_addr dummyAddr; dummyAddr.s_addr = 0;
 
-	  serverRTPPort = serverPortNum;
-	  rtpGroupsock = createGroupsock(dummyAddr, serverRTPPort);
-	  if (rtpGroupsock->socketNum() < 0) {
-	    delete rtpGroupsock;
-	    continue; // try again
-	  }
+	  serverRTPPort = serverRTCPPort = fSharedRTPSocket->port();
+	  rtpGroupsock = rtcpGroupsock = fSharedRTPSocket->createGroupsock(dummyAddr);
+	} else {
+	  NoReuse dummy(envir()); // ensures that we skip over ports that are already in use
 
-	  if (fMultiplexRTCPWithRTP) {
-	    // Use the RTP 'groupsock' object for RTCP as well:
-	    serverRTCPPort = serverRTPPort;
-	    rtcpGroupsock = rtpGroupsock;
+	  // Take the port numbers from our environment's port pool (if our initial port number is in it),
+	  // rather than trying each port number in turn:
+	  ServerPortPool* portPool;
+	  if (fUsesServerPortPool) {
+	    portPool = ServerPortPool::ourPool(envir());
 	  } else {
-	    // Create a separate 'groupsock' object (with the next (odd) port number) for RTCP:
-	    serverRTCPPort = ++serverPortNum;
-	    rtcpGroupsock = createGroupsock(dummyAddr, serverRTCPPort);
-	    if (rtcpGroupsock->socketNum() < 0) {
-	      delete rtpGroupsock;
-	      delete rtcpGroupsock;
-	      continue; // try again
+	    portPool = ServerPortPool::useOurPool(envir(), fInitialPortNum);
+	    fUsesServerPortPool = True;
+	  }
+	  if (portPool != NULL && portPool->contains(fInitialPortNum)) {
+	    for (unsigned i = 0; i < portPool->numPortPairs(); ++i) {
+	      portNumBits serverPortNum = portPool->allocate();
+	      if (serverPortNum == 0) break; // the pool is full
+
+	      if (createGroupsocks(serverPortNum, serverRTPPort, serverRTCPPort, rtpGroupsock, rtcpGroupsock)) {
+		serverPortsArePooled = True;
+		break; // success
+	      }
+
+	      // One of these ports is being used by someone else; try the next pair:
+	      portPool->release(serverPortNum);
+	      portPool->noteBindFailure();
 	    }
 	  }
 
-	  break; // success
+	  if (!serverPortsArePooled) {
+	    // Try each port number in turn (beginning with our initial port number), until we succeed:
+	    for (portNumBits serverPortNum = fInitialPortNum; ; serverPortNum += fMultiplexRTCPWithRTP ? 1 : 2) {
+	      if (createGroupsocks(serverPortNum, serverRTPPort, serverRTCPPort, rtpGroupsock, rtcpGroupsock)) break;
+	    }
+	  }
 	}
 
 	unsigned char rtpPayloadType = 96 + trackNumber()-1; // if dynamic
 	rtpSink = createNewRTPSink(rtpGroupsock, rtpPayloadType, mediaSource);
 	if (rtpSink != NULL && rtpSink->estimatedBitrate() > 0) streamBitrate = rtpSink->estimatedBitrate();
+	if (rtpSink != NULL && fRetransmissionHistorySize > 0) {
+	  rtpSink->enableRetransmissions(fRetransmissionHistorySize, fRTXPayloadType);
+	}
       }
 
       // Turn off the destinations for each groupsock.  They'll get set later
@@ -184,13 +238,19 @@ void OnDemandServerMediaSubsession
 	if (rtpBufSize < 50 * 1024) rtpBufSize = 50 * 1024;
 	increaseSendBufferTo(envir(), rtpGroupsock->socketNum(), rtpBufSize);
       }
+
+      if (rtpSink != NULL && fPacingBurstUSeconds > 0) {
+	// Let the kernel pace each burst of packets at a little more than the stream's bitrate:
+	rtpSink->enableKernelPacing(fPacingBurstUSeconds, (streamBitrate*5)/4);
+	    // (If the pacing rate can't be set - e.g., on a shared RTP socket - then packets are sent individually.)
+      }
     }
 
     // Set up the state of the stream.  The stream will get started later:
     streamToken = fLastStreamToken
       = new StreamState(*this, serverRTPPort, serverRTCPPort, rtpSink, udpSink,
 			streamBitrate, mediaSource,
-			rtpGroupsock, rtcpGroupsock);
+			rtpGroupsock, rtcpGroupsock, serverPortsArePooled);
   }
 
   // Record these destinations as being for this client session id:
@@ -392,6 +452,40 @@ void OnDemandServerMediaSubsession::closeStreamSource(FramedSource *inputSource)
   Medium::close(inputSource);
 }
 
+char* OnDemandServerMediaSubsession::sdpCacheKey() {
+  return NULL; // by default, we don't cache our SDP lines
+}
+
+Boolean OnDemandServerMediaSubsession
+::createGroupsocks(portNumBits serverPortNum, Port& serverRTPPort, Port& serverRTCPPort,
+		   Groupsock*& rtpGroupsock, Groupsock*& rtcpGroupsock) {
+  struct in_addr dummyAddr; dummyAddr.s_addr = 0;
+
+  serverRTPPort = serverPortNum;
+  rtpGroupsock = createGroupsock(dummyAddr, serverRTPPort);
+  if (rtpGroupsock->socketNum() < 0) {
+    delete rtpGroupsock; rtpGroupsock = NULL;
+    return False;
+  }
+
+  if (fMultiplexRTCPWithRTP) {
+    // Use the RTP 'groupsock' object for RTCP as well:
+    serverRTCPPort = serverRTPPort;
+    rtcpGroupsock = rtpGroupsock;
+  } else {
+    // Create a separate 'groupsock' object (with the next (odd) port number) for RTCP:
+    serverRTCPPort = serverPortNum+1;
+    rtcpGroupsock = createGroupsock(dummyAddr, serverRTCPPort);
+    if (rtcpGroupsock->socketNum() < 0) {
+      delete rtpGroupsock; rtpGroupsock = NULL;
+      delete rtcpGroupsock; rtcpGroupsock = NULL;
+      return False;
+    }
+  }
+
+  return True;
+}
+
 Groupsock* OnDemandServerMediaSubsession
 ::createGroupsock(struct in_addr const& addr, Port port) {
   // Default implementation; may be redefined by subclasses:
@@ -405,6 +499,31 @@ RTCPInstance* OnDemandServerMediaSubsession
   return RTCPInstance::createNew(envir(), RTCPgs, totSessionBW, cname, sink, NULL/*we're a server*/);
 }
 
+void OnDemandServerMediaSubsession::useSharedRTPSocket(SharedRTPSocket* sharedRTPSocket) {
+  fSharedRTPSocket = sharedRTPSocket;
+  if (fSharedRTPSocket != NULL) fMultiplexRTCPWithRTP = True;
+  warnIfKernelPacingIsUnavailable();
+}
+
+void OnDemandServerMediaSubsession::enableKernelPacing(unsigned burstDurationUSeconds) {
+  fPacingBurstUSeconds = burstDurationUSeconds;
+  warnIfKernelPacingIsUnavailable();
+}
+
+void OnDemandServerMediaSubsession::warnIfKernelPacingIsUnavailable() {
+  if (fPacingBurstUSeconds > 0 && fSharedRTPSocket != NULL) {
+    envir() << "OnDemandServerMediaSubsession: Warning: Kernel pacing can't be used with a shared RTP socket"
+	    << " (its pacing rate would limit all of the streams that use it), so UDP streams will send"
+	    << " their packets individually, rather than in bursts\n";
+  }
+}
+
+void OnDemandServerMediaSubsession
+::enableRetransmissions(unsigned historySize, unsigned char rtxPayloadType) {
+  fRetransmissionHistorySize = historySize;
+  fRTXPayloadType = historySize == 0 ? 0 : rtxPayloadType;
+}
+
 void OnDemandServerMediaSubsession
 ::setRTCPAppPacketHandler(RTCPAppHandlerFunc* handler, void* clientData) {
   fAppHandlerTask = handler;
@@ -429,25 +548,40 @@ void OnDemandServerMediaSubsession
   AddressString ipAddressStr(fServerAddressForSDP);
   char* rtpmapLine = rtpSink->rtpmapLine();
   char const* rtcpmuxLine = fMultiplexRTCPWithRTP ? "a=rtcp-mux\r\n" : "";
+  char rtxFmt[5] = ""; // an extra m= <fmt>, if we use "rtx"
+  char rtcpfbLines[150] = "";
+  if (fRetransmissionHistorySize > 0) {
+    if (fRTXPayloadType != 0) {
+      sprintf(rtxFmt, " %d", fRTXPayloadType);
+      sprintf(rtcpfbLines, "a=rtcp-fb:%d nack\r\na=rtpmap:%d rtx/%u\r\na=fmtp:%d apt=%d\r\n",
+	      rtpPayloadType, fRTXPayloadType, rtpSink->rtpTimestampFrequency(),
+	      fRTXPayloadType, rtpPayloadType);
+    } else {
+      sprintf(rtcpfbLines, "a=rtcp-fb:%d nack\r\n", rtpPayloadType);
+    }
+  }
   char const* rangeLine = rangeSDPLine();
   char const* auxSDPLine = getAuxSDPLine(rtpSink, inputSource);
   if (auxSDPLine == NULL) auxSDPLine = "";
 
   char const* const sdpFmt =
-    "m=%s %u RTP/AVP %d\r\n"
+    "m=%s %u RTP/AVP %d%s\r\n"
     "c=IN IP4 %s\r\n"
     "b=AS:%u\r\n"
     "%s"
     "%s"
     "%s"
     "%s"
+    "%s"
     "a=control:%s\r\n";
   unsigned sdpFmtSize = strlen(sdpFmt)
     + strlen(mediaType) + 5 /* max short len */ + 3 /* max char len */
     + strlen(ipAddressStr.val())
     + 20 /* max int len */
+    + strlen(rtxFmt)
     + strlen(rtpmapLine)
     + strlen(rtcpmuxLine)
+    + strlen(rtcpfbLines)
     + strlen(rangeLine)
     + strlen(auxSDPLine)
     + strlen(trackId());
@@ -456,10 +590,12 @@ void OnDemandServerMediaSubsession
 	  mediaType, // m= <media>
 	  fPortNumForSDP, // m= <port>
 	  rtpPayloadType, // m= <fmt list>
+	  rtxFmt, // m= <fmt list> (continued)
 	  ipAddressStr.val(), // c= address
 	  estBitrate, // b=AS:<bandwidth>
 	  rtpmapLine, // a=rtpmap:... (if present)
 	  rtcpmuxLine, // a=rtcp-mux:... (if present)
+	  rtcpfbLines, // a=rtcp-fb:... (and "rtx" a=rtpmap:, a=fmtp:) (if present)
 	  rangeLine, // a=range:... (if present)
 	  auxSDPLine, // optional extra SDP line
 	  trackId()); // a=control:<track-id>
@@ -472,6 +608,9 @@ void OnDemandServerMediaSubsession
 
 ////////// StreamState implementation //////////
 
+MemoryPool StreamState::fMemoryPool("StreamState", sizeof (StreamState));
+MemoryPool Destinations::fMemoryPool("Destinations", sizeof (Destinations));
+
 static void afterPlayingStreamState(void* clientData) {
   StreamState* streamState = (StreamState*)clientData;
   if (streamState->streamDuration() == 0.0) {
@@ -490,12 +629,14 @@ StreamState::StreamState(OnDemandServerMediaSubsession& master,
                          Port const& serverRTPPort, Port const& serverRTCPPort,
 			 RTPSink* rtpSink, BasicUDPSink* udpSink,
 			 unsigned totalBW, FramedSource* mediaSource,
-			 Groupsock* rtpGS, Groupsock* rtcpGS)
+			 Groupsock* rtpGS, Groupsock* rtcpGS, Boolean serverPortsArePooled)
   : fMaster(master), fAreCurrentlyPlaying(False), fReferenceCount(1),
     fServerRTPPort(serverRTPPort), fServerRTCPPort(serverRTCPPort),
     fRTPSink(rtpSink), fUDPSink(udpSink), fStreamDuration(master.duration()),
     fTotalBW(totalBW), fRTCPInstance(NULL) /* created later */,
-    fMediaSource(mediaSource), fStartNPT(0.0), fRTPgs(rtpGS), fRTCPgs(rtcpGS) {
+    fMediaSource(mediaSource), fStartNPT(0.0), fRTPgs(rtpGS), fRTCPgs(rtcpGS),
+    fSharedRTPSocket(rtpGS != NULL && !rtpGS->ownsSocketNum() ? master.fSharedRTPSocket : NULL),
+    fServerPortsArePooled(serverPortsArePooled) {
 }
 
 StreamState::~StreamState() {
@@ -540,6 +681,12 @@ void StreamState
     if (fRTCPInstance != NULL) {
       fRTCPInstance->setSpecificRRHandler(dests->addr.s_addr, dests->rtcpPort,
 					  rtcpRRHandler, rtcpRRHandlerClientData);
+      if (fSharedRTPSocket != NULL) {
+	// Have the shared socket give us this client's incoming RTCP reports (identified by their source
+	// address and port, or by our SSRC):
+	fSharedRTPSocket->registerRTCPInstance(dests->addr, dests->rtcpPort, fRTCPInstance,
+					       fRTPSink == NULL ? 0 : fRTPSink->SSRC());
+      }
     }
   }
 
@@ -594,6 +741,7 @@ void StreamState::endPlaying(Destinations* dests, unsigned clientSessionId) {
     if (fRTCPgs != NULL && fRTCPgs != fRTPgs) fRTCPgs->removeDestination(clientSessionId);
     if (fRTCPInstance != NULL) {
       fRTCPInstance->unsetSpecificRRHandler(dests->addr.s_addr, dests->rtcpPort);
+      if (fSharedRTPSocket != NULL) fSharedRTPSocket->deregisterRTCPInstance(dests->addr, dests->rtcpPort);
     }
   }
 }
@@ -607,6 +755,7 @@ void StreamState::sendRTCPAppPacket(u_int8_t subtype, char const* name,
 
 void StreamState::reclaim() {
   // Delete allocated media objects
+  if (fSharedRTPSocket != NULL && fRTCPInstance != NULL) fSharedRTPSocket->deregisterRTCPInstance(fRTCPInstance);
   Medium::close(fRTCPInstance) /* will send a RTCP BYE */; fRTCPInstance = NULL;
   Medium::close(fRTPSink); fRTPSink = NULL;
   Medium::close(fUDPSink); fUDPSink = NULL;
@@ -617,4 +766,11 @@ void StreamState::reclaim() {
   delete fRTPgs;
   if (fRTCPgs != fRTPgs) delete fRTCPgs;
   fRTPgs = NULL; fRTCPgs = NULL;
+
+  if (fServerPortsArePooled) {
+    // Now that we've closed our sockets, return our server ports to the pool:
+    ServerPortPool* portPool = ServerPortPool::ourPool(fMaster.envir());
+    if (portPool != NULL) portPool->release(ntohs(fServerRTPPort.num()));
+    fServerPortsArePooled = False;
+  }
 }
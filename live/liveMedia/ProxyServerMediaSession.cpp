@@ -85,10 +85,11 @@ ProxyServerMediaSession* ProxyServerMediaSession
 	    char const* inputStreamURL, char const* streamName,
 	    char const* username, char const* password,
 	    portNumBits tunnelOverHTTPPortNum, int verbosityLevel, int socketNumToServer,
-	    MediaTranscodingTable* transcodingTable) {
+	    MediaTranscodingTable* transcodingTable, Boolean pipelineSETUPs) {
   return new ProxyServerMediaSession(env, ourMediaServer, inputStreamURL, streamName, username, password,
 				     tunnelOverHTTPPortNum, verbosityLevel, socketNumToServer,
-				     transcodingTable);
+				     transcodingTable, defaultCreateNewProxyRTSPClientFunc,
+				     6970, False, pipelineSETUPs);
 }
 
 
@@ -100,7 +101,8 @@ ProxyServerMediaSession
 			  int socketNumToServer,
 			  MediaTranscodingTable* transcodingTable,
 			  createNewProxyRTSPClientFunc* ourCreateNewProxyRTSPClientFunc,
-			  portNumBits initialPortNum, Boolean multiplexRTCPWithRTP)
+			  portNumBits initialPortNum, Boolean multiplexRTCPWithRTP,
+			  Boolean pipelineSETUPs)
   : ServerMediaSession(env, streamName, NULL, NULL, False, NULL),
     describeCompletedFlag(0), fOurMediaServer(ourMediaServer), fClientMediaSession(NULL),
     fVerbosityLevel(verbosityLevel),
@@ -115,6 +117,7 @@ ProxyServerMediaSession
 				       tunnelOverHTTPPortNum,
 				       verbosityLevel > 0 ? verbosityLevel-1 : verbosityLevel,
 				       socketNumToServer);
+  if (fProxyRTSPClient != NULL) fProxyRTSPClient->fPipelineSETUPs = pipelineSETUPs;
   ProxyRTSPClient::sendDESCRIBE(fProxyRTSPClient);
 }
 
@@ -237,6 +240,13 @@ static void continueAfterGET_PARAMETER(RTSPClient* rtspClient, int resultCode, c
 
 ////////// "ProxyRTSPClient" implementation /////////
 
+static unsigned millisecondsSince(struct timeval const& startTime) {
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  int ms = (timeNow.tv_sec - startTime.tv_sec)*1000 + (timeNow.tv_usec - startTime.tv_usec)/1000;
+  return ms < 0 ? 0 : (unsigned)ms;
+}
+
 UsageEnvironment& operator<<(UsageEnvironment& env, const ProxyRTSPClient& proxyRTSPClient) { // used for debugging
   return env << "ProxyRTSPClient[" << proxyRTSPClient.url() << "]";
 }
@@ -249,7 +259,11 @@ ProxyRTSPClient::ProxyRTSPClient(ProxyServerMediaSession& ourServerMediaSession,
     fOurServerMediaSession(ourServerMediaSession), fOurURL(strDup(rtspURL)), fStreamRTPOverTCP(tunnelOverHTTPPortNum != 0),
     fSetupQueueHead(NULL), fSetupQueueTail(NULL), fNumSetupsDone(0), fNextDESCRIBEDelay(1),
     fServerSupportsGetParameter(False), fLastCommandWasPLAY(False), fDoneDESCRIBE(False),
-    fLivenessCommandTask(NULL), fDESCRIBECommandTask(NULL), fSubsessionTimerTask(NULL), fResetTask(NULL) {
+    fLivenessCommandTask(NULL), fDESCRIBECommandTask(NULL), fSubsessionTimerTask(NULL), fResetTask(NULL),
+    fPipelineSETUPs(False), fNumSetupResponses(0),
+    fNumResets(0), fNumDESCRIBEFailures(0), fLastDESCRIBELatency(0), fLastStartupLatency(0) {
+  fDESCRIBESendTime.tv_sec = fDESCRIBESendTime.tv_usec = 0;
+  fFirstSETUPSendTime.tv_sec = fFirstSETUPSendTime.tv_usec = 0;
   if (username != NULL && password != NULL) {
     fOurAuthenticator = new Authenticator(username, password);
   } else {
@@ -264,7 +278,7 @@ void ProxyRTSPClient::reset() {
   envir().taskScheduler().unscheduleDelayedTask(fResetTask); fResetTask = NULL;
 
   fSetupQueueHead = fSetupQueueTail = NULL;
-  fNumSetupsDone = 0;
+  fNumSetupsDone = fNumSetupResponses = 0;
   fNextDESCRIBEDelay = 1;
   fLastCommandWasPLAY = False;
   fDoneDESCRIBE = False;
@@ -295,6 +309,10 @@ int ProxyRTSPClient::connectToServer(int socketNum, portNumBits remotePortNum) {
 
 void ProxyRTSPClient::continueAfterDESCRIBE(char const* sdpDescription) {
   if (sdpDescription != NULL) {
+    fLastDESCRIBELatency = millisecondsSince(fDESCRIBESendTime);
+    if (fVerbosityLevel > 0) {
+      envir() << *this << ": \"DESCRIBE\" took " << fLastDESCRIBELatency << " ms\n";
+    }
     fOurServerMediaSession.continueAfterDESCRIBE(sdpDescription);
 
     // Unlike most RTSP streams, there might be a long delay between this "DESCRIBE" command (to the downstream server) and the
@@ -306,6 +324,7 @@ void ProxyRTSPClient::continueAfterDESCRIBE(char const* sdpDescription) {
   } else {
     // The "DESCRIBE" command failed, most likely because the server or the stream is not yet running.
     // Reschedule another "DESCRIBE" command to take place later:
+    ++fNumDESCRIBEFailures;
     scheduleDESCRIBECommand();
   }
   fDoneDESCRIBE = True;
@@ -362,14 +381,20 @@ void ProxyRTSPClient::continueAfterSETUP(int resultCode) {
   ProxyServerMediaSubsession* smss = fSetupQueueHead; // Assert: != NULL
   fSetupQueueHead = fSetupQueueHead->fNext;
   if (fSetupQueueHead == NULL) fSetupQueueTail = NULL;
+  smss->fNext = NULL;
+  ++fNumSetupResponses;
 
   if (fSetupQueueHead != NULL) {
     // There are still entries in the queue, for tracks for which we have still to do a "SETUP".
-    // "SETUP" the first of these now:
-    sendSetupCommand(fSetupQueueHead->fClientMediaSubsession, ::continueAfterSETUP,
-		     False, fStreamRTPOverTCP, False, fOurAuthenticator);
-    ++fNumSetupsDone;
-    fSetupQueueHead->fHaveSetupStream = True;
+    if (fPipelineSETUPs) {
+      // We now know the session id, so "SETUP" all of these now (except those whose "SETUP" we've already sent):
+      for (ProxyServerMediaSubsession* p = fSetupQueueHead; p != NULL; p = p->fNext) {
+	if (!p->fHaveSetupStream) sendSETUP(p);
+      }
+    } else if (!fSetupQueueHead->fHaveSetupStream) {
+      // "SETUP" the first of these now:
+      sendSETUP(fSetupQueueHead);
+    }
   } else {
     if (fNumSetupsDone >= smss->fParentSession->numSubsessions()) {
       // We've now finished setting up each of our subsessions (i.e., 'tracks').
@@ -396,6 +421,24 @@ void ProxyRTSPClient::continueAfterPLAY(int resultCode) {
     scheduleReset();
     return;
   }
+
+  if (fFirstSETUPSendTime.tv_sec != 0 || fFirstSETUPSendTime.tv_usec != 0) {
+    // This "PLAY" completes the startup of the back-end stream:
+    fLastStartupLatency = millisecondsSince(fFirstSETUPSendTime);
+    fFirstSETUPSendTime.tv_sec = fFirstSETUPSendTime.tv_usec = 0;
+    if (fVerbosityLevel > 0) {
+      envir() << *this << ": back-end stream started (\"SETUP\"+\"PLAY\" took " << fLastStartupLatency << " ms)\n";
+    }
+  }
+}
+
+void ProxyRTSPClient::sendSETUP(ProxyServerMediaSubsession* smss) {
+  if (fNumSetupsDone == 0) gettimeofday(&fFirstSETUPSendTime, NULL);
+
+  sendSetupCommand(smss->fClientMediaSubsession, ::continueAfterSETUP,
+		   False, fStreamRTPOverTCP, False, fOurAuthenticator);
+  ++fNumSetupsDone;
+  smss->fHaveSetupStream = True;
 }
 
 void ProxyRTSPClient::scheduleLivenessCommand() {
@@ -450,6 +493,7 @@ void ProxyRTSPClient::doReset() {
 
   reset();
   fOurServerMediaSession.resetDESCRIBEState();
+  ++fNumResets;
 
   setBaseURL(fOurURL); // because we'll be sending an initial "DESCRIBE" all over again
   sendDESCRIBE(this);
@@ -478,7 +522,10 @@ void ProxyRTSPClient::scheduleDESCRIBECommand() {
 
 void ProxyRTSPClient::sendDESCRIBE(void* clientData) {
   ProxyRTSPClient* rtspClient = (ProxyRTSPClient*)clientData;
-  if (rtspClient != NULL) rtspClient->sendDescribeCommand(::continueAfterDESCRIBE, rtspClient->auth());
+  if (rtspClient != NULL) {
+    gettimeofday(&rtspClient->fDESCRIBESendTime, NULL);
+    rtspClient->sendDescribeCommand(::continueAfterDESCRIBE, rtspClient->auth());
+  }
 }
 
 void ProxyRTSPClient::subsessionTimeout(void* clientData) {
@@ -605,11 +652,11 @@ FramedSource* ProxyServerMediaSubsession::createNewStreamSource(unsigned clientS
 
       // Hack: If there's already a pending "SETUP" request, don't send this track's "SETUP" right away, because
       // the server might not properly handle 'pipelined' requests.  Instead, wait until after previous "SETUP" responses come back.
-      if (queueWasEmpty) {
-	proxyRTSPClient->sendSetupCommand(fClientMediaSubsession, ::continueAfterSETUP,
-					  False, proxyRTSPClient->fStreamRTPOverTCP, False, proxyRTSPClient->auth());
-	++proxyRTSPClient->fNumSetupsDone;
-	fHaveSetupStream = True;
+      // (If we've been asked to pipeline "SETUP"s, then we wait only until we've got the first "SETUP" response,
+      //  because that's what gives us the session id to use in subsequent "SETUP"s.)
+      if (queueWasEmpty
+	  || (proxyRTSPClient->fPipelineSETUPs && proxyRTSPClient->fNumSetupResponses > 0)) {
+	proxyRTSPClient->sendSETUP(this);
       }
     } else {
       // This is a "SETUP" from a new client.  We know that there are no other currently active clients (otherwise we wouldn't
@@ -34,6 +34,11 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #define H264_IDR_FRAME 0x65  //bit 8 == 0, bits 7-6 (ref) == 3, bits 5-0 (type) == 5
 
+#ifndef MAX_FRAGMENT_DATA_SIZE
+#define MAX_FRAGMENT_DATA_SIZE 50000000
+    // the most data that we'll buffer for a fragment (of a fragmented MP4 file) before ending it
+#endif
+
 ////////// SubsessionIOState, ChunkDescriptor ///////////
 // A structure used to represent the I/O state of each input 'subsession':
 
@@ -85,6 +90,33 @@ private:
   unsigned fBytesInUse;
 };
 
+// A buffer used (only when writing a fragmented file) to hold the media data,
+// and sample table, of each track for the current fragment:
+class FragmentBuffer {
+public:
+  FragmentBuffer();
+  virtual ~FragmentBuffer();
+
+  void reset() { fDataSize = fNumSamples = 0; }
+  void addData(unsigned char const* from, unsigned numBytes);
+  void addWord(unsigned word);
+  void addSample(unsigned sampleSize, unsigned sampleDuration, unsigned sampleFlags,
+		 struct timeval const& presentationTime);
+
+public:
+  unsigned char* fData;
+  unsigned fDataSize, fDataMaxSize;
+  struct Sample {
+    unsigned size, duration, flags;
+  }* fSamples;
+  unsigned fNumSamples, fMaxNumSamples;
+  struct timeval fFirstPresentationTime, fLastPresentationTime;
+};
+
+// 'sample_flags' values used in 'trun' atoms:
+#define FRAGMENT_SYNC_SAMPLE_FLAGS 0x02000000 // depends on no other sample
+#define FRAGMENT_NON_SYNC_SAMPLE_FLAGS 0x01010000 // depends on others; 'non-sync sample'
+
 class SyncFrame {
 public:
   SyncFrame(unsigned frameNum);
@@ -169,6 +201,12 @@ public:
   unsigned fNumChunks;
   SyncFrame *fHeadSyncFrame, *fTailSyncFrame;
 
+  // Used only when writing a fragmented file:
+  FragmentBuffer* fFragment;
+  int64_t fTRUN_dataOffsetPosn;
+      // position of the 'data offset' in the current fragment's 'trun' atom
+  Boolean fPrevFrameCouldStartFragment;
+
   // Counters to be used in the hint track's 'udta'/'hinf' atom;
   struct hinf {
     Count64 trpy;
@@ -185,6 +223,7 @@ public:
 
 private:
   void useFrame(SubsessionBuffer& buffer);
+  void useFrameForFragment(SubsessionBuffer& buffer);
   void useFrameForHinting(unsigned frameSize,
 			  struct timeval presentationTime,
 			  unsigned startSampleNumber);
@@ -226,14 +265,19 @@ QuickTimeFileSink::QuickTimeFileSink(UsageEnvironment& env,
 				     Boolean packetLossCompensate,
 				     Boolean syncStreams,
 				     Boolean generateHintTracks,
-				     Boolean generateMP4Format)
+				     Boolean generateMP4Format,
+				     unsigned fragmentDuration)
   : Medium(env), fInputSession(inputSession),
     fBufferSize(bufferSize), fPacketLossCompensate(packetLossCompensate),
-    fSyncStreams(syncStreams), fGenerateMP4Format(generateMP4Format),
+    fSyncStreams(syncStreams),
+    fGenerateMP4Format(generateMP4Format || fragmentDuration > 0),
     fAreCurrentlyBeingPlayed(False),
     fLargestRTPtimestampFrequency(0),
     fNumSubsessions(0), fNumSyncedSubsessions(0),
     fHaveCompletedOutputFile(False),
+    fFragmentDuration(fragmentDuration), fHaveWrittenInitializationSegment(False),
+    fHaveFragmentStartTime(False), fHaveKeyFrameTrack(False),
+    fFragmentSequenceNumber(0), fFragmentDataSize(0),
     fMovieWidth(movieWidth), fMovieHeight(movieHeight),
     fMovieFPS(movieFPS), fMaxTrackDurationM(0) {
   fOutFid = OpenOutputFile(env, outputFileName);
@@ -272,7 +316,12 @@ QuickTimeFileSink::QuickTimeFileSink(UsageEnvironment& env,
     }
     subsession->miscPtr = (void*)ioState;
 
-    if (generateHintTracks) {
+    if (ioState->fQTMediaDataAtomCreator == &QuickTimeFileSink::addAtom_avc1) {
+      // Fragments will begin (where possible) with a H.264 key frame:
+      fHaveKeyFrameTrack = True;
+    }
+
+    if (generateHintTracks && !isFragmented()) {
       // Also create a hint track for this track:
       SubsessionIOState* hintTrack
 	= new SubsessionIOState(*this, *subsession);
@@ -302,6 +351,10 @@ QuickTimeFileSink::QuickTimeFileSink(UsageEnvironment& env,
   gettimeofday(&fStartTime, NULL);
   fAppleCreationTime = fStartTime.tv_sec - 0x83da4f80;
 
+  // A fragmented file has no initial "mdat" atom; instead, each fragment
+  // gets its own "mdat" atom, written once the fragment is complete:
+  if (isFragmented()) return;
+
   // Begin by writing a "mdat" atom at the start of the file.
   // (Later, when we've finished copying data to the file, we'll come
   // back and fill in its size.)
@@ -343,10 +396,12 @@ QuickTimeFileSink::createNew(UsageEnvironment& env,
 			     Boolean packetLossCompensate,
 			     Boolean syncStreams,
 			     Boolean generateHintTracks,
-			     Boolean generateMP4Format) {
+			     Boolean generateMP4Format,
+			     unsigned fragmentDuration) {
   QuickTimeFileSink* newSink = 
     new QuickTimeFileSink(env, inputSession, outputFileName, bufferSize, movieWidth, movieHeight, movieFPS,
-			  packetLossCompensate, syncStreams, generateHintTracks, generateMP4Format);
+			  packetLossCompensate, syncStreams, generateHintTracks, generateMP4Format,
+			  fragmentDuration);
   if (newSink == NULL || newSink->fOutFid == NULL) {
     Medium::close(newSink);
     return NULL;
@@ -361,6 +416,12 @@ void QuickTimeFileSink
   // Default implementation: Do nothing
 }
 
+void QuickTimeFileSink
+::noteCompletedFragment(int64_t /*fileOffset*/, unsigned /*fragmentSize*/,
+			Boolean /*isInitializationSegment*/) {
+  // Default implementation: Do nothing
+}
+
 Boolean QuickTimeFileSink::startPlaying(afterPlayingFunc* afterFunc,
 					void* afterClientData) {
   // Make sure we're not already being played:
@@ -481,6 +542,16 @@ static Boolean timevalGE(struct timeval const& tv1,
 void QuickTimeFileSink::completeOutputFile() {
   if (fHaveCompletedOutputFile || fOutFid == NULL) return;
 
+  if (isFragmented()) {
+    // All that remains is to write out the last (partial) fragment (if any).
+    // (The 'moov' atom has already been written, at the start of the file.)
+    writeInitializationSegment(); // if we haven't already done so
+    completeFragment();
+
+    fHaveCompletedOutputFile = True;
+    return;
+  }
+
   // Begin by filling in the initial "mdat" atom with the current
   // file size:
   int64_t curFileSize = TellFile64(fOutFid);
@@ -527,6 +598,100 @@ void QuickTimeFileSink::completeOutputFile() {
   fHaveCompletedOutputFile = True;
 }
 
+static double timevalDiff(struct timeval const& tv1, struct timeval const& tv2) {
+  // Returns tv1 - tv2, in seconds
+  return (tv1.tv_sec - tv2.tv_sec) + (tv1.tv_usec - tv2.tv_usec)/1000000.0;
+}
+
+Boolean QuickTimeFileSink
+::fragmentShouldEndBefore(struct timeval const& presentationTime, unsigned frameSize,
+			  Boolean isKeyFrameTrack, Boolean frameCanStartFragment) {
+  if (!fHaveFragmentStartTime) {
+    // This is the first frame of a new fragment:
+    fFragmentStartTime = presentationTime;
+    if (fFragmentSequenceNumber == 0) fFragmentTimeBase = presentationTime;
+    fHaveFragmentStartTime = True;
+    return False;
+  }
+
+  // Regardless of its duration, end the fragment if it would otherwise hold too much data:
+  if (fFragmentDataSize + frameSize > MAX_FRAGMENT_DATA_SIZE) return True;
+
+  double const elapsed = timevalDiff(presentationTime, fFragmentStartTime);
+  if (elapsed < fFragmentDuration) return False;
+
+  // The fragment is long enough.  If we have a H.264 track, then that track ends the
+  // fragment, before a key frame - unless the fragment has become twice as long as
+  // desired, in which case any track ends it.  (This bounds our memory usage, even if
+  // the H.264 track has stalled or ended.)
+  if (!fHaveKeyFrameTrack || elapsed >= 2*fFragmentDuration) return True;
+  return isKeyFrameTrack && frameCanStartFragment;
+}
+
+void QuickTimeFileSink::writeInitializationSegment() {
+  if (fHaveWrittenInitializationSegment) return;
+
+  // Note: We do this only once we have a fragment's worth of data, because
+  // some of the track parameters (e.g., "fQTTimeScale" for generic media) are
+  // not known until we've seen data.
+  int64_t const initPosn = TellFile64(fOutFid);
+  addAtom_ftyp();
+  addAtom_moov();
+  fflush(fOutFid);
+  fHaveWrittenInitializationSegment = True;
+
+  noteCompletedFragment(initPosn, (unsigned)(TellFile64(fOutFid) - initPosn), True);
+}
+
+void QuickTimeFileSink::completeFragment() {
+  fHaveFragmentStartTime = False;
+  fFragmentDataSize = 0;
+
+  // Check whether any track has data for this fragment:
+  unsigned totDataSize = 0;
+  MediaSubsessionIterator iter(fInputSession);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL) {
+    SubsessionIOState* ioState
+      = (SubsessionIOState*)(subsession->miscPtr);
+    if (ioState == NULL) continue;
+
+    totDataSize += ioState->fFragment->fDataSize;
+  }
+  if (totDataSize == 0) return;
+
+  writeInitializationSegment(); // if we haven't already done so
+
+  // Write the fragment's "moof" atom (which contains a 'traf' atom for each
+  // track that has data), followed by its "mdat" atom:
+  ++fFragmentSequenceNumber;
+  int64_t const moofPosn = TellFile64(fOutFid);
+  unsigned const moofSize = addAtom_moof();
+
+  addWord(8 + totDataSize); // mdat atom size
+  add4ByteString("mdat");
+  unsigned dataOffset = moofSize + 8; // offset (from the "moof" start) of each track's data
+  iter.reset();
+  while ((subsession = iter.next()) != NULL) {
+    SubsessionIOState* ioState
+      = (SubsessionIOState*)(subsession->miscPtr);
+    if (ioState == NULL) continue;
+
+    FragmentBuffer* fragment = ioState->fFragment;
+    if (fragment->fNumSamples == 0) continue;
+
+    fwrite(fragment->fData, 1, fragment->fDataSize, fOutFid);
+    setWord(ioState->fTRUN_dataOffsetPosn, dataOffset);
+    dataOffset += fragment->fDataSize;
+
+    fragment->reset(); // for the next fragment
+  }
+
+  // Make sure that the fragment reaches the file now, so that it will survive a crash:
+  fflush(fOutFid);
+  noteCompletedFragment(moofPosn, (unsigned)(TellFile64(fOutFid) - moofPosn), False);
+}
+
 
 ////////// SubsessionIOState, ChunkDescriptor implementation ///////////
 
@@ -538,9 +703,12 @@ SubsessionIOState::SubsessionIOState(QuickTimeFileSink& sink,
     fOurSink(sink), fOurSubsession(subsession),
     fLastPacketRTPSeqNum(0), fHaveBeenSynced(False), fQTTotNumSamples(0), 
     fHeadChunk(NULL), fTailChunk(NULL), fNumChunks(0),
-    fHeadSyncFrame(NULL), fTailSyncFrame(NULL) {
+    fHeadSyncFrame(NULL), fTailSyncFrame(NULL),
+    fFragment(NULL), fTRUN_dataOffsetPosn(0), fPrevFrameCouldStartFragment(False) {
   fTrackID = ++fCurrentTrackNumber;
 
+  if (sink.isFragmented()) fFragment = new FragmentBuffer;
+
   fBuffer = new SubsessionBuffer(fOurSink.fBufferSize);
   fPrevBuffer = sink.fPacketLossCompensate
     ? new SubsessionBuffer(fOurSink.fBufferSize) : NULL;
@@ -555,6 +723,7 @@ SubsessionIOState::SubsessionIOState(QuickTimeFileSink& sink,
 
 SubsessionIOState::~SubsessionIOState() {
   delete fBuffer; delete fPrevBuffer;
+  delete fFragment;
 
   // Delete the list of chunk descriptors:
   ChunkDescriptor* chunk = fHeadChunk;
@@ -796,6 +965,11 @@ void SubsessionIOState::afterGettingFrame(unsigned packetDataSize,
 }
 
 void SubsessionIOState::useFrame(SubsessionBuffer& buffer) {
+  if (fFragment != NULL) {
+    useFrameForFragment(buffer);
+    return;
+  }
+
   unsigned char* const frameSource = buffer.dataStart();
   unsigned const frameSize = buffer.bytesInUse();
   struct timeval const& presentationTime = buffer.presentationTime();
@@ -868,6 +1042,57 @@ void SubsessionIOState::useFrame(SubsessionBuffer& buffer) {
   }
 }
 
+void SubsessionIOState::useFrameForFragment(SubsessionBuffer& buffer) {
+  unsigned char* const frameSource = buffer.dataStart();
+  unsigned const frameSize = buffer.bytesInUse();
+  struct timeval const& presentationTime = buffer.presentationTime();
+  Boolean const avcHack = fQTMediaDataAtomCreator == &QuickTimeFileSink::addAtom_avc1;
+
+  // Figure out whether this frame is a 'sync sample', and whether it can begin
+  // a new fragment.  For H.264, a fragment can begin with the first of a SPS,
+  // PPS or IDR NAL unit, and each of these NAL units is a sync sample (so that
+  // the fragment's first sample is always one):
+  unsigned sampleFlags = FRAGMENT_SYNC_SAMPLE_FLAGS;
+  Boolean frameCanStartFragment = True;
+  if (avcHack) {
+    u_int8_t const nal_unit_type = frameSize > 0 ? (frameSource[0]&0x1F) : 0;
+    Boolean const isKeyFrameNAL
+      = nal_unit_type == 5 || nal_unit_type == 7 || nal_unit_type == 8;
+    if (!isKeyFrameNAL) sampleFlags = FRAGMENT_NON_SYNC_SAMPLE_FLAGS;
+    frameCanStartFragment = isKeyFrameNAL && !fPrevFrameCouldStartFragment;
+    fPrevFrameCouldStartFragment = isKeyFrameNAL;
+  }
+
+  unsigned frameSizeToUse = frameSize;
+  if (avcHack) frameSizeToUse += 4; // H.264/AVC gets the frame size prefix
+
+  if (fOurSink.fragmentShouldEndBefore(presentationTime, frameSizeToUse, avcHack, frameCanStartFragment)) {
+    fOurSink.completeFragment();
+    (void)fOurSink.fragmentShouldEndBefore(presentationTime, frameSizeToUse, avcHack, True); // starts the next fragment
+  }
+
+  // Give each frame a fixed duration, except for synced video streams, where
+  // we use the difference between successive frames' presentation times (by
+  // updating the duration of the previous frame, now that we know it):
+  unsigned numFrames = 1;
+  if (fQTBytesPerFrame != 0) numFrames = frameSize/fQTBytesPerFrame;
+  unsigned const frameDuration = numFrames*fQTTimeUnitsPerSample*fQTSamplesPerFrame;
+
+  if (fOurSink.fSyncStreams && fQTcomponentSubtype == fourChar('v','i','d','e')
+      && fFragment->fNumSamples > 0) {
+    double duration = timevalDiff(presentationTime, fFragment->fLastPresentationTime);
+    if (duration < 0.0) duration = 0.0;
+    fFragment->fSamples[fFragment->fNumSamples-1].duration
+      = (unsigned)((2*duration*fQTTimeScale+1)/2); // round
+  }
+
+  if (avcHack) fFragment->addWord(frameSize);
+  fFragment->addData(frameSource, frameSize);
+  fFragment->addSample(frameSizeToUse, frameDuration, sampleFlags, presentationTime);
+  fOurSink.fFragmentDataSize += frameSizeToUse;
+  fQTTotNumSamples += numFrames*fQTSamplesPerFrame;
+}
+
 void SubsessionIOState::useFrameForHinting(unsigned frameSize,
 					   struct timeval presentationTime,
 					   unsigned startSampleNumber) {
@@ -1146,6 +1371,56 @@ void SubsessionIOState::setHintTrack(SubsessionIOState* hintedTrack,
   if (hintTrack != NULL) hintTrack->fTrackHintedByUs = hintedTrack;
 }
 
+FragmentBuffer::FragmentBuffer()
+  : fData(NULL), fDataSize(0), fDataMaxSize(0),
+    fSamples(NULL), fNumSamples(0), fMaxNumSamples(0) {
+}
+
+FragmentBuffer::~FragmentBuffer() {
+  delete[] fData;
+  delete[] fSamples;
+}
+
+void FragmentBuffer::addData(unsigned char const* from, unsigned numBytes) {
+  if (fDataSize + numBytes > fDataMaxSize) {
+    // Grow our data buffer.  (It gets reused for each fragment, so its size is
+    // bounded by the size of the largest fragment.)
+    unsigned newMaxSize = 2*fDataMaxSize;
+    if (newMaxSize < fDataSize + numBytes) newMaxSize = fDataSize + numBytes;
+    unsigned char* newData = new unsigned char[newMaxSize];
+    memmove(newData, fData, fDataSize);
+    delete[] fData;
+    fData = newData; fDataMaxSize = newMaxSize;
+  }
+
+  memmove(&fData[fDataSize], from, numBytes);
+  fDataSize += numBytes;
+}
+
+void FragmentBuffer::addWord(unsigned word) {
+  unsigned char bytes[4];
+  bytes[0] = word>>24; bytes[1] = word>>16; bytes[2] = word>>8; bytes[3] = word;
+  addData(bytes, 4);
+}
+
+void FragmentBuffer::addSample(unsigned sampleSize, unsigned sampleDuration, unsigned sampleFlags,
+			       struct timeval const& presentationTime) {
+  if (fNumSamples == fMaxNumSamples) {
+    unsigned newMaxNumSamples = fMaxNumSamples == 0 ? 64 : 2*fMaxNumSamples;
+    Sample* newSamples = new Sample[newMaxNumSamples];
+    for (unsigned i = 0; i < fNumSamples; ++i) newSamples[i] = fSamples[i];
+    delete[] fSamples;
+    fSamples = newSamples; fMaxNumSamples = newMaxNumSamples;
+  }
+
+  fSamples[fNumSamples].size = sampleSize;
+  fSamples[fNumSamples].duration = sampleDuration;
+  fSamples[fNumSamples].flags = sampleFlags;
+  if (fNumSamples == 0) fFirstPresentationTime = presentationTime;
+  fLastPresentationTime = presentationTime;
+  ++fNumSamples;
+}
+
 SyncFrame::SyncFrame(unsigned frameNum)
   : nextSyncFrame(NULL), sfFrameNum(frameNum) {
 }  
@@ -1317,10 +1592,18 @@ void QuickTimeFileSink::setWord64(int64_t filePosn, u_int64_t size) {
 }
 
 addAtom(ftyp);
-  size += add4ByteString("mp42");
-  size += addWord(0x00000000);
-  size += add4ByteString("mp42");
-  size += add4ByteString("isom");
+  if (isFragmented()) {
+    size += add4ByteString("iso6");
+    size += addWord(0x00000000);
+    size += add4ByteString("iso6");
+    size += add4ByteString("isom");
+    size += add4ByteString("mp42");
+  } else {
+    size += add4ByteString("mp42");
+    size += addWord(0x00000000);
+    size += add4ByteString("mp42");
+    size += add4ByteString("isom");
+  }
 addAtomEnd;
 
 addAtom(moov);
@@ -1363,6 +1646,11 @@ addAtom(moov);
       size += addAtom_trak();
     }
   }
+
+  if (isFragmented()) {
+    // Signal that the movie's samples will be found in subsequent 'moof' atoms:
+    size += addAtom_mvex();
+  }
 addAtomEnd;
 
 addAtom(mvhd);
@@ -1654,7 +1942,8 @@ addAtomEnd;
 addAtom(stbl);
   size += addAtom_stsd();
   size += addAtom_stts();
-  if (fCurrentIOState->fQTcomponentSubtype == fourChar('v','i','d','e')) {
+  if (fCurrentIOState->fQTcomponentSubtype == fourChar('v','i','d','e')
+      && !isFragmented()) {
     size += addAtom_stss(); // only for video streams
   }
   size += addAtom_stsc();
@@ -2003,10 +2292,12 @@ addAtom(stts); // Time-to-Sample
     chunk = chunk->fNextChunk;
   }
 
-  // Then, write out the last entry:
-  ++numEntries;
-  size += addWord(numSamplesSoFar); // Sample count
-  size += addWord(prevSampleDuration); // Sample duration
+  // Then, write out the last entry (if any):
+  if (fCurrentIOState->fHeadChunk != NULL) {
+    ++numEntries;
+    size += addWord(numSamplesSoFar); // Sample count
+    size += addWord(prevSampleDuration); // Sample duration
+  }
 
   // Now go back and fill in the "Number of entries" field:
   setWord(numEntriesPosition, numEntries);
@@ -2139,8 +2430,12 @@ addAtom(stsz); // Sample Size
   } else {
     sampleSize = 0; // indicates a multiple-entry table
   }
+  unsigned totNumSamples = fCurrentIOState->fQTTotNumSamples;
+  if (isFragmented()) {
+    // The initialization segment's sample tables are empty; each fragment's 'trun' describes its samples instead:
+    sampleSize = totNumSamples = 0;
+  }
   size += addWord(sampleSize); // Sample size
-  unsigned const totNumSamples = fCurrentIOState->fQTTotNumSamples;
   size += addWord(totNumSamples); // Number of entries
 
   if (!haveSingleEntryTable) {
@@ -2332,6 +2627,83 @@ addAtom(payt);
   }
 addAtomEnd;
 
+addAtom(mvex);
+  // Add a 'trex' atom for each track:
+  MediaSubsessionIterator iter(fInputSession);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL) {
+    fCurrentIOState = (SubsessionIOState*)(subsession->miscPtr);
+    if (fCurrentIOState == NULL) continue;
+
+    size += addAtom_trex();
+  }
+addAtomEnd;
+
+addAtom(trex);
+  size += addWord(0x00000000); // Version + Flags
+  size += addWord(fCurrentIOState->fTrackID); // Track ID
+  size += addWord(0x00000001); // Default sample description index
+  size += addZeroWords(3); // Default sample duration+size+flags (we always use 'trun' values)
+addAtomEnd;
+
+addAtom(moof);
+  size += addAtom_mfhd();
+
+  // Add a 'traf' atom for each track that has data in this fragment:
+  MediaSubsessionIterator iter(fInputSession);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL) {
+    fCurrentIOState = (SubsessionIOState*)(subsession->miscPtr);
+    if (fCurrentIOState == NULL || fCurrentIOState->fFragment->fNumSamples == 0) continue;
+
+    size += addAtom_traf();
+  }
+addAtomEnd;
+
+addAtom(mfhd);
+  size += addWord(0x00000000); // Version + Flags
+  size += addWord(fFragmentSequenceNumber); // Sequence number
+addAtomEnd;
+
+addAtom(traf);
+  size += addAtom_tfhd();
+  size += addAtom_tfdt();
+  size += addAtom_trun();
+addAtomEnd;
+
+addAtom(tfhd);
+  size += addWord(0x00020000); // Version + Flags ('default-base-is-moof')
+  size += addWord(fCurrentIOState->fTrackID); // Track ID
+addAtomEnd;
+
+addAtom(tfdt);
+  size += addWord(0x01000000); // Version (1) + Flags
+  // Use the fragment's presentation time (relative to the start of the file) as
+  // its decode time.  (This keeps the tracks in sync, even if the sample
+  // durations that we've computed are not exact.)
+  double fragmentStart
+    = timevalDiff(fCurrentIOState->fFragment->fFirstPresentationTime, fFragmentTimeBase);
+  if (fragmentStart < 0.0) fragmentStart = 0.0;
+  u_int64_t const baseMediaDecodeTime
+    = (u_int64_t)(fragmentStart*fCurrentIOState->fQTTimeScale + 0.5);
+  size += addWord64(baseMediaDecodeTime); // Base media decode time
+addAtomEnd;
+
+addAtom(trun);
+  // Flags: 'data-offset-present', 'sample-duration-present',
+  // 'sample-size-present', 'sample-flags-present':
+  size += addWord(0x00000701); // Version + Flags
+  FragmentBuffer* fragment = fCurrentIOState->fFragment;
+  size += addWord(fragment->fNumSamples); // Sample count
+  fCurrentIOState->fTRUN_dataOffsetPosn = TellFile64(fOutFid);
+  size += addWord(0); // Data offset (filled in later, once we know the 'moof' size)
+  for (unsigned i = 0; i < fragment->fNumSamples; ++i) {
+    size += addWord(fragment->fSamples[i].duration); // Sample duration
+    size += addWord(fragment->fSamples[i].size); // Sample size
+    size += addWord(fragment->fSamples[i].flags); // Sample flags
+  }
+addAtomEnd;
+
 // A dummy atom (with name "????"):
 unsigned QuickTimeFileSink::addAtom_dummy() {
     int64_t initFilePosn = TellFile64(fOutFid);
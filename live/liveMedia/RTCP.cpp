@@ -111,6 +111,8 @@ void RTCPMemberDatabase::reapOldMembers(unsigned threshold) {
 
 ////////// RTCPInstance //////////
 
+MemoryPool RTCPInstance::fMemoryPool("RTCPInstance", sizeof (RTCPInstance));
+
 static double dTimeNow() {
     struct timeval timeNow;
     gettimeofday(&timeNow, NULL);
@@ -367,6 +369,41 @@ void RTCPInstance::sendAppPacket(u_int8_t subtype, char const* name,
   sendBuiltPacket();
 }
 
+void RTCPInstance::sendNACK(u_int32_t mediaSSRC, u_int16_t const* seqNums, unsigned numSeqNums) {
+  if (numSeqNums == 0) return;
+  u_int32_t ourSSRC = fSource != NULL ? fSource->SSRC() : fSink != NULL ? fSink->SSRC() : 0;
+
+  // The packet must begin with a SR or RR.  We use an empty RR, so that we don't disturb
+  // the reception statistics that our regular reports are based on:
+  fOutBuf->enqueueWord(0x80000000|(RTCP_PT_RR<<16)|1);
+  fOutBuf->enqueueWord(ourSSRC);
+
+  // Pack the sequence numbers into 'PID'+'BLP' pairs.  First, count them, to get the length field:
+  unsigned const maxNumFCIs = 64; // to be sure that our packet fits in "fOutBuf"
+  unsigned numFCIs = 0;
+  unsigned i;
+  for (i = 0; i < numSeqNums && numFCIs < maxNumFCIs; ++numFCIs) {
+    u_int16_t pid = seqNums[i++];
+    while (i < numSeqNums && (u_int16_t)(seqNums[i] - pid - 1) < 16) ++i;
+  }
+
+  // Then, output the feedback message header (FMT 1 = "Generic NACK"), and the FCIs:
+  fOutBuf->enqueueWord(0x80000000|(1<<24)|(RTCP_PT_RTPFB<<16)|(2 + numFCIs));
+  fOutBuf->enqueueWord(ourSSRC);
+  fOutBuf->enqueueWord(mediaSSRC);
+  i = 0;
+  for (unsigned j = 0; j < numFCIs; ++j) {
+    u_int16_t pid = seqNums[i++];
+    u_int16_t blp = 0;
+    while (i < numSeqNums && (u_int16_t)(seqNums[i] - pid - 1) < 16) {
+      blp |= 1<<(u_int16_t)(seqNums[i++] - pid - 1);
+    }
+    fOutBuf->enqueueWord((pid<<16)|blp);
+  }
+
+  sendBuiltPacket();
+}
+
 void RTCPInstance::setStreamSocket(int sockNum,
 				   unsigned char streamChannelId) {
   // Turn off background read handling:
@@ -384,7 +421,10 @@ void RTCPInstance::setStreamSocket(int sockNum,
 void RTCPInstance::addStreamSocket(int sockNum,
 				   unsigned char streamChannelId) {
   // First, turn off background read handling for the default (UDP) socket:
-  envir().taskScheduler().turnOffBackgroundReadHandling(fRTCPInterface.gs()->socketNum());
+  // (unless it's shared, in which case it's not ours to turn off)
+  if (fRTCPInterface.gs()->ownsSocketNum()) {
+    envir().taskScheduler().turnOffBackgroundReadHandling(fRTCPInterface.gs()->socketNum());
+  }
 
   // Add the RTCP-over-TCP interface:
   fRTCPInterface.addStreamSocket(sockNum, streamChannelId);
@@ -718,8 +758,35 @@ void RTCPInstance
 	  break;
 	}
         case RTCP_PT_RTPFB: {
+	  // The only 'generic RTP feedback' that we handle is "Generic NACK" (FMT 1):
+	  if (rc == 1 && length >= 4 && fSink != NULL) {
+	    u_int32_t mediaSSRC = ntohl(*(u_int32_t*)pkt);
+#ifdef DEBUG
+	    fprintf(stderr, "RTPFB Generic NACK (media SSRC 0x%08x)\n", mediaSSRC);
+#endif
+	    if (mediaSSRC == fSink->SSRC()) {
+	      // Identify the client that sent the NACK (so that only it gets the retransmissions).  Over UDP, it's the
+	      // client whose RTCP destination (added with its session id) is the address and port that the NACK came from:
+	      unsigned clientSessionId = 0;
+	      if (tcpSocketNum < 0 && RTCPgs() != NULL) {
+		clientSessionId = RTCPgs()->lookupSessionIdFromDestination(fromAddressAndPort);
+	      }
+
+	      // Each 4-byte 'FCI' is a lost packet's sequence number ("PID"), followed by a bitmask
+	      // ("BLP") of lost packets among the following 16:
+	      for (unsigned i = 4; i + 4 <= length; i += 4) {
+		u_int16_t pid = (pkt[i]<<8)|pkt[i+1];
+		u_int16_t blp = (pkt[i+2]<<8)|pkt[i+3];
+
+		fSink->retransmitPacket(pid, clientSessionId, tcpSocketNum);
+		for (unsigned bit = 0; bit < 16; ++bit) {
+		  if ((blp&(1<<bit)) != 0) fSink->retransmitPacket(pid + 1 + bit, clientSessionId, tcpSocketNum);
+		}
+	      }
+	    }
+	  }
 #ifdef DEBUG
-	  fprintf(stderr, "RTPFB(unhandled)\n");
+	  else fprintf(stderr, "RTPFB(unhandled)\n");
 #endif
 	  subPacketOK = True;
 	  break;
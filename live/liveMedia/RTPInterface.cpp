@@ -33,6 +33,13 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // The top-level hash table maps TCP socket numbers to a
 // "SocketDescriptor" that contains a hash table for each of the
 // sub-channels that are reading from this socket.
+// Each "SocketDescriptor" also reads its socket in large chunks, into its own input buffer,
+// so that the '$'<channel><size> framing (and often the packet data as well) of many packets
+// can be parsed without further system calls.
+
+#ifndef SOCKET_DESCRIPTOR_INPUT_BUFFER_SIZE
+#define SOCKET_DESCRIPTOR_INPUT_BUFFER_SIZE 16384
+#endif
 
 static HashTable* socketHashTable(UsageEnvironment& env, Boolean createIfNotPresent = True) {
   _Tables* ourTables = _Tables::getOurTables(env, createIfNotPresent);
@@ -60,9 +67,17 @@ public:
     fServerRequestAlternativeByteHandlerClientData = clientData;
   }
 
+  int readData(u_int8_t* to, unsigned numBytes);
+      // Reads up to "numBytes" bytes - first from our input buffer; otherwise from the socket.
+      // Returns the number of bytes read (0 if none are available now), or <0 on error.
+
 private:
   static void tcpReadHandler(SocketDescriptor*, int mask);
+  static void bufferedDataHandler(void* clientData);
   Boolean tcpReadHandler1(int mask);
+  int readByte(u_int8_t& c);
+      // Returns 1 if a byte was read, 0 if no data is available now, or <0 on error
+  unsigned numBufferedBytes() const { return fInputBufferEnd - fInputBufferStart; }
 
 private:
   UsageEnvironment& fEnv;
@@ -72,6 +87,9 @@ private:
   void* fServerRequestAlternativeByteHandlerClientData;
   u_int8_t fStreamChannelId, fSizeByte1;
   Boolean fReadErrorOccurred, fDeleteMyselfNext, fAreInReadHandlerLoop;
+  u_int8_t* fInputBuffer;
+  unsigned fInputBufferStart, fInputBufferEnd;
+  TaskToken fBufferedDataTask;
   enum { AWAITING_DOLLAR, AWAITING_STREAM_CHANNEL_ID, AWAITING_SIZE1, AWAITING_SIZE2, AWAITING_PACKET_DATA } fTCPReadingState;
 };
 
@@ -136,7 +154,9 @@ RTPInterface::~RTPInterface() {
 void RTPInterface::setStreamSocket(int sockNum,
 				   unsigned char streamChannelId) {
   fGS->removeAllDestinations();
-  envir().taskScheduler().disableBackgroundHandling(fGS->socketNum()); // turn off any reading on our datagram socket
+  if (fGS->ownsSocketNum()) {
+    envir().taskScheduler().disableBackgroundHandling(fGS->socketNum()); // turn off any reading on our datagram socket
+  }
   fGS->reset(); // and close our datagram socket, because we won't be using it anymore
 
   addStreamSocket(sockNum, streamChannelId);
@@ -232,11 +252,35 @@ Boolean RTPInterface::sendPacket(unsigned char* packet, unsigned packetSize) {
   return success;
 }
 
+Boolean RTPInterface
+::sendPacketToClient(unsigned char* packet, unsigned packetSize, unsigned clientSessionId, int tcpSocketNum) {
+  if (tcpSocketNum < 0) return fGS->outputToSession(envir(), packet, packetSize, clientSessionId);
+
+  for (tcpStreamRecord* stream = fTCPStreams; stream != NULL; stream = stream->fNext) {
+    if (stream->fStreamSocketNum == tcpSocketNum) {
+      return sendRTPorRTCPPacketOverTCP(packet, packetSize, stream->fStreamSocketNum, stream->fStreamChannelId);
+    }
+  }
+  return False; // not one of our TCP connections
+}
+
+Boolean RTPInterface::hasMultipleDestinations() const {
+  unsigned numTCPStreams = 0;
+  for (tcpStreamRecord* stream = fTCPStreams; stream != NULL; stream = stream->fNext) ++numTCPStreams;
+
+  if (fGS->hasMultipleDestinations()) return True;
+  return numTCPStreams + (fGS->hasDestinations() ? 1 : 0) > 1;
+}
+
 void RTPInterface
 ::startNetworkReading(TaskScheduler::BackgroundHandlerProc* handlerProc) {
   // Normal case: Arrange to read UDP packets:
-  envir().taskScheduler().
-    turnOnBackgroundReadHandling(fGS->socketNum(), handlerProc, fOwner);
+  // (But if our socket is shared with other 'groupsocks', then its owner reads it instead, and
+  // passes us our packets.)
+  if (fGS->ownsSocketNum()) {
+    envir().taskScheduler().
+      turnOnBackgroundReadHandling(fGS->socketNum(), handlerProc, fOwner);
+  }
 
   // Also, receive RTP over TCP, on each of our TCP connections:
   fReadHandlerProc = handlerProc;
@@ -253,13 +297,14 @@ void RTPInterface
 Boolean RTPInterface::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 				 unsigned& bytesRead, struct sockaddr_in& fromAddress,
 				 int& tcpSocketNum, unsigned char& tcpStreamChannelId,
-				 Boolean& packetReadWasIncomplete) {
+				 Boolean& packetReadWasIncomplete,
+				 struct timeval* timeReceived) {
   packetReadWasIncomplete = False; // by default
   Boolean readSuccess;
   if (fNextTCPReadStreamSocketNum < 0) {
     // Normal case: read from the (datagram) 'groupsock':
     tcpSocketNum = -1;
-    readSuccess = fGS->handleRead(buffer, bufferMaxSize, bytesRead, fromAddress);
+    readSuccess = fGS->handleRead(buffer, bufferMaxSize, bytesRead, fromAddress, timeReceived);
   } else {
     // Read from the TCP connection:
     tcpSocketNum = fNextTCPReadStreamSocketNum;
@@ -270,9 +315,10 @@ Boolean RTPInterface::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
     if (totBytesToRead > bufferMaxSize) totBytesToRead = bufferMaxSize;
     unsigned curBytesToRead = totBytesToRead;
     int curBytesRead;
-    while ((curBytesRead = readSocket(envir(), fNextTCPReadStreamSocketNum,
-				      &buffer[bytesRead], curBytesToRead,
-				      fromAddress)) > 0) {
+    SocketDescriptor* socketDescriptor = lookupSocketDescriptor(envir(), fNextTCPReadStreamSocketNum, False);
+    while ((curBytesRead = socketDescriptor != NULL
+	    ? socketDescriptor->readData(&buffer[bytesRead], curBytesToRead)
+	    : readSocket(envir(), fNextTCPReadStreamSocketNum, &buffer[bytesRead], curBytesToRead, fromAddress)) > 0) {
       bytesRead += curBytesRead;
       if (bytesRead >= totBytesToRead) break;
       curBytesToRead -= curBytesRead;
@@ -291,6 +337,7 @@ Boolean RTPInterface::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
       return True;
     }
     fNextTCPReadStreamSocketNum = -1; // default, for next time
+    if (timeReceived != NULL) gettimeofday(timeReceived, NULL);
   }
 
   if (readSuccess && fAuxReadHandlerFunc != NULL) {
@@ -302,7 +349,7 @@ Boolean RTPInterface::handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 
 void RTPInterface::stopNetworkReading() {
   // Normal case
-  if (fGS != NULL) envir().taskScheduler().turnOffBackgroundReadHandling(fGS->socketNum());
+  if (fGS != NULL && fGS->ownsSocketNum()) envir().taskScheduler().turnOffBackgroundReadHandling(fGS->socketNum());
 
   // Also turn off read handling on each of our TCP connections:
   for (tcpStreamRecord* streams = fTCPStreams; streams != NULL; streams = streams->fNext) {
@@ -397,10 +444,13 @@ SocketDescriptor::SocketDescriptor(UsageEnvironment& env, int socketNum)
   :fEnv(env), fOurSocketNum(socketNum),
     fSubChannelHashTable(HashTable::create(ONE_WORD_HASH_KEYS)),
    fServerRequestAlternativeByteHandler(NULL), fServerRequestAlternativeByteHandlerClientData(NULL),
-   fReadErrorOccurred(False), fDeleteMyselfNext(False), fAreInReadHandlerLoop(False), fTCPReadingState(AWAITING_DOLLAR) {
+   fReadErrorOccurred(False), fDeleteMyselfNext(False), fAreInReadHandlerLoop(False),
+   fInputBuffer(new u_int8_t[SOCKET_DESCRIPTOR_INPUT_BUFFER_SIZE]), fInputBufferStart(0), fInputBufferEnd(0),
+   fBufferedDataTask(NULL), fTCPReadingState(AWAITING_DOLLAR) {
 }
 
 SocketDescriptor::~SocketDescriptor() {
+  fEnv.taskScheduler().unscheduleDelayedTask(fBufferedDataTask);
   fEnv.taskScheduler().turnOffBackgroundReadHandling(fOurSocketNum);
   removeSocketDescription(fEnv, fOurSocketNum);
 
@@ -430,7 +480,17 @@ SocketDescriptor::~SocketDescriptor() {
     // - no error occurred, but it needs to take over control of the TCP socket once again.
     u_int8_t specialChar = fReadErrorOccurred ? 0xFF : 0xFE;
     (*fServerRequestAlternativeByteHandler)(fServerRequestAlternativeByteHandlerClientData, specialChar);
+
+    if (!fReadErrorOccurred) {
+      // We may have read (into our input buffer) bytes that we didn't get to handle.  Because these
+      // are no longer available from the socket, pass them to the handler (which now owns the socket):
+      while (fInputBufferStart < fInputBufferEnd) {
+	(*fServerRequestAlternativeByteHandler)(fServerRequestAlternativeByteHandlerClientData,
+						fInputBuffer[fInputBufferStart++]);
+      }
+    }
   }
+  delete[] fInputBuffer;
 }
 
 void SocketDescriptor::registerRTPInterface(unsigned char streamChannelId,
@@ -480,7 +540,48 @@ void SocketDescriptor::tcpReadHandler(SocketDescriptor* socketDescriptor, int ma
   socketDescriptor->fAreInReadHandlerLoop = True;
   while (!socketDescriptor->fDeleteMyselfNext && socketDescriptor->tcpReadHandler1(mask) && --count > 0) {}
   socketDescriptor->fAreInReadHandlerLoop = False;
-  if (socketDescriptor->fDeleteMyselfNext) delete socketDescriptor;
+  if (socketDescriptor->fDeleteMyselfNext) {
+    delete socketDescriptor;
+  } else if (socketDescriptor->numBufferedBytes() > 0 && socketDescriptor->fBufferedDataTask == NULL) {
+    // We stopped with data still in our input buffer.  Because the socket might not become readable again,
+    // arrange to handle this data (after first letting other sockets be handled):
+    socketDescriptor->fBufferedDataTask
+      = socketDescriptor->fEnv.taskScheduler().scheduleDelayedTask(0, bufferedDataHandler, socketDescriptor);
+  }
+}
+
+void SocketDescriptor::bufferedDataHandler(void* clientData) {
+  SocketDescriptor* socketDescriptor = (SocketDescriptor*)clientData;
+  socketDescriptor->fBufferedDataTask = NULL;
+  tcpReadHandler(socketDescriptor, SOCKET_READABLE);
+}
+
+int SocketDescriptor::readData(u_int8_t* to, unsigned numBytes) {
+  unsigned numBuffered = numBufferedBytes();
+  if (numBuffered > 0) {
+    if (numBytes > numBuffered) numBytes = numBuffered;
+    memmove(to, &fInputBuffer[fInputBufferStart], numBytes);
+    fInputBufferStart += numBytes;
+    return numBytes;
+  }
+
+  // Our buffer is empty, so read directly from the socket (avoiding a copy):
+  struct sockaddr_in fromAddress;
+  return readSocket(fEnv, fOurSocketNum, to, numBytes, fromAddress);
+}
+
+int SocketDescriptor::readByte(u_int8_t& c) {
+  if (fInputBufferStart == fInputBufferEnd) {
+    // Refill our (empty) input buffer from the socket:
+    fInputBufferStart = fInputBufferEnd = 0;
+    struct sockaddr_in fromAddress;
+    int result = readSocket(fEnv, fOurSocketNum, fInputBuffer, SOCKET_DESCRIPTOR_INPUT_BUFFER_SIZE, fromAddress);
+    if (result <= 0) return result;
+    fInputBufferEnd = result;
+  }
+
+  c = fInputBuffer[fInputBufferStart++];
+  return 1;
 }
 
 Boolean SocketDescriptor::tcpReadHandler1(int mask) {
@@ -493,9 +594,8 @@ Boolean SocketDescriptor::tcpReadHandler1(int mask) {
   // However, because the socket is being read asynchronously, this data might arrive in pieces.
   
   u_int8_t c;
-  struct sockaddr_in fromAddress;
   if (fTCPReadingState != AWAITING_PACKET_DATA) {
-    int result = readSocket(fEnv, fOurSocketNum, &c, 1, fromAddress);
+    int result = readByte(c);
     if (result == 0) { // There was no more data to read
       return False;
     } else if (result != 1) { // error reading TCP socket, so we will no longer handle it
@@ -566,7 +666,8 @@ Boolean SocketDescriptor::tcpReadHandler1(int mask) {
       RTPInterface* rtpInterface = lookupRTPInterface(fStreamChannelId);
       if (rtpInterface != NULL) {
 	if (rtpInterface->fNextTCPReadSize == 0) {
-	  // We've already read all the data for this packet.
+	  // We've already read all the data for this packet; go on to the next one:
+	  callAgain = True;
 	  break;
 	}
 	if (rtpInterface->fReadHandlerProc != NULL) {
@@ -575,11 +676,19 @@ Boolean SocketDescriptor::tcpReadHandler1(int mask) {
 #endif
 	  fTCPReadingState = AWAITING_PACKET_DATA;
 	  rtpInterface->fReadHandlerProc(rtpInterface->fOwner, mask);
+
+	  // If the handler read the entire packet, then go on to handle the next one (which may already be buffered).
+	  // (The handler might have closed "rtpInterface", so we look it up again.)
+	  rtpInterface = lookupRTPInterface(fStreamChannelId);
+	  if (rtpInterface == NULL || rtpInterface->fNextTCPReadSize == 0) {
+	    fTCPReadingState = AWAITING_DOLLAR;
+	    callAgain = True;
+	  }
 	} else {
 #ifdef DEBUG_RECEIVE
 	  fprintf(stderr, "SocketDescriptor(socket %d)::tcpReadHandler(): No handler proc for \"rtpInterface\" for channel %d; need to skip %d remaining bytes\n", fOurSocketNum, fStreamChannelId, rtpInterface->fNextTCPReadSize);
 #endif
-	  int result = readSocket(fEnv, fOurSocketNum, &c, 1, fromAddress);
+	  int result = readByte(c);
 	  if (result < 0) { // error reading TCP socket, so we will no longer handle it
 #ifdef DEBUG_RECEIVE
 	    fprintf(stderr, "SocketDescriptor(socket %d)::tcpReadHandler(): readSocket(1 byte) returned %d (error)\n", fOurSocketNum, result);
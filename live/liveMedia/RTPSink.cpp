@@ -128,6 +128,18 @@ void RTPSink::resetPresentationTimes() {
   fInitialPresentationTime.tv_usec = fMostRecentPresentationTime.tv_usec = 0;
 }
 
+Boolean RTPSink::enableRetransmissions(unsigned /*historySize*/, unsigned char /*rtxPayloadType*/) {
+  return False; // by default, we don't support retransmissions
+}
+
+Boolean RTPSink::enableKernelPacing(unsigned /*burstDurationUSeconds*/, unsigned /*pacingRateKbps*/) {
+  return False; // by default, we don't support this
+}
+
+void RTPSink::retransmitPacket(u_int16_t /*seqNo*/, unsigned /*clientSessionId*/, int /*tcpSocketNum*/) {
+  // default implementation: do nothing
+}
+
 char const* RTPSink::sdpMediaType() const {
   return "data";
   // default SDP media (m=) type, unless redefined by subclasses
@@ -244,6 +256,8 @@ void RTPTransmissionStatsDB::add(u_int32_t SSRC, RTPTransmissionStats* stats) {
 
 ////////// RTPTransmissionStats //////////
 
+MemoryPool RTPTransmissionStats::fMemoryPool("RTPTransmissionStats", sizeof (RTPTransmissionStats));
+
 RTPTransmissionStats::RTPTransmissionStats(RTPSink& rtpSink, u_int32_t SSRC)
   : fOurRTPSink(rtpSink), fSSRC(SSRC), fLastPacketNumReceived(0),
     fPacketLossRatio(0), fTotNumPacketsLost(0), fJitter(0),
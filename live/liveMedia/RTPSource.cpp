@@ -44,6 +44,14 @@ Boolean RTPSource::hasBeenSynchronizedUsingRTCP() {
   return fCurPacketHasBeenSynchronizedUsingRTCP;
 }
 
+void RTPSource::setAdaptivePacketReorderingThresholdTime(unsigned /*minUSeconds*/, unsigned /*maxUSeconds*/) {
+  // By default, we don't support this
+}
+
+void RTPSource::enableRetransmissionRequests(RTCPInstance* /*rtcpInstance*/, unsigned char /*rtxPayloadFormat*/) {
+  // By default, we don't support this
+}
+
 Boolean RTPSource::isRTPSource() const {
   return True;
 }
@@ -103,7 +111,7 @@ void RTPReceptionStatsDB
 		     Boolean useForJitterCalculation,
 		     struct timeval& resultPresentationTime,
 		     Boolean& resultHasBeenSyncedUsingRTCP,
-		     unsigned packetSize) {
+		     unsigned packetSize, struct timeval const* timeReceived) {
   ++fTotNumPacketsReceived;
   RTPReceptionStats* stats = lookup(SSRC);
   if (stats == NULL) {
@@ -121,7 +129,7 @@ void RTPReceptionStatsDB
   stats->noteIncomingPacket(seqNum, rtpTimestamp, timestampFrequency,
 			    useForJitterCalculation,
 			    resultPresentationTime,
-			    resultHasBeenSyncedUsingRTCP, packetSize);
+			    resultHasBeenSyncedUsingRTCP, packetSize, timeReceived);
 }
 
 void RTPReceptionStatsDB
@@ -185,6 +193,8 @@ void RTPReceptionStatsDB::add(u_int32_t SSRC, RTPReceptionStats* stats) {
 
 ////////// RTPReceptionStats //////////
 
+MemoryPool RTPReceptionStats::fMemoryPool("RTPReceptionStats", sizeof (RTPReceptionStats));
+
 RTPReceptionStats::RTPReceptionStats(u_int32_t SSRC, u_int16_t initialSeqNum) {
   initSeqNum(initialSeqNum);
   init(SSRC);
@@ -234,7 +244,7 @@ void RTPReceptionStats
 		     Boolean useForJitterCalculation,
 		     struct timeval& resultPresentationTime,
 		     Boolean& resultHasBeenSyncedUsingRTCP,
-		     unsigned packetSize) {
+		     unsigned packetSize, struct timeval const* timeReceived) {
   if (!fHaveSeenInitialSequenceNumber) initSeqNum(seqNum);
 
   ++fNumPacketsReceivedSinceLastReset;
@@ -278,7 +288,11 @@ void RTPReceptionStats
 
   // Record the inter-packet delay
   struct timeval timeNow;
-  gettimeofday(&timeNow, NULL);
+  if (timeReceived != NULL) {
+    timeNow = *timeReceived;
+  } else {
+    gettimeofday(&timeNow, NULL);
+  }
   if (fLastPacketReceptionTime.tv_sec != 0
       || fLastPacketReceptionTime.tv_usec != 0) {
     unsigned gap
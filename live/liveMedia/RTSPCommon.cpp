@@ -48,6 +48,28 @@ static void decodeURL(char* url) {
   *url = '\0';
 }
 
+static Boolean copyHeaderValue(char const* reqStr, unsigned reqStrSize, unsigned& j,
+			       char* result, unsigned resultMaxSize) {
+  // Skip whitespace, then copy everything up to the next \r or \n into "result".
+  // Returns True iff the value was terminated (by \r or \n) before "result" filled up.
+  while (j < reqStrSize && (reqStr[j] ==  ' ' || reqStr[j] == '\t')) ++j;
+
+  Boolean terminated = False;
+  unsigned n;
+  for (n = 0; n < resultMaxSize-1 && j < reqStrSize; ++n,++j) {
+    char c = reqStr[j];
+    if (c == '\r' || c == '\n') {
+      terminated = True;
+      break;
+    }
+
+    result[n] = c;
+  }
+  result[n] = '\0';
+
+  return terminated;
+}
+
 Boolean parseRTSPRequestString(char const* reqStr,
 			       unsigned reqStrSize,
 			       char* resultCmdName,
@@ -60,8 +82,14 @@ Boolean parseRTSPRequestString(char const* reqStr,
 			       unsigned resultCSeqMaxSize,
                                char* resultSessionIdStr,
                                unsigned resultSessionIdStrMaxSize,
-			       unsigned& contentLength) {
-  // This parser is currently rather dumb; it should be made smarter #####
+			       unsigned& contentLength,
+			       RTSPRequestHeaders* resultHeaders) {
+  if (resultHeaders != NULL) {
+    resultHeaders->request = NULL; // until we've parsed the request
+    resultHeaders->transport = resultHeaders->range = resultHeaders->scale
+      = resultHeaders->playNow = resultHeaders->authorization = NULL;
+  }
+
 
   // "Be liberal in what you accept": Skip over any whitespace at the start of the request:
   unsigned i;
@@ -149,63 +177,92 @@ Boolean parseRTSPRequestString(char const* reqStr,
   }
   if (!parseSucceeded) return False;
 
-  // Look for "CSeq:" (mandatory, case insensitive), skip whitespace,
-  // then read everything up to the next \r or \n as 'CSeq':
-  parseSucceeded = False;
-  for (j = i; (int)j < (int)(reqStrSize-5); ++j) {
-    if (_strncasecmp("CSeq:", &reqStr[j], 5) == 0) {
-      j += 5;
-      while (j < reqStrSize && (reqStr[j] ==  ' ' || reqStr[j] == '\t')) ++j;
-      unsigned n;
-      for (n = 0; n < resultCSeqMaxSize-1 && j < reqStrSize; ++n,++j) {
-	char c = reqStr[j];
-	if (c == '\r' || c == '\n') {
-	  parseSucceeded = True;
-	  break;
+  // Then, in a single pass over the remaining header lines, look for "CSeq:" (mandatory),
+  // "Session:" (optional), and "Content-Length:" (optional) - all case insensitive.
+  // At the same time, note (in "resultHeaders") where any other headers of interest begin:
+  Boolean haveCSeq = False, haveSessionId = False;
+  resultSessionIdStr[0] = '\0'; // default value (empty string)
+  contentLength = 0; // default value
+  j = i;
+  while (1) {
+    // Move to the start of the next line:
+    while (j < reqStrSize && reqStr[j] != '\r' && reqStr[j] != '\n') ++j;
+    while (j < reqStrSize && (reqStr[j] == '\r' || reqStr[j] == '\n')) ++j;
+    if (j >= reqStrSize) break;
+
+    char const* line = &reqStr[j];
+    unsigned lineMaxSize = reqStrSize - j;
+    switch (line[0]) {
+      case 'A': case 'a': {
+	if (resultHeaders != NULL && resultHeaders->authorization == NULL
+	    && lineMaxSize > 14 && _strncasecmp(line, "Authorization:", 14) == 0) {
+	  resultHeaders->authorization = line;
 	}
-
-	resultCSeq[n] = c;
+	break;
       }
-      resultCSeq[n] = '\0';
-      break;
-    }
-  }
-  if (!parseSucceeded) return False;
-
-  // Look for "Session:" (optional, case insensitive), skip whitespace,
-  // then read everything up to the next \r or \n as 'Session':
-  resultSessionIdStr[0] = '\0'; // default value (empty string)
-  for (j = i; (int)j < (int)(reqStrSize-8); ++j) {
-    if (_strncasecmp("Session:", &reqStr[j], 8) == 0) {
-      j += 8;
-      while (j < reqStrSize && (reqStr[j] ==  ' ' || reqStr[j] == '\t')) ++j;
-      unsigned n;
-      for (n = 0; n < resultSessionIdStrMaxSize-1 && j < reqStrSize; ++n,++j) {
-	char c = reqStr[j];
-	if (c == '\r' || c == '\n') {
-	  break;
+      case 'C': case 'c': {
+	if (!haveCSeq && lineMaxSize > 5 && _strncasecmp(line, "CSeq:", 5) == 0) {
+	  // Read everything up to the next \r or \n as 'CSeq':
+	  j += 5;
+	  if (!copyHeaderValue(reqStr, reqStrSize, j, resultCSeq, resultCSeqMaxSize)) return False;
+	  haveCSeq = True;
+	} else if (lineMaxSize > 15 && _strncasecmp(line, "Content-Length:", 15) == 0) {
+	  j += 15;
+	  while (j < reqStrSize && (reqStr[j] ==  ' ' || reqStr[j] == '\t')) ++j;
+	  unsigned num = 0;
+	  Boolean haveDigits = False;
+	  for (; j < reqStrSize && reqStr[j] >= '0' && reqStr[j] <= '9'; ++j) {
+	    num = 10*num + (reqStr[j] - '0');
+	    haveDigits = True;
+	  }
+	  if (haveDigits) contentLength = num;
 	}
-
-	resultSessionIdStr[n] = c;
+	break;
       }
-      resultSessionIdStr[n] = '\0';
-      break;
-    }
-  }
-
-  // Also: Look for "Content-Length:" (optional, case insensitive)
-  contentLength = 0; // default value
-  for (j = i; (int)j < (int)(reqStrSize-15); ++j) {
-    if (_strncasecmp("Content-Length:", &(reqStr[j]), 15) == 0) {
-      j += 15;
-      while (j < reqStrSize && (reqStr[j] ==  ' ' || reqStr[j] == '\t')) ++j;
-      unsigned num;
-      if (sscanf(&reqStr[j], "%u", &num) == 1) {
-	contentLength = num;
+      case 'S': case 's': {
+	if (!haveSessionId && lineMaxSize > 8 && _strncasecmp(line, "Session:", 8) == 0) {
+	  // Read everything up to the next \r or \n as 'Session':
+	  j += 8;
+	  copyHeaderValue(reqStr, reqStrSize, j, resultSessionIdStr, resultSessionIdStrMaxSize);
+	  haveSessionId = True;
+	} else if (resultHeaders != NULL && resultHeaders->scale == NULL
+		   && lineMaxSize > 6 && _strncasecmp(line, "Scale:", 6) == 0) {
+	  resultHeaders->scale = line;
+	}
+	break;
+      }
+      case 'R': case 'r': {
+	if (resultHeaders != NULL && resultHeaders->range == NULL
+	    && lineMaxSize > 6 && _strncasecmp(line, "Range:", 6) == 0) {
+	  resultHeaders->range = line;
+	}
+	break;
+      }
+      case 'T': case 't': {
+	if (resultHeaders != NULL && resultHeaders->transport == NULL
+	    && lineMaxSize > 10 && _strncasecmp(line, "Transport:", 10) == 0) {
+	  resultHeaders->transport = line;
+	}
+	break;
+      }
+      case 'X': case 'x': {
+	if (resultHeaders != NULL && resultHeaders->playNow == NULL
+	    && lineMaxSize > 10 && _strncasecmp(line, "x-playNow:", 10) == 0) {
+	  resultHeaders->playNow = line;
+	}
+	break;
       }
     }
   }
-  return True;
+
+  if (haveCSeq && resultHeaders != NULL) resultHeaders->request = reqStr;
+  return haveCSeq;
+}
+
+char const* requestHeaderToParse(RTSPRequestHeaders const& headers, char const* headerLine, char const* fullRequestStr) {
+  if (headers.request == NULL || headers.request != fullRequestStr) return fullRequestStr; // it'll need to be scanned
+
+  return headerLine == NULL ? "" : headerLine;
 }
 
 Boolean parseRangeParam(char const* paramStr,
@@ -144,7 +144,9 @@ RTSPServer::RTSPServer(UsageEnvironment& env,
     fClientConnectionsForHTTPTunneling(NULL), // will get created if needed
     fTCPStreamingDatabase(HashTable::create(ONE_WORD_HASH_KEYS)),
     fPendingRegisterOrDeregisterRequests(HashTable::create(ONE_WORD_HASH_KEYS)),
-    fRegisterOrDeregisterRequestCounter(0), fAuthDB(authDatabase), fAllowStreamingRTPOverTCP(True) {
+    fRegisterOrDeregisterRequestCounter(0), fAuthDB(authDatabase), fAllowStreamingRTPOverTCP(True),
+    fDateHeaderTime((time_t)-1) {
+  fDateHeader[0] = '\0';
 }
 
 // A data structure that is used to implement "fTCPStreamingDatabase"
@@ -266,9 +268,22 @@ void RTSPServer::stopTCPStreamingOnSocket(int socketNum) {
   }
 }
 
+char const* RTSPServer::responseDateHeader() {
+  time_t tt = time(NULL);
+  if (tt != fDateHeaderTime) {
+    // The header changes only once per second, so we don't reformat it for each response:
+    strcpy(fDateHeader, dateHeader());
+    fDateHeaderTime = tt;
+  }
+
+  return fDateHeader;
+}
+
 
 ////////// RTSPServer::RTSPClientConnection implementation //////////
 
+MemoryPool RTSPServer::RTSPClientConnection::fMemoryPool("RTSPServer::RTSPClientConnection", sizeof (RTSPServer::RTSPClientConnection));
+
 RTSPServer::RTSPClientConnection
 ::RTSPClientConnection(RTSPServer& ourServer, int clientSocket, struct sockaddr_in clientAddr)
   : GenericMediaServer::ClientConnection(ourServer, clientSocket, clientAddr),
@@ -290,9 +305,10 @@ RTSPServer::RTSPClientConnection::~RTSPClientConnection() {
 // Handler routines for specific RTSP commands:
 
 void RTSPServer::RTSPClientConnection::handleCmd_OPTIONS() {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "RTSP/1.0 200 OK\r\nCSeq: %s\r\n%sPublic: %s\r\n\r\n",
-	   fCurrentCSeq, dateHeader(), fOurRTSPServer.allowedCommandNames());
+  unsigned responseSize = setRTSPResponseHead("200 OK");
+  appendToRTSPResponse(responseSize, "Public: ");
+  appendToRTSPResponse(responseSize, fOurRTSPServer.allowedCommandNames());
+  appendToRTSPResponse(responseSize, "\r\n\r\n");
 }
 
 void RTSPServer::RTSPClientConnection
@@ -356,18 +372,14 @@ void RTSPServer::RTSPClientConnection
     // (which is necessary to ensure that the correct URL gets used in subsequent "SETUP" requests).
     rtspURL = fOurRTSPServer.rtspURL(session, fClientInputSocket);
     
-    snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	     "RTSP/1.0 200 OK\r\nCSeq: %s\r\n"
-	     "%s"
-	     "Content-Base: %s/\r\n"
-	     "Content-Type: application/sdp\r\n"
-	     "Content-Length: %d\r\n\r\n"
-	     "%s",
-	     fCurrentCSeq,
-	     dateHeader(),
-	     rtspURL,
-	     sdpDescriptionSize,
-	     sdpDescription);
+    unsigned responseSize = setRTSPResponseHead("200 OK");
+    appendToRTSPResponse(responseSize, "Content-Base: ");
+    appendToRTSPResponse(responseSize, rtspURL);
+    appendToRTSPResponse(responseSize, "/\r\nContent-Type: application/sdp\r\n");
+    char contentLengthHeader[40];
+    sprintf(contentLengthHeader, "Content-Length: %d\r\n\r\n", sdpDescriptionSize);
+    appendToRTSPResponse(responseSize, contentLengthHeader);
+    appendToRTSPResponse(responseSize, sdpDescription);
   } while (0);
   
   if (session != NULL) {
@@ -382,39 +394,42 @@ void RTSPServer::RTSPClientConnection
   delete[] rtspURL;
 }
 
-static void lookForHeader(char const* headerName, char const* source, unsigned sourceLen, char* resultStr, unsigned resultMaxSize) {
-  resultStr[0] = '\0';  // by default, return an empty string
+static Boolean lookForHeader(char const* headerName, char const* line, unsigned lineMaxSize, char* resultStr, unsigned resultMaxSize) {
+  // Checks whether "line" (the start of a header line) is the header "headerName".  If so, returns True, after copying
+  // the header's value to "resultStr" (if it will fit):
   unsigned headerNameLen = strlen(headerName);
-  for (int i = 0; i < (int)(sourceLen-headerNameLen); ++i) {
-    if (strncmp(&source[i], headerName, headerNameLen) == 0 && source[i+headerNameLen] == ':') {
-      // We found the header.  Skip over any whitespace, then copy the rest of the line to "resultStr":
-      for (i += headerNameLen+1; i < (int)sourceLen && (source[i] == ' ' || source[i] == '\t'); ++i) {}
-      for (unsigned j = i; j < sourceLen; ++j) {
-	if (source[j] == '\r' || source[j] == '\n') {
-	  // We've found the end of the line.  Copy it to the result (if it will fit):
-	  if (j-i+1 > resultMaxSize) return; // it wouldn't fit
-	  char const* resultSource = &source[i];
-	  char const* resultSourceEnd = &source[j];
-	  while (resultSource < resultSourceEnd) *resultStr++ = *resultSource++;
-	  *resultStr = '\0';
-	  return;
-	}
-      }
+  if (lineMaxSize <= headerNameLen || strncmp(line, headerName, headerNameLen) != 0 || line[headerNameLen] != ':') return False;
+
+  // We found the header.  Skip over any whitespace, then copy the rest of the line to "resultStr":
+  unsigned i;
+  for (i = headerNameLen+1; i < lineMaxSize && (line[i] == ' ' || line[i] == '\t'); ++i) {}
+  for (unsigned j = i; j < lineMaxSize; ++j) {
+    if (line[j] == '\r' || line[j] == '\n') {
+      // We've found the end of the line.  Copy it to the result (if it will fit):
+      if (j-i+1 > resultMaxSize) break; // it wouldn't fit
+      char const* resultSource = &line[i];
+      char const* resultSourceEnd = &line[j];
+      while (resultSource < resultSourceEnd) *resultStr++ = *resultSource++;
+      *resultStr = '\0';
+      break;
     }
   }
+  return True;
 }
 
 void RTSPServer::RTSPClientConnection::handleCmd_bad() {
   // Don't do anything with "fCurrentCSeq", because it might be nonsense
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "RTSP/1.0 400 Bad Request\r\n%sAllow: %s\r\n\r\n",
-	   dateHeader(), fOurRTSPServer.allowedCommandNames());
+  unsigned responseSize = setRTSPResponseHead("400 Bad Request", False);
+  appendToRTSPResponse(responseSize, "Allow: ");
+  appendToRTSPResponse(responseSize, fOurRTSPServer.allowedCommandNames());
+  appendToRTSPResponse(responseSize, "\r\n\r\n");
 }
 
 void RTSPServer::RTSPClientConnection::handleCmd_notSupported() {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "RTSP/1.0 405 Method Not Allowed\r\nCSeq: %s\r\n%sAllow: %s\r\n\r\n",
-	   fCurrentCSeq, dateHeader(), fOurRTSPServer.allowedCommandNames());
+  unsigned responseSize = setRTSPResponseHead("405 Method Not Allowed");
+  appendToRTSPResponse(responseSize, "Allow: ");
+  appendToRTSPResponse(responseSize, fOurRTSPServer.allowedCommandNames());
+  appendToRTSPResponse(responseSize, "\r\n\r\n");
 }
 
 void RTSPServer::RTSPClientConnection::handleCmd_notFound() {
@@ -475,23 +490,34 @@ Boolean RTSPServer::RTSPClientConnection::parseHTTPRequestString(char* resultCmd
   while (++j <= k) urlSuffix[n++] = reqStr[j];
   urlSuffix[n] = '\0';
   
-  // Look for various headers that we're interested in:
-  lookForHeader("x-sessioncookie", &reqStr[i], reqStrSize-i, sessionCookie, sessionCookieMaxSize);
-  lookForHeader("Accept", &reqStr[i], reqStrSize-i, acceptStr, acceptStrMaxSize);
+  // Look - in a single pass over the header lines - for the headers that we're interested in:
+  sessionCookie[0] = acceptStr[0] = '\0'; // by default, return empty strings
+  Boolean haveSessionCookie = False, haveAccept = False;
+  while (1) {
+    // Move to the start of the next line:
+    while (i < reqStrSize && reqStr[i] != '\r' && reqStr[i] != '\n' && reqStr[i] != '\0') ++i;
+    while (i < reqStrSize && (reqStr[i] == '\r' || reqStr[i] == '\n')) ++i;
+    if (i >= reqStrSize || reqStr[i] == '\0') break; // we've reached the end of the headers
+
+    if (!haveSessionCookie) {
+      haveSessionCookie = lookForHeader("x-sessioncookie", &reqStr[i], reqStrSize-i, sessionCookie, sessionCookieMaxSize);
+    }
+    if (!haveAccept) {
+      haveAccept = lookForHeader("Accept", &reqStr[i], reqStrSize-i, acceptStr, acceptStrMaxSize);
+    }
+  }
   
   return True;
 }
 
 void RTSPServer::RTSPClientConnection::handleHTTPCmd_notSupported() {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "HTTP/1.1 405 Method Not Allowed\r\n%s\r\n\r\n",
-	   dateHeader());
+  unsigned responseSize = setHTTPResponseHead("405 Method Not Allowed");
+  appendToRTSPResponse(responseSize, "\r\n\r\n");
 }
 
 void RTSPServer::RTSPClientConnection::handleHTTPCmd_notFound() {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "HTTP/1.1 404 Not Found\r\n%s\r\n\r\n",
-	   dateHeader());
+  unsigned responseSize = setHTTPResponseHead("404 Not Found");
+  appendToRTSPResponse(responseSize, "\r\n\r\n");
 }
 
 void RTSPServer::RTSPClientConnection::handleHTTPCmd_OPTIONS() {
@@ -499,15 +525,13 @@ void RTSPServer::RTSPClientConnection::handleHTTPCmd_OPTIONS() {
   fprintf(stderr, "Handled HTTP \"OPTIONS\" request\n");
 #endif
   // Construct a response to the "OPTIONS" command that notes that our special headers (for RTSP-over-HTTP tunneling) are allowed:
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "HTTP/1.1 200 OK\r\n"
-	   "%s"
-	   "Access-Control-Allow-Origin: *\r\n"
-	   "Access-Control-Allow-Methods: POST, GET, OPTIONS\r\n"
-	   "Access-Control-Allow-Headers: x-sessioncookie, Pragma, Cache-Control\r\n"
-	   "Access-Control-Max-Age: 1728000\r\n"
-	   "\r\n",
-	   dateHeader());
+  unsigned responseSize = setHTTPResponseHead("200 OK");
+  appendToRTSPResponse(responseSize,
+		       "Access-Control-Allow-Origin: *\r\n"
+		       "Access-Control-Allow-Methods: POST, GET, OPTIONS\r\n"
+		       "Access-Control-Allow-Headers: x-sessioncookie, Pragma, Cache-Control\r\n"
+		       "Access-Control-Max-Age: 1728000\r\n"
+		       "\r\n");
 }
 
 void RTSPServer::RTSPClientConnection::handleHTTPCmd_TunnelingGET(char const* sessionCookie) {
@@ -523,14 +547,12 @@ void RTSPServer::RTSPClientConnection::handleHTTPCmd_TunnelingGET(char const* se
 #endif
   
   // Construct our response:
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "HTTP/1.1 200 OK\r\n"
-	   "%s"
-	   "Cache-Control: no-cache\r\n"
-	   "Pragma: no-cache\r\n"
-	   "Content-Type: application/x-rtsp-tunnelled\r\n"
-	   "\r\n",
-	   dateHeader());
+  unsigned responseSize = setHTTPResponseHead("200 OK");
+  appendToRTSPResponse(responseSize,
+		       "Cache-Control: no-cache\r\n"
+		       "Pragma: no-cache\r\n"
+		       "Content-Type: application/x-rtsp-tunnelled\r\n"
+		       "\r\n");
 }
 
 Boolean RTSPServer::RTSPClientConnection
@@ -567,7 +589,7 @@ void RTSPServer::RTSPClientConnection::resetRequestBuffer() {
   ClientConnection::resetRequestBuffer();
   
   fLastCRLF = &fRequestBuffer[-3]; // hack: Ensures that we don't think we have end-of-msg if the data starts with <CR><LF>
-  fBase64RemainderCount = 0;
+  fCurrentRequestHeaders.request = NULL; // we no longer have a parsed request
 }
 
 void RTSPServer::RTSPClientConnection::closeSocketsRTSP() {
@@ -632,59 +654,28 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
     
     if (fClientOutputSocket != fClientInputSocket && numBytesRemaining == 0) {
       // We're doing RTSP-over-HTTP tunneling, and input commands are assumed to have been Base64-encoded.
-      // We therefore Base64-decode as much of this new data as we can (i.e., up to a multiple of 4 bytes).
-      
-      // But first, we remove any whitespace that may be in the input data:
-      unsigned toIndex = 0;
-      for (int fromIndex = 0; fromIndex < newBytesRead; ++fromIndex) {
-	char c = ptr[fromIndex];
-	if (!(c == ' ' || c == '\t' || c == '\r' || c == '\n')) { // not 'whitespace': space,tab,CR,NL
-	  ptr[toIndex++] = c;
-	}
-      }
-      newBytesRead = toIndex;
-      
-      unsigned numBytesToDecode = fBase64RemainderCount + newBytesRead;
-      unsigned newBase64RemainderCount = numBytesToDecode%4;
-      numBytesToDecode -= newBase64RemainderCount;
-      if (numBytesToDecode > 0) {
-	ptr[newBytesRead] = '\0';
-	unsigned decodedSize;
-	unsigned char* decodedBytes = base64Decode((char const*)(ptr-fBase64RemainderCount), numBytesToDecode, decodedSize);
+      // We therefore Base64-decode this new data, in place.  (Our decoder skips any whitespace, and remembers
+      // any incomplete final group of characters, so that it can be completed by subsequent data.)
+      newBytesRead = fBase64Decoder.decode(ptr, (char const*)ptr, newBytesRead);
 #ifdef DEBUG
-	fprintf(stderr, "Base64-decoded %d input bytes into %d new bytes:", numBytesToDecode, decodedSize);
-	for (unsigned k = 0; k < decodedSize; ++k) fprintf(stderr, "%c", decodedBytes[k]);
-	fprintf(stderr, "\n");
+      fprintf(stderr, "Base64-decoded into %d new bytes:", newBytesRead);
+      for (int k = 0; k < newBytesRead; ++k) fprintf(stderr, "%c", ptr[k]);
+      fprintf(stderr, "\n");
 #endif
-	
-	// Copy the new decoded bytes in place of the old ones (we can do this because there are fewer decoded bytes than original):
-	unsigned char* to = ptr-fBase64RemainderCount;
-	for (unsigned i = 0; i < decodedSize; ++i) *to++ = decodedBytes[i];
-	
-	// Then copy any remaining (undecoded) bytes to the end:
-	for (unsigned j = 0; j < newBase64RemainderCount; ++j) *to++ = (ptr-fBase64RemainderCount+numBytesToDecode)[j];
-	
-	newBytesRead = decodedSize - fBase64RemainderCount + newBase64RemainderCount;
-	  // adjust to allow for the size of the new decoded data (+ remainder)
-	delete[] decodedBytes;
-      }
-      fBase64RemainderCount = newBase64RemainderCount;
     }
     
     unsigned char* tmpPtr = fLastCRLF + 2;
-    if (fBase64RemainderCount == 0) { // no more Base-64 bytes remain to be read/decoded
-      // Look for the end of the message: <CR><LF><CR><LF>
-      if (tmpPtr < fRequestBuffer) tmpPtr = fRequestBuffer;
-      while (tmpPtr < &ptr[newBytesRead-1]) {
-	if (*tmpPtr == '\r' && *(tmpPtr+1) == '\n') {
-	  if (tmpPtr - fLastCRLF == 2) { // This is it:
-	    endOfMsg = True;
-	    break;
-	  }
-	  fLastCRLF = tmpPtr;
+    // Look for the end of the message: <CR><LF><CR><LF>
+    if (tmpPtr < fRequestBuffer) tmpPtr = fRequestBuffer;
+    while (tmpPtr < &ptr[newBytesRead-1]) {
+      if (*tmpPtr == '\r' && *(tmpPtr+1) == '\n') {
+	if (tmpPtr - fLastCRLF == 2) { // This is it:
+	  endOfMsg = True;
+	  break;
 	}
-	++tmpPtr;
+	fLastCRLF = tmpPtr;
       }
+      ++tmpPtr;
     }
     
     fRequestBufferBytesLeft -= newBytesRead;
@@ -708,7 +699,7 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 						    urlSuffix, sizeof urlSuffix,
 						    cseq, sizeof cseq,
 						    sessionIdStr, sizeof sessionIdStr,
-						    contentLength);
+						    contentLength, &fCurrentRequestHeaders);
     fLastCRLF[2] = '\r'; // restore its value
     // Check first for a bogus "Content-Length" value that would cause a pointer wraparound:
     if (tmpPtr + 2 + contentLength < tmpPtr + 2) {
@@ -803,7 +794,9 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 	  // Check for special command-specific parameters in a "Transport:" header:
 	  Boolean reuseConnection, deliverViaTCP;
 	  char* proxyURLSuffix;
-	  parseTransportHeaderForREGISTER((const char*)fRequestBuffer, reuseConnection, deliverViaTCP, proxyURLSuffix);
+	  parseTransportHeaderForREGISTER(requestHeaderToParse(fCurrentRequestHeaders, fCurrentRequestHeaders.transport,
+							       (char const*)fRequestBuffer),
+					  reuseConnection, deliverViaTCP, proxyURLSuffix);
 
 	  handleCmd_REGISTER(cmdName, url, urlSuffix, (char const*)fRequestBuffer, reuseConnection, deliverViaTCP, proxyURLSuffix);
 	  delete[] proxyURLSuffix;
@@ -972,7 +965,8 @@ Boolean RTSPServer::RTSPClientConnection
     // Next, the request needs to contain an "Authorization:" header,
     // containing a username, (our) realm, (our) nonce, uri,
     // and response string:
-    if (!parseAuthorizationHeader(fullRequestStr,
+    if (!parseAuthorizationHeader(requestHeaderToParse(fCurrentRequestHeaders, fCurrentRequestHeaders.authorization,
+						       fullRequestStr),
 				  username, realm, nonce, uri, response)
 	|| username == NULL
 	|| realm == NULL || strcmp(realm, fCurrentAuthenticator.realm()) != 0
@@ -1017,39 +1011,27 @@ Boolean RTSPServer::RTSPClientConnection
   // If we get here, we failed to authenticate the user.
   // Send back a "401 Unauthorized" response, with a new random nonce:
   fCurrentAuthenticator.setRealmAndRandomNonce(authDB->realm());
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "RTSP/1.0 401 Unauthorized\r\n"
-	   "CSeq: %s\r\n"
-	   "%s"
-	   "WWW-Authenticate: Digest realm=\"%s\", nonce=\"%s\"\r\n\r\n",
-	   fCurrentCSeq,
-	   dateHeader(),
-	   fCurrentAuthenticator.realm(), fCurrentAuthenticator.nonce());
+  unsigned responseSize = setRTSPResponseHead("401 Unauthorized");
+  appendToRTSPResponse(responseSize, "WWW-Authenticate: Digest realm=\"");
+  appendToRTSPResponse(responseSize, fCurrentAuthenticator.realm());
+  appendToRTSPResponse(responseSize, "\", nonce=\"");
+  appendToRTSPResponse(responseSize, fCurrentAuthenticator.nonce());
+  appendToRTSPResponse(responseSize, "\"\r\n\r\n");
   return False;
 }
 
 void RTSPServer::RTSPClientConnection
 ::setRTSPResponse(char const* responseStr) {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "RTSP/1.0 %s\r\n"
-	   "CSeq: %s\r\n"
-	   "%s\r\n",
-	   responseStr,
-	   fCurrentCSeq,
-	   dateHeader());
+  unsigned responseSize = setRTSPResponseHead(responseStr);
+  appendToRTSPResponse(responseSize, "\r\n");
 }
 
 void RTSPServer::RTSPClientConnection
 ::setRTSPResponse(char const* responseStr, u_int32_t sessionId) {
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "RTSP/1.0 %s\r\n"
-	   "CSeq: %s\r\n"
-	   "%s"
-	   "Session: %08X\r\n\r\n",
-	   responseStr,
-	   fCurrentCSeq,
-	   dateHeader(),
-	   sessionId);
+  unsigned responseSize = setRTSPResponseHead(responseStr);
+  char sessionHeader[30];
+  sprintf(sessionHeader, "Session: %08X\r\n\r\n", sessionId);
+  appendToRTSPResponse(responseSize, sessionHeader);
 }
 
 void RTSPServer::RTSPClientConnection
@@ -1057,17 +1039,11 @@ void RTSPServer::RTSPClientConnection
   if (contentStr == NULL) contentStr = "";
   unsigned const contentLen = strlen(contentStr);
   
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "RTSP/1.0 %s\r\n"
-	   "CSeq: %s\r\n"
-	   "%s"
-	   "Content-Length: %d\r\n\r\n"
-	   "%s",
-	   responseStr,
-	   fCurrentCSeq,
-	   dateHeader(),
-	   contentLen,
-	   contentStr);
+  unsigned responseSize = setRTSPResponseHead(responseStr);
+  char contentLengthHeader[40];
+  sprintf(contentLengthHeader, "Content-Length: %d\r\n\r\n", contentLen);
+  appendToRTSPResponse(responseSize, contentLengthHeader);
+  appendToRTSPResponse(responseSize, contentStr);
 }
 
 void RTSPServer::RTSPClientConnection
@@ -1075,19 +1051,49 @@ void RTSPServer::RTSPClientConnection
   if (contentStr == NULL) contentStr = "";
   unsigned const contentLen = strlen(contentStr);
   
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "RTSP/1.0 %s\r\n"
-	   "CSeq: %s\r\n"
-	   "%s"
-	   "Session: %08X\r\n"
-	   "Content-Length: %d\r\n\r\n"
-	   "%s",
-	   responseStr,
-	   fCurrentCSeq,
-	   dateHeader(),
-	   sessionId,
-	   contentLen,
-	   contentStr);
+  unsigned responseSize = setRTSPResponseHead(responseStr);
+  char sessionAndContentLengthHeaders[70];
+  sprintf(sessionAndContentLengthHeaders, "Session: %08X\r\nContent-Length: %d\r\n\r\n", sessionId, contentLen);
+  appendToRTSPResponse(responseSize, sessionAndContentLengthHeaders);
+  appendToRTSPResponse(responseSize, contentStr);
+}
+
+unsigned RTSPServer::RTSPClientConnection
+::setRTSPResponseHead(char const* responseStr, Boolean includeCSeq) {
+  // Build the start of the response from its (mostly constant) parts, rather than using "snprintf()":
+  unsigned responseSize = 0;
+  appendToRTSPResponse(responseSize, "RTSP/1.0 ");
+  appendToRTSPResponse(responseSize, responseStr);
+  appendToRTSPResponse(responseSize, "\r\n");
+  if (includeCSeq) {
+    appendToRTSPResponse(responseSize, "CSeq: ");
+    appendToRTSPResponse(responseSize, fCurrentCSeq);
+    appendToRTSPResponse(responseSize, "\r\n");
+  }
+  appendToRTSPResponse(responseSize, fOurRTSPServer.responseDateHeader());
+
+  return responseSize;
+}
+
+unsigned RTSPServer::RTSPClientConnection::setHTTPResponseHead(char const* responseStr) {
+  unsigned responseSize = 0;
+  appendToRTSPResponse(responseSize, "HTTP/1.1 ");
+  appendToRTSPResponse(responseSize, responseStr);
+  appendToRTSPResponse(responseSize, "\r\n");
+  appendToRTSPResponse(responseSize, fOurRTSPServer.responseDateHeader());
+
+  return responseSize;
+}
+
+void RTSPServer::RTSPClientConnection::appendToRTSPResponse(unsigned& responseSize, char const* str) {
+  // As with "snprintf()", truncate the response if it would overflow "fResponseBuffer", but always '\0'-terminate it:
+  unsigned len = strlen(str);
+  unsigned const maxLen = sizeof fResponseBuffer - 1 - responseSize;
+  if (len > maxLen) len = maxLen;
+
+  memcpy(&fResponseBuffer[responseSize], str, len);
+  responseSize += len;
+  fResponseBuffer[responseSize] = '\0';
 }
 
 void RTSPServer::RTSPClientConnection
@@ -1110,6 +1116,8 @@ void RTSPServer::RTSPClientConnection
 
 ////////// RTSPServer::RTSPClientSession implementation //////////
 
+MemoryPool RTSPServer::RTSPClientSession::fMemoryPool("RTSPServer::RTSPClientSession", sizeof (RTSPServer::RTSPClientSession));
+
 RTSPServer::RTSPClientSession
 ::RTSPClientSession(RTSPServer& ourServer, u_int32_t sessionId)
   : GenericMediaServer::ClientSession(ourServer, sessionId),
@@ -1164,7 +1172,8 @@ static void parseTransportHeader(char const* buf,
 				 portNumBits& clientRTPPortNum, // if UDP
 				 portNumBits& clientRTCPPortNum, // if UDP
 				 unsigned char& rtpChannelId, // if TCP
-				 unsigned char& rtcpChannelId // if TCP
+				 unsigned char& rtcpChannelId, // if TCP
+				 Boolean& rtcpMuxRequested
 				 ) {
   // Initialize the result parameters to default values:
   streamingMode = RTP_UDP;
@@ -1174,6 +1183,7 @@ static void parseTransportHeader(char const* buf,
   clientRTPPortNum = 0;
   clientRTCPPortNum = 1;
   rtpChannelId = rtcpChannelId = 0xFF;
+  rtcpMuxRequested = False;
   
   portNumBits p1, p2;
   unsigned ttl, rtpCid, rtcpCid;
@@ -1211,6 +1221,8 @@ static void parseTransportHeader(char const* buf,
     } else if (sscanf(field, "interleaved=%u-%u", &rtpCid, &rtcpCid) == 2) {
       rtpChannelId = (unsigned char)rtpCid;
       rtcpChannelId = (unsigned char)rtcpCid;
+    } else if (_strncasecmp(field, "RTCP-mux", 8) == 0 && field[8] == '\0') {
+      rtcpMuxRequested = True;
     }
     
     fields += strlen(field);
@@ -1218,6 +1230,16 @@ static void parseTransportHeader(char const* buf,
     if (*fields == '\0' || *fields == '\r' || *fields == '\n') break;
   }
   delete[] field;
+
+  if (rtcpMuxRequested) {
+    // The client wants RTCP multiplexed with RTP (RFC 5761), so both are sent to (and received from)
+    // the client's RTP port, regardless of any second "client_port" number:
+    if (streamingMode == RTP_UDP && clientRTPPortNum != 0) {
+      clientRTCPPortNum = clientRTPPortNum;
+    } else {
+      rtcpMuxRequested = False;
+    }
+  }
 }
 
 static Boolean parsePlayNowHeader(char const* buf) {
@@ -1338,10 +1360,13 @@ void RTSPServer::RTSPClientSession
     u_int8_t clientsDestinationTTL;
     portNumBits clientRTPPortNum, clientRTCPPortNum;
     unsigned char rtpChannelId, rtcpChannelId;
-    parseTransportHeader(fullRequestStr, streamingMode, streamingModeString,
+    Boolean rtcpMuxRequested;
+    RTSPRequestHeaders const& requestHeaders = ourClientConnection->fCurrentRequestHeaders;
+    parseTransportHeader(requestHeaderToParse(requestHeaders, requestHeaders.transport, fullRequestStr),
+			 streamingMode, streamingModeString,
 			 clientsDestinationAddressStr, clientsDestinationTTL,
 			 clientRTPPortNum, clientRTCPPortNum,
-			 rtpChannelId, rtcpChannelId);
+			 rtpChannelId, rtcpChannelId, rtcpMuxRequested);
     if ((streamingMode == RTP_TCP && rtpChannelId == 0xFF) ||
 	(streamingMode != RTP_TCP && ourClientConnection->fClientOutputSocket != ourClientConnection->fClientInputSocket)) {
       // An anomolous situation, caused by a buggy client.  Either:
@@ -1361,10 +1386,11 @@ void RTSPServer::RTSPClientSession
     double rangeStart = 0.0, rangeEnd = 0.0;
     char* absStart = NULL; char* absEnd = NULL;
     Boolean startTimeIsNow;
-    if (parseRangeHeader(fullRequestStr, rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow)) {
+    if (parseRangeHeader(requestHeaderToParse(requestHeaders, requestHeaders.range, fullRequestStr),
+			 rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow)) {
       delete[] absStart; delete[] absEnd;
       fStreamAfterSETUP = True;
-    } else if (parsePlayNowHeader(fullRequestStr)) {
+    } else if (parsePlayNowHeader(requestHeaderToParse(requestHeaders, requestHeaders.playNow, fullRequestStr))) {
       fStreamAfterSETUP = True;
     } else {
       fStreamAfterSETUP = False;
@@ -1420,87 +1446,71 @@ void RTSPServer::RTSPClientSession
     } else {
       timeoutParameterString[0] = '\0';
     }
+    char const* transportProtocolStr = NULL; // if this remains NULL, we can't use the requested transport
+    char transportParamsStr[200];
     if (fIsMulticast) {
       switch (streamingMode) {
           case RTP_UDP: {
-	    snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
-		     "RTSP/1.0 200 OK\r\n"
-		     "CSeq: %s\r\n"
-		     "%s"
-		     "Transport: RTP/AVP;multicast;destination=%s;source=%s;port=%d-%d;ttl=%d\r\n"
-		     "Session: %08X%s\r\n\r\n",
-		     ourClientConnection->fCurrentCSeq,
-		     dateHeader(),
-		     destAddrStr.val(), sourceAddrStr.val(), ntohs(serverRTPPort.num()), ntohs(serverRTCPPort.num()), destinationTTL,
-		     fOurSessionId, timeoutParameterString);
+	    transportProtocolStr = "RTP/AVP";
+	    snprintf(transportParamsStr, sizeof transportParamsStr,
+		     ";multicast;destination=%s;source=%s;port=%d-%d;ttl=%d",
+		     destAddrStr.val(), sourceAddrStr.val(), ntohs(serverRTPPort.num()), ntohs(serverRTCPPort.num()), destinationTTL);
 	    break;
 	  }
           case RTP_TCP: {
 	    // multicast streams can't be sent via TCP
-	    ourClientConnection->handleCmd_unsupportedTransport();
 	    break;
 	  }
           case RAW_UDP: {
-	    snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
-		     "RTSP/1.0 200 OK\r\n"
-		     "CSeq: %s\r\n"
-		     "%s"
-		     "Transport: %s;multicast;destination=%s;source=%s;port=%d;ttl=%d\r\n"
-		     "Session: %08X%s\r\n\r\n",
-		     ourClientConnection->fCurrentCSeq,
-		     dateHeader(),
-		     streamingModeString, destAddrStr.val(), sourceAddrStr.val(), ntohs(serverRTPPort.num()), destinationTTL,
-		     fOurSessionId, timeoutParameterString);
+	    transportProtocolStr = streamingModeString;
+	    snprintf(transportParamsStr, sizeof transportParamsStr,
+		     ";multicast;destination=%s;source=%s;port=%d;ttl=%d",
+		     destAddrStr.val(), sourceAddrStr.val(), ntohs(serverRTPPort.num()), destinationTTL);
 	    break;
 	  }
       }
     } else {
       switch (streamingMode) {
           case RTP_UDP: {
-	    snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
-		     "RTSP/1.0 200 OK\r\n"
-		     "CSeq: %s\r\n"
-		     "%s"
-		     "Transport: RTP/AVP;unicast;destination=%s;source=%s;client_port=%d-%d;server_port=%d-%d\r\n"
-		     "Session: %08X%s\r\n\r\n",
-		     ourClientConnection->fCurrentCSeq,
-		     dateHeader(),
+	    transportProtocolStr = "RTP/AVP";
+	    snprintf(transportParamsStr, sizeof transportParamsStr,
+		     ";unicast;destination=%s;source=%s;client_port=%d-%d;server_port=%d-%d%s",
 		     destAddrStr.val(), sourceAddrStr.val(), ntohs(clientRTPPort.num()), ntohs(clientRTCPPort.num()), ntohs(serverRTPPort.num()), ntohs(serverRTCPPort.num()),
-		     fOurSessionId, timeoutParameterString);
+		     rtcpMuxRequested && serverRTCPPort.num() == serverRTPPort.num() ? ";RTCP-mux" : "");
 	    break;
 	  }
           case RTP_TCP: {
-	    if (!fOurRTSPServer.fAllowStreamingRTPOverTCP) {
-	      ourClientConnection->handleCmd_unsupportedTransport();
-	    } else {
-	      snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
-		       "RTSP/1.0 200 OK\r\n"
-		       "CSeq: %s\r\n"
-		       "%s"
-		       "Transport: RTP/AVP/TCP;unicast;destination=%s;source=%s;interleaved=%d-%d\r\n"
-		       "Session: %08X%s\r\n\r\n",
-		       ourClientConnection->fCurrentCSeq,
-		       dateHeader(),
-		       destAddrStr.val(), sourceAddrStr.val(), rtpChannelId, rtcpChannelId,
-		       fOurSessionId, timeoutParameterString);
+	    if (fOurRTSPServer.fAllowStreamingRTPOverTCP) {
+	      transportProtocolStr = "RTP/AVP/TCP";
+	      snprintf(transportParamsStr, sizeof transportParamsStr,
+		       ";unicast;destination=%s;source=%s;interleaved=%d-%d",
+		       destAddrStr.val(), sourceAddrStr.val(), rtpChannelId, rtcpChannelId);
 	    }
 	    break;
 	  }
           case RAW_UDP: {
-	    snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
-		     "RTSP/1.0 200 OK\r\n"
-		     "CSeq: %s\r\n"
-		     "%s"
-		     "Transport: %s;unicast;destination=%s;source=%s;client_port=%d;server_port=%d\r\n"
-		     "Session: %08X%s\r\n\r\n",
-		     ourClientConnection->fCurrentCSeq,
-		     dateHeader(),
-		     streamingModeString, destAddrStr.val(), sourceAddrStr.val(), ntohs(clientRTPPort.num()), ntohs(serverRTPPort.num()),
-		     fOurSessionId, timeoutParameterString);
+	    transportProtocolStr = streamingModeString;
+	    snprintf(transportParamsStr, sizeof transportParamsStr,
+		     ";unicast;destination=%s;source=%s;client_port=%d;server_port=%d",
+		     destAddrStr.val(), sourceAddrStr.val(), ntohs(clientRTPPort.num()), ntohs(serverRTPPort.num()));
 	    break;
 	  }
       }
     }
+
+    if (transportProtocolStr == NULL) {
+      ourClientConnection->handleCmd_unsupportedTransport();
+    } else {
+      unsigned responseSize = ourClientConnection->setRTSPResponseHead("200 OK");
+      ourClientConnection->appendToRTSPResponse(responseSize, "Transport: ");
+      ourClientConnection->appendToRTSPResponse(responseSize, transportProtocolStr);
+      ourClientConnection->appendToRTSPResponse(responseSize, transportParamsStr);
+      char sessionHeader[30];
+      sprintf(sessionHeader, "\r\nSession: %08X", fOurSessionId);
+      ourClientConnection->appendToRTSPResponse(responseSize, sessionHeader);
+      ourClientConnection->appendToRTSPResponse(responseSize, timeoutParameterString);
+      ourClientConnection->appendToRTSPResponse(responseSize, "\r\n\r\n");
+    }
     delete[] streamingModeString;
   } while (0);
   
@@ -1594,8 +1604,11 @@ void RTSPServer::RTSPClientSession
       break;
     }
   }
+  UsageEnvironment& env = envir(); // alias, in case we get deleted
   if (noSubsessionsRemain) delete this;
   std::cout << "Streaming complete." << std::endl;
+  // Report the per-client objects that are still live (which, at this point, would be leaks):
+  if (MemoryPool::accountingIsEnabled()) MemoryPool::printStatistics(env);
   exit(0);
 }
 
@@ -1607,8 +1620,10 @@ void RTSPServer::RTSPClientSession
   unsigned rtspURLSize = strlen(rtspURL);
   
   // Parse the client's "Scale:" header, if any:
+  RTSPRequestHeaders const& requestHeaders = ourClientConnection->fCurrentRequestHeaders;
   float scale;
-  Boolean sawScaleHeader = parseScaleHeader(fullRequestStr, scale);
+  Boolean sawScaleHeader
+    = parseScaleHeader(requestHeaderToParse(requestHeaders, requestHeaders.scale, fullRequestStr), scale);
   
   // Try to set the stream's scale factor to this value:
   if (subsession == NULL /*aggregate op*/) {
@@ -1632,7 +1647,8 @@ void RTSPServer::RTSPClientSession
   char* absStart = NULL; char* absEnd = NULL;
   Boolean startTimeIsNow;
   Boolean sawRangeHeader
-    = parseRangeHeader(fullRequestStr, rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow);
+    = parseRangeHeader(requestHeaderToParse(requestHeaders, requestHeaders.range, fullRequestStr),
+		       rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow);
   
   if (sawRangeHeader && absStart == NULL/*not seeking by 'absolute' time*/) {
     // Use this information, plus the stream's duration (if known), to create our own "Range:" header, for the response:
@@ -1792,20 +1808,14 @@ void RTSPServer::RTSPClientSession
   }
   
   // Fill in the response:
-  snprintf((char*)ourClientConnection->fResponseBuffer, sizeof ourClientConnection->fResponseBuffer,
-	   "RTSP/1.0 200 OK\r\n"
-	   "CSeq: %s\r\n"
-	   "%s"
-	   "%s"
-	   "%s"
-	   "Session: %08X\r\n"
-	   "%s\r\n",
-	   ourClientConnection->fCurrentCSeq,
-	   dateHeader(),
-	   scaleHeader,
-	   rangeHeader,
-	   fOurSessionId,
-	   rtpInfo);
+  unsigned responseSize = ourClientConnection->setRTSPResponseHead("200 OK");
+  ourClientConnection->appendToRTSPResponse(responseSize, scaleHeader);
+  ourClientConnection->appendToRTSPResponse(responseSize, rangeHeader);
+  char sessionHeader[30];
+  sprintf(sessionHeader, "Session: %08X\r\n", fOurSessionId);
+  ourClientConnection->appendToRTSPResponse(responseSize, sessionHeader);
+  ourClientConnection->appendToRTSPResponse(responseSize, rtpInfo);
+  ourClientConnection->appendToRTSPResponse(responseSize, "\r\n");
   delete[] rtpInfo; delete[] rangeHeader;
   delete[] scaleHeader; delete[] rtspURL;
 }
@@ -129,18 +129,13 @@ void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStream
       }
       
       // Construct our response:
-      snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	       "HTTP/1.1 200 OK\r\n"
-	       "%s"
-	       "Server: LIVE555 Streaming Media v%s\r\n"
-	       "%s"
-	       "Content-Length: %d\r\n"
-	       "Content-Type: text/plain; charset=ISO-8859-1\r\n"
-	       "\r\n",
-	       dateHeader(),
-	       LIVEMEDIA_LIBRARY_VERSION_STRING,
-	       lastModifiedHeader(streamName),
-	       numTSBytesToStream);
+      unsigned responseSize = setHTTPResponseHead("200 OK");
+      appendToRTSPResponse(responseSize, "Server: LIVE555 Streaming Media v" LIVEMEDIA_LIBRARY_VERSION_STRING "\r\n");
+      appendToRTSPResponse(responseSize, lastModifiedHeader(streamName));
+      char contentLengthHeader[40];
+      sprintf(contentLengthHeader, "Content-Length: %d\r\n", numTSBytesToStream);
+      appendToRTSPResponse(responseSize, contentLengthHeader);
+      appendToRTSPResponse(responseSize, "Content-Type: text/plain; charset=ISO-8859-1\r\n\r\n");
       // Send the response now, because we're about to add more data (from the source):
       send(fClientOutputSocket, (char const*)fResponseBuffer, strlen((char*)fResponseBuffer), 0);
       fResponseBuffer[0] = '\0'; // We've already sent the response.  This tells the calling code not to send it again.
@@ -226,18 +221,13 @@ void RTSPServerSupportingHTTPStreaming::RTSPClientConnectionSupportingHTTPStream
   unsigned playlistLen = s - playlist;
 
   // Construct our response:
-  snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-	   "HTTP/1.1 200 OK\r\n"
-	   "%s"
-	   "Server: LIVE555 Streaming Media v%s\r\n"
-	   "%s"
-	   "Content-Length: %d\r\n"
-	   "Content-Type: application/vnd.apple.mpegurl\r\n"
-	   "\r\n",
-	   dateHeader(),
-	   LIVEMEDIA_LIBRARY_VERSION_STRING,
-	   lastModifiedHeader(urlSuffix),
-	   playlistLen);
+  unsigned responseSize = setHTTPResponseHead("200 OK");
+  appendToRTSPResponse(responseSize, "Server: LIVE555 Streaming Media v" LIVEMEDIA_LIBRARY_VERSION_STRING "\r\n");
+  appendToRTSPResponse(responseSize, lastModifiedHeader(urlSuffix));
+  char contentLengthHeader[40];
+  sprintf(contentLengthHeader, "Content-Length: %d\r\n", playlistLen);
+  appendToRTSPResponse(responseSize, contentLengthHeader);
+  appendToRTSPResponse(responseSize, "Content-Type: application/vnd.apple.mpegurl\r\n\r\n");
 
   // Send the response header now, because we're about to add more data (the playlist):
   send(fClientOutputSocket, (char const*)fResponseBuffer, strlen((char*)fResponseBuffer), 0);
@@ -0,0 +1,142 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2018 Live Networks, Inc.  All rights reserved.
+// A cache of the SDP lines that describe server media subsessions, optionally backed by a file
+// Implementation
+
+#include "SDPCache.hh"
+#include "ServerMediaSession.hh"
+#include <string.h>
+
+// Each entry in the cache file has the form
+//   <key length> <SDP lines length>\n<key><SDP lines>\n
+// Entries are only ever appended; when the file is read, later entries override earlier ones.
+
+SDPCache* SDPCache::createNew(UsageEnvironment& env, char const* cacheFileName) {
+  return new SDPCache(env, cacheFileName);
+}
+
+SDPCache* SDPCache::ourCache(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env, False);
+  if (ourTables == NULL) return NULL;
+
+  return (SDPCache*)(ourTables->sdpCache);
+}
+
+SDPCache::SDPCache(UsageEnvironment& env, char const* cacheFileName)
+  : Medium(env),
+    fTable(HashTable::create(STRING_HASH_KEYS)),
+    fCacheFileName(strDup(cacheFileName)), fCacheFid(NULL),
+    fNumHits(0), fNumMisses(0) {
+  if (fCacheFileName != NULL) {
+    loadFromFile();
+
+    fCacheFid = fopen(fCacheFileName, "ab");
+    if (fCacheFid == NULL) {
+      env << "SDPCache: Failed to open \"" << fCacheFileName << "\" for appending\n";
+    }
+  }
+
+  // Replace any existing cache with ourself:
+  _Tables* ourTables = _Tables::getOurTables(env);
+  SDPCache* oldCache = (SDPCache*)(ourTables->sdpCache);
+  ourTables->sdpCache = this;
+  if (oldCache != NULL) Medium::close(oldCache);
+}
+
+SDPCache::~SDPCache() {
+  _Tables* ourTables = _Tables::getOurTables(envir(), False);
+  if (ourTables != NULL && ourTables->sdpCache == this) {
+    ourTables->sdpCache = NULL;
+    ourTables->reclaimIfPossible();
+  }
+
+  if (fCacheFid != NULL) fclose(fCacheFid);
+  delete[] fCacheFileName;
+
+  char* sdpLines;
+  while ((sdpLines = (char*)fTable->RemoveNext()) != NULL) {
+    delete[] sdpLines;
+  }
+  delete fTable;
+}
+
+char const* SDPCache::lookup(char const* key) const {
+  if (key == NULL) return NULL;
+
+  char const* result = (char const*)(fTable->Lookup(key));
+  if (result != NULL) ++fNumHits; else ++fNumMisses;
+
+  return result;
+}
+
+void SDPCache::add(char const* key, char const* sdpLines) {
+  if (key == NULL || sdpLines == NULL) return;
+
+  char const* existingSDPLines = (char const*)(fTable->Lookup(key));
+  if (existingSDPLines != NULL && strcmp(existingSDPLines, sdpLines) == 0) return; // nothing new
+
+  addToTable(key, sdpLines);
+
+  if (fCacheFid != NULL) {
+    unsigned keyLen = strlen(key);
+    unsigned sdpLinesLen = strlen(sdpLines);
+    fprintf(fCacheFid, "%u %u\n", keyLen, sdpLinesLen);
+    fwrite(key, 1, keyLen, fCacheFid);
+    fwrite(sdpLines, 1, sdpLinesLen, fCacheFid);
+    fputc('\n', fCacheFid);
+    fflush(fCacheFid);
+  }
+}
+
+void SDPCache::prewarm(ServerMediaSession& sms) {
+  // Generating the session's SDP description causes each subsession's SDP lines to be computed
+  // (and, for "OnDemandServerMediaSubsession"s, added to the cache):
+  char* sdpDescription = sms.generateSDPDescription();
+  delete[] sdpDescription;
+}
+
+void SDPCache::loadFromFile() {
+  FILE* fid = fopen(fCacheFileName, "rb");
+  if (fid == NULL) return; // the file doesn't exist yet
+
+  unsigned keyLen, sdpLinesLen;
+  while (fscanf(fid, "%u %u", &keyLen, &sdpLinesLen) == 2 && fgetc(fid) == '\n') {
+    if (keyLen == 0 || keyLen > 10000 || sdpLinesLen > 100000) break; // sanity check
+
+    char* key = new char[keyLen+1];
+    char* sdpLines = new char[sdpLinesLen+1];
+    Boolean ok
+      = fread(key, 1, keyLen, fid) == keyLen
+      && fread(sdpLines, 1, sdpLinesLen, fid) == sdpLinesLen
+      && fgetc(fid) == '\n';
+    if (ok) {
+      key[keyLen] = '\0';
+      sdpLines[sdpLinesLen] = '\0';
+      addToTable(key, sdpLines);
+    }
+    delete[] key; delete[] sdpLines;
+    if (!ok) break; // the file was truncated
+  }
+
+  fclose(fid);
+}
+
+void SDPCache::addToTable(char const* key, char const* sdpLines) {
+  char* oldSDPLines = (char*)(fTable->Add(key, strDup(sdpLines)));
+  delete[] oldSDPLines;
+}
@@ -0,0 +1,140 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2018 Live Networks, Inc.  All rights reserved.
+// A pool of server port numbers (even/odd pairs, for RTP and RTCP)
+// Implementation
+
+#include "ServerPortPool.hh"
+
+ServerPortPool* ServerPortPool
+::createNew(UsageEnvironment& env, portNumBits firstPortNum, unsigned numPortPairs) {
+  return new ServerPortPool(env, firstPortNum, numPortPairs);
+}
+
+ServerPortPool* ServerPortPool::ourPool(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env, False);
+  if (ourTables == NULL) return NULL;
+
+  return (ServerPortPool*)(ourTables->serverPortPool);
+}
+
+ServerPortPool* ServerPortPool::useOurPool(UsageEnvironment& env, portNumBits firstPortNum) {
+  ServerPortPool* pool = ourPool(env);
+  if (pool == NULL) {
+    pool = new ServerPortPool(env, firstPortNum, SERVER_PORT_POOL_DEFAULT_NUM_PAIRS);
+    pool->fCloseWhenUnused = True;
+  }
+
+  ++pool->fNumUsers;
+  return pool;
+}
+
+void ServerPortPool::stopUsingOurPool(UsageEnvironment& env) {
+  ServerPortPool* pool = ourPool(env);
+  if (pool == NULL || pool->fNumUsers == 0) return;
+
+  if (--pool->fNumUsers == 0 && pool->fCloseWhenUnused) Medium::close(pool);
+}
+
+ServerPortPool::ServerPortPool(UsageEnvironment& env, portNumBits firstPortNum, unsigned numPortPairs)
+  : Medium(env),
+    fFirstPortNum(0), fNumPortPairs(numPortPairs), fNextPair(0),
+    fNumAllocated(0), fPeakNumAllocated(0),
+    fNumAllocations(0), fNumExhaustions(0), fNumBindFailures(0),
+    fNumUsers(0), fCloseWhenUnused(False) {
+  // Begin at an even port number, and don't go past the last (16-bit) port number.
+  // (If "firstPortNum" is 65535, then there's no room for any pairs, so we're empty.)
+  unsigned const firstEvenPortNum = ((unsigned)firstPortNum+1)&~1;
+  unsigned const maxNumPortPairs = (0x10000 - firstEvenPortNum)/2;
+  if (fNumPortPairs > maxNumPortPairs) fNumPortPairs = maxNumPortPairs;
+  if (fNumPortPairs > 0) fFirstPortNum = firstEvenPortNum;
+  fNumWords = (fNumPortPairs+31)/32;
+
+  fInUse = new u_int32_t[fNumWords];
+  for (unsigned i = 0; i < fNumWords; ++i) fInUse[i] = 0;
+  // Mark any bits past the end of the last word as 'in use', so that we never allocate them:
+  if (fNumPortPairs%32 != 0) fInUse[fNumWords-1] = ~(u_int32_t)0 << (fNumPortPairs%32);
+
+  // Replace any existing pool with ourself (taking over its users):
+  _Tables* ourTables = _Tables::getOurTables(env);
+  ServerPortPool* oldPool = (ServerPortPool*)(ourTables->serverPortPool);
+  ourTables->serverPortPool = this;
+  if (oldPool != NULL) {
+    fNumUsers = oldPool->fNumUsers;
+    Medium::close(oldPool);
+  }
+}
+
+ServerPortPool::~ServerPortPool() {
+  _Tables* ourTables = _Tables::getOurTables(envir(), False);
+  if (ourTables != NULL && ourTables->serverPortPool == this) {
+    ourTables->serverPortPool = NULL;
+    ourTables->reclaimIfPossible();
+  }
+
+  delete[] fInUse;
+}
+
+static unsigned lowestZeroBit(u_int32_t word) {
+  // Assumes that "word" has at least one zero bit
+#if defined(__GNUC__)
+  return __builtin_ctz(~word);
+#else
+  unsigned bit = 0;
+  while ((word&1) != 0) { word >>= 1; ++bit; }
+  return bit;
+#endif
+}
+
+portNumBits ServerPortPool::allocate() {
+  if (fNumAllocated >= fNumPortPairs) {
+    ++fNumExhaustions;
+    return 0;
+  }
+
+  // Find the first free pair at or after "fNextPair", wrapping around if necessary.  (Because the pool
+  // is not full, there must be one.)  Because each search begins where the previous one ended, it
+  // usually ends within the first word, and a just-released pair (e.g., one whose ports failed to bind)
+  // isn't handed out again until we've cycled through the rest of the pool:
+  unsigned wordNum = fNextPair/32;
+  u_int32_t word = fInUse[wordNum] | (((u_int32_t)1 << (fNextPair%32)) - 1);
+      // (treat the pairs before "fNextPair" in this word as being in use, for now)
+  while (word == ~(u_int32_t)0) {
+    if (++wordNum == fNumWords) wordNum = 0;
+    word = fInUse[wordNum];
+  }
+
+  unsigned pairNum = wordNum*32 + lowestZeroBit(word);
+  fInUse[wordNum] |= (u_int32_t)1 << (pairNum%32);
+  fNextPair = pairNum+1 < fNumPortPairs ? pairNum+1 : 0;
+
+  ++fNumAllocations;
+  if (++fNumAllocated > fPeakNumAllocated) fPeakNumAllocated = fNumAllocated;
+
+  return fFirstPortNum + 2*pairNum;
+}
+
+void ServerPortPool::release(portNumBits portNum) {
+  if (!contains(portNum)) return;
+
+  unsigned pairNum = (portNum - fFirstPortNum)/2;
+  u_int32_t mask = (u_int32_t)1 << (pairNum%32);
+  if ((fInUse[pairNum/32]&mask) == 0) return; // not allocated
+
+  fInUse[pairNum/32] &= ~mask;
+  --fNumAllocated;
+}
@@ -0,0 +1,212 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2018 Live Networks, Inc.  All rights reserved.
+// A single UDP socket that's shared by many RTP (and multiplexed RTCP) streams
+// Implementation
+
+#include "SharedRTPSocket.hh"
+#include <GroupsockHelper.hh>
+
+static unsigned const maxIncomingPacketSize = 1500;
+
+class RTCPInstanceRecord {
+public:
+  RTCPInstanceRecord(struct in_addr const& fromAddr, Port const& fromPort, RTCPInstance* rtcpInstance, u_int32_t ourSSRC)
+    : fFromAddr(fromAddr), fFromPort(fromPort), fRTCPInstance(rtcpInstance), fOurSSRC(ourSSRC), fNext(NULL) {
+  }
+
+  struct in_addr fFromAddr;
+  Port fFromPort;
+  RTCPInstance* fRTCPInstance;
+  u_int32_t fOurSSRC; // 0 if not known
+  RTCPInstanceRecord* fNext; // used only when deregistering
+};
+
+// An entry in our SSRC table.  (Several clients - each with their own "RTCPInstanceRecord" - can share
+// a stream, and thus its SSRC, so we count them.)
+class SSRCRecord {
+public:
+  SSRCRecord(RTCPInstance* rtcpInstance)
+    : fRTCPInstance(rtcpInstance), fNumRegistrations(0) {
+  }
+
+  RTCPInstance* fRTCPInstance;
+  unsigned fNumRegistrations;
+};
+
+SharedRTPSocket* SharedRTPSocket::createNew(UsageEnvironment& env, Port port) {
+  struct in_addr dummyAddr; dummyAddr.s_addr = 0;
+  Groupsock* gs = new Groupsock(env, dummyAddr, port, 255);
+  if (gs->socketNum() < 0) {
+    delete gs;
+    return NULL;
+  }
+
+  return new SharedRTPSocket(env, gs);
+}
+
+SharedRTPSocket::SharedRTPSocket(UsageEnvironment& env, Groupsock* gs)
+  : Medium(env), fGS(gs), fRTCPInstances(new AddressPortLookupTable),
+    fRTCPInstancesBySSRC(HashTable::create(ONE_WORD_HASH_KEYS)),
+    fInBuf(new unsigned char[maxIncomingPacketSize]),
+    fNumRegistrations(0), fNumPacketsDemultiplexed(0), fNumPacketsDemultiplexedBySSRC(0), fNumPacketsUnmatched(0) {
+  fGS->removeAllDestinations(); // each of our streams has its own destinations
+
+  // Because this socket carries the traffic of all of our streams, give it large buffers:
+  increaseSendBufferTo(env, fGS->socketNum(), 1024*1024);
+  increaseReceiveBufferTo(env, fGS->socketNum(), 256*1024);
+
+  // We alone read from this socket, giving each incoming (RTCP) packet to the appropriate "RTCPInstance":
+  envir().taskScheduler().turnOnBackgroundReadHandling(fGS->socketNum(),
+	(TaskScheduler::BackgroundHandlerProc*)&incomingPacketHandler, this);
+}
+
+SharedRTPSocket::~SharedRTPSocket() {
+  envir().taskScheduler().turnOffBackgroundReadHandling(fGS->socketNum());
+
+  RTCPInstanceRecord* record;
+  while ((record = (RTCPInstanceRecord*)fRTCPInstances->RemoveNext()) != NULL) {
+    delete record; // note: we don't own the "RTCPInstance"s themselves
+  }
+  delete fRTCPInstances;
+  SSRCRecord* ssrcRecord;
+  while ((ssrcRecord = (SSRCRecord*)fRTCPInstancesBySSRC->RemoveNext()) != NULL) {
+    delete ssrcRecord;
+  }
+  delete fRTCPInstancesBySSRC;
+  delete[] fInBuf;
+  delete fGS;
+}
+
+Groupsock* SharedRTPSocket::createGroupsock(struct in_addr const& addr) {
+  return new Groupsock(envir(), addr, fGS->port(), 255, fGS->socketNum());
+}
+
+void SharedRTPSocket
+::registerRTCPInstance(struct in_addr const& fromAddr, Port const& fromPort, RTCPInstance* rtcpInstance,
+		       u_int32_t ourSSRC) {
+  // Replace any existing registration for this address and port:
+  deregisterRTCPInstance(fromAddr, fromPort);
+
+  fRTCPInstances->Add(fromAddr.s_addr, (~0), fromPort, new RTCPInstanceRecord(fromAddr, fromPort, rtcpInstance, ourSSRC));
+  ++fNumRegistrations;
+
+  if (ourSSRC != 0) {
+    SSRCRecord* ssrcRecord = (SSRCRecord*)(fRTCPInstancesBySSRC->Lookup((char const*)(long)ourSSRC));
+    if (ssrcRecord == NULL) {
+      ssrcRecord = new SSRCRecord(rtcpInstance);
+      fRTCPInstancesBySSRC->Add((char const*)(long)ourSSRC, ssrcRecord);
+    }
+    ssrcRecord->fRTCPInstance = rtcpInstance;
+    ++ssrcRecord->fNumRegistrations;
+  }
+}
+
+void SharedRTPSocket::deregisterRTCPInstance(struct in_addr const& fromAddr, Port const& fromPort) {
+  RTCPInstanceRecord* record = (RTCPInstanceRecord*)(fRTCPInstances->Lookup(fromAddr.s_addr, (~0), fromPort));
+  if (record == NULL) return;
+
+  if (record->fOurSSRC != 0) {
+    SSRCRecord* ssrcRecord = (SSRCRecord*)(fRTCPInstancesBySSRC->Lookup((char const*)(long)record->fOurSSRC));
+    if (ssrcRecord != NULL && --ssrcRecord->fNumRegistrations == 0) {
+      fRTCPInstancesBySSRC->Remove((char const*)(long)record->fOurSSRC);
+      delete ssrcRecord;
+    }
+  }
+
+  fRTCPInstances->Remove(fromAddr.s_addr, (~0), fromPort);
+  delete record;
+  --fNumRegistrations;
+}
+
+void SharedRTPSocket::deregisterRTCPInstance(RTCPInstance* rtcpInstance) {
+  // First, collect the records for "rtcpInstance" (because we can't remove them while iterating):
+  RTCPInstanceRecord* recordsToRemove = NULL;
+  AddressPortLookupTable::Iterator iter(*fRTCPInstances);
+  RTCPInstanceRecord* record;
+  while ((record = (RTCPInstanceRecord*)iter.next()) != NULL) {
+    if (record->fRTCPInstance == rtcpInstance) {
+      record->fNext = recordsToRemove;
+      recordsToRemove = record;
+    }
+  }
+
+  // Then remove them:
+  while (recordsToRemove != NULL) {
+    record = recordsToRemove;
+    recordsToRemove = record->fNext;
+    deregisterRTCPInstance(record->fFromAddr, record->fFromPort);
+  }
+}
+
+void SharedRTPSocket::incomingPacketHandler(SharedRTPSocket* sharedSocket, int /*mask*/) {
+  sharedSocket->incomingPacketHandler1();
+}
+
+void SharedRTPSocket::incomingPacketHandler1() {
+  struct sockaddr_in fromAddress;
+  int bytesRead = readSocket(envir(), fGS->socketNum(), fInBuf, maxIncomingPacketSize, fromAddress);
+  if (bytesRead <= 0) return;
+
+  RTCPInstance* rtcpInstance;
+  RTCPInstanceRecord* record
+    = (RTCPInstanceRecord*)(fRTCPInstances->Lookup(fromAddress.sin_addr.s_addr, (~0), Port(ntohs(fromAddress.sin_port))));
+  if (record != NULL) {
+    rtcpInstance = record->fRTCPInstance;
+  } else {
+    // The packet didn't come from a registered address and port, but it might still report on one of our streams:
+    rtcpInstance = lookupBySSRC(fInBuf, (unsigned)bytesRead);
+    if (rtcpInstance == NULL) {
+      // The packet came from an unknown (or no longer active) client; ignore it:
+      ++fNumPacketsUnmatched;
+      return;
+    }
+    ++fNumPacketsDemultiplexedBySSRC;
+  }
+
+  ++fNumPacketsDemultiplexed;
+  rtcpInstance->injectReport(fInBuf, (unsigned)bytesRead, fromAddress);
+}
+
+RTCPInstance* SharedRTPSocket::lookupBySSRC(u_int8_t const* packet, unsigned packetSize) {
+  // Look (in each RTCP packet in this compound packet) for the SSRC of one of our streams: in the first
+  // report block of a SR or RR, or as the 'media source' of a RTPFB or PSFB feedback message:
+  while (packetSize >= 4) {
+    u_int32_t rtcpHdr = (packet[0]<<24)|(packet[1]<<16)|(packet[2]<<8)|packet[3];
+    if ((rtcpHdr & 0xC0000000) != 0x80000000) break; // not a RTCP (version 2) packet
+    unsigned length = 4*((rtcpHdr&0xFFFF) + 1);
+    if (length > packetSize) break;
+
+    unsigned char const pt = (rtcpHdr>>16)&0xFF;
+    unsigned const rc = (rtcpHdr>>24)&0x1F; // report count (or, for feedback messages, FMT)
+    unsigned ssrcOffset = 0;
+    if (pt == RTCP_PT_SR && rc > 0) ssrcOffset = 28; // after the header, sender SSRC, and sender info
+    else if (pt == RTCP_PT_RR && rc > 0) ssrcOffset = 8; // after the header, and sender SSRC
+    else if (pt == RTCP_PT_RTPFB || pt == RTCP_PT_PSFB) ssrcOffset = 8; // after the header, and sender SSRC
+
+    if (ssrcOffset > 0 && ssrcOffset + 4 <= length) {
+      u_int8_t const* p = &packet[ssrcOffset];
+      u_int32_t ssrc = (p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3];
+      SSRCRecord* ssrcRecord = (SSRCRecord*)(fRTCPInstancesBySSRC->Lookup((char const*)(long)ssrc));
+      if (ssrcRecord != NULL) return ssrcRecord->fRTCPInstance;
+    }
+
+    packet += length; packetSize -= length;
+  }
+
+  return NULL;
+}
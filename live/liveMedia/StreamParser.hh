@@ -99,6 +99,10 @@ protected: // we're a virtual base class
 
   unsigned curOffset() const { return fCurParserIndex; }
 
+  // The bytes that can be parsed without having to read more input (useful for 'fast path' parsing):
+  unsigned numBufferedBytes() const { return fTotNumValidBytes - fCurParserIndex; }
+  unsigned char const* bufferedBytes() const { return &fCurBank[fCurParserIndex]; }
+
   unsigned& totNumValidBytes() { return fTotNumValidBytes; }
 
   Boolean haveSeenEOF() const { return fHaveSeenEOF; }
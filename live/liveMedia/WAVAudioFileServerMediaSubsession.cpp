@@ -226,3 +226,7 @@ void WAVAudioFileServerMediaSubsession::testScaleFactor(float& scale) {
 float WAVAudioFileServerMediaSubsession::duration() const {
   return fFileDuration;
 }
+
+char* WAVAudioFileServerMediaSubsession::sdpCacheKey() {
+  return NULL; // because "fFileDuration" gets set only when we create a source
+}
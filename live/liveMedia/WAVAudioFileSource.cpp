@@ -108,8 +108,9 @@ static Boolean skipBytes(FILE* fid, int num) {
 
 WAVAudioFileSource::WAVAudioFileSource(UsageEnvironment& env, FILE* fid)
   : AudioInputDevice(env, 0, 0, 0, 0)/* set the real parameters later */,
-    fFid(fid), fFidIsSeekable(False), fLastPlayTime(0), fHaveStartedReading(False), fWAVHeaderSize(0), fFileSize(0),
-    fScaleFactor(1), fLimitNumBytesToStream(False), fNumBytesToStream(0), fAudioFormat(WA_UNKNOWN) {
+    fPreferredFrameSize(0), fFid(fid), fFidIsSeekable(False), fLastPlayTime(0), fHaveStartedReading(False), fWAVHeaderSize(0), fFileSize(0),
+    fScaleFactor(1), fLimitNumBytesToStream(False), fNumBytesToStream(0), fAudioFormat(WA_UNKNOWN),
+    fTrickPlayBuffer(NULL), fTrickPlayBufferSize(0) {
   // Check the WAV file header for validity.
   // Note: The following web pages contain info about the WAV format:
   // http://www.ringthis.com/dev/wave_format.htm
@@ -224,6 +225,7 @@ WAVAudioFileSource::WAVAudioFileSource(UsageEnvironment& env, FILE* fid)
 }
 
 WAVAudioFileSource::~WAVAudioFileSource() {
+  delete[] fTrickPlayBuffer;
   if (fFid == NULL) return;
 
 #ifndef READ_FROM_FILES_SYNCHRONOUSLY
@@ -233,6 +235,10 @@ WAVAudioFileSource::~WAVAudioFileSource() {
   CloseInputFile(fFid);
 }
 
+unsigned WAVAudioFileSource::maxFrameSize() const {
+  return fPreferredFrameSize; // we never deliver more than this
+}
+
 void WAVAudioFileSource::doGetNextFrame() {
   if (feof(fFid) || ferror(fFid) || (fLimitNumBytesToStream && fNumBytesToStream == 0)) {
     handleClosure();
@@ -279,10 +285,13 @@ void WAVAudioFileSource::doReadFromFile() {
   unsigned bytesPerSample = (fNumChannels*fBitsPerSample)/8;
   if (bytesPerSample == 0) bytesPerSample = 1; // because we can't read less than a byte at a time
 
-  // For 'trick play', read one sample at a time; otherwise (normal case) read samples in bulk:
-  unsigned bytesToRead = fScaleFactor == 1 ? fMaxSize - fMaxSize%bytesPerSample : bytesPerSample;
   unsigned numBytesRead;
-  while (1) { // loop for 'trick play' only
+  if (fScaleFactor != 1) {
+    // 'Trick play' (which we do only on seekable files):
+    numBytesRead = readScaledSamples(bytesPerSample);
+  } else {
+    // Normal case: read samples in bulk:
+    unsigned bytesToRead = fMaxSize - fMaxSize%bytesPerSample;
 #ifdef READ_FROM_FILES_SYNCHRONOUSLY
     numBytesRead = fread(fTo, 1, bytesToRead, fFid);
 #else
@@ -293,29 +302,20 @@ void WAVAudioFileSource::doReadFromFile() {
       numBytesRead = read(fileno(fFid), fTo, bytesToRead);
     }
 #endif
-    if (numBytesRead == 0) {
-     handleClosure();
-      return;
-    }
-    fFrameSize += numBytesRead;
-    fTo += numBytesRead;
-    fMaxSize -= numBytesRead;
-    fNumBytesToStream -= numBytesRead;
+  }
+  if (numBytesRead == 0) {
+    handleClosure();
+    return;
+  }
+  fFrameSize += numBytesRead;
+  fTo += numBytesRead;
+  fMaxSize -= numBytesRead;
+  fNumBytesToStream -= numBytesRead;
 
-    // If we did an asynchronous read, and didn't read an integral number of samples, then we need to wait for another read:
+  // If we did an asynchronous read, and didn't read an integral number of samples, then we need to wait for another read:
 #ifndef READ_FROM_FILES_SYNCHRONOUSLY
-    if (fFrameSize%bytesPerSample > 0) return;
+  if (fFrameSize%bytesPerSample > 0) return;
 #endif
-    
-    // If we're doing 'trick play', then seek to the appropriate place for reading the next sample,
-    // and keep reading until we fill the provided buffer:
-    if (fScaleFactor != 1) {
-      SeekFile64(fFid, (fScaleFactor-1)*bytesPerSample, SEEK_CUR);
-      if (fMaxSize < bytesPerSample) break;
-    } else {
-      break; // from the loop (normal case)
-    }
-  }
 
   // Set the 'presentation time' and 'duration' of this frame:
   if (fPresentationTime.tv_sec == 0 && fPresentationTime.tv_usec == 0) {
@@ -344,6 +344,60 @@ void WAVAudioFileSource::doReadFromFile() {
 #endif
 }
 
+unsigned WAVAudioFileSource::readScaledSamples(unsigned bytesPerSample) {
+  // Rather than reading each sample separately (and seeking past the samples in between),
+  // we read - in one go - the whole block of the file that spans the samples that we'll deliver,
+  // and then pick out every |fScaleFactor|th sample from it.
+  unsigned numSamples = fMaxSize/bytesPerSample;
+  if (numSamples == 0) numSamples = 1; // as before, always deliver at least one sample
+  unsigned const stride = fScaleFactor < 0 ? -fScaleFactor : fScaleFactor;
+  unsigned const strideBytes = stride*bytesPerSample;
+
+  int64_t blockStart = TellFile64(fFid);
+  unsigned blockSize;
+  if (fScaleFactor > 0) {
+    // The block begins at the current file position, and ends where the next block will begin:
+    blockSize = numSamples*strideBytes;
+  } else {
+    // We're reading backwards, so the block *ends* with the sample at the current file position:
+    if (blockStart < (int64_t)fWAVHeaderSize) return 0; // we've reached the start of the audio
+    unsigned numSamplesAvailable = (unsigned)((blockStart - fWAVHeaderSize)/strideBytes) + 1;
+    if (numSamples > numSamplesAvailable) numSamples = numSamplesAvailable;
+    blockStart -= (int64_t)(numSamples-1)*strideBytes;
+    blockSize = (numSamples-1)*strideBytes + bytesPerSample;
+    SeekFile64(fFid, blockStart, SEEK_SET);
+  }
+
+  if (blockSize > fTrickPlayBufferSize) {
+    delete[] fTrickPlayBuffer;
+    fTrickPlayBuffer = new unsigned char[blockSize];
+    fTrickPlayBufferSize = blockSize;
+  }
+  unsigned blockBytesRead = fread(fTrickPlayBuffer, 1, blockSize, fFid);
+  blockBytesRead -= blockBytesRead%bytesPerSample; // ignore any partial sample at the end of the file
+
+  unsigned numBytesDelivered = 0;
+  if (fScaleFactor > 0) {
+    // Deliver the first sample of each stride, in order.  (The file is now positioned for our next read.)
+    for (unsigned offset = 0; offset < blockBytesRead; offset += strideBytes) {
+      memmove(&fTo[numBytesDelivered], &fTrickPlayBuffer[offset], bytesPerSample);
+      numBytesDelivered += bytesPerSample;
+    }
+  } else {
+    // Deliver the samples in reverse order, then reposition the file at the next sample (backwards) to be read.
+    // (If there's no such sample, this puts us before the start of the audio, so that our next read returns nothing.)
+    for (int offset = (numSamples-1)*strideBytes; offset >= 0; offset -= strideBytes) {
+      if ((unsigned)offset >= blockBytesRead) continue;
+      memmove(&fTo[numBytesDelivered], &fTrickPlayBuffer[offset], bytesPerSample);
+      numBytesDelivered += bytesPerSample;
+    }
+    int64_t nextSamplePosition = blockStart - strideBytes;
+    SeekFile64(fFid, nextSamplePosition < 0 ? 0 : nextSamplePosition, SEEK_SET);
+  }
+
+  return numBytesDelivered;
+}
+
 Boolean WAVAudioFileSource::setInputPort(int /*portIndex*/) {
   return True;
 }
@@ -54,6 +54,7 @@ private:
 private:
   // redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual unsigned maxFrameSize() const;
 
 private:
   struct timeval currentFramePlayTime() const;
@@ -40,4 +40,28 @@ char* base64Encode(char const* orig, unsigned origLength);
     // returns a 0-terminated string that
     // the caller is responsible for delete[]ing.
 
+inline unsigned base64EncodedSize(unsigned origLength) { return 4*((origLength+2)/3); }
+
+unsigned base64Encode(char* result, char const* orig, unsigned origLength);
+    // As above, but writes the (0-terminated) string to "result", which must have space for at least
+    // "base64EncodedSize(origLength)+1" bytes.  Returns the length of the string (not counting the '\0').
+
+// An incremental Base-64 decoder, for a stream of Base-64 data that arrives in arbitrary pieces
+// (e.g., RTSP commands that are tunneled over HTTP).  It does no memory allocation.
+class Base64Decoder {
+public:
+  Base64Decoder() { reset(); }
+  void reset() { fBits = 0; fNumBits = 0; }
+
+  unsigned decode(unsigned char* to, char const* from, unsigned fromSize);
+      // Decodes the next "fromSize" bytes of the stream, writing the decoded data to "to", and returns
+      // the number of bytes written.  Whitespace (and any other non-Base-64 character) is skipped.
+      // Bits from an incomplete final group are remembered, to be completed by the next call.
+      // "to" needs space for at most "fromSize" bytes, and may be the same as "from" (i.e., in-place decoding).
+
+private:
+  unsigned fBits; // undecoded bits (fewer than 8)
+  unsigned fNumBits;
+};
+
 #endif
@@ -35,11 +35,50 @@ public:
 	     unsigned baseBitOffset,
 	     unsigned totNumBits);
 
-  void putBits(unsigned from, unsigned numBits); // "numBits" <= 32
+  void putBits(unsigned from, unsigned numBits) { // "numBits" <= 32
+    // Fast path: Up to 24 bits, all of which fit (and so lie within at most 4 bytes):
+    if (numBits - 1 < 24 && numBits <= fTotNumBits - fCurBitIndex) {
+      unsigned totBitOffset = fBaseBitOffset + fCurBitIndex;
+      unsigned char* ptr = &fBaseBytePtr[totBitOffset/8];
+      unsigned numBytes = (totBitOffset%8 + numBits + 7)/8;
+      unsigned shift = 8*numBytes - totBitOffset%8 - numBits;
+      unsigned mask = ((1<<numBits) - 1)<<shift;
+
+      unsigned word = 0;
+      for (unsigned i = 0; i < numBytes; ++i) word = (word<<8)|ptr[i];
+      word = (word&~mask)|((from<<shift)&mask);
+      for (unsigned i = numBytes; i > 0; --i) {
+	ptr[i-1] = (unsigned char)word;
+	word >>= 8;
+      }
+      fCurBitIndex += numBits;
+    } else {
+      putBitsGeneral(from, numBits);
+    }
+  }
   void put1Bit(unsigned bit);
 
-  unsigned getBits(unsigned numBits); // "numBits" <= 32
-  unsigned get1Bit();
+  unsigned getBits(unsigned numBits) { // "numBits" <= 32
+    // Fast path: Up to 24 bits, all of which are present (and so lie within at most 4 bytes):
+    if (numBits - 1 < 24 && numBits <= fTotNumBits - fCurBitIndex) {
+      unsigned totBitOffset = fBaseBitOffset + fCurBitIndex;
+      unsigned char const* ptr = &fBaseBytePtr[totBitOffset/8];
+      unsigned numBytes = (totBitOffset%8 + numBits + 7)/8;
+
+      unsigned word = 0;
+      for (unsigned i = 0; i < numBytes; ++i) word = (word<<8)|ptr[i];
+      fCurBitIndex += numBits;
+      return (word>>(8*numBytes - totBitOffset%8 - numBits))&((1<<numBits) - 1);
+    }
+    return getBitsGeneral(numBits);
+  }
+  unsigned get1Bit() {
+    // The following is equivalent to "getBits(1)", except faster:
+    if (fCurBitIndex >= fTotNumBits) return 0; // overflow
+
+    unsigned totBitOffset = fBaseBitOffset + fCurBitIndex++;
+    return (fBaseBytePtr[totBitOffset/8]>>(7-(totBitOffset%8)))&0x01;
+  }
   Boolean get1BitBoolean() { return get1Bit() != 0; }
 
   void skipBits(unsigned numBits);
@@ -52,6 +91,12 @@ public:
       // Returns the value of the next bits, assuming that they were encoded using an exponential-Golomb code of order 0
   int get_expGolombSigned(); // signed version of the above
 
+private:
+  // The general (out-of-line) versions of "putBits()" and "getBits()", for longer reads and writes,
+  // and for those that run off the end:
+  void putBitsGeneral(unsigned from, unsigned numBits);
+  unsigned getBitsGeneral(unsigned numBits);
+
 private:
   unsigned char* fBaseBytePtr;
   unsigned fBaseBitOffset;
@@ -43,6 +43,7 @@ private: // redefined virtual functions
   virtual FramedSource* createNewStreamSource(unsigned clientSessionId, unsigned& estBitrate);
   virtual RTPSink* createNewRTPSink(Groupsock* rtpGroupsock, unsigned char rtpPayloadTypeIfDynamic, FramedSource* inputSource);
   virtual float duration() const;
+  virtual char* sdpCacheKey();
 
 private:
   float fFileDuration; // in seconds
@@ -35,6 +35,11 @@ protected: // we're a virtual base class
 			    Boolean reuseFirstSource);
   virtual ~FileServerMediaSubsession();
 
+protected: // redefined virtual functions
+  virtual char* sdpCacheKey();
+      // our file name, size, and modification time.  (Subclasses that compute their
+      // "duration()" only when a source is created should redefine this to return NULL.)
+
 protected:
   char const* fFileName;
   u_int64_t fFileSize; // if known
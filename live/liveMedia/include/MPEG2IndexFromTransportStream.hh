@@ -33,6 +33,11 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #define MAX_PES_PACKET_SIZE 65536
 #endif
 
+// The maximum number of Transport Stream packets that we ask our input source for at a time:
+#ifndef INDEXER_INPUT_BUFFER_NUM_PACKETS
+#define INDEXER_INPUT_BUFFER_NUM_PACKETS 64
+#endif
+
 class IndexRecord; // forward
 
 class MPEG2IFrameIndexFromTransportStream: public FramedFilter {
@@ -63,6 +68,10 @@ private:
   static void handleInputClosure(void* clientData);
   void handleInputClosure1();
 
+  Boolean addTransportPacket(unsigned char* pkt);
+      // adds the video data (if any) from a Transport Stream packet to our parse buffer;
+      // returns False iff the input is bad (and we've handled this as if the input ended)
+
   void analyzePAT(unsigned char* pkt, unsigned size);
   void analyzePMT(unsigned char* pkt, unsigned size);
 
@@ -71,6 +80,9 @@ private:
   Boolean parseToNextCode(unsigned char& nextCode);
   void compactParseBuffer();
   void addToTail(IndexRecord* newIndexRecord);
+  IndexRecord* newIndexRecord(u_int8_t startOffset, u_int8_t size,
+			      unsigned long transportPacketNumber, float pcr);
+  void freeIndexRecord(IndexRecord* record);
 
 private:
   Boolean fIsH264; // True iff the video is H.264 (encapsulated in a Transport Stream)
@@ -82,7 +94,8 @@ private:
   Boolean fHaveSeenFirstPCR;
   u_int16_t fPMT_PID, fVideo_PID;
       // Note: We assume: 1 program per Transport Stream; 1 video stream per program
-  unsigned char fInputBuffer[TRANSPORT_PACKET_SIZE];
+  unsigned char fInputBuffer[INDEXER_INPUT_BUFFER_NUM_PACKETS*TRANSPORT_PACKET_SIZE];
+  unsigned fInputBufferDataStart, fInputBufferDataEnd; // the data that we've read, but not yet processed
   unsigned char* fParseBuffer;
   unsigned fParseBufferSize;
   unsigned fParseBufferFrameStart;
@@ -90,6 +103,7 @@ private:
   unsigned fParseBufferDataEnd;
   IndexRecord* fHeadIndexRecord;
   IndexRecord* fTailIndexRecord;
+  IndexRecord* fFreeIndexRecords; // records that we've finished with, kept for reuse (linked by "fNext")
 };
 
 #endif
@@ -38,6 +38,12 @@ public:
 
   u_int64_t tsPacketCount() const { return fTSPacketCount; }
 
+  double pcrDrift() const { return fPCRDrift; }
+  double maxPCRDrift() const { return fMaxPCRDrift; }
+      // The difference (in seconds) between the time that we've spent delivering the stream,
+      // and the stream's own (PCR) time, as of the most recent PCR (and the largest absolute
+      // value seen so far).  A positive value means that we're delivering later than the PCRs.
+
   void changeInputSource(FramedSource* newInputSource) { fInputSource = newInputSource; }
 
   void clearPIDStatusTable();
@@ -67,7 +73,11 @@ private:
 private:
   u_int64_t fTSPacketCount;
   double fTSPacketDurationEstimate;
+  double fDurationRemainder; // in microseconds; carried over to the next chunk's duration
   HashTable* fPIDStatusTable;
+  unsigned fLastPCRPID;
+  class PIDStatus* fLastPCRPIDStatus; // a cache of the most recent "fPIDStatusTable" lookup
+  double fPCRDrift, fMaxPCRDrift;
   u_int64_t fTSPCRCount;
   Boolean fLimitNumTSPacketsToStream;
   unsigned long fNumTSPacketsToStream; // used iff "fLimitNumTSPacketsToStream" is True
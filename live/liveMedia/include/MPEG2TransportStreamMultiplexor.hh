@@ -37,6 +37,14 @@ public:
       // Can be used by a downstream reader to test whether the next call to "doGetNextFrame()"
       // will deliver data immediately).
 
+  void setMaxNumTransportPacketsPerFrame(unsigned maxNumPackets) {
+    fMaxNumTransportPacketsPerFrame = maxNumPackets == 0 ? 1 : maxNumPackets;
+  }
+      // By default, each delivered 'frame' is a single 188-byte Transport Stream packet.
+      // Setting this to a larger value (e.g., 7, for RTP) lets us deliver several packets at a
+      // time (as many as fit in the downstream reader's buffer), as long as input data is
+      // immediately available.
+
 protected:
   MPEG2TransportStreamMultiplexor(UsageEnvironment& env);
   virtual ~MPEG2TransportStreamMultiplexor();
@@ -62,8 +70,12 @@ private:
   void deliverDataToClient(u_int8_t pid, unsigned char* buffer, unsigned bufferSize,
 			   unsigned& startPositionInBuffer);
 
+  void deliverNextTransportPacket();
+
   void deliverPATPacket();
   void deliverPMTPacket(Boolean hasChanged);
+  void buildPAT();
+  void buildPMT();
 
   void setProgramStreamMap(unsigned frameSize);
 
@@ -85,6 +97,12 @@ private:
   unsigned char* fInputBuffer;
   unsigned fInputBufferSize, fInputBufferBytesUsed;
   Boolean fIsFirstAdaptationField;
+  unsigned fMaxNumTransportPacketsPerFrame;
+  unsigned fNumFramesDelivered;
+  unsigned char* fPATBuffer; // our (constant) Program Association Table (including its CRC)
+  unsigned char* fPMTBuffer; // the most recently built Program Map Table (including its CRC)
+  Boolean fPMTBufferIsCurrent;
+      // Set to False whenever something that appears in the Program Map Table changes
 };
 
 
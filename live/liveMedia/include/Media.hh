@@ -125,6 +125,8 @@ public:
 
   MediaLookupTable* mediaTable;
   void* socketTable;
+  void* sdpCache; // an "SDPCache", if one has been created
+  void* serverPortPool; // a "ServerPortPool", if one has been created
 
 protected:
   _Tables(UsageEnvironment& env);
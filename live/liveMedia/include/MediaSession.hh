@@ -180,6 +180,10 @@ public:
   RTCPInstance* rtcpInstance() { return fRTCPInstance; }
   unsigned rtpTimestampFrequency() const { return fRTPTimestampFrequency; }
   Boolean rtcpIsMuxed() const { return fMultiplexRTCPWithRTP; }
+  Boolean serverSupportsNACK() const { return fServerSupportsNACK; }
+      // True iff the SDP description had a "a=rtcp-fb:<fmt> nack" line (RFC 4585) for our payload format
+  unsigned char rtxPayloadFormat() const { return fRTXPayloadFormat; }
+      // the payload type of the "RTX" (RFC 4588) retransmission format, if the SDP description offered one; else 0
   FramedSource* readSource() { return fReadSource; }
     // This is the source that client sinks read from.  It is usually
     // (but not necessarily) the same as "rtpSource()"
@@ -283,6 +287,7 @@ protected:
   Boolean parseSDPLine_b(char const* sdpLine);
   Boolean parseSDPAttribute_rtpmap(char const* sdpLine);
   Boolean parseSDPAttribute_rtcpmux(char const* sdpLine);
+  Boolean parseSDPAttribute_rtcpfb(char const* sdpLine);
   Boolean parseSDPAttribute_control(char const* sdpLine);
   Boolean parseSDPAttribute_range(char const* sdpLine);
   Boolean parseSDPAttribute_fmtp(char const* sdpLine);
@@ -309,6 +314,8 @@ protected:
   char* fProtocolName;
   unsigned fRTPTimestampFrequency;
   Boolean fMultiplexRTCPWithRTP;
+  Boolean fServerSupportsNACK;
+  unsigned char fRTXPayloadFormat;
   char* fControlPath; // holds optional a=control: string
   struct in_addr fSourceFilterAddr; // used for SSM
   unsigned fBandwidth; // in kilobits-per-second, from b= line
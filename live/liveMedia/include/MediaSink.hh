@@ -38,6 +38,7 @@ public:
 
   // Test for specific types of sink:
   virtual Boolean isRTPSink() const;
+  virtual Boolean isMultiFramedRTPSink() const;
 
   FramedSource* source() const {return fSource;}
 
@@ -76,8 +77,17 @@ public:
   ~OutPacketBuffer();
 
   static unsigned maxSize;
+      // the initial buffer size for sinks whose source doesn't report a "maxFrameSize()".
+      // (Sinks enlarge their buffers later, if needed.)
   static void increaseMaxSizeTo(unsigned newMaxSize) { if (newMaxSize > OutPacketBuffer::maxSize) OutPacketBuffer::maxSize = newMaxSize; }
 
+  Boolean increaseBufferSizeTo(unsigned newBufferSize);
+      // enlarges our buffer (preserving its contents), up to "bufferSizeLimit()".
+      // Returns False if the buffer could not be made any bigger.
+  static unsigned bufferSizeLimit();
+      // the largest that "increaseBufferSizeTo()" will make a buffer.  (This is "OUT_PACKET_BUFFER_MAX_SIZE",
+      // which can be changed when compiling "MediaSink.cpp".)
+
   unsigned char* curPtr() const {return &fBuf[fPacketStart + fCurOffset];}
   unsigned totalBytesAvailable() const {
     return fLimit - (fPacketStart + fCurOffset);
@@ -37,6 +37,28 @@ public:
     fOnSendErrorData = onSendErrorFuncData;
   }
 
+  // Retransmission statistics (see "enableRetransmissions()"):
+  unsigned retransmissionHistorySize() const { return fRetransmissionHistorySize; }
+  unsigned numPacketsRetransmitted() const { return fNumPacketsRetransmitted; }
+  unsigned numRetransmissionsMissed() const { return fNumRetransmissionsMissed; }
+      // the number of NACKed packets that were no longer (or never) in our history
+
+  unsigned numSendWakeups() const { return fNumSendWakeups; }
+      // the number of tasks that we've scheduled (i.e., times that we've been woken up) to send packets
+
+  // Buffer statistics:
+  unsigned outputBufferSize() const;
+      // the size of our output buffer, which is sized from our source's "maxFrameSize()" (if known),
+      // and grows if we see larger frames
+  unsigned numOutputBufferGrowths() const { return fNumOutputBufferGrowths; }
+  unsigned numTruncatedFrames() const { return fNumTruncatedFrames; }
+      // the number of frames that were too large for our buffer (before it grew)
+  unsigned numBytesAllocated() const;
+      // the memory used by our output buffer and retransmission history
+
+  static void printStatistics(UsageEnvironment& env);
+      // Prints (to "env") the buffer statistics of each "MultiFramedRTPSink" that exists in "env"
+
 protected:
   MultiFramedRTPSink(UsageEnvironment& env,
 		     Groupsock* rtpgs, unsigned char rtpPayloadType,
@@ -92,17 +114,23 @@ protected:
   unsigned ourMaxPacketSize() const { return fOurMaxPacketSize; }
 
 public: // redefined virtual functions:
+  virtual Boolean isMultiFramedRTPSink() const;
   virtual void stopPlaying();
+  virtual Boolean enableRetransmissions(unsigned historySize, unsigned char rtxPayloadType = 0);
+  virtual Boolean enableKernelPacing(unsigned burstDurationUSeconds = 10000, unsigned pacingRateKbps = 0);
 
 protected: // redefined virtual functions:
   virtual Boolean continuePlaying();
+  virtual void retransmitPacket(u_int16_t seqNo, unsigned clientSessionId, int tcpSocketNum);
 
 private:
   void buildAndSendPacket(Boolean isFirstPacket);
   void packFrame();
+  void increaseOutputBufferSizeIfNecessary();
   void sendPacketIfNecessary();
   static void sendNext(void* firstArg);
   friend void sendNext(void*);
+  void sendBurst();
 
   static void afterGettingFrame(void* clientData,
 				unsigned numBytesRead, unsigned numTruncatedBytes,
@@ -115,6 +143,9 @@ private:
 
   static void ourHandleClosure(void* clientData);
 
+  void saveForRetransmission(unsigned char const* packet, unsigned packetSize);
+  void deleteRetransmissionHistory();
+
 private:
   OutPacketBuffer* fOutBuf;
 
@@ -132,9 +163,30 @@ private:
   unsigned fCurFrameSpecificHeaderSize; // size in bytes of cur frame-specific header
   unsigned fTotalFrameSpecificHeaderSizes; // size of all frame-specific hdrs in pkt
   unsigned fOurMaxPacketSize;
+  unsigned fMinFrameSpace; // the buffer space that we make available for each frame that we read
+  Boolean fSourceReportsMaxFrameSize;
+  unsigned fNumOutputBufferGrowths, fNumTruncatedFrames;
 
   onSendErrorFunc* fOnSendErrorFunc;
   void* fOnSendErrorData;
+
+  // A ring of recently-sent packets, indexed by (sequence number % "fRetransmissionHistorySize"):
+  unsigned fRetransmissionHistorySize; // 0 iff retransmissions are disabled
+  unsigned fRetransmissionSlotSize;
+  unsigned char* fRetransmissionHistory;
+  unsigned* fRetransmissionPacketSizes; // 0 for an empty slot
+  u_int16_t* fRetransmissionSeqNos;
+  unsigned char fRTXPayloadType; // 0 means: resend the original packet
+  u_int32_t fRTXSSRC;
+  u_int16_t fRTXSeqNo;
+  unsigned char* fRTXPacket; // used to build each "RTX" packet
+  unsigned fNumPacketsRetransmitted, fNumRetransmissionsMissed;
+
+  unsigned fPacingBurstUSeconds; // 0 iff we wake up for each packet
+  struct timeval fBurstStartTime;
+  enum { BURST_PACKET_PENDING, BURST_SEND_ANOTHER, BURST_DONE };
+  int* fBurstStatus; // non-NULL while "sendBurst()" waits for a packet to be sent
+  unsigned fNumSendWakeups;
 };
 
 #endif
@@ -29,6 +29,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 class BufferedPacket; // forward
 class BufferedPacketFactory; // forward
 
+#define NUM_ADDED_DELAY_HISTOGRAM_BUCKETS 12
+
 class MultiFramedRTPSource: public RTPSource {
 protected:
   MultiFramedRTPSource(UsageEnvironment& env, Groupsock* RTPgs,
@@ -47,6 +49,22 @@ protected:
 						    unsigned packetSize);
       // The default implementation returns True, but this can be redefined
 
+public:
+  // Statistics about the delay that's added by our reordering of incoming packets:
+  unsigned packetReorderingThresholdTime() const; // the current threshold, in uSeconds
+  unsigned numPacketsArrivingTooLate() const; // i.e., after we'd given up on them
+  unsigned const* addedDelayHistogram() const;
+      // An array of NUM_ADDED_DELAY_HISTOGRAM_BUCKETS packet counts.  Bucket 0 counts packets
+      // that were delivered < 1 ms after they arrived; bucket i (>0) counts those delivered
+      // [2^(i-1), 2^i) ms after they arrived.  (The last bucket also counts any later packets.)
+      // Note: This is collected only while an adaptive threshold is being used
+      // (see "setAdaptivePacketReorderingThresholdTime()"), because it costs a clock read per packet.
+
+  // Statistics about retransmission requests (see "enableRetransmissionRequests()"):
+  unsigned numPacketsNACKed() const { return fNumPacketsNACKed; }
+  unsigned numPacketsRecovered() const { return fNumPacketsRecovered; }
+      // the number of "RTX" packets that we used (not counting duplicates, or packets that arrived too late)
+
 protected:
   Boolean fCurrentPacketBeginsFrame;
   Boolean fCurrentPacketCompletesFrame;
@@ -57,12 +75,17 @@ protected:
 
 private:
   // redefined virtual functions:
+  virtual Boolean isMultiFramedRTPSource() const;
   virtual void doGetNextFrame();
   virtual void setPacketReorderingThresholdTime(unsigned uSeconds);
+  virtual void setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+  virtual void enableRetransmissionRequests(class RTCPInstance* rtcpInstance,
+					    unsigned char rtxPayloadFormat = 0);
 
 private:
   void reset();
   void doGetNextFrame1();
+  void noteSeqNoForRetransmissionRequests(u_int16_t rtpSeqNo);
 
   static void networkReadHandler(MultiFramedRTPSource* source, int /*mask*/);
   void networkReadHandler1();
@@ -76,6 +99,13 @@ private:
 
   // A buffer to (optionally) hold incoming pkts that have been reorderered
   class ReorderingPacketBuffer* fReorderingBuffer;
+
+  // State used to request retransmissions of missing packets:
+  class RTCPInstance* fRTCPInstanceForRetransmissionRequests;
+  unsigned char fRTXPayloadFormat;
+  Boolean fHaveSeenSeqNoForRetransmissionRequests;
+  u_int16_t fHighestSeqNoForRetransmissionRequests;
+  unsigned fNumPacketsNACKed, fNumPacketsRecovered;
 };
 
 
@@ -50,6 +50,7 @@ public:
 
   char const* fileName() const { return fFileName; }
   unsigned numTracks() const;
+  float fileDuration() const { return fFileDuration; } // in seconds (0 if unknown)
 
   FramedSource*
   createSourceForStreaming(FramedSource* baseSource, u_int32_t trackNumber,
@@ -75,12 +76,16 @@ private:
   void addTrack(OggTrack* newTrack);
   void removeDemux(OggDemux* demux);
 
+  void computeFileDuration();
+
 private:
   friend class OggFileParser;
   friend class OggDemux;
   char const* fFileName;
   onCreationFunc* fOnCreation;
   void* fOnCreationClientData;
+  float fFileDuration;
+  u_int64_t fFileSize;
 
   class OggTrackTable* fTrackTable;
   HashTable* fDemuxesTable;
@@ -124,6 +129,20 @@ public:
       vtoHdrs.header[1] == NULL ||
       (vtoHdrs.header[2] == NULL && strcmp(mimeType, "audio/OPUS") != 0);
     }
+
+  double granulePositionToNPT(u_int64_t granule_position) const; // in seconds
+
+  // A seek index for the track, built (by "OggFileParser") from the "granule_position"s of
+  // pages as they are read.  Each entry records a file offset at which a page begins, and the
+  // time at which the first packet (that begins in that page) will be played:
+  void addSeekIndexEntry(double npt, u_int64_t offsetInFile);
+  Boolean lookupSeekIndex(double npt, double& resultNPT, u_int64_t& resultOffsetInFile) const;
+      // Finds the latest entry at or before "npt".  Returns False if there is none.
+
+private:
+  unsigned fSeekIndexSize, fSeekIndexMaxSize;
+  double* fSeekIndexNPT;
+  u_int64_t* fSeekIndexOffsetInFile;
 };
 
 class OggTrackTableIterator {
@@ -163,6 +182,7 @@ private:
   friend class OggDemuxedTrack;
   void removeTrack(u_int32_t trackNumber);
   void continueReading(); // called by a demuxed track to tell us that it has a pending read ("doGetNextFrame()")
+  void seekToTime(double& seekNPT);
 
   static void handleEndOfFile(void* clientData);
   void handleEndOfFile();
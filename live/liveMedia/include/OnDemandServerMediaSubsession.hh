@@ -34,6 +34,12 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _RTCP_HH
 #include "RTCP.hh"
 #endif
+#ifndef _SHARED_RTP_SOCKET_HH
+#include "SharedRTPSocket.hh"
+#endif
+#ifndef _SERVER_PORT_POOL_HH
+#include "ServerPortPool.hh"
+#endif
 
 class OnDemandServerMediaSubsession: public ServerMediaSubsession {
 protected: // we're a virtual base class
@@ -91,6 +97,10 @@ protected: // new virtual functions, possibly redefined by subclasses
   virtual void setStreamSourceScale(FramedSource* inputSource, float scale);
   virtual void setStreamSourceDuration(FramedSource* inputSource, double streamDuration, u_int64_t& numBytes);
   virtual void closeStreamSource(FramedSource* inputSource);
+  virtual char* sdpCacheKey();
+    // Returns a newly-allocated string that identifies the media that we stream (e.g., a file name and
+    // its modification time), for use as a key in the environment's "SDPCache" (if any).
+    // The default implementation returns NULL, meaning that our SDP lines are never cached.
 
 protected: // new virtual functions, defined by all subclasses
   virtual FramedSource* createNewStreamSource(unsigned clientSessionId,
@@ -109,6 +119,24 @@ public:
   void multiplexRTCPWithRTP() { fMultiplexRTCPWithRTP = True; }
     // An alternative to passing the "multiplexRTCPWithRTP" parameter as True in the constructor
 
+  void useSharedRTPSocket(SharedRTPSocket* sharedRTPSocket);
+    // Streams future RTP-over-UDP clients from "sharedRTPSocket"'s single port (which may also be
+    // used by other subsessions), rather than binding new ports for each.  This implies that RTCP is
+    // multiplexed with RTP.  (Call with NULL to go back to using separate ports for future clients.)
+    // Note: "sharedRTPSocket" must outlive any streams that use it.
+
+  void enableRetransmissions(unsigned historySize, unsigned char rtxPayloadType = 0);
+    // Has each future stream's "RTPSink" keep its last "historySize" packets, and resend them in
+    // response to RTCP "Generic NACK"s (see "RTPSink::enableRetransmissions()").  Our SDP description
+    // then advertises "a=rtcp-fb:<fmt> nack" - and, if "rtxPayloadType" is non-zero, the "rtx"
+    // payload format (RFC 4588) with that (dynamic) payload type.
+
+  void enableKernelPacing(unsigned burstDurationUSeconds = 10000);
+    // Has each future stream's "RTPSink" send its packets in bursts, paced by the kernel
+    // (see "RTPSink::enableKernelPacing()").
+    // Note: This is not done for streams that use a shared RTP socket (see "useSharedRTPSocket()"),
+    // because the pacing rate can't be set for each of those streams separately.
+
   void setRTCPAppPacketHandler(RTCPAppHandlerFunc* handler, void* clientData);
     // Sets a handler to be called if a RTCP "APP" packet arrives from any future client.
     // (Any current clients are not affected; any "APP" packets from them will continue to be
@@ -126,6 +154,13 @@ public:
     // then the remaining bytes are '\0'.)
 
 private:
+  Boolean createGroupsocks(portNumBits serverPortNum, Port& serverRTPPort, Port& serverRTCPPort,
+			   Groupsock*& rtpGroupsock, Groupsock*& rtcpGroupsock);
+      // Creates RTP and RTCP 'groupsocks' for "serverPortNum" (and, unless RTCP is multiplexed,
+      // "serverPortNum"+1).  Returns False (with no 'groupsocks' created) if a port is already in use.
+
+  void warnIfKernelPacingIsUnavailable();
+
   void setSDPLinesFromRTPSink(RTPSink* rtpSink, FramedSource* inputSource,
 			      unsigned estBitrate);
       // used to implement "sdpLines()"
@@ -138,6 +173,11 @@ private:
   Boolean fReuseFirstSource;
   portNumBits fInitialPortNum;
   Boolean fMultiplexRTCPWithRTP;
+  Boolean fUsesServerPortPool; // iff we've called "ServerPortPool::useOurPool()"
+  SharedRTPSocket* fSharedRTPSocket;
+  unsigned fRetransmissionHistorySize;
+  unsigned char fRTXPayloadType;
+  unsigned fPacingBurstUSeconds;
   void* fLastStreamToken;
   char fCNAME[100]; // for RTCP
   RTCPAppHandlerFunc* fAppHandlerTask;
@@ -152,6 +192,8 @@ private:
 
 class Destinations {
 public:
+  static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+  static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
   Destinations(struct in_addr const& destAddr,
                Port const& rtpDestPort,
                Port const& rtcpDestPort)
@@ -169,15 +211,20 @@ public:
   Port rtcpPort;
   int tcpSocketNum;
   unsigned char rtpChannelId, rtcpChannelId;
+
+private:
+  static MemoryPool fMemoryPool;
 };
 
 class StreamState {
 public:
+  static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+  static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
   StreamState(OnDemandServerMediaSubsession& master,
               Port const& serverRTPPort, Port const& serverRTCPPort,
 	      RTPSink* rtpSink, BasicUDPSink* udpSink,
 	      unsigned totalBW, FramedSource* mediaSource,
-	      Groupsock* rtpGS, Groupsock* rtcpGS);
+	      Groupsock* rtpGS, Groupsock* rtcpGS, Boolean serverPortsArePooled = False);
   virtual ~StreamState();
 
   void startPlaying(Destinations* destinations, unsigned clientSessionId,
@@ -222,6 +269,10 @@ private:
 
   Groupsock* fRTPgs;
   Groupsock* fRTCPgs;
+  SharedRTPSocket* fSharedRTPSocket; // non-NULL iff "fRTPgs" (and "fRTCPgs") use a shared socket
+  Boolean fServerPortsArePooled; // iff our server ports were allocated from our environment's "ServerPortPool"
+
+  static MemoryPool fMemoryPool;
 };
 
 #endif
@@ -52,6 +52,15 @@ public:
   void continueAfterPLAY(int resultCode);
   void scheduleReset();
 
+  // Statistics about our connection to the back-end server (e.g., for monitoring a large number of proxied cameras):
+  unsigned numResets() const { return fNumResets; }
+      // the number of times that we've had to reset (and reconnect to) the back-end stream
+  unsigned numDESCRIBEFailures() const { return fNumDESCRIBEFailures; }
+  unsigned lastDESCRIBELatency() const { return fLastDESCRIBELatency; }
+      // in milliseconds: the time between sending the most recent successful "DESCRIBE", and getting its response
+  unsigned lastStartupLatency() const { return fLastStartupLatency; }
+      // in milliseconds: the time between sending the first "SETUP", and getting the response to the subsequent "PLAY"
+
 private:
   void reset();
   int connectToServer(int socketNum, portNumBits remotePortNum);
@@ -66,6 +75,8 @@ private:
   void scheduleDESCRIBECommand();
   static void sendDESCRIBE(void* clientData);
 
+  void sendSETUP(class ProxyServerMediaSubsession* smss);
+
   static void subsessionTimeout(void* clientData);
   void handleSubsessionTimeout();
 
@@ -81,6 +92,10 @@ private:
   unsigned fNextDESCRIBEDelay; // in seconds
   Boolean fServerSupportsGetParameter, fLastCommandWasPLAY, fDoneDESCRIBE;
   TaskToken fLivenessCommandTask, fDESCRIBECommandTask, fSubsessionTimerTask, fResetTask;
+  Boolean fPipelineSETUPs;
+  unsigned fNumSetupResponses;
+  unsigned fNumResets, fNumDESCRIBEFailures, fLastDESCRIBELatency, fLastStartupLatency;
+  struct timeval fDESCRIBESendTime, fFirstSETUPSendTime;
 };
 
 
@@ -108,16 +123,23 @@ public:
 					        // for streaming the *proxied* (i.e., back-end) stream
 					    int verbosityLevel = 0,
 					    int socketNumToServer = -1,
-					    MediaTranscodingTable* transcodingTable = NULL);
+					    MediaTranscodingTable* transcodingTable = NULL,
+					    Boolean pipelineSETUPs = False);
       // Hack: "tunnelOverHTTPPortNum" == 0xFFFF (i.e., all-ones) means: Stream RTP/RTCP-over-TCP, but *not* using HTTP
       // "verbosityLevel" == 1 means display basic proxy setup info; "verbosityLevel" == 2 means display RTSP client protocol also.
       // If "socketNumToServer" is >= 0, then it is the socket number of an already-existing TCP connection to the server.
       //      (In this case, "inputStreamURL" must point to the socket's endpoint, so that it can be accessed via the socket.)
+      // If "pipelineSETUPs" is True, then - once the back-end server has responded to our first "SETUP" (and so given us a
+      //      session id) - we send any remaining "SETUP"s without waiting for the responses to previous ones.  This reduces
+      //      startup latency for multi-track streams, but should be used only with servers that handle 'pipelined' requests.
 
   virtual ~ProxyServerMediaSession();
 
   char const* url() const;
 
+  ProxyRTSPClient const* proxyRTSPClient() const { return fProxyRTSPClient; }
+      // e.g., to get statistics about our connection to the back-end server
+
   char describeCompletedFlag;
     // initialized to 0; set to 1 when the back-end "DESCRIBE" completes.
     // (This can be used as a 'watch variable' in "doEventLoop()".)
@@ -134,7 +156,8 @@ protected:
 			  createNewProxyRTSPClientFunc* ourCreateNewProxyRTSPClientFunc
 			  = defaultCreateNewProxyRTSPClientFunc,
 			  portNumBits initialPortNum = 6970,
-			  Boolean multiplexRTCPWithRTP = False);
+			  Boolean multiplexRTCPWithRTP = False,
+			  Boolean pipelineSETUPs = False);
 
   // If you subclass "ProxyRTSPClient", then you will also need to define your own function
   // - with signature "createNewProxyRTSPClientFunc" (see above) - that creates a new object
@@ -37,7 +37,15 @@ public:
 				      Boolean packetLossCompensate = False,
 				      Boolean syncStreams = False,
 				      Boolean generateHintTracks = False,
-				      Boolean generateMP4Format = False);
+				      Boolean generateMP4Format = False,
+				      unsigned fragmentDuration = 0);
+      // If "fragmentDuration" (in seconds) is non-zero, then we write a
+      // fragmented MP4 file: an initial 'ftyp'+'moov' (the 'initialization
+      // segment'), followed by a 'moof'+'mdat' pair (a 'fragment') roughly
+      // every "fragmentDuration" seconds.  Only one fragment's worth of data
+      // is kept in memory, and the file is playable as soon as the first
+      // fragment has been written.  (This implies "generateMP4Format", and
+      // disables "generateHintTracks".)
 
   typedef void (afterPlayingFunc)(void* clientData);
   Boolean startPlaying(afterPlayingFunc* afterFunc,
@@ -51,12 +59,17 @@ protected:
 		    unsigned short movieWidth, unsigned short movieHeight,
 		    unsigned movieFPS, Boolean packetLossCompensate,
 		    Boolean syncStreams, Boolean generateHintTracks,
-		    Boolean generateMP4Format);
+		    Boolean generateMP4Format, unsigned fragmentDuration);
       // called only by createNew()
   virtual ~QuickTimeFileSink();
 
   virtual void noteRecordedFrame(MediaSubsession& inputSubsession,
 				 unsigned packetDataSize, struct timeval const& presentationTime);
+  virtual void noteCompletedFragment(int64_t fileOffset, unsigned fragmentSize,
+				     Boolean isInitializationSegment);
+      // Called (in fragmented mode only) after each complete segment has been written
+      // (and flushed) to the output file.  Subclasses can redefine this to (e.g.)
+      // make each new segment available for HTTP streaming.
 
 private:
   Boolean continuePlaying();
@@ -69,6 +82,13 @@ private:
   static void onRTCPBye(void* clientData);
   void completeOutputFile();
 
+  // Used only when writing a fragmented file:
+  Boolean isFragmented() const { return fFragmentDuration > 0; }
+  Boolean fragmentShouldEndBefore(struct timeval const& presentationTime, unsigned frameSize,
+				  Boolean isKeyFrameTrack, Boolean frameCanStartFragment);
+  void writeInitializationSegment();
+  void completeFragment();
+
 private:
   friend class SubsessionIOState;
   MediaSession& fInputSession;
@@ -85,6 +105,12 @@ private:
   unsigned fNumSubsessions, fNumSyncedSubsessions;
   struct timeval fStartTime;
   Boolean fHaveCompletedOutputFile;
+  unsigned fFragmentDuration; // in seconds; 0 means 'not fragmented'
+  Boolean fHaveWrittenInitializationSegment;
+  Boolean fHaveFragmentStartTime, fHaveKeyFrameTrack;
+  struct timeval fFragmentStartTime, fFragmentTimeBase;
+  unsigned fFragmentSequenceNumber;
+  unsigned fFragmentDataSize; // the data buffered (for all tracks) for the current fragment
 
 private:
   ///// Definitions specific to the QuickTime file format:
@@ -178,6 +204,14 @@ private:
                   _atom(pmax);
                   _atom(dmax);
                   _atom(payt);
+  _atom(mvex); // for fragmented MP4 files
+      _atom(trex);
+  _atom(moof); // for fragmented MP4 files
+      _atom(mfhd);
+      _atom(traf);
+          _atom(tfhd);
+          _atom(tfdt);
+          _atom(trun);
   unsigned addAtom_dummy();
 
 private:
@@ -47,6 +47,8 @@ class RTCPMemberDatabase; // forward
 
 class RTCPInstance: public Medium {
 public:
+  static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+  static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
   static RTCPInstance* createNew(UsageEnvironment& env, Groupsock* RTCPgs,
 				 unsigned totSessionBW, /* in kbps */
 				 unsigned char const* cname,
@@ -96,6 +98,11 @@ public:
       // of "name" are used.  (If "name" has fewer than 4 bytes, or is NULL,
       // then the remaining bytes are '\0'.)
 
+  void sendNACK(u_int32_t mediaSSRC, u_int16_t const* seqNums, unsigned numSeqNums);
+      // Sends a RTCP "Generic NACK" (RFC 4585, section 6.2.1) to the peer(s), asking for the
+      // listed RTP packets (from "mediaSSRC") to be resent.  "seqNums" should be in increasing order.
+      // (A corresponding incoming "Generic NACK" is handled by calling our sink's "retransmitPacket()".)
+
   Groupsock* RTCPgs() const { return fRTCPInterface.gs(); }
 
   void setStreamSocket(int sockNum, unsigned char streamChannelId);
@@ -203,6 +210,9 @@ public: // because this stuff is used by an external "C" function
   int checkNewSSRC();
   void removeLastReceivedSSRC();
   void removeSSRC(u_int32_t ssrc, Boolean alsoRemoveStats);
+
+private:
+  static MemoryPool fMemoryPool;
 };
 
 // RTCP packet types:
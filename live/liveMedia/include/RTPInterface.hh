@@ -67,15 +67,23 @@ public:
   static void clearServerRequestAlternativeByteHandler(UsageEnvironment& env, int socketNum);
 
   Boolean sendPacket(unsigned char* packet, unsigned packetSize);
+  Boolean sendPacketToClient(unsigned char* packet, unsigned packetSize, unsigned clientSessionId, int tcpSocketNum);
+      // Like "sendPacket()", but sends to just one client: over the TCP connection "tcpSocketNum" (if >= 0),
+      // otherwise to the UDP destination(s) that were added with "clientSessionId".
+      // Returns False if this client is not one of our destinations (or if the send fails).
+  Boolean hasMultipleDestinations() const;
   void startNetworkReading(TaskScheduler::BackgroundHandlerProc*
                            handlerProc);
   Boolean handleRead(unsigned char* buffer, unsigned bufferMaxSize,
 		     // out parameters:
 		     unsigned& bytesRead, struct sockaddr_in& fromAddress,
 		     int& tcpSocketNum, unsigned char& tcpStreamChannelId,
-		     Boolean& packetReadWasIncomplete);
+		     Boolean& packetReadWasIncomplete,
+		     struct timeval* timeReceived = NULL);
   // Note: If "tcpSocketNum" < 0, then the packet was received over UDP, and "tcpStreamChannelId"
   //   is undefined (and irrelevant).
+  // If "timeReceived" is non-NULL, it's set to the packet's arrival time.  (For UDP, this comes from
+  //   the kernel, if "gs()->enableReceiveTimestamps()" succeeded.)
 
 
   // Otherwise (if "tcpSocketNum" >= 0), the packet was received (interleaved) over TCP, and
@@ -27,6 +27,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _RTP_INTERFACE_HH
 #include "RTPInterface.hh"
 #endif
+#ifndef _MEMORY_POOL_HH
+#include "MemoryPool.hh"
+#endif
 
 class RTPTransmissionStatsDB; // forward
 
@@ -89,6 +92,22 @@ public:
   u_int32_t SSRC() const {return fSSRC;}
      // later need a means of changing the SSRC if there's a collision #####
 
+  virtual Boolean enableRetransmissions(unsigned historySize, unsigned char rtxPayloadType = 0);
+      // Asks the sink to keep a history of the last "historySize" RTP packets that it sent, so that
+      // they can be resent in response to RTCP "Generic NACK" feedback (RFC 4585).
+      // If "rtxPayloadType" is non-zero, resent packets use the RTP "RTX" payload format (RFC 4588),
+      // with this payload type; otherwise, the original packets are resent unchanged.
+      // Returns False if the sink doesn't support retransmissions. (The default implementation
+      // doesn't.)  A "historySize" of 0 turns retransmissions off again.
+  virtual Boolean enableKernelPacing(unsigned burstDurationUSeconds = 10000, unsigned pacingRateKbps = 0);
+      // Asks the sink to wake up only once per "burstDurationUSeconds", sending all packets that are due
+      // during that interval at once, and leaving it to the kernel to space them out at the socket's maximum
+      // 'pacing rate'.  This rate is set to "pacingRateKbps" or - if this is 0 - to 125% of our
+      // "estimatedBitrate()" (if known).  Returns False if the pacing rate couldn't be set - e.g., because the
+      // sink's RTP socket is shared with other streams - in which case packets are not sent in bursts (but
+      // individually, as usual); or if the sink doesn't support this. (The default implementation doesn't.)
+      // A "burstDurationUSeconds" of 0 turns this off again.
+
 protected:
   RTPSink(UsageEnvironment& env,
 	  Groupsock* rtpGS, unsigned char rtpPayloadType,
@@ -105,6 +124,10 @@ protected:
   u_int32_t convertToRTPTimestamp(struct timeval tv);
   unsigned packetCount() const {return fPacketCount;}
   unsigned octetCount() const {return fOctetCount;}
+  virtual void retransmitPacket(u_int16_t seqNo, unsigned clientSessionId, int tcpSocketNum);
+      // called when a RTCP "Generic NACK" asks for packet "seqNo" to be resent (default: does nothing).
+      // The NACK came from the client that was added as a destination with "clientSessionId" (0 if unknown),
+      // or - if "tcpSocketNum" >= 0 - from the client at the other end of that TCP connection.
 
 protected:
   RTPInterface fRTPInterface;
@@ -177,6 +200,9 @@ private:
 
 class RTPTransmissionStats {
 public:
+  // (These are allocated - one per receiver - from a "MemoryPool".)
+  static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+  static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
   u_int32_t SSRC() const {return fSSRC;}
   struct sockaddr_in const& lastFromAddress() const {return fLastFromAddress;}
   unsigned lastPacketNumReceived() const {return fLastPacketNumReceived;}
@@ -228,6 +254,9 @@ private:
   unsigned fFirstPacketNumReported;
   u_int32_t fLastOctetCount, fTotalOctetCount_hi, fTotalOctetCount_lo;
   u_int32_t fLastPacketCount, fTotalPacketCount_hi, fTotalPacketCount_lo;
+
+private:
+  static MemoryPool fMemoryPool;
 };
 
 #endif
@@ -27,6 +27,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _RTP_INTERFACE_HH
 #include "RTPInterface.hh"
 #endif
+#ifndef _MEMORY_POOL_HH
+#include "MemoryPool.hh"
+#endif
 
 class RTPReceptionStatsDB; // forward
 
@@ -44,6 +47,16 @@ public:
   Groupsock* RTPgs() const { return fRTPInterface.gs(); }
 
   virtual void setPacketReorderingThresholdTime(unsigned uSeconds) = 0;
+  virtual void setAdaptivePacketReorderingThresholdTime(unsigned minUSeconds, unsigned maxUSeconds);
+      // Rather than using a fixed threshold, adapt it - between these bounds - to the
+      // interarrival jitter, and the reordering, that we observe.  (By default, this does nothing.)
+  virtual void enableRetransmissionRequests(class RTCPInstance* rtcpInstance,
+					    unsigned char rtxPayloadFormat = 0);
+      // Asks for any missing RTP packets to be resent, by sending RTCP "Generic NACK"s (RFC 4585)
+      // - via "rtcpInstance" - as soon as we notice a gap in incoming sequence numbers.
+      // If "rtxPayloadFormat" is non-zero, we also accept resent packets in the "RTX" payload
+      // format (RFC 4588), with this payload type.  (A "rtcpInstance" of NULL turns this off again.)
+      // (By default, this does nothing.)
 
   // used by RTCP:
   u_int32_t SSRC() const { return fSSRC; }
@@ -146,7 +159,9 @@ public:
 			  Boolean useForJitterCalculation,
 			  struct timeval& resultPresentationTime,
 			  Boolean& resultHasBeenSyncedUsingRTCP,
-			  unsigned packetSize /* payload only */);
+			  unsigned packetSize /* payload only */,
+			  struct timeval const* timeReceived = NULL);
+      // If "timeReceived" is NULL, then the current time is used as the packet's arrival time
 
   // The following is called whenever a RTCP SR packet is received:
   void noteIncomingSR(u_int32_t SSRC,
@@ -177,6 +192,8 @@ private:
 
 class RTPReceptionStats {
 public:
+  static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+  static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
   u_int32_t SSRC() const { return fSSRC; }
   unsigned numPacketsReceivedSinceLastReset() const {
     return fNumPacketsReceivedSinceLastReset;
@@ -223,7 +240,8 @@ private:
 			  Boolean useForJitterCalculation,
 			  struct timeval& resultPresentationTime,
 			  Boolean& resultHasBeenSyncedUsingRTCP,
-			  unsigned packetSize /* payload only */);
+			  unsigned packetSize /* payload only */,
+			  struct timeval const* timeReceived);
   void noteIncomingSR(u_int32_t ntpTimestampMSW, u_int32_t ntpTimestampLSW,
 		      u_int32_t rtpTimestamp);
   void init(u_int32_t SSRC);
@@ -257,6 +275,8 @@ private:
   Boolean fHasBeenSynchronized;
   u_int32_t fSyncTimestamp;
   struct timeval fSyncTime;
+
+  static MemoryPool fMemoryPool;
 };
 
 
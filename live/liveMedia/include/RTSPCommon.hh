@@ -38,6 +38,22 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #define RTSP_PARAM_STRING_MAX 200
 
+// The header lines - of interest to a server - that "parseRTSPRequestString()" saw during its single pass over a request.
+// Each is a pointer to the start of the (first) such line within "request", or NULL if the request had no such header.
+// This lets the per-command header parsing routines go straight to a header, rather than rescanning the whole request:
+typedef struct RTSPRequestHeaders {
+  char const* request; // the request string that these were found in (NULL if none)
+  char const* transport;
+  char const* range;
+  char const* scale;
+  char const* playNow;
+  char const* authorization;
+} RTSPRequestHeaders;
+
+char const* requestHeaderToParse(RTSPRequestHeaders const& headers, char const* headerLine, char const* fullRequestStr);
+    // Returns the string that should be given to a header parsing routine (e.g., "parseRangeHeader()"), to parse a header of
+    // "fullRequestStr": "headerLine" (or "", if it's NULL) if "headers" came from "fullRequestStr"; "fullRequestStr" otherwise.
+
 Boolean parseRTSPRequestString(char const *reqStr, unsigned reqStrSize,
 			       char *resultCmdName,
 			       unsigned resultCmdNameMaxSize,
@@ -49,7 +65,8 @@ Boolean parseRTSPRequestString(char const *reqStr, unsigned reqStrSize,
 			       unsigned resultCSeqMaxSize,
 			       char* resultSessionId,
 			       unsigned resultSessionIdMaxSize,
-			       unsigned& contentLength);
+			       unsigned& contentLength,
+			       RTSPRequestHeaders* resultHeaders = NULL);
 
 Boolean parseRangeParam(char const* paramStr, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
 Boolean parseRangeHeader(char const* buf, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
@@ -27,6 +27,12 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _DIGEST_AUTHENTICATION_HH
 #include "DigestAuthentication.hh"
 #endif
+#ifndef _BASE64_HH
+#include "Base64.hh"
+#endif
+#ifndef _RTSP_COMMON_HH
+#include "RTSPCommon.hh"
+#endif
 
 class RTSPServer: public GenericMediaServer {
 public:
@@ -134,6 +140,10 @@ public: // should be protected, but some old compilers complain otherwise
   class RTSPClientSession; // forward
   class RTSPClientConnection: public GenericMediaServer::ClientConnection {
   public:
+    // Connections and sessions are allocated from "MemoryPool"s, so that their memory usage can be reported:
+    static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+    static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
+
     // A data structure that's used to implement the "REGISTER" command:
     class ParamsForREGISTER {
     public:
@@ -203,6 +213,11 @@ public: // should be protected, but some old compilers complain otherwise
     void setRTSPResponse(char const* responseStr, u_int32_t sessionId);
     void setRTSPResponse(char const* responseStr, char const* contentStr);
     void setRTSPResponse(char const* responseStr, u_int32_t sessionId, char const* contentStr);
+    unsigned setRTSPResponseHead(char const* responseStr, Boolean includeCSeq = True);
+        // copies the response's status line, "CSeq:" (optionally) and "Date:" headers into "fResponseBuffer"; returns their length
+    unsigned setHTTPResponseHead(char const* responseStr);
+        // likewise, for a HTTP response (which has no "CSeq:" header)
+    void appendToRTSPResponse(unsigned& responseSize, char const* str);
 
     RTSPServer& fOurRTSPServer; // same as ::fOurServer
     int& fClientInputSocket; // aliased to ::fOurSocket
@@ -211,13 +226,21 @@ public: // should be protected, but some old compilers complain otherwise
     unsigned char* fLastCRLF;
     unsigned fRecursionCount;
     char const* fCurrentCSeq;
+    RTSPRequestHeaders fCurrentRequestHeaders; // where the current request's headers of interest are
     Authenticator fCurrentAuthenticator; // used if access control is needed
     char* fOurSessionCookie; // used for optional RTSP-over-HTTP tunneling
-    unsigned fBase64RemainderCount; // used for optional RTSP-over-HTTP tunneling (possible values: 0,1,2,3)
+    Base64Decoder fBase64Decoder; // used for optional RTSP-over-HTTP tunneling
+
+  private:
+    static MemoryPool fMemoryPool;
   };
 
   // The state of an individual client session (using one or more sequential TCP connections) handled by a RTSP server:
   class RTSPClientSession: public GenericMediaServer::ClientSession {
+  public:
+    static void* operator new(size_t size) { return fMemoryPool.allocate(size); }
+    static void operator delete(void* p, size_t size) { fMemoryPool.deallocate(p, size); }
+
   protected:
     RTSPClientSession(RTSPServer& ourServer, u_int32_t sessionId);
     virtual ~RTSPClientSession();
@@ -263,6 +286,9 @@ public: // should be protected, but some old compilers complain otherwise
       int tcpSocketNum;
       void* streamToken;
     } * fStreamStates;
+
+  private:
+    static MemoryPool fMemoryPool;
   };
 
 protected: // redefined virtual functions
@@ -283,6 +309,9 @@ private:
   void unnoteTCPStreamingOnSocket(int socketNum, RTSPClientSession* clientSession, unsigned trackNum);
   void stopTCPStreamingOnSocket(int socketNum);
 
+  char const* responseDateHeader();
+      // Like "dateHeader()", but the header is reformatted (into our own buffer) only when the time (in seconds) changes
+
 private:
   friend class RTSPClientConnection;
   friend class RTSPClientSession;
@@ -298,6 +327,8 @@ private:
   unsigned fRegisterOrDeregisterRequestCounter;
   UserAuthenticationDatabase* fAuthDB;
   Boolean fAllowStreamingRTPOverTCP; // by default, True
+  char fDateHeader[100];
+  time_t fDateHeaderTime; // the time at which "fDateHeader" was last formatted
 };
 
 
@@ -0,0 +1,69 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2018 Live Networks, Inc.  All rights reserved.
+// A cache of the SDP lines that describe server media subsessions, optionally backed by a file,
+// so that these lines need not be recomputed (e.g., by reading a file until its parameter sets appear)
+// C++ header
+
+#ifndef _SDP_CACHE_HH
+#define _SDP_CACHE_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+class ServerMediaSession;
+
+class SDPCache: public Medium {
+public:
+  static SDPCache* createNew(UsageEnvironment& env, char const* cacheFileName = NULL);
+      // Creates the cache that's used by all "OnDemandServerMediaSubsession"s in this environment
+      // (replacing any existing cache).  If "cacheFileName" is non-NULL, then the cache is
+      // initialized from this file (if it exists), and new entries are appended to it.
+
+  static SDPCache* ourCache(UsageEnvironment& env);
+      // returns NULL if no cache has been created in this environment
+
+  char const* lookup(char const* key) const;
+  void add(char const* key, char const* sdpLines);
+
+  void prewarm(ServerMediaSession& sms);
+      // Computes (and thus caches) the SDP lines for each of "sms"'s subsessions.
+      // Call this at startup - for each file-based "ServerMediaSession" - so that later
+      // "DESCRIBE"s don't have to wait for this.
+
+  unsigned numEntries() const { return fTable->numEntries(); }
+  unsigned numHits() const { return fNumHits; }
+  unsigned numMisses() const { return fNumMisses; }
+
+protected:
+  SDPCache(UsageEnvironment& env, char const* cacheFileName);
+      // called only by createNew()
+  virtual ~SDPCache();
+
+private:
+  void loadFromFile();
+  void addToTable(char const* key, char const* sdpLines);
+
+private:
+  HashTable* fTable; // maps keys to strDup()d SDP lines
+  char* fCacheFileName;
+  FILE* fCacheFid; // for appending new entries
+  mutable unsigned fNumHits, fNumMisses;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2018 Live Networks, Inc.  All rights reserved.
+// A pool of server port numbers (even/odd pairs, for RTP and RTCP), from which
+// "OnDemandServerMediaSubsession"s allocate the ports for their streams.
+// Note: There is at most one pool - covering a single range of port numbers - per environment.  Subsessions whose initial
+// port number lies outside this range don't use the pool; they instead try each port number in turn (as before).
+// C++ header
+
+#ifndef _SERVER_PORT_POOL_HH
+#define _SERVER_PORT_POOL_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+#ifndef _NET_ADDRESS_HH
+#include "NetAddress.hh"
+#endif
+
+#ifndef SERVER_PORT_POOL_DEFAULT_NUM_PAIRS
+#define SERVER_PORT_POOL_DEFAULT_NUM_PAIRS 4096
+#endif
+
+class ServerPortPool: public Medium {
+public:
+  static ServerPortPool* createNew(UsageEnvironment& env, portNumBits firstPortNum,
+				   unsigned numPortPairs = SERVER_PORT_POOL_DEFAULT_NUM_PAIRS);
+      // Creates the pool that's used by all "OnDemandServerMediaSubsession"s in this environment
+      // (replacing any existing pool), covering ports "firstPortNum" (rounded up to even)
+      // through "firstPortNum" + 2*"numPortPairs" - 1 (but no further than port 65535).
+      // (If there's no room for any pairs - i.e., if "firstPortNum" is 65535 - then the pool is empty.)
+      // A pool that's created this way lasts until it's closed (using "Medium::close()") or replaced.
+      // (If no pool has been created, the first "OnDemandServerMediaSubsession" to need one creates it - beginning at its
+      //  own initial port number - using "useOurPool()".)
+
+  static ServerPortPool* ourPool(UsageEnvironment& env);
+      // returns NULL if no pool has been created in this environment
+
+  static ServerPortPool* useOurPool(UsageEnvironment& env, portNumBits firstPortNum);
+      // Called by each "OnDemandServerMediaSubsession" that allocates ports from our environment's pool (once, before it
+      // first does so).  Returns the pool, after first creating it (beginning at "firstPortNum") if there was none.
+  static void stopUsingOurPool(UsageEnvironment& env);
+      // Undoes "useOurPool()".  A pool that was created by "useOurPool()" is closed once it no longer has any users,
+      // so that it doesn't prevent the environment's "liveMediaPriv" tables from being reclaimed.
+
+  Boolean contains(portNumBits portNum) const {
+    return portNum >= fFirstPortNum && (unsigned)(portNum - fFirstPortNum) < 2*fNumPortPairs;
+  }
+
+  portNumBits allocate();
+      // Returns the (even) first port number of a currently unused pair, or 0 if the pool is full.
+      // (The caller should "release()" the pair - and try again - if it then fails to bind either port.)
+  void release(portNumBits portNum);
+      // Returns the pair containing "portNum" to the pool (if it was allocated)
+
+  // Statistics:
+  unsigned numPortPairs() const { return fNumPortPairs; }
+  unsigned numAllocated() const { return fNumAllocated; }
+  unsigned peakNumAllocated() const { return fPeakNumAllocated; }
+  float utilization() const { return fNumPortPairs == 0 ? 0.0f : (float)fNumAllocated/fNumPortPairs; }
+  unsigned numAllocations() const { return fNumAllocations; }
+  unsigned numExhaustions() const { return fNumExhaustions; }
+  unsigned numBindFailures() const { return fNumBindFailures; }
+  void noteBindFailure() { ++fNumBindFailures; }
+
+protected:
+  ServerPortPool(UsageEnvironment& env, portNumBits firstPortNum, unsigned numPortPairs);
+      // called only by createNew() and useOurPool()
+  virtual ~ServerPortPool();
+
+private:
+  portNumBits fFirstPortNum;
+  unsigned fNumPortPairs;
+  u_int32_t* fInUse; // a bitmap: one bit per port pair
+  unsigned fNumWords;
+  unsigned fNextPair; // where the next search for a free pair begins
+  unsigned fNumAllocated, fPeakNumAllocated;
+  unsigned fNumAllocations, fNumExhaustions, fNumBindFailures;
+  unsigned fNumUsers; // the number of "useOurPool()" calls (on this, or on any pool that we replaced) not yet undone
+  Boolean fCloseWhenUnused; // iff we were created by "useOurPool()"
+};
+
+#endif
@@ -0,0 +1,77 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 3 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2018 Live Networks, Inc.  All rights reserved.
+// A single UDP socket that's shared by many RTP (and multiplexed RTCP) streams - e.g., so that a
+// server can stream to all of its (UDP) clients from just one port.
+// Incoming (RTCP) packets are demultiplexed - to each stream's "RTCPInstance" - by the address and
+// port that they came from, or (failing that) by the SSRC of the stream that they report on.
+// C++ header
+
+#ifndef _SHARED_RTP_SOCKET_HH
+#define _SHARED_RTP_SOCKET_HH
+
+#ifndef _RTCP_HH
+#include "RTCP.hh"
+#endif
+
+class SharedRTPSocket: public Medium {
+public:
+  static SharedRTPSocket* createNew(UsageEnvironment& env, Port port);
+      // Returns NULL if a socket could not be bound to "port"
+
+  Port port() const { return fGS->port(); }
+  int socketNum() const { return fGS->socketNum(); }
+
+  Groupsock* createGroupsock(struct in_addr const& addr);
+      // Returns a new 'groupsock' that sends (from our port) using our socket.  This 'groupsock'
+      // may be deleted (without closing our socket) at any time.
+
+  void registerRTCPInstance(struct in_addr const& fromAddr, Port const& fromPort, RTCPInstance* rtcpInstance,
+			    u_int32_t ourSSRC = 0);
+      // Incoming packets from "fromAddr" and "fromPort" will be given to "rtcpInstance" (as RTCP reports).
+      // If "ourSSRC" (the SSRC of the stream that we send - e.g., from "rtcpInstance"s "RTPSink") is
+      // non-zero, then so will incoming packets from any other address or port that report on this SSRC
+      // (in a SR or RR report block, or as the 'media source' of a feedback message) - e.g., from a client
+      // whose source port has been changed by a NAT.
+  void deregisterRTCPInstance(struct in_addr const& fromAddr, Port const& fromPort);
+  void deregisterRTCPInstance(RTCPInstance* rtcpInstance); // removes all entries for "rtcpInstance"
+
+  // Statistics:
+  unsigned numRegistrations() const { return fNumRegistrations; }
+  unsigned numPacketsDemultiplexed() const { return fNumPacketsDemultiplexed; }
+  unsigned numPacketsDemultiplexedBySSRC() const { return fNumPacketsDemultiplexedBySSRC; }
+      // (a subset of "numPacketsDemultiplexed()")
+  unsigned numPacketsUnmatched() const { return fNumPacketsUnmatched; }
+
+protected:
+  SharedRTPSocket(UsageEnvironment& env, Groupsock* gs); // called only by createNew()
+  virtual ~SharedRTPSocket();
+
+private:
+  static void incomingPacketHandler(SharedRTPSocket* sharedSocket, int /*mask*/);
+  void incomingPacketHandler1();
+  RTCPInstance* lookupBySSRC(u_int8_t const* packet, unsigned packetSize);
+
+private:
+  Groupsock* fGS; // owns our socket
+  AddressPortLookupTable* fRTCPInstances;
+  HashTable* fRTCPInstancesBySSRC; // indexed by (our) SSRC
+  unsigned char* fInBuf;
+  unsigned fNumRegistrations, fNumPacketsDemultiplexed, fNumPacketsDemultiplexedBySSRC, fNumPacketsUnmatched;
+};
+
+#endif
@@ -52,6 +52,7 @@ protected: // redefined virtual functions
 				    FramedSource* inputSource);
   virtual void testScaleFactor(float& scale);
   virtual float duration() const;
+  virtual char* sdpCacheKey();
 
 protected:
   Boolean fConvertToULaw;
@@ -58,11 +58,14 @@ protected:
 
   static void fileReadableHandler(WAVAudioFileSource* source, int mask);
   void doReadFromFile();
+  unsigned readScaledSamples(unsigned bytesPerSample);
+      // for 'trick play': returns the number of bytes delivered (0 at end-of-file)
 
 private:
   // redefined virtual functions:
   virtual void doGetNextFrame();
   virtual void doStopGettingFrames();
+  virtual unsigned maxFrameSize() const;
   virtual Boolean setInputPort(int portIndex);
   virtual double getAverageLevel() const;
 
@@ -81,6 +84,8 @@ private:
   Boolean fLimitNumBytesToStream;
   unsigned fNumBytesToStream; // used iff "fLimitNumBytesToStream" is True
   unsigned char fAudioFormat;
+  unsigned char* fTrickPlayBuffer; // holds each block of samples that we read during 'trick play'
+  unsigned fTrickPlayBufferSize;
 };
 
 #endif
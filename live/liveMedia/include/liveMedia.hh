@@ -128,5 +128,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MatroskaFileServerDemux.hh"
 #include "OggFileServerDemux.hh"
 #include "ProxyServerMediaSession.hh"
+#include "SDPCache.hh"
+#include "SharedRTPSocket.hh"
+#include "ServerPortPool.hh"
 
 #endif
@@ -45,6 +45,7 @@ protected:
 private:
   // Redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual unsigned maxFrameSize() const;
 
 private:
   static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -79,6 +80,7 @@ protected:
 private:
   // Redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual unsigned maxFrameSize() const;
 
 private:
   static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -89,10 +91,6 @@ private:
 			  unsigned numTruncatedBytes,
 			  struct timeval presentationTime,
 			  unsigned durationInMicroseconds);
-
-private:
-  unsigned char* fInputBuffer;
-  unsigned fInputBufferSize;
 };
 
 
@@ -111,6 +109,7 @@ protected:
 private:
   // Redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual unsigned maxFrameSize() const;
 
 private:
   static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -139,6 +138,7 @@ protected:
 private:
   // Redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual unsigned maxFrameSize() const;
 
 private:
   static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -166,6 +166,7 @@ protected:
 private:
   // Redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual unsigned maxFrameSize() const;
 
 private:
   static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -193,6 +194,7 @@ protected:
 private:
   // Redefined virtual functions:
   virtual void doGetNextFrame();
+  virtual unsigned maxFrameSize() const;
 
 private:
   static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -19,6 +19,71 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "uLawAudioFilter.hh"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define USE_NEON_KERNELS 1
+#endif
+
+////////// Conversion kernels (shared by the filters below) //////////
+
+// Each of these kernels converts a whole frame in a single pass.  Where the compiler
+// tells us that SSE2/SSSE3 (x86) or NEON (ARM) is available, the bulk of the frame is
+// handled 16 bytes at a time; the remainder (and other CPUs) use the scalar loop.
+
+static Boolean hostIsLittleEndian() {
+  u_int16_t const one = 1;
+  return *(u_int8_t const*)&one == 1;
+}
+
+static void swapBytes16(u_int8_t* data, unsigned numValues) {
+  unsigned i = 0;
+#if defined(USE_NEON_KERNELS)
+  for (; i + 8 <= numValues; i += 8) {
+    u_int8_t* p = &data[2*i];
+    vst1q_u8(p, vrev16q_u8(vld1q_u8(p)));
+  }
+#elif defined(__SSE2__)
+  for (; i + 8 <= numValues; i += 8) {
+    __m128i* p = (__m128i*)&data[2*i];
+    __m128i const v = _mm_loadu_si128(p);
+    _mm_storeu_si128(p, _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+  }
+#endif
+  for (; i < numValues; ++i) {
+    u_int8_t* p = &data[2*i];
+    u_int8_t const tmp = p[0]; p[0] = p[1]; p[1] = tmp;
+  }
+}
+
+static void swapBytes24(u_int8_t* data, unsigned numValues) {
+  unsigned i = 0;
+#if defined(USE_NEON_KERNELS)
+  for (; i + 16 <= numValues; i += 16) {
+    u_int8_t* p = &data[3*i];
+    uint8x16x3_t v = vld3q_u8(p);
+    uint8x16_t const tmp = v.val[0]; v.val[0] = v.val[2]; v.val[2] = tmp;
+    vst3q_u8(p, v);
+  }
+#elif defined(__SSSE3__)
+  // Each 16-byte load holds 5 complete values (plus one byte that we leave alone):
+  __m128i const shuffle = _mm_setr_epi8(2,1,0, 5,4,3, 8,7,6, 11,10,9, 14,13,12, 15);
+  for (; i + 6 <= numValues; i += 5) { // "6", so that the 16th byte is still within the data
+    __m128i* p = (__m128i*)&data[3*i];
+    _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), shuffle));
+  }
+#endif
+  for (; i < numValues; ++i) {
+    u_int8_t* p = &data[3*i];
+    u_int8_t const tmp = p[0]; p[0] = p[2]; p[2] = tmp;
+  }
+}
+
 
 ////////// 16-bit PCM (in various byte orders) -> 8-bit u-Law //////////
 
@@ -43,6 +108,11 @@ uLawFromPCMAudioSource::~uLawFromPCMAudioSource() {
   delete[] fInputBuffer;
 }
 
+unsigned uLawFromPCMAudioSource::maxFrameSize() const {
+  // Each 16-bit input sample becomes one output byte:
+  return fInputSource == NULL ? 0 : fInputSource->maxFrameSize()/2;
+}
+
 void uLawFromPCMAudioSource::doGetNextFrame() {
   // Figure out how many bytes of input data to ask for, and increase
   // our input buffer if necessary:
@@ -71,7 +141,7 @@ void uLawFromPCMAudioSource
 #define BIAS 0x84   // the add-in bias for 16 bit samples
 #define CLIP 32635
 
-static unsigned char uLawFrom16BitLinear(u_int16_t sample) {
+static inline unsigned char uLawFrom16BitLinear(u_int16_t sample) {
   static int const exp_lut[256] = {0,0,1,1,2,2,2,2,3,3,3,3,3,3,3,3,
 				   4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
 				   5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,
@@ -109,27 +179,15 @@ void uLawFromPCMAudioSource
   // Translate raw 16-bit PCM samples (in the input buffer)
   // into uLaw samples (in the output buffer).
   unsigned numSamples = frameSize/2;
-  switch (fByteOrdering) {
-    case 0: { // host order
-      u_int16_t* inputSample = (u_int16_t*)fInputBuffer;
-      for (unsigned i = 0; i < numSamples; ++i) {
-	fTo[i] = uLawFrom16BitLinear(inputSample[i]);
-      }
-      break;
-    }
-    case 1: { // little-endian order
-      for (unsigned i = 0; i < numSamples; ++i) {
-	u_int16_t const newValue = (fInputBuffer[2*i+1]<<8)|fInputBuffer[2*i];
-	fTo[i] = uLawFrom16BitLinear(newValue);
-      }
-      break;
+  Boolean inputIsLittleEndian
+    = fByteOrdering == 1 || (fByteOrdering == 0 && hostIsLittleEndian());
+  if (inputIsLittleEndian) {
+    for (unsigned i = 0; i < numSamples; ++i) {
+      fTo[i] = uLawFrom16BitLinear((fInputBuffer[2*i+1]<<8)|fInputBuffer[2*i]);
     }
-    case 2: { // network (i.e., big-endian) order
-      for (unsigned i = 0; i < numSamples; ++i) {
-	u_int16_t const newValue = (fInputBuffer[2*i]<<8)|fInputBuffer[2*i+i];
-	fTo[i] = uLawFrom16BitLinear(newValue);
-      }
-      break;
+  } else {
+    for (unsigned i = 0; i < numSamples; ++i) {
+      fTo[i] = uLawFrom16BitLinear((fInputBuffer[2*i]<<8)|fInputBuffer[2*i+1]);
     }
   }
 
@@ -152,25 +210,23 @@ PCMFromuLawAudioSource* PCMFromuLawAudioSource
 PCMFromuLawAudioSource
 ::PCMFromuLawAudioSource(UsageEnvironment& env,
 			 FramedSource* inputSource)
-  : FramedFilter(env, inputSource),
-    fInputBuffer(NULL), fInputBufferSize(0) {
+  : FramedFilter(env, inputSource) {
 }
 
 PCMFromuLawAudioSource::~PCMFromuLawAudioSource() {
-  delete[] fInputBuffer;
 }
 
-void PCMFromuLawAudioSource::doGetNextFrame() {
-  // Figure out how many bytes of input data to ask for, and increase
-  // our input buffer if necessary:
-  unsigned bytesToRead = fMaxSize/2; // because we're converting 8 bits->16
-  if (bytesToRead > fInputBufferSize) {
-    delete[] fInputBuffer; fInputBuffer = new unsigned char[bytesToRead];
-    fInputBufferSize = bytesToRead;
-  }
+unsigned PCMFromuLawAudioSource::maxFrameSize() const {
+  // Each input byte becomes one 16-bit output sample:
+  return fInputSource == NULL ? 0 : 2*fInputSource->maxFrameSize();
+}
 
-  // Arrange to read samples into the input buffer:
-  fInputSource->getNextFrame(fInputBuffer, bytesToRead,
+void PCMFromuLawAudioSource::doGetNextFrame() {
+  // Arrange to read the uLaw samples directly into the second half of the client's buffer.
+  // (Because we're converting 8 bits->16, we can then expand them in place, front-to-back,
+  //  without overwriting any input sample before we've used it.)
+  unsigned bytesToRead = fMaxSize/2;
+  fInputSource->getNextFrame(&fTo[bytesToRead], bytesToRead,
 			     afterGettingFrame, this,
                              FramedSource::handleClosure, this);
 }
@@ -185,29 +241,55 @@ void PCMFromuLawAudioSource
 			     presentationTime, durationInMicroseconds);
 }
 
-static u_int16_t linear16FromuLaw(unsigned char uLawByte) {
-  static int const exp_lut[8] = {0,132,396,924,1980,4092,8316,16764};
-  uLawByte = ~uLawByte;
-
-  Boolean sign = (uLawByte & 0x80) != 0;
-  unsigned char exponent = (uLawByte>>4) & 0x07;
-  unsigned char mantissa = uLawByte & 0x0F;
-
-  u_int16_t result = exp_lut[exponent] + (mantissa << (exponent+3));
-  if (sign) result = -result;
-  return result;
-}
+// There are only 256 possible uLaw values, so we decode using a (constant) table.  Entry "u" is the 16-bit linear value
+// of uLaw byte "u": With "v" = ~u, this is ("expLut"[(v>>4)&0x07] + ((v&0x0F) << (((v>>4)&0x07)+3))), negated if (v&0x80),
+// where "expLut" = {0,132,396,924,1980,4092,8316,16764}:
+static u_int16_t const linear16FromuLaw[256] = {
+  0x8284, 0x8684, 0x8A84, 0x8E84, 0x9284, 0x9684, 0x9A84, 0x9E84,
+  0xA284, 0xA684, 0xAA84, 0xAE84, 0xB284, 0xB684, 0xBA84, 0xBE84,
+  0xC184, 0xC384, 0xC584, 0xC784, 0xC984, 0xCB84, 0xCD84, 0xCF84,
+  0xD184, 0xD384, 0xD584, 0xD784, 0xD984, 0xDB84, 0xDD84, 0xDF84,
+  0xE104, 0xE204, 0xE304, 0xE404, 0xE504, 0xE604, 0xE704, 0xE804,
+  0xE904, 0xEA04, 0xEB04, 0xEC04, 0xED04, 0xEE04, 0xEF04, 0xF004,
+  0xF0C4, 0xF144, 0xF1C4, 0xF244, 0xF2C4, 0xF344, 0xF3C4, 0xF444,
+  0xF4C4, 0xF544, 0xF5C4, 0xF644, 0xF6C4, 0xF744, 0xF7C4, 0xF844,
+  0xF8A4, 0xF8E4, 0xF924, 0xF964, 0xF9A4, 0xF9E4, 0xFA24, 0xFA64,
+  0xFAA4, 0xFAE4, 0xFB24, 0xFB64, 0xFBA4, 0xFBE4, 0xFC24, 0xFC64,
+  0xFC94, 0xFCB4, 0xFCD4, 0xFCF4, 0xFD14, 0xFD34, 0xFD54, 0xFD74,
+  0xFD94, 0xFDB4, 0xFDD4, 0xFDF4, 0xFE14, 0xFE34, 0xFE54, 0xFE74,
+  0xFE8C, 0xFE9C, 0xFEAC, 0xFEBC, 0xFECC, 0xFEDC, 0xFEEC, 0xFEFC,
+  0xFF0C, 0xFF1C, 0xFF2C, 0xFF3C, 0xFF4C, 0xFF5C, 0xFF6C, 0xFF7C,
+  0xFF88, 0xFF90, 0xFF98, 0xFFA0, 0xFFA8, 0xFFB0, 0xFFB8, 0xFFC0,
+  0xFFC8, 0xFFD0, 0xFFD8, 0xFFE0, 0xFFE8, 0xFFF0, 0xFFF8, 0x0000,
+  0x7D7C, 0x797C, 0x757C, 0x717C, 0x6D7C, 0x697C, 0x657C, 0x617C,
+  0x5D7C, 0x597C, 0x557C, 0x517C, 0x4D7C, 0x497C, 0x457C, 0x417C,
+  0x3E7C, 0x3C7C, 0x3A7C, 0x387C, 0x367C, 0x347C, 0x327C, 0x307C,
+  0x2E7C, 0x2C7C, 0x2A7C, 0x287C, 0x267C, 0x247C, 0x227C, 0x207C,
+  0x1EFC, 0x1DFC, 0x1CFC, 0x1BFC, 0x1AFC, 0x19FC, 0x18FC, 0x17FC,
+  0x16FC, 0x15FC, 0x14FC, 0x13FC, 0x12FC, 0x11FC, 0x10FC, 0x0FFC,
+  0x0F3C, 0x0EBC, 0x0E3C, 0x0DBC, 0x0D3C, 0x0CBC, 0x0C3C, 0x0BBC,
+  0x0B3C, 0x0ABC, 0x0A3C, 0x09BC, 0x093C, 0x08BC, 0x083C, 0x07BC,
+  0x075C, 0x071C, 0x06DC, 0x069C, 0x065C, 0x061C, 0x05DC, 0x059C,
+  0x055C, 0x051C, 0x04DC, 0x049C, 0x045C, 0x041C, 0x03DC, 0x039C,
+  0x036C, 0x034C, 0x032C, 0x030C, 0x02EC, 0x02CC, 0x02AC, 0x028C,
+  0x026C, 0x024C, 0x022C, 0x020C, 0x01EC, 0x01CC, 0x01AC, 0x018C,
+  0x0174, 0x0164, 0x0154, 0x0144, 0x0134, 0x0124, 0x0114, 0x0104,
+  0x00F4, 0x00E4, 0x00D4, 0x00C4, 0x00B4, 0x00A4, 0x0094, 0x0084,
+  0x0078, 0x0070, 0x0068, 0x0060, 0x0058, 0x0050, 0x0048, 0x0040,
+  0x0038, 0x0030, 0x0028, 0x0020, 0x0018, 0x0010, 0x0008, 0x0000
+};
 
 void PCMFromuLawAudioSource
 ::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedBytes,
 		     struct timeval presentationTime,
 		     unsigned durationInMicroseconds) {
-  // Translate uLaw samples (in the input buffer)
-  // into 16-bit PCM samples (in the output buffer), in host order.
+  // Translate uLaw samples (in the second half of the client's buffer)
+  // into 16-bit PCM samples (in place), in host order.
   unsigned numSamples = frameSize;
+  u_int8_t const* inputSample = &fTo[fMaxSize/2];
   u_int16_t* outputSample = (u_int16_t*)fTo;
   for (unsigned i = 0; i < numSamples; ++i) {
-    outputSample[i] = linear16FromuLaw(fInputBuffer[i]);
+    outputSample[i] = linear16FromuLaw[inputSample[i]];
   }
 
   // Complete delivery to the client:
@@ -235,6 +317,10 @@ NetworkFromHostOrder16
 NetworkFromHostOrder16::~NetworkFromHostOrder16() {
 }
 
+unsigned NetworkFromHostOrder16::maxFrameSize() const {
+  return fInputSource == NULL ? 0 : fInputSource->maxFrameSize(); // we don't change the frame size
+}
+
 void NetworkFromHostOrder16::doGetNextFrame() {
   // Arrange to read data directly into the client's buffer:
   fInputSource->getNextFrame(fTo, fMaxSize,
@@ -257,12 +343,9 @@ void NetworkFromHostOrder16
 		     struct timeval presentationTime,
 		     unsigned durationInMicroseconds) {
   // Translate the 16-bit values that we have just read from host
-  // to network order (in-place)
+  // to network order (in-place).  (This is a no-op on big-endian hosts.)
   unsigned numValues = frameSize/2;
-  u_int16_t* value = (u_int16_t*)fTo;
-  for (unsigned i = 0; i < numValues; ++i) {
-    value[i] = htons(value[i]);
-  }
+  if (hostIsLittleEndian()) swapBytes16(fTo, numValues);
 
   // Complete delivery to the client:
   fFrameSize = numValues*2;
@@ -289,6 +372,10 @@ HostFromNetworkOrder16
 HostFromNetworkOrder16::~HostFromNetworkOrder16() {
 }
 
+unsigned HostFromNetworkOrder16::maxFrameSize() const {
+  return fInputSource == NULL ? 0 : fInputSource->maxFrameSize(); // we don't change the frame size
+}
+
 void HostFromNetworkOrder16::doGetNextFrame() {
   // Arrange to read data directly into the client's buffer:
   fInputSource->getNextFrame(fTo, fMaxSize,
@@ -311,12 +398,9 @@ void HostFromNetworkOrder16
 		     struct timeval presentationTime,
 		     unsigned durationInMicroseconds) {
   // Translate the 16-bit values that we have just read from network
-  // to host order (in-place):
+  // to host order (in-place).  (This is a no-op on big-endian hosts.)
   unsigned numValues = frameSize/2;
-  u_int16_t* value = (u_int16_t*)fTo;
-  for (unsigned i = 0; i < numValues; ++i) {
-    value[i] = ntohs(value[i]);
-  }
+  if (hostIsLittleEndian()) swapBytes16(fTo, numValues);
 
   // Complete delivery to the client:
   fFrameSize = numValues*2;
@@ -342,6 +426,10 @@ EndianSwap16::EndianSwap16(UsageEnvironment& env,
 EndianSwap16::~EndianSwap16() {
 }
 
+unsigned EndianSwap16::maxFrameSize() const {
+  return fInputSource == NULL ? 0 : fInputSource->maxFrameSize(); // we don't change the frame size
+}
+
 void EndianSwap16::doGetNextFrame() {
   // Arrange to read data directly into the client's buffer:
   fInputSource->getNextFrame(fTo, fMaxSize,
@@ -363,11 +451,7 @@ void EndianSwap16::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedB
 				      unsigned durationInMicroseconds) {
   // Swap the byte order of the 16-bit values that we have just read (in place):
   unsigned numValues = frameSize/2;
-  u_int16_t* value = (u_int16_t*)fTo;
-  for (unsigned i = 0; i < numValues; ++i) {
-    u_int16_t const orig = value[i];
-    value[i] = ((orig&0xFF)<<8) | ((orig&0xFF00)>>8);
-  }
+  swapBytes16(fTo, numValues);
 
   // Complete delivery to the client:
   fFrameSize = numValues*2;
@@ -393,6 +477,10 @@ EndianSwap24::EndianSwap24(UsageEnvironment& env,
 EndianSwap24::~EndianSwap24() {
 }
 
+unsigned EndianSwap24::maxFrameSize() const {
+  return fInputSource == NULL ? 0 : fInputSource->maxFrameSize(); // we don't change the frame size
+}
+
 void EndianSwap24::doGetNextFrame() {
   // Arrange to read data directly into the client's buffer:
   fInputSource->getNextFrame(fTo, fMaxSize,
@@ -414,13 +502,7 @@ void EndianSwap24::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedB
 				      unsigned durationInMicroseconds) {
   // Swap the byte order of the 24-bit values that we have just read (in place):
   unsigned const numValues = frameSize/3;
-  u_int8_t* p = fTo;
-  for (unsigned i = 0; i < numValues; ++i) {
-    u_int8_t tmp = p[0];
-    p[0] = p[2];
-    p[2] = tmp;
-    p += 3;
-  }
+  swapBytes24(fTo, numValues);
 
   // Complete delivery to the client:
   fFrameSize = numValues*3;